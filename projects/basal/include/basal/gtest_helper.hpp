@@ -5,9 +5,9 @@
 
 #if defined(USE_PRECISION_AS_FLOAT)
 #define ASSERT_PRECISION_EQ(a, b) ASSERT_FLOAT_EQ(a, b)
-#define ASSERT_PRECISION_NE(a, b) ASSERT_FLOAT_NE(a, b)
+#define ASSERT_PRECISION_NE(a, b) ASSERT_PRED_FORMAT2(not ::testing::internal::CmpHelperFloatingPointEQ<float>, a, b)
 #define EXPECT_PRECISION_EQ(a, b) EXPECT_FLOAT_EQ(a, b)
-#define EXPECT_PRECISION_NE(a, b) EXPECT_FLOAT_NE(a, b)
+#define EXPECT_PRECISION_NE(a, b) EXPECT_PRED_FORMAT2(not ::testing::internal::CmpHelperFloatingPointEQ<float>, a, b)
 #else
 #define ASSERT_PRECISION_EQ(a, b) ASSERT_DOUBLE_EQ(a, b)
 #define ASSERT_PRECISION_NE(a, b) ASSERT_PRED_FORMAT2(not ::testing::internal::CmpHelperFloatingPointEQ<double>, a, b)
@@ -0,0 +1,259 @@
+#pragma once
+
+/// @file
+/// A vector which keeps its first few elements inside itself.
+/// @note This is a header-only implementation, so it can be included in any translation unit without needing to link
+/// against a separate library.
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace basal {
+
+/// A vector which stores up to N elements inline and only allocates from the heap once it grows beyond that. Short
+/// lists which are made and thrown away very often (like the collisions along a ray) then never allocate, while long
+/// lists still work. Only the subset of std::vector which is needed is provided.
+/// @tparam TYPE The element type
+/// @tparam N The number of elements stored inline
+template <typename TYPE, size_t N>
+class small_vector {
+public:
+    static_assert(N > 0U, "Must have some inline capacity");
+    using value_type = TYPE;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = TYPE&;
+    using const_reference = TYPE const&;
+    using pointer = TYPE*;
+    using const_pointer = TYPE const*;
+    using iterator = TYPE*;
+    using const_iterator = TYPE const*;
+
+    small_vector() noexcept : data_{inline_data()}, size_{0U}, capacity_{N} {
+    }
+
+    small_vector(std::initializer_list<TYPE> list) : small_vector() {
+        reserve(list.size());
+        std::uninitialized_copy(list.begin(), list.end(), data_);
+        size_ = list.size();
+    }
+
+    template <typename INPUT, typename = typename std::iterator_traits<INPUT>::iterator_category>
+    small_vector(INPUT first, INPUT last) : small_vector() {
+        insert(end(), first, last);
+    }
+
+    small_vector(small_vector const& other) : small_vector() {
+        reserve(other.size_);
+        std::uninitialized_copy(other.begin(), other.end(), data_);
+        size_ = other.size_;
+    }
+
+    small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<TYPE>) : small_vector() {
+        steal(other);
+    }
+
+    small_vector& operator=(small_vector const& other) {
+        if (this != &other) {
+            clear();
+            reserve(other.size_);
+            std::uninitialized_copy(other.begin(), other.end(), data_);
+            size_ = other.size_;
+        }
+        return *this;
+    }
+
+    small_vector& operator=(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<TYPE>) {
+        if (this != &other) {
+            clear();
+            release();
+            steal(other);
+        }
+        return *this;
+    }
+
+    ~small_vector() {
+        clear();
+        release();
+    }
+
+    iterator begin() noexcept {
+        return data_;
+    }
+    const_iterator begin() const noexcept {
+        return data_;
+    }
+    iterator end() noexcept {
+        return data_ + size_;
+    }
+    const_iterator end() const noexcept {
+        return data_ + size_;
+    }
+    pointer data() noexcept {
+        return data_;
+    }
+    const_pointer data() const noexcept {
+        return data_;
+    }
+    size_t size() const noexcept {
+        return size_;
+    }
+    bool empty() const noexcept {
+        return size_ == 0U;
+    }
+    /// The number of elements which fit before the next allocation
+    size_t capacity() const noexcept {
+        return capacity_;
+    }
+    /// True while the elements are stored inline
+    bool is_inline() const noexcept {
+        return data_ == inline_data();
+    }
+    reference operator[](size_t index) noexcept {
+        return data_[index];
+    }
+    const_reference operator[](size_t index) const noexcept {
+        return data_[index];
+    }
+    reference front() noexcept {
+        return data_[0];
+    }
+    const_reference front() const noexcept {
+        return data_[0];
+    }
+    reference back() noexcept {
+        return data_[size_ - 1U];
+    }
+    const_reference back() const noexcept {
+        return data_[size_ - 1U];
+    }
+
+    /// Ensures the capacity is at least the count (keeps the elements)
+    void reserve(size_t count) {
+        if (count > capacity_) {
+            grow(count);
+        }
+    }
+
+    /// Removes all the elements but keeps the capacity
+    void clear() noexcept {
+        std::destroy(begin(), end());
+        size_ = 0U;
+    }
+
+    void push_back(TYPE const& value) {
+        emplace_back(value);
+    }
+
+    void push_back(TYPE&& value) {
+        emplace_back(std::move(value));
+    }
+
+    template <typename... ARGS>
+    reference emplace_back(ARGS&&... args) {
+        if (size_ == capacity_) {
+            // made before growing as the arguments may refer to an element
+            TYPE value(std::forward<ARGS>(args)...);
+            grow(capacity_ * 2U);
+            ::new (static_cast<void*>(data_ + size_)) TYPE(std::move(value));
+        } else {
+            ::new (static_cast<void*>(data_ + size_)) TYPE(std::forward<ARGS>(args)...);
+        }
+        return data_[size_++];
+    }
+
+    void pop_back() noexcept {
+        data_[--size_].~TYPE();
+    }
+
+    /// Inserts a range of elements (which must not be from this vector) before the position
+    template <typename INPUT>
+    iterator insert(const_iterator position, INPUT first, INPUT last) {
+        size_t const offset = static_cast<size_t>(position - begin());
+        size_t const before = size_;
+        for (; first != last; ++first) {
+            emplace_back(*first);
+        }
+        std::rotate(begin() + offset, begin() + before, end());
+        return begin() + offset;
+    }
+
+    /// Removes the elements in the range [first, last)
+    iterator erase(const_iterator first, const_iterator last) {
+        iterator const from = begin() + (first - begin());
+        iterator const to = begin() + (last - begin());
+        iterator const kept = std::move(to, end(), from);
+        std::destroy(kept, end());
+        size_ -= static_cast<size_t>(to - from);
+        return from;
+    }
+
+    iterator erase(const_iterator position) {
+        return erase(position, position + 1);
+    }
+
+    friend bool operator==(small_vector const& a, small_vector const& b) {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end());
+    }
+
+    friend bool operator!=(small_vector const& a, small_vector const& b) {
+        return not(a == b);
+    }
+
+protected:
+    TYPE* inline_data() noexcept {
+        return std::launder(reinterpret_cast<TYPE*>(storage_));
+    }
+
+    TYPE const* inline_data() const noexcept {
+        return std::launder(reinterpret_cast<TYPE const*>(storage_));
+    }
+
+    /// Moves the elements to a heap allocation of the count
+    void grow(size_t count) {
+        TYPE* larger = std::allocator<TYPE>{}.allocate(count);
+        std::uninitialized_move(begin(), end(), larger);
+        std::destroy(begin(), end());
+        release();
+        data_ = larger;
+        capacity_ = count;
+    }
+
+    /// Frees any heap allocation (the elements must already be destroyed)
+    void release() noexcept {
+        if (not is_inline()) {
+            std::allocator<TYPE>{}.deallocate(data_, capacity_);
+            data_ = inline_data();
+            capacity_ = N;
+        }
+    }
+
+    /// Takes the elements of the other (empty) vector, leaving it empty
+    void steal(small_vector& other) {
+        if (other.is_inline()) {
+            std::uninitialized_move(other.begin(), other.end(), data_);
+            size_ = other.size_;
+            other.clear();
+        } else {
+            data_ = other.data_;
+            size_ = other.size_;
+            capacity_ = other.capacity_;
+            other.data_ = other.inline_data();
+            other.size_ = 0U;
+            other.capacity_ = N;
+        }
+    }
+
+    alignas(TYPE) unsigned char storage_[N * sizeof(TYPE)];
+    TYPE* data_;
+    size_t size_;
+    size_t capacity_;
+};
+
+}  // namespace basal
@@ -25,9 +25,9 @@ void process(size_t num_opts, config options[], int argc, char* argv[]) {
                     sscanf(argv[i + 1], "%" PRIz, &v);
                     options[j].value = v;
                 } else if (std::holds_alternative<precision>(options[j].value)) {
-                    precision v;
+                    double v;
                     sscanf(argv[i + 1], "%lf", &v);
-                    options[j].value = v;
+                    options[j].value = static_cast<precision>(v);
                 } else if (std::holds_alternative<std::string>(options[j].value)) {
                     char input[41];
                     sscanf(argv[i + 1], "%40s", input);
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <basal/small_vector.hpp>
+#include <memory>
+#include <string>
+
+using namespace basal;
+
+TEST(SmallVector, InlineUntilFull) {
+    small_vector<int, 4> v;
+    EXPECT_TRUE(v.empty());
+    EXPECT_TRUE(v.is_inline());
+    for (int i = 0; i < 4; i++) {
+        v.push_back(i);
+    }
+    EXPECT_TRUE(v.is_inline());
+    EXPECT_EQ(4U, v.capacity());
+    v.emplace_back(4);
+    EXPECT_FALSE(v.is_inline());
+    ASSERT_EQ(5U, v.size());
+    for (int i = 0; i < 5; i++) {
+        EXPECT_EQ(i, v[static_cast<size_t>(i)]);
+    }
+    EXPECT_EQ(0, v.front());
+    EXPECT_EQ(4, v.back());
+    v.clear();
+    EXPECT_TRUE(v.empty());
+    EXPECT_EQ(8U, v.capacity());  // keeps the capacity
+}
+
+TEST(SmallVector, CopyAndMove) {
+    small_vector<std::string, 2> a{"one", "two"};
+    small_vector<std::string, 2> b{a};
+    EXPECT_EQ(a, b);
+    small_vector<std::string, 2> c{std::move(b)};
+    EXPECT_TRUE(b.empty());
+    EXPECT_EQ(a, c);
+    c.push_back("three");  // spills
+    small_vector<std::string, 2> d;
+    d = c;
+    EXPECT_EQ(c, d);
+    small_vector<std::string, 2> e;
+    e = std::move(d);  // takes the allocation
+    EXPECT_FALSE(e.is_inline());
+    EXPECT_TRUE(d.is_inline());
+    EXPECT_TRUE(d.empty());
+    EXPECT_EQ(c, e);
+    EXPECT_NE(a, e);
+}
+
+TEST(SmallVector, InsertEraseSort) {
+    small_vector<int, 3> v{5, 1, 4};
+    small_vector<int, 3> const w{3, 2};
+    EXPECT_EQ(w, (small_vector<int, 3>{w.begin(), w.end()}));
+    v.insert(v.end(), w.begin(), w.end());
+    ASSERT_EQ(5U, v.size());
+    std::sort(v.begin(), v.end());
+    EXPECT_EQ((small_vector<int, 3>{1, 2, 3, 4, 5}), v);
+    v.insert(v.begin() + 1, w.begin(), w.end());
+    EXPECT_EQ((small_vector<int, 3>{1, 3, 2, 2, 3, 4, 5}), v);
+    v.erase(v.begin() + 1, v.begin() + 3);
+    EXPECT_EQ((small_vector<int, 3>{1, 2, 3, 4, 5}), v);
+    v.erase(v.begin());
+    v.pop_back();
+    EXPECT_EQ((small_vector<int, 3>{2, 3, 4}), v);
+}
+
+TEST(SmallVector, DestroysElements) {
+    auto counter = std::make_shared<int>(0);
+    {
+        small_vector<std::shared_ptr<int>, 2> v;
+        for (size_t i = 0; i < 5; i++) {
+            v.push_back(counter);
+        }
+        EXPECT_EQ(6, counter.use_count());
+        v.erase(v.begin(), v.begin() + 2);
+        EXPECT_EQ(4, counter.use_count());
+        v.emplace_back(v[0]);  // an element of itself while it grows
+        EXPECT_EQ(5, counter.use_count());
+    }
+    EXPECT_EQ(1, counter.use_count());
+}
@@ -100,7 +100,7 @@ public:
     inline void clamp() {
         static_assert(std::is_floating_point_v<ChannelType>, "Must be a floating point type to clamp!");
         for (auto& c : data_.channels) {
-            c = std::clamp(c, 0.0_p, 1.0_p);
+            c = std::clamp(c, ChannelType{0}, ChannelType{1});
         }
     }
 
@@ -198,7 +198,7 @@ bool plane::operator!=(plane const& other) const {
 }
 
 precision plane::angle(plane const& P) const {
-    return acos(dot(m_normal, P.unormal()));
+    return std::acos(dot(m_normal, P.unormal()));
 }
 
 std::ostream& operator<<(std::ostream& os, plane const& p) {
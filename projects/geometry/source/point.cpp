@@ -305,8 +305,8 @@ template vector_<2ul> operators::operator+ <2ul>(point_<2ul> const&, point_<2ul>
 template vector_<2ul> operators::operator- <2ul>(point_<2ul> const&, point_<2ul> const&);
 template point_<2ul> operators::operator+ <2ul>(point_<2ul> const&, const vector_<2ul>&) noexcept(false);
 template point_<2ul> operators::operator- <2ul>(point_<2ul> const&, const vector_<2ul>&) noexcept(false);
-template point_<2ul> multiply<2ul>(point_<2ul> const&, double);
-template point_<2ul> multiply<2ul>(double, point_<2ul> const&);
+template point_<2ul> multiply<2ul>(point_<2ul> const&, precision);
+template point_<2ul> multiply<2ul>(precision, point_<2ul> const&);
 template point_<2ul> pairwise::divide<2ul>(point_<2ul> const&, point_<2ul> const&);
 template point_<2ul> pairwise::multiply<2ul>(point_<2ul> const&, point_<2ul> const&);
 template std::ostream& operator<< <2ul>(std::ostream&, point_<2ul> const&);
@@ -324,8 +324,8 @@ template vector_<3ul> operators::operator+ <3ul>(point_<3ul> const&, point_<3ul>
 template vector_<3ul> operators::operator- <3ul>(point_<3ul> const&, point_<3ul> const&);
 template point_<3ul> operators::operator+ <3ul>(point_<3ul> const&, const vector_<3ul>&) noexcept(false);
 template point_<3ul> operators::operator- <3ul>(point_<3ul> const&, const vector_<3ul>&) noexcept(false);
-template point_<3ul> multiply<3ul>(point_<3ul> const&, double);
-template point_<3ul> multiply<3ul>(double, point_<3ul> const&);
+template point_<3ul> multiply<3ul>(point_<3ul> const&, precision);
+template point_<3ul> multiply<3ul>(precision, point_<3ul> const&);
 template point_<3ul> pairwise::divide<3ul>(point_<3ul> const&, point_<3ul> const&);
 template point_<3ul> pairwise::multiply<3ul>(point_<3ul> const&, point_<3ul> const&);
 template std::ostream& operator<< <3ul>(std::ostream&, point_<3ul> const&);
@@ -343,8 +343,8 @@ template vector_<4ul> operators::operator+ <4ul>(point_<4ul> const&, point_<4ul>
 template vector_<4ul> operators::operator- <4ul>(point_<4ul> const& a, point_<4ul> const& b);
 template point_<4ul> operators::operator+ <4ul>(point_<4ul> const& a, const vector_<4ul>& b) noexcept(false);
 template point_<4ul> operators::operator- <4ul>(point_<4ul> const& a, const vector_<4ul>& b) noexcept(false);
-template point_<4ul> multiply<4ul>(point_<4ul> const&, double);
-template point_<4ul> multiply<4ul>(double, point_<4ul> const&);
+template point_<4ul> multiply<4ul>(point_<4ul> const&, precision);
+template point_<4ul> multiply<4ul>(precision, point_<4ul> const&);
 template point_<4ul> pairwise::divide<4ul>(point_<4ul> const&, point_<4ul> const&);
 template point_<4ul> pairwise::multiply<4ul>(point_<4ul> const&, point_<4ul> const&);
 template std::ostream& operator<< <4ul>(std::ostream&, point_<4ul> const&);
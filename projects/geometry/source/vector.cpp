@@ -176,7 +176,7 @@ void vector_<DIMS>::print(std::ostream& os, char const name[]) const {
 // Template functions outside the class
 template <size_t DIMS>
 iso::radians angle(vector_<DIMS> const& a, vector_<DIMS> const& b) {
-    iso::radians r{acos(dot(a, b) / (a.norm() * b.norm()))};
+    iso::radians r{std::acos(dot(a, b) / (a.norm() * b.norm()))};
     return r;
 }
 
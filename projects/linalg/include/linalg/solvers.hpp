@@ -5,6 +5,7 @@
 
 #include <cmath>
 #include <complex>
+#include <cstddef>
 #include <iso/iso.hpp>  // for PI
 #include <tuple>
 
@@ -15,6 +16,13 @@ namespace linalg {
 /// Given: a*x^2+b*x+c=0, solves for x. A NaN is a complex solution.
 std::tuple<precision, precision> quadratic_roots(precision a, precision b, precision c);
 
+/// Solves a batch of quadratics, which is faster than solving them one at a time as the equations are solved in
+/// blocks which vectorize. Each equation has the same roots as @ref quadratic_roots would give.
+/// @param count The number of equations
+/// @param coefficients The arrays of the a, b and c of each equation (each array has count values)
+/// @param roots The arrays the first and second roots are written to (each array has count values)
+void quadratic_roots(size_t count, precision const* const coefficients[3], precision* const roots[2]);
+
 ///
 /// Solves for cubic roots of a cubic formula:
 /// Given: a*x^3+b*x^2+c*x+d=0, solves for x. A NaN in the tuple is a complex solution.
@@ -23,11 +31,28 @@ std::tuple<precision, precision> quadratic_roots(precision a, precision b, preci
 ///
 std::tuple<precision, precision, precision> cubic_roots(precision a, precision b, precision c, precision d);
 
+/// Solves a batch of cubics in vectorized blocks. Each equation has the same roots as @ref cubic_roots would give,
+/// except that an equation without a solution (a nearly zero) is left as NaNs instead of throwing.
+/// @param count The number of equations
+/// @param coefficients The arrays of the a, b, c and d of each equation (each array has count values)
+/// @param roots The arrays the three roots are written to (each array has count values)
+void cubic_roots(size_t count, precision const* const coefficients[4], precision* const roots[3]);
+
 /// Solves for quartic roots of a quartic formula:
 /// Given: a*x^4+b*x^3+c*x^2+d*x^1+e=0, solves for x. A NaN in the tuple is a complex solution.
+/// The roots come in the pairs (x1, x3) and (x2, x4) which are either both real or both NaN. Each real root is
+/// polished with Newton's method.
 std::tuple<precision, precision, precision, precision> quartic_roots(precision a, precision b, precision c, precision d,
                                                                      precision e);
 
+/// Solves a batch of quartics in vectorized blocks. Each equation has the same roots as @ref quartic_roots would give.
+/// @param count The number of equations
+/// @param coefficients The arrays of the a, b, c, d and e of each equation (each array has count values)
+/// @param roots The arrays the four roots are written to (each array has count values)
+/// @param real Optional, the array the number of real roots of each equation is written to
+void quartic_roots(size_t count, precision const* const coefficients[5], precision* const roots[4],
+                   size_t* real = nullptr);
+
 /// Returns true when m is within the range of low to hi (but not when equal)
 constexpr bool within(precision low, precision m, precision hi) {
     return (low < m and m < hi);
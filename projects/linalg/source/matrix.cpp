@@ -2,6 +2,8 @@
 /// @author "Erik Rainey" (erik.rainey@gmail.com)
 /// @copyright Copyright (c) 2007-2020 Erik Rainey
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 #include "linalg/matrix.hpp"
@@ -19,6 +21,27 @@ namespace linalg {
 // ****************************************************************************
 static char const* g_filename = __FILE__;
 
+/// Determines if a determinant is too small for the matrix to be inverted. The determinant is compared to the largest
+/// it could be for the matrix (by Hadamard's inequality, the smaller of the products of the lengths of the rows and of
+/// the columns) so that the test does not depend on the scale of the values, which a fixed epsilon would (and which
+/// rejects well conditioned matrices of small values when the precision is a float).
+static bool nearly_singular(matrix const& m, precision det) {
+    precision by_rows = 1.0_p;
+    precision by_cols = 1.0_p;
+    for (size_t i = 0; i < m.rows; i++) {
+        precision row = 0.0_p;
+        precision col = 0.0_p;
+        for (size_t j = 0; j < m.cols; j++) {
+            row += m[i][j] * m[i][j];
+            col += m[j][i] * m[j][i];
+        }
+        by_rows *= std::sqrt(row);
+        by_cols *= std::sqrt(col);
+    }
+    precision const bound = std::min(by_rows, by_cols);
+    return not(std::abs(det) >= basal::epsilon * bound) or det == 0.0_p;
+}
+
 matrix matrix::zeros(size_t rows, size_t cols) {
     return matrix{rows, cols}.fill(0.0_p);
 }
@@ -482,7 +505,7 @@ bool matrix::orthogonal() const {
 }
 
 bool matrix::invertible() const {
-    if (rows == cols && !basal::nearly_zero(determinant()))
+    if (rows == cols && !nearly_singular(*this, determinant()))
         return true;
     return false;
 }
@@ -670,7 +693,7 @@ matrix matrix::inverse() const noexcept(false) {
                                    "Must be a square matrix");  // no inverses for non square matrix
     matrix m{rows, cols};
     precision det = determinant();
-    basal::exception::throw_if(basal::nearly_zero(det), g_filename, __LINE__, "Matrix is singular, not invertible");
+    basal::exception::throw_if(nearly_singular(*this, det), g_filename, __LINE__, "Matrix is singular, not invertible");
 
     if (rows == 1) {
         m[0][0] = 1.0_p / det;
@@ -1,210 +1,355 @@
 #include "linalg/solvers.hpp"
 
-#include <complex>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
 
 namespace linalg {
 
-/// in order to save some typing just a shorter definition of complex numbers
-using complex_ = std::complex<precision>;
-
 /// pull in basal's precision literals
 using namespace basal::literals;
 
+namespace {
+/// The cubic and quartic roots are found in double precision even when the precision is a float, as the resolvent
+/// cubic of a quartic (i.e. of a torus) loses too many digits in a float to find any roots at all.
+using working = double;
+
+/// The largest finite value, anything larger in magnitude is infinite (and a NaN is neither)
+constexpr working largest = std::numeric_limits<working>::max();
+
+/// Pi in the working precision
+constexpr working pi = 3.14159265358979323846;
+
+/// The same limit as basal::nearly_zero has with double precision
+inline bool nearly_zero(working a) {
+    return std::abs(a) < 0x1.0p-20;
+}
+
+/// True when a sum is positive or is zero within the rounding of its terms (scale is the sum of their magnitudes).
+/// The sum under a square root which is zero at a repeated root is rarely exactly zero and is as often a little
+/// negative, which would make a real (double) root complex.
+inline bool nearly_positive(working sum, working scale) {
+    return sum >= -0x1.0p-22 * scale;
+}
+
+/// Zero when a lane has a real value, otherwise NaN. Adding it to the value (instead of selecting a NaN) keeps the
+/// computation of the value unconditional, so the compiler does not move a division into a branch.
+template <typename T>
+constexpr T invalid_unless(bool real) {
+    return real ? T(0) : std::numeric_limits<T>::quiet_NaN();
+}
+
+/// The number of equations a batch solves together. Each step of a solver is a loop without branches over a block
+/// of this many lanes (held in local arrays so nothing can alias), which the compiler turns into vector instructions.
+constexpr size_t lanes{16U};
+
+// The kernels below solve a single lane. The scalar solvers call them once and the batch solvers call them for each
+// lane of a block, so both give the same roots. The arithmetic kernels compute all of their cases and select the
+// answer instead of branching, so a block of lanes is solved with vector instructions. The steps which need the
+// transcendental functions of the math library are done one lane at a time anyway, so they only compute the case
+// they need.
+
+/// The roots of a*x^2+b*x+c=0 or NaNs when they are complex
+inline void quadratic_kernel(precision a, precision b, precision c, precision& x1, precision& x2) {
+    precision const i = (b * b) - (4.0_p * a * c);
+    precision const root = std::sqrt(std::max(i, 0.0_p));
+    precision const invalid = invalid_unless<precision>(not basal::nearly_zero(a) and i >= 0.0_p);
+    x1 = ((-b + root) / (2.0_p * a)) + invalid;
+    x2 = ((-b - root) / (2.0_p * a)) + invalid;
+}
+
+/// Reduces the monic cubic x^3+b*x^2+c*x+d to the depressed cubic about its inflection (at x=-b/3), returning the Q
+/// and R of Cardano's method and the discriminant D which tells how many real roots there are.
+inline void cubic_terms(working b, working c, working d, working& Q, working& R, working& D) {
+    Q = ((3.0 * c) - (b * b)) / 9.0;
+    R = ((b * ((9.0 * c) - (2.0 * b * b))) - (27.0 * d)) / 54.0;
+    D = (Q * Q * Q) + (R * R);
+}
+
+/// Normalizes the cubic a*x^3+b*x^2+c*x+d to a monic one (all NaN when a is nearly zero) and reduces it with
+/// @ref cubic_terms
+/// @param shift Returns the shift which moves the roots of the depressed cubic back to the roots of the cubic
+inline void cubic_terms(working a, working b, working c, working d, working& Q, working& R, working& D,
+                        working& shift) {
+    working const inverse = (1.0 / a) + invalid_unless<working>(not nearly_zero(a));
+    shift = -(b * inverse) / 3.0;
+    cubic_terms(b * inverse, c * inverse, d * inverse, Q, R, D);
+}
+
+/// The largest real root of the depressed cubic. When there are three real roots (D < 0) they are found with the
+/// trigonometric method, which avoids the complex cube roots, otherwise with Cardano's real cube roots.
+/// @param phi Returns the angle of the trigonometric method (for @ref cubic_other_roots)
+inline working cubic_first_root(working Q, working R, working D, working& phi) {
+    if (D < 0.0) {
+        working const q = std::sqrt(-Q);
+        phi = std::acos(std::clamp(R / (q * q * q), -1.0, 1.0));
+        return 2.0 * q * std::cos(phi / 3.0);
+    }
+    phi = 0.0;
+    working const s = std::sqrt(std::max(D, 0.0));
+    return std::cbrt(R + s) + std::cbrt(R - s);
+}
+
+/// The other two real roots of the depressed cubic, given the first, or NaNs when they are complex. The repeated
+/// root of a (nearly) zero discriminant is returned twice.
+inline void cubic_other_roots(working Q, working D, working phi, working x1, working& x2, working& x3) {
+    if (D < 0.0) {
+        working const q = std::sqrt(-Q);
+        x2 = 2.0 * q * std::cos((phi + 4.0 * pi) / 3.0);
+        x3 = 2.0 * q * std::cos((phi + 2.0 * pi) / 3.0);
+    } else {
+        x2 = x3 = (-0.5 * x1) + invalid_unless<working>(nearly_zero(D));
+    }
+}
+
+/// Normalizes the quartic a*x^4+b*x^3+c*x^2+d*x+e to a monic one (all NaN when a is nearly zero) and finds the Q, R
+/// and D of its resolvent cubic z^3-c*z^2+(b*d-4*e)*z+e*(4*c-b^2)-d^2.
+/// @internal A method based on Herbert E. Salzer "A Note on the Solution of Quartic Equations"
+/// (Am. Math Society Proceedings, 1959).
+inline void quartic_terms(working a, working& b, working& c, working& d, working& e, working& Q, working& R,
+                          working& D) {
+    working const inverse = (1.0 / a) + invalid_unless<working>(not nearly_zero(a));
+    b *= inverse;
+    c *= inverse;
+    d *= inverse;
+    e *= inverse;
+    working const c1 = (b * d) - (4.0 * e);
+    working const d1 = (e * ((4.0 * c) - (b * b))) - (d * d);
+    cubic_terms(-c, c1, d1, Q, R, D);
+}
+
+/// Moves a root of the monic quartic closer with Newton's method, only taking a step which lowers the residual so a
+/// root at a flat spot (a repeated root) can not be thrown away. A NaN stays a NaN.
+inline working quartic_polish(working x, working b, working c, working d, working e) {
+    constexpr size_t iterations{2U};
+    for (size_t k = 0; k < iterations; k++) {
+        working const f = (((((x + b) * x) + c) * x) + d) * x + e;
+        working const df = ((((4.0 * x) + (3.0 * b)) * x) + (2.0 * c)) * x + d;
+        working const y = x - (f / df);
+        working const g = (((((y + b) * y) + c) * y) + d) * y + e;
+        x = (std::abs(g) < std::abs(f)) ? y : x;
+    }
+    return x;
+}
+
+/// Finds the m and n which factor the monic quartic into two quadratics, given a root z of its resolvent cubic. Both
+/// m^2 and n^2 are known but only the larger is square rooted, the other is found from their product so it is not
+/// divided by a (nearly) zero root when the two factors are (nearly) the same. m is never negative.
+/// @param invalid Returns NaN when the factors are complex (then all of the roots are) and zero otherwise
+inline void quartic_factors(working b, working c, working d, working e, working z, working& m, working& n,
+                            working& invalid) {
+    working const mm = (0.25 * b * b) - c + z;
+    working const nn = (0.25 * z * z) - e;
+    working const mn = 0.25 * ((b * z) - (2.0 * d));
+    // the choice is blended so neither is in a branch (nor is a division by zero)
+    working const by_m = (mm >= nn) ? 1.0 : 0.0;
+    working const larger = std::sqrt(std::max((by_m * mm) + ((1.0 - by_m) * nn), 0.0));
+    working const other = mn / (larger + ((larger > 0.0) ? 0.0 : 1.0));
+    m = (by_m * larger) + ((1.0 - by_m) * std::abs(other));
+    n = (by_m * other) + ((1.0 - by_m) * std::copysign(larger, mn));
+    working const scale = (0.25 * b * b) + std::abs(c) + std::abs(z);
+    invalid = invalid_unless<working>(nearly_positive(mm, scale));
+}
+
+/// The two roots of one of the quadratic factors of the monic quartic, given its m and n (negated for the second
+/// factor) or NaNs when they are complex (or infinite). A double root is kept even when rounding leaves its
+/// discriminant a little negative (see @ref nearly_positive), the polishing then moves it onto the root.
+inline void quartic_pair(working b, working c, working z, working m, working n, working invalid, working& x1,
+                         working& x2) {
+    working const alpha = (0.5 * b * b) - z - c;
+    working const beta = (4.0 * n) - (b * m);
+    working const scale = (0.5 * b * b) + std::abs(z) + std::abs(c) + std::abs(4.0 * n) + std::abs(b * m);
+    working const root = std::sqrt(std::max(alpha + beta, 0.0));
+    working const real = invalid + invalid_unless<working>(nearly_positive(alpha + beta, scale));
+    working const X1 = ((-b * 0.5) + m + root) * 0.5;
+    working const X2 = ((-b * 0.5) + m - root) * 0.5;
+    x1 = X1 + real + invalid_unless<working>(std::abs(X1) <= largest);
+    x2 = X2 + real + invalid_unless<working>(std::abs(X2) <= largest);
+}
+
+/// @return The number of roots which are real (not NaN)
+inline size_t real_roots(working x1, working x2, working x3, working x4) {
+    return size_t(x1 == x1) + size_t(x2 == x2) + size_t(x3 == x3) + size_t(x4 == x4);
+}
+
+/// Copies the coefficients of up to @ref lanes equations starting at an index into a block, the lanes past the end
+/// are filled with x^(N-1)=0 so they solve without trouble.
+template <size_t N, typename T>
+void load(size_t count, size_t first, precision const* const coefficients[N], T (&block)[N][lanes]) {
+    size_t const used = std::min(lanes, count - first);
+    for (size_t k = 0; k < N; k++) {
+        if (used == lanes) {
+            // a whole block is a copy of a constant size
+            for (size_t l = 0; l < lanes; l++) {
+                block[k][l] = static_cast<T>(coefficients[k][first + l]);
+            }
+        } else {
+            for (size_t l = 0; l < lanes; l++) {
+                block[k][l] = T((k == 0U) ? 1 : 0);
+            }
+            for (size_t l = 0; l < used; l++) {
+                block[k][l] = static_cast<T>(coefficients[k][first + l]);
+            }
+        }
+    }
+}
+
+/// Copies the roots of a block out, as many as there are equations left
+template <size_t N, typename T>
+void store(size_t count, size_t first, T const (&block)[N][lanes], precision* const roots[N]) {
+    size_t const used = std::min(lanes, count - first);
+    for (size_t k = 0; k < N; k++) {
+        if (used == lanes) {
+            for (size_t l = 0; l < lanes; l++) {
+                roots[k][first + l] = static_cast<precision>(block[k][l]);
+            }
+        } else {
+            for (size_t l = 0; l < used; l++) {
+                roots[k][first + l] = static_cast<precision>(block[k][l]);
+            }
+        }
+    }
+}
+}  // namespace
+
 std::tuple<precision, precision> quadratic_roots(precision a, precision b, precision c) {
     statistics::get().quadratic_roots++;
     if constexpr (debug::root) {
         std::cout << "Quadratic Coefficients a=" << a << ", b=" << b << ", c=" << c << std::endl;
     }
-    if (basal::nearly_zero(a)) {
-        return std::make_tuple(basal::nan, basal::nan);
-    }
-    auto i = (b * b) - (4.0_p * a * c);
-    if (basal::is_greater_than_or_equal_to_zero(i)) {
-        auto p = (-b + sqrt(i)) / (2.0_p * a);
-        auto q = (-b - sqrt(i)) / (2.0_p * a);
-        return std::make_tuple(p, q);
-    } else {
-        // Requires Complex Numbers
-        return std::make_tuple(basal::nan, basal::nan);
+    precision x1, x2;
+    quadratic_kernel(a, b, c, x1, x2);
+    return std::make_tuple(x1, x2);
+}
+
+void quadratic_roots(size_t count, precision const* const coefficients[3], precision* const roots[2]) {
+    statistics::get().quadratic_roots += count;
+    for (size_t first = 0; first < count; first += lanes) {
+        precision in[3][lanes];
+        precision out[2][lanes];
+        load<3>(count, first, coefficients, in);
+        for (size_t l = 0; l < lanes; l++) {
+            quadratic_kernel(in[0][l], in[1][l], in[2][l], out[0][l], out[1][l]);
+        }
+        store<2>(count, first, out, roots);
     }
 }
 
 std::tuple<precision, precision, precision> cubic_roots(precision a, precision b, precision c, precision d) {
     statistics::get().cubic_roots++;
-    if (basal::nearly_zero(a)) {
+    if (nearly_zero(a)) {
         // not a valid case
         return std::make_tuple(basal::nan, basal::nan, basal::nan);
     }
     if constexpr (debug::root) {
         std::cout << "Cubic Coefficients a=" << a << ", b=" << b << ", c=" << c << ", d=" << d << std::endl;
     }
-    // reduce b,c,d by a to do less math overall
-    b /= a;
-    c /= a;
-    d /= a;
-    // we'll apply this at the end again to move the roots back
-    // to the right place. the equations assume that the cubic is shifted
-    // such that the inflection is on x=0
-    precision shift = -b / 3.0_p;
-    // now that a = 1 these are much simpler
-    complex_ Q = ((3.0_p * c) - (b * b)) / 9.0_p;
-    complex_ R = ((b * ((9.0_p * c) - (2.0_p * b * b))) - (27.0_p * d)) / 54.0_p;
-    // this is the discriminant which tells us how may solutions there are
-    complex_ D = (Q * Q * Q) + (R * R);
+    working Q, R, D, shift, phi, x1, x2, x3;
+    cubic_terms(a, b, c, d, Q, R, D, shift);
+    x1 = cubic_first_root(Q, R, D, phi);
+    cubic_other_roots(Q, D, phi, x1, x2, x3);
+    // move the roots back from the inflection
+    x1 += shift;
+    x2 += shift;
+    x3 += shift;
     if constexpr (debug::root) {
-        std::cout << "Q: " << Q << std::endl;
-        std::cout << "R: " << R << std::endl;
-        std::cout << "D: " << D << std::endl;
+        std::cout << "Q: " << Q << ", R: " << R << ", D: " << D << std::endl;
+        std::cout << "Cubic Real Roots: x1=" << x1 << ", x2=" << x2 << ", x3=" << x3 << std::endl;
     }
-    precision x1 = basal::nan;
-    precision x2 = basal::nan;
-    precision x3 = basal::nan;
-    complex_ X1, X2, X3;
-    if (D.real() < 0) {
-        complex_ S_ = R + sqrt(D);
-        complex_ T_ = R - sqrt(D);
-        auto S3 = cbrt(S_);  // returns 3 roots
-        auto T3 = cbrt(T_);  // returns 3 roots
-        if constexpr (debug::root) {
-            std::cout << "one real and two complex (which does cross y=0)" << std::endl;
-            std::cout << "S0: " << std::get<0>(S3) << std::endl;
-            std::cout << "S1: " << std::get<1>(S3) << std::endl;
-            std::cout << "S2: " << std::get<2>(S3) << std::endl;
-            std::cout << "T0: " << std::get<0>(T3) << std::endl;
-            std::cout << "T1: " << std::get<1>(T3) << std::endl;
-            std::cout << "T2: " << std::get<2>(T3) << std::endl;
+    basal::exception::throw_if(std::isnan(x1) and std::isnan(x2) and std::isnan(x3), __FILE__, __LINE__,
+                               "Cubics always have at least 1 solution");
+    return std::make_tuple(static_cast<precision>(x1), static_cast<precision>(x2), static_cast<precision>(x3));
+}
+
+void cubic_roots(size_t count, precision const* const coefficients[4], precision* const roots[3]) {
+    statistics::get().cubic_roots += count;
+    for (size_t first = 0; first < count; first += lanes) {
+        working in[4][lanes];
+        working out[3][lanes];
+        working Q[lanes], R[lanes], D[lanes], phi[lanes], shift[lanes];
+        load<4>(count, first, coefficients, in);
+        for (size_t l = 0; l < lanes; l++) {
+            cubic_terms(in[0][l], in[1][l], in[2][l], in[3][l], Q[l], R[l], D[l], shift[l]);
         }
-        X1 = std::get<0>(S3) + std::get<0>(T3);  // real?
-        X2 = std::get<2>(S3) + std::get<1>(T3);  // swap conj pairs
-        X3 = std::get<1>(S3) + std::get<2>(T3);  // swap conj pairs
-        x1 = (not basal::nearly_zero(X1.imag()) ? basal::nan : (X1.real() + shift));
-        x2 = (not basal::nearly_zero(X2.imag()) ? basal::nan : (X2.real() + shift));
-        x3 = (not basal::nearly_zero(X3.imag()) ? basal::nan : (X3.real() + shift));
-    } else if (basal::nearly_zero(D.real())) {
-        auto R3 = cbrt(R);
-        if constexpr (debug::root) {
-            std::cout << "Either 2 real or at the zero inflection" << std::endl;
-            std::cout << "R0: " << std::get<0>(R3) << std::endl;
-            std::cout << "R1: " << std::get<1>(R3) << std::endl;
-            std::cout << "R2: " << std::get<2>(R3) << std::endl;
+        for (size_t l = 0; l < lanes; l++) {
+            out[0][l] = cubic_first_root(Q[l], R[l], D[l], phi[l]);
         }
-        X1 = 2.0_p * std::get<0>(R3);
-        X2 = -std::get<1>(R3);
-        X3 = -std::get<2>(R3);
-        x1 = X1.real() + shift;
-        x2 = X2.real() + shift;
-        x3 = X3.real() + shift;
-    } else if (D.real() > 0) {
-        precision S_ = R.real() + sqrt(D.real());
-        precision T_ = R.real() - sqrt(D.real());
-        precision S = std::cbrt(S_);
-        precision T = std::cbrt(T_);
-        if constexpr (debug::root) {
-            std::cout << "one real and two complex (which does not cross y=0)" << std::endl;
-            std::cout << "S: " << S << std::endl;
-            std::cout << "T: " << T << std::endl;
+        for (size_t l = 0; l < lanes; l++) {
+            cubic_other_roots(Q[l], D[l], phi[l], out[0][l], out[1][l], out[2][l]);
+            out[0][l] += shift[l];
+            out[1][l] += shift[l];
+            out[2][l] += shift[l];
         }
-        // the easiest but incomplete solution is to ignore the imaginary parts all together.
-        X1 = S + T;
-        x1 = X1.real() + shift;
-    }
-    if constexpr (debug::root) {
-        std::cout << "Cubic Complex Roots (no shift): X1=" << X1 << ", X2=" << X2 << ", X3=" << X3 << std::endl;
-        std::cout << "Cubic Real Roots: x1=" << x1 << ", x2=" << x2 << ", x3=" << x3 << std::endl;
+        store<3>(count, first, out, roots);
     }
-    basal::exception::throw_if(basal::is_nan(x1) and basal::is_nan(x2) and basal::is_nan(x3), __FILE__, __LINE__,
-                               "Cubics always have at least 1 solution");
-    return std::make_tuple(x1, x2, x3);
 }
 
-#if defined(USE_PRECISION_AS_FLOAT)
-#warning "Using float precision for quartic_roots, most solutions will not work"
-#endif
-
 std::tuple<precision, precision, precision, precision> quartic_roots(precision a, precision b, precision c, precision d,
                                                                      precision e) {
-    using namespace std::literals::complex_literals;
     statistics::get().quartic_roots++;
     if constexpr (debug::root) {
         std::cout << "Quartic Coefficients: a=" << a << ", b=" << b << ", c=" << c << ", d=" << d << ", e=" << e
                   << std::endl;
     }
-    if (basal::nearly_zero(a)) {
-        return std::make_tuple(basal::nan, basal::nan, basal::nan, basal::nan);
-    }
-    a /= a;
-    b /= a;
-    c /= a;
-    d /= a;
-    e /= a;
-    precision x1, x2, x3, x4;
-    x1 = x2 = x3 = x4 = basal::nan;
-
-    /// @internal A method based on Herbert E. Salzer "A Note on the Solution of Quartic Equations"
-    /// (Am. Math Society Proceedings, 1959).
-    ///
-
-    // solve the cubic to find a good value of z. this is the "resolvent cubic equation"
-    precision c1 = (b * d) - (4.0_p * e);
-    precision d1 = (e * ((4.0_p * c) - (b * b))) - (d * d);
-    auto cr = cubic_roots(1.0_p, -c, c1, d1);
-    // how to pick which root? any root? we'll pick left first then eliminate if NaN.
-    precision z = std::get<0>(cr);
-    z = basal::is_nan(z) ? std::get<1>(cr) : z;
-    z = basal::is_nan(z) ? std::get<2>(cr) : z;
-    complex_ mm = (0.25_p * b * b) - c + z;
-    complex_ m, n;
+    working B = b, C = c, D = d, E = e, Q, R, discriminant, phi, x1, x2, x3, x4;
+    quartic_terms(a, B, C, D, E, Q, R, discriminant);
+    // any root of the resolvent will do, the largest is always real
+    working const z = cubic_first_root(Q, R, discriminant, phi) + (C / 3.0);
+    working m, n, invalid;
+    quartic_factors(B, C, D, E, z, m, n, invalid);
+    // the roots of the factors are paired as (x1, x3) and (x2, x4)
+    quartic_pair(B, C, z, m, n, invalid, x1, x3);
+    quartic_pair(B, C, z, -m, -n, invalid, x2, x4);
+    x1 = quartic_polish(x1, B, C, D, E);
+    x2 = quartic_polish(x2, B, C, D, E);
+    x3 = quartic_polish(x3, B, C, D, E);
+    x4 = quartic_polish(x4, B, C, D, E);
     if constexpr (debug::root) {
-        std::cout << "z=" << z << ", m^2=" << mm << std::endl;
+        std::cout << "z=" << z << std::endl;
+        std::cout << "Quartic Real Roots: x1=" << x1 << ", x2=" << x2 << ", x3=" << x3 << ", x4=" << x4 << std::endl;
     }
-    m = std::sqrt(mm);
-    if (real(mm) > 0) {
-        n = (0.25_p * ((b * z) - (2.0_p * d))) / m;
-    } else if (basal::nearly_zero(real(mm))) {
-        complex_ none{0.0_p, 0.0_p};
-        n = ((0.25_p * z * z) - e) + none;
-        n = std::sqrt(n);
-    } else {
-        // all imaginary roots
-        if constexpr (debug::root) {
-            std::cout << "Quartic roots are all imaginary. Returning NaNs" << std::endl;
+    return std::make_tuple(static_cast<precision>(x1), static_cast<precision>(x2), static_cast<precision>(x3),
+                           static_cast<precision>(x4));
+}
+
+void quartic_roots(size_t count, precision const* const coefficients[5], precision* const roots[4], size_t* real) {
+    statistics::get().quartic_roots += count;
+    for (size_t first = 0; first < count; first += lanes) {
+        working in[5][lanes];
+        working out[4][lanes];
+        working Q[lanes], R[lanes], D[lanes], phi[lanes], z[lanes], m[lanes], n[lanes], invalid[lanes];
+        size_t found[lanes];
+        load<5>(count, first, coefficients, in);
+        for (size_t l = 0; l < lanes; l++) {
+            quartic_terms(in[0][l], in[1][l], in[2][l], in[3][l], in[4][l], Q[l], R[l], D[l]);
+        }
+        for (size_t l = 0; l < lanes; l++) {
+            z[l] = cubic_first_root(Q[l], R[l], D[l], phi[l]) + (in[2][l] / 3.0);
+        }
+        for (size_t l = 0; l < lanes; l++) {
+            quartic_factors(in[1][l], in[2][l], in[3][l], in[4][l], z[l], m[l], n[l], invalid[l]);
+        }
+        for (size_t l = 0; l < lanes; l++) {
+            quartic_pair(in[1][l], in[2][l], z[l], m[l], n[l], invalid[l], out[0][l], out[2][l]);
+        }
+        for (size_t l = 0; l < lanes; l++) {
+            quartic_pair(in[1][l], in[2][l], z[l], -m[l], -n[l], invalid[l], out[1][l], out[3][l]);
+        }
+        for (size_t k = 0; k < 4U; k++) {
+            for (size_t l = 0; l < lanes; l++) {
+                out[k][l] = quartic_polish(out[k][l], in[1][l], in[2][l], in[3][l], in[4][l]);
+            }
+        }
+        for (size_t l = 0; l < lanes; l++) {
+            found[l] = real_roots(out[0][l], out[1][l], out[2][l], out[3][l]);
+        }
+        store<4>(count, first, out, roots);
+        if (real != nullptr) {
+            size_t const used = std::min(lanes, count - first);
+            std::copy(found, found + used, real + first);
         }
-        return std::make_tuple(basal::nan, basal::nan, basal::nan, basal::nan);
-    }
-    if constexpr (debug::root) {
-        std::cout << "m=" << m << ", n=" << n << std::endl;
-    }
-    complex_ alpha = (0.5_p * b * b) - z - c;
-    complex_ beta = (4.0_p * n) - (b * m);
-    if constexpr (debug::root) {
-        std::cout << "α=" << alpha << ", β=" << beta << std::endl;
-    }
-    complex_ alpha_plus_beta = alpha + beta;
-    complex_ alpha_minus_beta = alpha - beta;
-    complex_ gamma = std::sqrt(alpha_plus_beta);
-    complex_ delta = std::sqrt(alpha_minus_beta);
-    if constexpr (debug::root) {
-        std::cout << "γ=" << gamma << ", δ=" << delta << std::endl;
-    }
-    complex_ X1 = ((-b * 0.5_p) + m + gamma) * 0.5_p;
-    complex_ X2 = ((-b * 0.5_p) - m + delta) * 0.5_p;
-    complex_ X3 = ((-b * 0.5_p) + m - gamma) * 0.5_p;
-    complex_ X4 = ((-b * 0.5_p) - m - delta) * 0.5_p;
-
-    if (alpha_plus_beta.real() >= 0.0) {
-        x1 = std::isinf(X1.real()) ? basal::nan : X1.real();
-        x3 = std::isinf(X3.real()) ? basal::nan : X3.real();
-    }
-    if (alpha_minus_beta.real() >= 0.0) {
-        x2 = std::isinf(X2.real()) ? basal::nan : X2.real();
-        x4 = std::isinf(X4.real()) ? basal::nan : X4.real();
-    }
-    if constexpr (debug::root) {
-        std::cout << "Quartic Complex Roots: X1=" << X1 << ", X2=" << X2 << ", X3=" << X3 << ", X4=" << X4 << std::endl;
-        std::cout << "Quartic Real Roots: x1=" << x1 << ", x2=" << x2 << ", x3=" << x3 << ", x4=" << x4 << std::endl;
     }
-    return std::make_tuple(x1, x2, x3, x4);
 }
 
 }  // namespace linalg
@@ -1,5 +1,7 @@
 #include <benchmark/benchmark.h>
 #include <linalg/linalg.hpp>
+#include <random>
+#include <vector>
 
 using namespace iso::literals;
 using namespace linalg;
@@ -115,4 +117,65 @@ static void BM_QuarticEquationSolver(benchmark::State& state) {
 }
 BENCHMARK(BM_QuarticEquationSolver);
 
-BENCHMARK_MAIN();
\ No newline at end of file
+/// Makes the coefficient arrays of a batch of equations, each with real roots which are made from random values
+static void batch_equations(size_t count, size_t degree, std::vector<precision> (&coefficients)[5]) {
+    std::mt19937 generator{2019U};
+    std::uniform_real_distribution<precision> dist{-4.0_p, 4.0_p};
+    for (size_t i = 0; i < count; i++) {
+        // (x - r0)(x - r1) then times (x - r2) and (x - r3) as needed
+        precision poly[5] = {1.0_p, 0.0_p, 0.0_p, 0.0_p, 0.0_p};
+        for (size_t order = 1; order <= degree; order++) {
+            precision const root = dist(generator);
+            for (size_t k = order; k > 0; k--) {
+                poly[k] -= root * poly[k - 1];
+            }
+        }
+        for (size_t k = 0; k <= degree; k++) {
+            coefficients[k].push_back(poly[k]);
+        }
+    }
+}
+
+/// Solves a batch of equations of a degree with one of the batch solvers
+template <size_t DEGREE, typename SOLVER>
+static void batch_solver(benchmark::State& state, SOLVER solver) {
+    size_t const count = static_cast<size_t>(state.range(0));
+    std::vector<precision> coefficients[5];
+    batch_equations(count, DEGREE, coefficients);
+    std::vector<precision> roots[4];
+    for (auto& values : roots) {
+        values.resize(count);
+    }
+    precision const* const in[] = {coefficients[0].data(), coefficients[1].data(), coefficients[2].data(),
+                                   coefficients[3].data(), coefficients[4].data()};
+    precision* const out[] = {roots[0].data(), roots[1].data(), roots[2].data(), roots[3].data()};
+    for (auto _ : state) {
+        solver(count, in, out);
+        benchmark::DoNotOptimize(roots[0].data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_QuadraticEquationBatch(benchmark::State& state) {
+    batch_solver<2>(state, [](size_t count, precision const* const in[], precision* const out[]) {
+        linalg::quadratic_roots(count, in, out);
+    });
+}
+BENCHMARK(BM_QuadraticEquationBatch)->RangeMultiplier(4)->Range(4, 1024);
+
+static void BM_CubicEquationBatch(benchmark::State& state) {
+    batch_solver<3>(state, [](size_t count, precision const* const in[], precision* const out[]) {
+        linalg::cubic_roots(count, in, out);
+    });
+}
+BENCHMARK(BM_CubicEquationBatch)->RangeMultiplier(4)->Range(4, 1024);
+
+static void BM_QuarticEquationBatch(benchmark::State& state) {
+    batch_solver<4>(state, [](size_t count, precision const* const in[], precision* const out[]) {
+        linalg::quartic_roots(count, in, out);
+    });
+}
+BENCHMARK(BM_QuarticEquationBatch)->RangeMultiplier(4)->Range(4, 1024);
+
+BENCHMARK_MAIN();
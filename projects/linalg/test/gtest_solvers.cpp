@@ -2,6 +2,7 @@
 
 #include <basal/basal.hpp>
 #include <linalg/linalg.hpp>
+#include <random>
 #include <vector>
 
 #include "linalg/gtest_helper.hpp"
@@ -119,7 +120,10 @@ TEST(LinalgExtraTests, CubicRoots02) {
     // @see https://www.desmos.com/calculator/nnybnwsnkn
     // for playing with the a,b,c,d dials and checking if D ==0  0 for these cases
     auto roots = cubic_roots(1, -5, 8, -4);
-    EXPECT_TRIPLE_TUPLE_EQ2(1, 2, roots);
+    // the repeated root is returned twice
+    EXPECT_NEAR(1, std::get<0>(roots), basal::epsilon);
+    EXPECT_NEAR(2, std::get<1>(roots), basal::epsilon);
+    EXPECT_NEAR(2, std::get<2>(roots), basal::epsilon);
 }
 
 #define EXPECT_TRIPLE_TUPLE_EQ3(A, B, C, tup)                                      \
@@ -283,4 +287,104 @@ TEST(LinalgExtraTests, QuarticRoots00) {
     // for playing with the a,b,c,d dials and checking if D < 0 for these cases
     auto roots = quartic_roots(0.6_p, -3.4_p, 5.8_p, -2.8_p, 1.4_p);
     EXPECT_QUAD_TUPLE_EQ0(roots);
-}
\ No newline at end of file
+}
+
+TEST(LinalgExtraTests, QuarticDoubleRoots) {
+    using namespace linalg;
+    // a double root in each of the factors, which rounding leaves a little complex unless it is allowed for
+    auto roots = quartic_roots(1, 0, -2, 0, 1);  // (x^2-1)^2
+    EXPECT_QUAD_TUPLE_EQ4(1, -1, 1, -1, roots);
+    roots = quartic_roots(1, 2, -3, -4, 4);  // (x-1)^2 (x+2)^2
+    EXPECT_QUAD_TUPLE_EQ4(1, -2, 1, -2, roots);
+    roots = quartic_roots(1, 0, -18, 0, 81);  // (x+3)^2 (x-3)^2
+    EXPECT_QUAD_TUPLE_EQ4(3, -3, 3, -3, roots);
+}
+
+namespace {
+/// Expects the root from a batch to be the root of the single solver (NaN or not)
+void expect_same_root(basal::precision expected, basal::precision actual) {
+    if (basal::is_nan(expected)) {
+        EXPECT_TRUE(basal::is_nan(actual)) << actual;
+    } else {
+        EXPECT_NEAR(expected, actual, basal::epsilon * std::max(1.0_p, std::abs(expected)));
+    }
+}
+}  // namespace
+
+TEST(LinalgExtraTests, BatchRootsMatchSingleRoots) {
+    using namespace linalg;
+    // not a multiple of the block size so the last block is partly used
+    constexpr size_t count = 37U;
+    std::mt19937 generator{2019U};
+    std::uniform_real_distribution<basal::precision> dist{-4.0_p, 4.0_p};
+    std::vector<basal::precision> coefficients[5];
+    for (auto& values : coefficients) {
+        values.resize(count);
+    }
+    for (size_t i = 0; i < count; i++) {
+        // every other equation is a quartic made from four distinct real roots, the rest are random
+        basal::precision const r0 = dist(generator);
+        basal::precision const r[4] = {r0, r0 + 0.5_p, r0 + 1.5_p, r0 + 3.0_p};
+        basal::precision const pairs = (r[0] * r[1]) + (r[0] * r[2]) + (r[0] * r[3]) + (r[1] * r[2]) + (r[1] * r[3])
+                                       + (r[2] * r[3]);
+        basal::precision const triples
+            = (r[0] * r[1] * r[2]) + (r[0] * r[1] * r[3]) + (r[0] * r[2] * r[3]) + (r[1] * r[2] * r[3]);
+        bool const from_roots = (i % 2U) == 0U;
+        coefficients[0][i] = from_roots ? 1.0_p : dist(generator);
+        coefficients[1][i] = from_roots ? -(r[0] + r[1] + r[2] + r[3]) : dist(generator);
+        coefficients[2][i] = from_roots ? pairs : dist(generator);
+        coefficients[3][i] = from_roots ? -triples : dist(generator);
+        coefficients[4][i] = from_roots ? (r[0] * r[1] * r[2] * r[3]) : dist(generator);
+    }
+    // the pinned equations from above
+    basal::precision const pinned[][5] = {
+        {1, -7, 5, 31, -30}, {1, -4, 6, -4, -3}, {0.6_p, -3.4_p, 5.8_p, -2.8_p, 1.4_p},
+        // with double roots in both factors
+        {1, 0, -2, 0, 1},    {1, 2, -3, -4, 4},  {1, 0, -18, 0, 81}};
+    size_t const pinned_real[] = {4U, 2U, 0U, 4U, 4U, 4U};
+    for (size_t p = 0; p < basal::dimof(pinned); p++) {
+        for (size_t k = 0; k < 5U; k++) {
+            coefficients[k][p] = pinned[p][k];
+        }
+    }
+    basal::precision const* const in[] = {coefficients[0].data(), coefficients[1].data(), coefficients[2].data(),
+                                          coefficients[3].data(), coefficients[4].data()};
+    std::vector<basal::precision> roots[4];
+    for (auto& values : roots) {
+        values.resize(count);
+    }
+    basal::precision* const out[] = {roots[0].data(), roots[1].data(), roots[2].data(), roots[3].data()};
+    std::vector<size_t> real(count);
+
+    quadratic_roots(count, in, out);
+    for (size_t i = 0; i < count; i++) {
+        auto const [x1, x2] = quadratic_roots(in[0][i], in[1][i], in[2][i]);
+        expect_same_root(x1, roots[0][i]);
+        expect_same_root(x2, roots[1][i]);
+    }
+    cubic_roots(count, in, out);
+    for (size_t i = 0; i < count; i++) {
+        auto const [x1, x2, x3] = cubic_roots(in[0][i], in[1][i], in[2][i], in[3][i]);
+        expect_same_root(x1, roots[0][i]);
+        expect_same_root(x2, roots[1][i]);
+        expect_same_root(x3, roots[2][i]);
+    }
+    quartic_roots(count, in, out, real.data());
+    for (size_t i = 0; i < count; i++) {
+        auto const [x1, x2, x3, x4] = quartic_roots(in[0][i], in[1][i], in[2][i], in[3][i], in[4][i]);
+        expect_same_root(x1, roots[0][i]);
+        expect_same_root(x2, roots[1][i]);
+        expect_same_root(x3, roots[2][i]);
+        expect_same_root(x4, roots[3][i]);
+        size_t const found = (basal::is_nan(x1) ? 0U : 1U) + (basal::is_nan(x2) ? 0U : 1U)
+                             + (basal::is_nan(x3) ? 0U : 1U) + (basal::is_nan(x4) ? 0U : 1U);
+        EXPECT_EQ(found, real[i]);
+        if ((i % 2U) == 0U and i >= basal::dimof(pinned)) {
+            // made from four real roots
+            EXPECT_EQ(4U, real[i]);
+        }
+    }
+    for (size_t p = 0; p < basal::dimof(pinned); p++) {
+        EXPECT_EQ(pinned_real[p], real[p]);
+    }
+}
@@ -0,0 +1,132 @@
+///
+/// @file
+/// @brief Renders the animation of a world into numbered image files without any UI
+///
+
+#include <basal/module.hpp>
+#include <basal/options.hpp>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <raytrace/raytrace.hpp>
+
+#include "world.hpp"
+
+using namespace basal::literals;
+
+struct Parameters {
+    std::string dim_name;
+    size_t subsamples;
+    size_t reflections;
+    std::string module;
+    precision fps;
+    size_t first;
+    size_t count;
+    std::string prefix;
+    std::string extension;
+    size_t queue;
+    bool tone_mapping;
+    bool roulette;
+};
+
+int main(int argc, char* argv[]) {
+    Parameters params;
+    bool verbose = false;
+
+    basal::options::config opts[] = {
+        {"-d", "--dims", std::string("QVGA"), "Use text video format like VGA or 2K"},
+        {"-b", "--subsamples", (size_t)1, "Number of subsamples"},
+        {"-r", "--reflections", (size_t)4, "Reflection Depth"},
+        {"-v", "--verbose", false, "Enables showing the early debugging"},
+        {"-m", "--module", std::string(""), "Module to load"},
+        {"-s", "--fps", 24.0_p, "Frames per second"},
+        {"-i", "--first", (size_t)0, "The first frame to render (to split a sequence across processes)"},
+        {"-n", "--count", (size_t)0, "The number of frames to render (0 renders to the end)"},
+        {"-p", "--prefix", std::string("frame_"), "The start of each frame's filename"},
+        {"-x", "--extension", std::string(".ppm"), "The format of the frames (.ppm, .tga, .pfm or .exr)"},
+        {"-q", "--queue", (size_t)2, "The number of rendered frames which may wait to be saved"},
+        {"-t", "--tone-mapping", false, "Whether to apply tone mapping to the frames"},
+        {"-o", "--roulette", false, "End deep reflections by russian roulette instead of the adaptive threshold"},
+    };
+
+    basal::options::process(basal::dimof(opts), opts, argc, argv);
+    basal::exit_unless(basal::options::find(opts, "--dims", params.dim_name), __FILE__, __LINE__,
+                       "Must have a text value");
+    basal::exit_unless(basal::options::find(opts, "--subsamples", params.subsamples), __FILE__, __LINE__,
+                       "Must have some number of subsamples");
+    basal::exit_unless(basal::options::find(opts, "--reflections", params.reflections), __FILE__, __LINE__,
+                       "Must have some number of reflections");
+    basal::exit_unless(basal::options::find(opts, "--verbose", verbose), __FILE__, __LINE__,
+                       "Must be able to assign bool");
+    basal::exit_unless(basal::options::find(opts, "--module", params.module), __FILE__, __LINE__,
+                       "Must choose a module to load");
+    basal::exit_unless(basal::options::find(opts, "--fps", params.fps), __FILE__, __LINE__,
+                       "Must be able to get the FPS value");
+    basal::exit_unless(basal::options::find(opts, "--first", params.first), __FILE__, __LINE__,
+                       "Must have a first frame");
+    basal::exit_unless(basal::options::find(opts, "--count", params.count), __FILE__, __LINE__,
+                       "Must have a number of frames");
+    basal::exit_unless(basal::options::find(opts, "--prefix", params.prefix), __FILE__, __LINE__,
+                       "Must have a text value");
+    basal::exit_unless(basal::options::find(opts, "--extension", params.extension), __FILE__, __LINE__,
+                       "Must have a text value");
+    basal::exit_unless(basal::options::find(opts, "--queue", params.queue), __FILE__, __LINE__,
+                       "Must have a queue depth");
+    basal::exit_unless(basal::options::find(opts, "--tone-mapping", params.tone_mapping), __FILE__, __LINE__,
+                       "Must be able to assign bool");
+    basal::exit_unless(basal::options::find(opts, "--roulette", params.roulette), __FILE__, __LINE__,
+                       "Must be able to assign bool");
+    basal::options::print(basal::dimof(opts), opts);
+
+    basal::module mod(params.module.c_str());
+    basal::exit_unless(mod.is_loaded(), __FILE__, __LINE__, "Must have loaded module");
+
+    // get the symbol to load wth
+    auto get_world = mod.get_symbol<raytrace::world_getter>("get_world");
+    basal::exit_unless(get_world != nullptr, __FILE__, __LINE__, "Must find module to load");
+
+    // creates a local reference to the object
+    raytrace::world& world = *get_world();
+    auto [width, height] = fourcc::dimensions(params.dim_name);
+    basal::exit_unless(width > 0 and height > 0, __FILE__, __LINE__, "Must have valid dimensions");
+
+    // the one scene renders every frame so its hierarchy is only built once
+    raytrace::scene scene;
+    scene.set_background_mapper(std::bind(&raytrace::world::background, &world, std::placeholders::_1));
+    world.add_to(scene);
+    if (verbose) {
+        scene.print(std::cout, world.window_name().c_str());
+    }
+    scene.set_ambient_light(world.ambient());
+    if (params.roulette) {
+        scene.set_termination(raytrace::Termination::RussianRoulette);
+    }
+
+    raytrace::animation::Batch::Settings settings;
+    settings.height = height;
+    settings.width = width;
+    settings.number_of_samples = params.subsamples;
+    settings.reflection_depth = params.reflections;
+    settings.tone_mapping = params.tone_mapping;
+    settings.prefix = params.prefix;
+    settings.extension = params.extension;
+    settings.first = params.first;
+    settings.last = (params.count > 0U) ? (params.first + params.count) : std::numeric_limits<size_t>::max();
+    settings.queue_depth = params.queue;
+    raytrace::animation::Batch batch{scene, settings};
+
+    raytrace::animation::anchors anchors = world.get_anchors();
+    raytrace::animation::Animator animator{params.fps, anchors};
+    auto const start = std::chrono::steady_clock::now();
+    auto previous = start;
+    size_t const saved = batch.render(animator, [&](size_t frame, raytrace::camera const&) {
+        auto const now = std::chrono::steady_clock::now();
+        std::chrono::duration<double> const diff = now - previous;
+        previous = now;
+        std::cout << "Rendered " << batch.filename(frame) << " in " << diff.count() << " seconds" << std::endl;
+    });
+    std::chrono::duration<double> const diff = std::chrono::steady_clock::now() - start;
+    std::cout << "Saved " << saved << " frames in " << diff.count() << " seconds" << std::endl;
+    std::cout << raytrace::statistics::get() << std::endl;
+    return 0;
+}
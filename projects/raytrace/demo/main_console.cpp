@@ -16,6 +16,7 @@
 #include <chrono>
 #include <functional>
 #include <iomanip>
+#include <mutex>
 #include <raytrace/raytrace.hpp>
 #include <thread>
 
@@ -32,6 +33,8 @@ struct Parameters {
     precision fov;
     std::string module;
     size_t mask_threshold;
+    bool roulette;
+    bool costs;
 };
 
 enum class State : char {
@@ -153,6 +156,8 @@ int main(int argc, char* argv[]) {
         {"-m", "--module", std::string(""), "Module to load"},
         {"-a", "--aaa", (size_t)raytrace::image::AAA_MASK_DISABLED,
          "Adaptive Anti-Aliasing Threshold value (255 disables)"},
+        {"-o", "--roulette", false, "End deep reflections by russian roulette instead of the adaptive threshold"},
+        {"-c", "--costs", false, "Writes the cost heatmaps and the trace of the tiles next to the rendered image"},
     };
 
     basal::options::process(basal::dimof(opts), opts, argc, argv);
@@ -169,6 +174,10 @@ int main(int argc, char* argv[]) {
                        "Must choose a module to load");
     basal::exit_unless(basal::options::find(opts, "--aaa", params.mask_threshold), __FILE__, __LINE__,
                        "Must be get value");
+    basal::exit_unless(basal::options::find(opts, "--roulette", params.roulette), __FILE__, __LINE__,
+                       "Must be able to assign bool");
+    basal::exit_unless(basal::options::find(opts, "--costs", params.costs), __FILE__, __LINE__,
+                       "Must be able to assign bool");
     basal::options::print(basal::dimof(opts), opts);
 
     basal::module mod(params.module.c_str());
@@ -186,24 +195,19 @@ int main(int argc, char* argv[]) {
 #if defined(RENDER_TO_CONSOLE)
     basal::exit_unless(console.get_width() % 2 == 0, __FILE__, __LINE__, "Must be an even console width");
 #endif
-    // The completion data will be stored in here, a bool per line.
+    // follows which lines are complete from the tile notifications
 #if defined(RENDER_TO_CONSOLE)
-    std::vector<bool> completed(console.get_height() * 2);
+    raytrace::line_progress progress(console.get_height() * 2, console.get_width());
 #else
-    std::vector<bool> completed(height);
+    raytrace::line_progress progress(height, width);
 #endif
-    std::fill(completed.begin(), completed.end(), false);
     bool running = true;
 
     auto progress_bar = [&]() -> void {
         while (running) {
-            size_t count = 0;
-            std::for_each(completed.begin(), completed.end(), [&](bool p) -> bool {
-                count += (p ? 1 : 0);
-                return p;
-            });
-            precision percentage = 100.0_p * count / completed.size();
-            bool done = (count == completed.size());
+            size_t count = progress.complete_lines();
+            precision percentage = 100.0_p * count / progress.lines();
+            bool done = (count == progress.lines());
             if (state == State::MENU) {
                 size_t h = console.get_height() - 2;  // account for border
                 console.print(h - 1, 2, " >> PROGRESS [ %0.3lf %%]", done ? 100.0_p : percentage);
@@ -241,14 +245,17 @@ int main(int argc, char* argv[]) {
         }
     };
 
-    auto row_notifier = [&](size_t row_index, bool is_complete) -> void { completed[row_index] = is_complete; };
-
     raytrace::scene scene;
 #if defined(RENDER_TO_CONSOLE)
     raytrace::camera view(console.get_height() * 2, console.get_width(), iso::degrees(params.fov));
 #else
     raytrace::camera view(height, width, iso::degrees(params.fov));
 #endif
+
+    auto tile_notifier = [&](raytrace::tile const& region, bool is_complete) -> void {
+        progress.update(region, is_complete);
+    };
+
     raytrace::vector looking = (world.looking_at() - world.looking_from()).normalized();
     raytrace::point image_plane_principal_point = world.looking_from() + looking;
     view.move_to(world.looking_from(), image_plane_principal_point);
@@ -259,6 +266,10 @@ int main(int argc, char* argv[]) {
         scene.print(std::cout, world.window_name().c_str());
     }
     scene.set_ambient_light(world.ambient());
+    if (params.roulette) {
+        scene.set_termination(raytrace::Termination::RussianRoulette);
+    }
+    scene.set_profiling(params.costs);
 
     do {
         if (state == State::MENU) {
@@ -308,7 +319,7 @@ int main(int argc, char* argv[]) {
                     console.print(6, 2, "START TIME: %s, RENDERING TIME: ??? secs", time_string);
                     std::thread bar_thread(progress_bar);  // thread starts
                     try {
-                        scene.render(view, world.output_filename(), params.subsamples, params.reflections, row_notifier,
+                        scene.render(view, world.output_filename(), params.subsamples, params.reflections, tile_notifier,
                                      params.mask_threshold);
                     } catch (basal::exception const& e) {
                         std::cout << "Caught basal::exception in scene.render()! " << std::endl;
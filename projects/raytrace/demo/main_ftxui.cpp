@@ -15,6 +15,7 @@
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <raytrace/raytrace.hpp>
@@ -45,6 +46,8 @@ struct Parameters {
     precision fov;
     std::string module;
     size_t mask_threshold;
+    bool progressive;
+    bool roulette;
 };
 
 struct FrameSnapshot {
@@ -191,6 +194,9 @@ int main(int argc, char* argv[]) {
         {"-m", "--module", std::string(""), "Module to load"},
         {"-a", "--aaa", (size_t)raytrace::image::AAA_MASK_DISABLED,
          "Adaptive Anti-Aliasing Threshold value (255 disables)"},
+        {"-p", "--progressive", false,
+         "Refine the view one sample per pixel at a time until the sub-samples are reached"},
+        {"-o", "--roulette", false, "End deep reflections by russian roulette instead of the adaptive threshold"},
     };
 
     basal::options::process(basal::dimof(opts), opts, argc, argv);
@@ -205,6 +211,10 @@ int main(int argc, char* argv[]) {
                        "Must choose a module to load");
     basal::exit_unless(basal::options::find(opts, "--aaa", params.mask_threshold), __FILE__, __LINE__,
                        "Must be get value");
+    basal::exit_unless(basal::options::find(opts, "--progressive", params.progressive), __FILE__, __LINE__,
+                       "Must be able to assign bool");
+    basal::exit_unless(basal::options::find(opts, "--roulette", params.roulette), __FILE__, __LINE__,
+                       "Must be able to assign bool");
     basal::options::print(basal::dimof(opts), opts);
 
     basal::module mod(params.module.c_str());
@@ -218,6 +228,9 @@ int main(int argc, char* argv[]) {
     scene.set_background_mapper(std::bind(&raytrace::world::background, &world, _1));
     world.add_to(scene);
     scene.set_ambient_light(world.ambient());
+    if (params.roulette) {
+        scene.set_termination(raytrace::Termination::RussianRoulette);
+    }
     if (verbose) {
         scene.print(std::cout, world.window_name().c_str());
     }
@@ -281,15 +294,27 @@ int main(int argc, char* argv[]) {
     };
 
     auto render_worker = std::thread([&]() {
+        // the camera is kept between renders so that the progressive passes can accumulate into its capture
+        std::unique_ptr<raytrace::camera> camera;
+        std::chrono::steady_clock::time_point start;
         while (not shutdown_requested) {
             size_t next_width = 0;
             size_t next_height = 0;
             CameraPose next_pose;
             std::string started_at;
+            // a progressive render keeps adding passes until it has all the sub-samples or something changes
+            bool const refining
+                = params.progressive and camera and scene.accumulated_passes() < params.subsamples;
+            bool restart = false;
             {
                 std::scoped_lock lock(state_mutex);
-                if (render_in_flight || not render_requested) {
+                if (render_in_flight || (not render_requested and not refining)) {
                     next_width = 0;
+                } else if (not render_requested) {
+                    render_in_flight = true;
+                    next_width = camera->capture.width;
+                    next_height = camera->capture.height;
+                    started_at = frame.started_at;
                 } else {
                     if (viewport_width == 0 || viewport_height == 0) {
                         next_width = 0;
@@ -298,6 +323,7 @@ int main(int argc, char* argv[]) {
                     }
                     render_requested = false;
                     render_in_flight = true;
+                    restart = true;
                     next_width = viewport_width;
                     next_height = viewport_height;
                     next_pose = pose;
@@ -325,38 +351,49 @@ int main(int argc, char* argv[]) {
             }
 
             try {
-                raytrace::camera camera(next_height, next_width, iso::degrees(params.fov));
-                camera.move_to(next_pose.from, ComputeLookAt(next_pose));
-                auto start = std::chrono::steady_clock::now();
-                auto row_notifier = [&](size_t row_index, bool is_complete) {
-                    std::scoped_lock lock(state_mutex);
-                    if (row_index >= frame.total_rows) {
-                        return;
-                    }
-                    if (is_complete) {
-                        frame.completed_rows = std::min(frame.total_rows, frame.completed_rows + 1U);
+                if (restart) {
+                    if (not camera or camera->capture.width != next_width or camera->capture.height != next_height) {
+                        camera = std::make_unique<raytrace::camera>(next_height, next_width, iso::degrees(params.fov));
                     }
+                    camera->move_to(next_pose.from, ComputeLookAt(next_pose));
+                    // even a re-render of the same pose starts the passes over
+                    scene.reset_accumulation();
+                    start = std::chrono::steady_clock::now();
+                }
+                // the progress is counted in whole lines worth of finished tile pixels
+                size_t finished_pixels = 0U;
+                auto tile_notifier = [&](raytrace::tile const& region, bool is_complete) {
+                    std::scoped_lock lock(state_mutex);
+                    finished_pixels = is_complete ? finished_pixels + (region.width * region.height) : 0U;
+                    frame.completed_rows = std::min(frame.total_rows, finished_pixels / next_width);
                 };
-                scene.render(camera, std::string{}, params.subsamples, params.reflections, row_notifier,
-                             static_cast<uint8_t>(params.mask_threshold), false, false);
+                size_t passes = params.subsamples;
+                if (params.progressive) {
+                    passes = scene.render_pass(*camera, params.reflections, tile_notifier, false);
+                } else {
+                    scene.render(*camera, std::string{}, params.subsamples, params.reflections, tile_notifier,
+                                 static_cast<uint8_t>(params.mask_threshold), false, false);
+                }
 
                 FrameSnapshot next_frame;
-                next_frame.width = camera.capture.width;
-                next_frame.height = camera.capture.height;
+                next_frame.width = camera->capture.width;
+                next_frame.height = camera->capture.height;
                 next_frame.has_image = true;
-                next_frame.rendering = false;
+                next_frame.rendering = passes < params.subsamples;
                 next_frame.completed_rows = next_frame.height;
                 next_frame.total_rows = next_frame.height;
                 next_frame.started_at = started_at;
                 next_frame.render_seconds
                     = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
-                next_frame.status = "Ready";
+                next_frame.status = next_frame.rendering ? ("Pass " + std::to_string(passes) + " of "
+                                                            + std::to_string(params.subsamples))
+                                                         : "Ready";
                 next_frame.pixels.reserve(next_frame.width * next_frame.height);
                 for (size_t y = 0; y < next_frame.height; ++y) {
                     for (size_t x = 0; x < next_frame.width; ++x) {
                         raytrace::color value(
-                            camera.capture.at(y, x).components.r, camera.capture.at(y, x).components.g,
-                            camera.capture.at(y, x).components.b, camera.capture.at(y, x).components.i);
+                            camera->capture.at(y, x).components.r, camera->capture.at(y, x).components.g,
+                            camera->capture.at(y, x).components.b, camera->capture.at(y, x).components.i);
                         value.clamp();
                         value.ToEncoding(fourcc::Encoding::GammaCorrected);
                         next_frame.pixels.push_back(value.to_<fourcc::PixelFormat::RGB8>());
@@ -445,12 +482,13 @@ int main(int argc, char* argv[]) {
         add_info("Yaw/Pitch: ", FormatDouble(pose_snapshot.yaw, 1) + "/" + FormatDouble(pose_snapshot.pitch, 1));
         add_info("Objects/Lights: ",
                  std::to_string(scene.number_of_objects()) + "/" + std::to_string(scene.number_of_lights()));
-        add_info("Rays Cast: ", std::to_string(raytrace::statistics::get().cast_rays_from_camera));
-        add_info("Intersections: ", std::to_string(raytrace::statistics::get().intersections_with_objects));
-        add_info("Bounced/Xmit: ", std::to_string(raytrace::statistics::get().bounced_rays) + "/"
-                                       + std::to_string(raytrace::statistics::get().transmitted_rays));
-        add_info("Missed/Bounds: ", std::to_string(raytrace::statistics::get().missed_rays) + "/"
-                                        + std::to_string(raytrace::statistics::get().intersections_with_bounds));
+        raytrace::statistics const counted = raytrace::statistics::get();
+        add_info("Rays Cast: ", std::to_string(counted.cast_rays_from_camera));
+        add_info("Intersections: ", std::to_string(counted.intersections_with_objects));
+        add_info("Bounced/Xmit: ",
+                 std::to_string(counted.bounced_rays) + "/" + std::to_string(counted.transmitted_rays));
+        add_info("Missed/Bounds: ",
+                 std::to_string(counted.missed_rays) + "/" + std::to_string(counted.intersections_with_bounds));
         add_info("Geometry: ", std::to_string(geometry::statistics::get().dot_operations) + " dot, "
                                    + std::to_string(geometry::statistics::get().cross_products) + " cross");
         if (not snapshot.started_at.empty()) {
@@ -9,6 +9,7 @@
 #include <basal/options.hpp>
 #include <functional>
 #include <linalg/trackbar.hpp>
+#include <mutex>
 #include <opencv2/opencv.hpp>
 #include <raytrace/raytrace.hpp>
 #include <thread>
@@ -147,9 +148,8 @@ int main(int argc, char* argv[]) {
             }
             scene.set_ambient_light(ambient);
 
-            // The completion data will be stored in here, a bool per line.
-            std::vector<bool> completed(height);
-            std::fill(completed.begin(), completed.end(), false);
+            // follows which lines are complete from the tile notifications
+            raytrace::line_progress progress(height, width);
             bool running = true;
             auto start = std::chrono::steady_clock::now();
             auto progress_bar = [&]() -> void {
@@ -157,18 +157,14 @@ int main(int argc, char* argv[]) {
                     static constexpr bool use_bar = false;
                     if constexpr (use_bar) {
                         fprintf(stdout, "\r [");
-                        for (size_t i = 0; i < completed.size(); i++) {
-                            fprintf(stdout, "%s", completed[i] ? "#" : "_");
+                        for (size_t i = 0; i < progress.lines(); i++) {
+                            fprintf(stdout, "%s", progress.is_complete(i) ? "#" : "_");
                         }
                         fprintf(stdout, "]");
                     } else {
-                        size_t count = 0;
-                        std::for_each(completed.begin(), completed.end(), [&](bool p) -> bool {
-                            count += (p ? 1 : 0);
-                            return p;
-                        });
-                        double percentage = 100.0_p * count / completed.size();
-                        bool done = (count == completed.size());
+                        size_t count = progress.complete_lines();
+                        double percentage = 100.0_p * count / progress.lines();
+                        bool done = (count == progress.lines());
                         fprintf(stdout,
                                 "\r[ %0.3lf %%] rays cast: %zu dots: %zu cross: %zu intersects: %zu bounced: %zu "
                                 "transmitted: %zu missed: %zu %s ",
@@ -185,7 +181,9 @@ int main(int argc, char* argv[]) {
                 fprintf(stdout, "\r\n");
             };
 
-            auto row_notifier = [&](size_t row_index, bool is_complete) -> void { completed[row_index] = is_complete; };
+            auto tile_notifier = [&](raytrace::tile const& region, bool is_complete) -> void {
+                progress.update(region, is_complete);
+            };
 
             if (first_render) {
                 render_image.setTo(cv::Scalar(128, 128, 128));
@@ -203,7 +201,7 @@ int main(int argc, char* argv[]) {
 
             std::thread bar_thread(progress_bar);  // thread starts
             try {
-                scene.render(view, world.output_filename(), params.subsamples, params.reflections, row_notifier,
+                scene.render(view, world.output_filename(), params.subsamples, params.reflections, tile_notifier,
                              params.mask_threshold);
             } catch (basal::exception const& e) {
                 std::cout << "Caught basal::exception in scene.render()! " << std::endl;
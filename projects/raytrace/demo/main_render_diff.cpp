@@ -0,0 +1,137 @@
+///
+/// @file
+/// @brief Compares two renders of the same frame (like a double and a float build of a world) and reports the error
+///
+
+#include <algorithm>
+#include <basal/basal.hpp>
+#include <basal/options.hpp>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fourcc/image.hpp>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace basal::literals;
+
+namespace {
+
+/// A render as rows of red, green and blue values in [0, 1] (or beyond for floating point files)
+struct Render {
+    size_t width{0U};
+    size_t height{0U};
+    std::vector<float> values;
+};
+
+/// Reads the next number of a PNM header, skipping comments
+bool read_header_value(FILE* fp, double& value) {
+    int c = fgetc(fp);
+    while (c == '#' or std::isspace(c)) {
+        if (c == '#') {
+            while (c != '\n' and c != EOF) {
+                c = fgetc(fp);
+            }
+        }
+        c = fgetc(fp);
+    }
+    ungetc(c, fp);
+    return fscanf(fp, "%lf", &value) == 1;
+}
+
+/// Loads a binary PPM (P6) or a color PFM (PF), the formats the renders are saved in
+bool load(std::string const& filename, Render& render) {
+    FILE* fp = fopen(filename.c_str(), "rb");
+    if (fp == nullptr) {
+        return false;
+    }
+    char magic[3] = {0, 0, 0};
+    double width = 0.0, height = 0.0, scale = 0.0;
+    bool read = fread(magic, 1U, 2U, fp) == 2U and read_header_value(fp, width) and read_header_value(fp, height)
+                and read_header_value(fp, scale) and fgetc(fp) != EOF;  // the single whitespace before the data
+    if (read) {
+        render.width = static_cast<size_t>(width);
+        render.height = static_cast<size_t>(height);
+        render.values.resize(render.width * render.height * 3U);
+    }
+    if (read and std::strcmp(magic, "P6") == 0 and scale == 255.0) {
+        std::vector<uint8_t> bytes(render.values.size());
+        read = fread(bytes.data(), 1U, bytes.size(), fp) == bytes.size();
+        for (size_t i = 0; read and i < bytes.size(); i++) {
+            render.values[i] = static_cast<float>(bytes[i]) / 255.0f;
+        }
+    } else if (read and std::strcmp(magic, "PF") == 0 and scale < 0.0) {
+        // little endian rows from the bottom up
+        size_t const row = render.width * 3U;
+        for (size_t y = render.height; read and y > 0U; y--) {
+            read = fread(&render.values[(y - 1U) * row], sizeof(float), row, fp) == row;
+        }
+    } else {
+        read = false;
+    }
+    fclose(fp);
+    return read;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string reference_name;
+    std::string candidate_name;
+    std::string output_name;
+    basal::precision tolerance = 0.0_p;
+
+    basal::options::config opts[] = {
+        {"-r", "--reference", std::string(""), "The reference render (.ppm or .pfm), like one from a double build"},
+        {"-c", "--candidate", std::string(""), "The render to compare (.ppm or .pfm), like one from a float build"},
+        {"-o", "--output", std::string(""), "Writes the absolute difference of each pixel to this .pfm"},
+        {"-t", "--tolerance", 0.0_p, "Fails when the root mean square error is above this (0 only reports)"},
+    };
+
+    basal::options::process(basal::dimof(opts), opts, argc, argv);
+    basal::exit_unless(basal::options::find(opts, "--reference", reference_name), __FILE__, __LINE__,
+                       "Must have a reference render");
+    basal::exit_unless(basal::options::find(opts, "--candidate", candidate_name), __FILE__, __LINE__,
+                       "Must have a candidate render");
+    basal::exit_unless(basal::options::find(opts, "--output", output_name), __FILE__, __LINE__,
+                       "Must have a text value");
+    basal::exit_unless(basal::options::find(opts, "--tolerance", tolerance), __FILE__, __LINE__,
+                       "Must have a tolerance");
+    basal::options::print(basal::dimof(opts), opts);
+
+    Render reference, candidate;
+    basal::exit_unless(load(reference_name, reference), __FILE__, __LINE__, "Must load the reference render");
+    basal::exit_unless(load(candidate_name, candidate), __FILE__, __LINE__, "Must load the candidate render");
+    basal::exit_unless(reference.width == candidate.width and reference.height == candidate.height, __FILE__,
+                       __LINE__, "Must compare renders of the same size");
+
+    fourcc::image<fourcc::PixelFormat::RGBf> difference{reference.height, reference.width};
+    double sum2 = 0.0;
+    double largest = 0.0;
+    size_t changed = 0U;
+    for (size_t y = 0; y < reference.height; y++) {
+        for (size_t x = 0; x < reference.width; x++) {
+            size_t const index = (y * reference.width + x) * 3U;
+            bool moved = false;
+            for (size_t c = 0; c < 3U; c++) {
+                double const error = std::abs(double(reference.values[index + c]) - candidate.values[index + c]);
+                difference.at(y, x).channels[c] = static_cast<float>(error);
+                sum2 += error * error;
+                largest = std::max(largest, error);
+                moved = moved or error > 0.5 / 255.0;  // more than the rounding of an 8 bit channel
+            }
+            changed += moved ? 1U : 0U;
+        }
+    }
+    double const rmse = std::sqrt(sum2 / static_cast<double>(reference.values.size()));
+    double const psnr = (rmse > 0.0) ? 20.0 * std::log10(1.0 / rmse) : std::numeric_limits<double>::infinity();
+    std::cout << "RMSE " << rmse << " PSNR " << psnr << " dB max " << largest << " changed " << changed << " of "
+              << reference.width * reference.height << " pixels" << std::endl;
+    if (not output_name.empty()) {
+        basal::exit_unless(difference.save(output_name), __FILE__, __LINE__, "Must save the difference");
+    }
+    return (tolerance > 0.0_p and rmse > tolerance) ? 1 : 0;
+}
@@ -17,6 +17,7 @@
 #include <basal/module.hpp>
 #include <basal/options.hpp>
 #include <functional>
+#include <memory>
 #include <raytrace/raytrace.hpp>
 #include <thread>
 #include <mutex>
@@ -37,8 +38,41 @@ struct Parameters {
     bool filter;
     bool tone_mapping;
     bool go;
+    bool progressive;
+    bool roulette;
+    bool costs;
 };
 
+/// Copies the capture into the window surface (converting to sRGB) at the horizontal offset
+static bool show(SDL_Surface *surface, raytrace::image const &capture, size_t view_offset) {
+    bool should_lock = SDL_MUSTLOCK(surface);
+    if (should_lock) {
+        if (0 != SDL_LockSurface(surface)) {
+            printf("Failed to lock surface!\n");
+            return false;
+        }
+    }
+    capture.for_each([&](size_t y, size_t x, raytrace::image::PixelStorageType const &pixel) -> void {
+        uint8_t *pixels = reinterpret_cast<uint8_t *>(surface->pixels);
+        size_t offset = (y * surface->pitch) + (x * sizeof(fourcc::bgra)) + (view_offset * sizeof(fourcc::bgra));
+        // clamp, then convert to sRGB
+        raytrace::color value(pixel.components.r, pixel.components.g, pixel.components.b, pixel.components.i);
+        value.clamp();
+        value.ToEncoding(fourcc::Encoding::GammaCorrected);
+        auto srgb = value.to_<fourcc::PixelFormat::RGB8>();
+
+        // B G R A order
+        pixels[offset + 0u] = srgb.components.b;
+        pixels[offset + 1u] = srgb.components.g;
+        pixels[offset + 2u] = srgb.components.r;
+        pixels[offset + 3u] = 0u;
+    });
+    if (should_lock) {
+        SDL_UnlockSurface(surface);
+    }
+    return true;
+}
+
 int main(int argc, char *argv[]) {
     Parameters params;
     bool verbose = false;
@@ -61,7 +95,11 @@ int main(int argc, char *argv[]) {
            {"-s", "--separation", 0.0_p, "Stereo Camera view separation"},
            {"-e", "--filter", false, "Whether to do a post-process filter on the capture before saving"},
            {"-t", "--tone-mapping", false, "Whether to apply tone mapping to the final image"},
-           {"-g", "--go", false, "Go immediately, no waiting for user input"}};
+           {"-g", "--go", false, "Go immediately, no waiting for user input"},
+           {"-p", "--progressive", false,
+            "Refine a single view one sample per pixel at a time until the subsamples are reached"},
+           {"-o", "--roulette", false, "End deep reflections by russian roulette instead of the adaptive threshold"},
+           {"-c", "--costs", false, "Writes the cost heatmaps and the trace of the tiles next to the rendered image"}};
 
     basal::options::process(dimof(opts), opts, argc, argv);
     basal::exit_unless(basal::options::find(opts, "--dims", params.dim_name), __FILE__, __LINE__,
@@ -85,6 +123,12 @@ int main(int argc, char *argv[]) {
                        "Must be able to assign a bool");
     basal::exit_unless(basal::options::find(opts, "--go", params.go), __FILE__, __LINE__,
                        "Must be able to assign a bool");
+    basal::exit_unless(basal::options::find(opts, "--roulette", params.roulette), __FILE__, __LINE__,
+                       "Must be able to assign bool");
+    basal::exit_unless(basal::options::find(opts, "--costs", params.costs), __FILE__, __LINE__,
+                       "Must be able to assign bool");
+    basal::exit_unless(basal::options::find(opts, "--progressive", params.progressive), __FILE__, __LINE__,
+                       "Must be able to assign a bool");
     basal::options::print(dimof(opts), opts);
 
     basal::module mod(params.module.c_str());
@@ -113,11 +157,63 @@ int main(int argc, char *argv[]) {
 
     if (params.go) {
         should_render = true;
-        should_quit = true;
+        // a progressive render quits once it has converged
+        should_quit = not params.progressive;
+    }
+
+    // the progressive mode keeps the scene and the camera so the passes accumulate until something changes
+    raytrace::scene progressive_scene;
+    std::unique_ptr<raytrace::camera> progressive_view;
+    precision progressive_fov = params.fov;
+    if (params.progressive) {
+        progressive_scene.set_background_mapper(
+            std::bind(&raytrace::world::background, &world, std::placeholders::_1));
+        world.add_to(progressive_scene);
+        progressive_scene.set_ambient_light(world.ambient());
+        if (params.roulette) {
+            progressive_scene.set_termination(raytrace::Termination::RussianRoulette);
+        }
     }
 
     do {
-        if (should_render) {
+        if (params.progressive) {
+            if (has_changed) {
+                // changes are shown right away, starting the passes over
+                progressive_scene.reset_accumulation();
+                has_changed = false;
+                should_render = true;
+            }
+            if (should_render and progressive_scene.accumulated_passes() < params.subsamples) {
+                if (not progressive_view or progressive_fov != params.fov) {
+                    progressive_fov = params.fov;
+                    progressive_view = std::make_unique<raytrace::camera>(height, width, iso::degrees(params.fov));
+                }
+                progressive_view->move_to(world.looking_from(), world.looking_at());
+                size_t passes = 0U;
+                try {
+                    passes = progressive_scene.render_pass(*progressive_view, params.reflections, std::nullopt,
+                                                           params.tone_mapping);
+                } catch (basal::exception const &e) {
+                    std::cout << "Caught basal::exception in scene.render_pass()! " << std::endl;
+                    std::cout << "What:" << e.what() << " Why:" << e.why() << " Where:" << e.where() << std::endl;
+                    should_render = false;
+                }
+                if (not show(surface, progressive_view->capture, 0U)) {
+                    return -1;
+                }
+                SDL_UpdateWindowSurface(window);
+                printf("\rPass %zu of %zu", passes, params.subsamples);
+                fflush(stdout);
+                if (passes == params.subsamples) {
+                    // the final image is the last preview
+                    printf("\r\n");
+                    progressive_view->capture.save(world.output_filename());
+                    std::cout << raytrace::statistics::get() << std::endl;
+                    should_render = false;
+                    should_quit = should_quit or params.go;
+                }
+            }
+        } else if (should_render) {
             std::cout << "Look From: " << world.looking_from() << std::endl;
             std::cout << "Look At: " << world.looking_at() << " (Towards)" << std::endl;
 
@@ -134,12 +230,15 @@ int main(int argc, char *argv[]) {
                 scene.print(std::cout, world.window_name().c_str());
             }
             scene.set_ambient_light(world.ambient());
+            if (params.roulette) {
+                scene.set_termination(raytrace::Termination::RussianRoulette);
+            }
+            scene.set_profiling(params.costs);
 
             size_t view_offset = 0u;
             for (auto &view : stereo_view) {
-                // The completion data will be stored in here, a bool per line.
-                std::vector<bool> completed(view.capture.height);
-                std::fill(completed.begin(), completed.end(), false);
+                // follows which lines are complete from the tile notifications
+                raytrace::line_progress progress(view.capture.height, view.capture.width);
                 bool running = true;
                 std::mutex window_mutex;
                 auto start = std::chrono::steady_clock::now();
@@ -148,34 +247,28 @@ int main(int argc, char *argv[]) {
                         static constexpr bool use_bar = false;
                         if constexpr (use_bar) {
                             fprintf(stdout, "\r [");
-                            for (size_t i = 0; i < completed.size(); i++) {
-                                fprintf(stdout, "%s", completed[i] ? "#" : "_");
+                            for (size_t i = 0; i < progress.lines(); i++) {
+                                fprintf(stdout, "%s", progress.is_complete(i) ? "#" : "_");
                             }
                             fprintf(stdout, "]");
                         } else {
-                            size_t count = 0;
-                            std::for_each(completed.begin(), completed.end(), [&](bool p) -> bool {
-                                count += (p ? 1 : 0);
-                                return p;
-                            });
-                            double percentage = 100.0_p * count / completed.size();
-                            bool done = (count == completed.size());
+                            size_t count = progress.complete_lines();
+                            double percentage = 100.0_p * count / progress.lines();
+                            bool done = (count == progress.lines());
+                            raytrace::statistics const counted = raytrace::statistics::get();
                             fprintf(
                                 stdout,
                                 "\r[ %0.3lf %%] rays cast: %zu dots: %zu cross: %zu 2r: %zu 3r: %zu 4r: %zu "
                                 "intersects: %zu (%zu/%zu/%zu) bounced: %zu "
                                 "transmitted: %zu missed: %zu bounds: %zu %s",
-                                done ? 100.0_p : percentage, raytrace::statistics::get().cast_rays_from_camera,
+                                done ? 100.0_p : percentage, counted.cast_rays_from_camera,
                                 geometry::statistics::get().dot_operations, geometry::statistics::get().cross_products,
                                 linalg::statistics::get().quadratic_roots, linalg::statistics::get().cubic_roots,
                                 linalg::statistics::get().quartic_roots,
-                                raytrace::statistics::get().intersections_with_objects,
-                                raytrace::statistics::get().intersections_with_point,
-                                raytrace::statistics::get().intersections_with_points,
-                                raytrace::statistics::get().intersections_with_line,
-                                raytrace::statistics::get().bounced_rays, raytrace::statistics::get().transmitted_rays,
-                                raytrace::statistics::get().missed_rays,
-                                raytrace::statistics::get().intersections_with_bounds, done ? "\r\n" : "");
+                                counted.intersections_with_objects, counted.intersections_with_point,
+                                counted.intersections_with_points, counted.intersections_with_line,
+                                counted.bounced_rays, counted.transmitted_rays, counted.missed_rays,
+                                counted.intersections_with_bounds, done ? "\r\n" : "");
                             // if (done) return;
                         }
                         fflush(stdout);
@@ -183,9 +276,9 @@ int main(int argc, char *argv[]) {
                     }
                     fprintf(stdout, "\r\n");
                 };
-                auto row_notifier = [&](size_t row_index, bool is_complete) -> void {
-                    completed[row_index] = is_complete;
-                    if (live_preview) {
+                auto tile_notifier = [&](raytrace::tile const &region, bool is_complete) -> void {
+                    progress.update(region, is_complete);
+                    if (live_preview and is_complete) {
                         // surface = SDL_GetWindowSurface(window);
                         bool should_lock = SDL_MUSTLOCK(surface);
                         if (should_lock) {
@@ -194,27 +287,27 @@ int main(int argc, char *argv[]) {
                                 return;
                             }
                         }
-                        view.capture.for_each([&](size_t y, size_t x,
-                                                  raytrace::image::PixelStorageType const &pixel) -> void {
-                            if (row_index != y)
-                                return;  // if it's not this row, skip it
-                            uint8_t *pixels = reinterpret_cast<uint8_t *>(surface->pixels);  // this is double width!
-                            size_t offset = (y * surface->pitch) + (x * sizeof(fourcc::bgra))
-                                            + (view_offset * sizeof(fourcc::bgra));
+                        for (size_t y = region.y; y < (region.y + region.height); y++) {
+                            for (size_t x = region.x; x < (region.x + region.width); x++) {
+                                raytrace::image::PixelStorageType const &pixel = view.capture.at(y, x);
+                                uint8_t *pixels = reinterpret_cast<uint8_t *>(surface->pixels);  // this is double width!
+                                size_t offset = (y * surface->pitch) + (x * sizeof(fourcc::bgra))
+                                                + (view_offset * sizeof(fourcc::bgra));
 
-                            // clamp, then convert to sRGB
-                            raytrace::color value(pixel.components.r, pixel.components.g, pixel.components.b,
-                                                  pixel.components.i);
-                            value.clamp();
-                            value.ToEncoding(fourcc::Encoding::GammaCorrected);
-                            auto srgb = value.to_<fourcc::PixelFormat::RGB8>();
+                                // clamp, then convert to sRGB
+                                raytrace::color value(pixel.components.r, pixel.components.g, pixel.components.b,
+                                                      pixel.components.i);
+                                value.clamp();
+                                value.ToEncoding(fourcc::Encoding::GammaCorrected);
+                                auto srgb = value.to_<fourcc::PixelFormat::RGB8>();
 
-                            // B G R A order in SDL2
-                            pixels[offset + 0u] = srgb.components.b;
-                            pixels[offset + 1u] = srgb.components.g;
-                            pixels[offset + 2u] = srgb.components.r;
-                            pixels[offset + 3u] = 0u;
-                        });
+                                // B G R A order in SDL2
+                                pixels[offset + 0u] = srgb.components.b;
+                                pixels[offset + 1u] = srgb.components.g;
+                                pixels[offset + 2u] = srgb.components.r;
+                                pixels[offset + 3u] = 0u;
+                            }
+                        }
                         if (window_mutex.try_lock()) {
                             SDL_UpdateWindowSurface(window);  // calling this across threads is bad
                             window_mutex.unlock();
@@ -230,7 +323,7 @@ int main(int argc, char *argv[]) {
 
                 std::thread bar_thread(progress_bar);  // thread starts
                 try {
-                    scene.render(view, world.output_filename(), params.subsamples, params.reflections, row_notifier,
+                    scene.render(view, world.output_filename(), params.subsamples, params.reflections, tile_notifier,
                                  params.mask_threshold, params.filter, params.tone_mapping);
                 } catch (basal::exception const &e) {
                     std::cout << "Caught basal::exception in scene.render()! " << std::endl;
@@ -244,35 +337,13 @@ int main(int argc, char *argv[]) {
                 bar_thread.join();  // thread stop
 
                 std::cout << "Image Rendered in " << diff.count() << " seconds" << std::endl;
+                std::cout << scene.hierarchy() << std::endl;
+                std::cout << raytrace::statistics::get() << std::endl;
 
-                bool should_lock = SDL_MUSTLOCK(surface);
-                if (should_lock) {
-                    if (0 != SDL_LockSurface(surface)) {
-                        printf("Failed to lock surface!\n");
-                        return -1;
-                    }
+                if (not show(surface, view.capture, view_offset)) {
+                    return -1;
                 }
-                view.capture.for_each([&](size_t y, size_t x, raytrace::image::PixelStorageType const &pixel) -> void {
-                    uint8_t *pixels = reinterpret_cast<uint8_t *>(surface->pixels);
-                    size_t offset
-                        = (y * surface->pitch) + (x * sizeof(fourcc::bgra)) + (view_offset * sizeof(fourcc::bgra));
-                    // clamp, then convert to sRGB
-                    raytrace::color value(pixel.components.r, pixel.components.g, pixel.components.b,
-                                          pixel.components.i);
-                    value.clamp();
-                    value.ToEncoding(fourcc::Encoding::GammaCorrected);
-                    auto srgb = value.to_<fourcc::PixelFormat::RGB8>();
-
-                    // B G R A order
-                    pixels[offset + 0u] = srgb.components.b;
-                    pixels[offset + 1u] = srgb.components.g;
-                    pixels[offset + 2u] = srgb.components.r;
-                    pixels[offset + 3u] = 0u;
-                });
                 SDL_UpdateWindowSurface(window);
-                if (should_lock) {
-                    SDL_UnlockSurface(surface);
-                }
                 printf("Separation: %lf\n", params.separation);
                 if (not basal::nearly_zero(params.separation)) {
                     view_offset += width;
@@ -292,6 +363,9 @@ int main(int argc, char *argv[]) {
                 printf("Use t/g to change FOV +5/-5\n");
                 printf("Use z/x to change separation +0.25/-0.25\n");
                 printf("Use u/j to change subsamples +1/-1\n");
+                if (params.progressive) {
+                    printf("Changes are rendered progressively as soon as they are made\n");
+                }
                 should_show_help = false;
             }
         }
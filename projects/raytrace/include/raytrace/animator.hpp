@@ -44,6 +44,7 @@ protected:
     Attributes interpolate(Attributes const& start, Attributes const& limit, Mappers const& mappers, precision dt);
 
     size_t index_{0};
+    size_t frame_{0};  ///< The number of frames given, so the time is a product instead of a (drifting) running sum
     iso::seconds now_{0.0};
     iso::seconds start_{0.0};  ///< The start of the current anchor duration
     iso::seconds delta_{0.0};
@@ -0,0 +1,91 @@
+#pragma once
+
+/// @file
+/// The Raytrace library animation batch renderer header
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "raytrace/animator.hpp"
+#include "raytrace/scene.hpp"
+
+namespace raytrace {
+
+namespace animation {
+
+/// Renders the frames of an animation into numbered image files. The same scene renders every frame, so its hierarchy
+/// (and light selection) is built once for the whole sequence as only the camera moves. Each rendered frame is copied
+/// onto a bounded queue and a writer thread converts and saves it while the next frame renders, so the renderer only
+/// waits on the disk when the writer falls a whole queue behind. A range of the frames can be rendered so a long
+/// sequence can be split across several processes.
+class Batch {
+public:
+    /// Called on the rendering thread after each frame is rendered with the frame number and its view
+    using rendered_frame = std::function<void(size_t frame, camera const& view)>;
+
+    /// The size, quality and output files of the frames
+    struct Settings {
+        size_t height{240U};                                  ///< The height of each frame
+        size_t width{320U};                                   ///< The width of each frame
+        size_t number_of_samples{1U};                         ///< The samples per pixel
+        size_t reflection_depth{4U};                          ///< The depth of recursion of each traced ray
+        bool tone_mapping{false};                             ///< Whether to tone map each frame
+        std::string prefix{"frame_"};                         ///< The start of each filename (may include a path)
+        std::string extension{".ppm"};                        ///< The format to save in (.ppm, .tga, .pfm or .exr)
+        size_t first{0U};                                     ///< The first frame to render
+        size_t last{std::numeric_limits<size_t>::max()};      ///< One past the last frame to render
+        size_t queue_depth{2U};                               ///< The number of frames which may wait to be saved
+    };
+
+    /// @param renderer The scene with everything in it (and which must outlive the batch)
+    /// @param settings The frames to render
+    /// @throw basal::exception if the frames are empty or the queue has no room
+    Batch(scene& renderer, Settings const& settings);
+
+    /// Renders the frames of the range from the animation and waits for them all to be saved. The frames before the
+    /// range are skipped without rendering.
+    /// @param animator The camera path, which is advanced by every frame it gives (up to the end of the range)
+    /// @param func The optional callback per rendered frame (used for updating UIs)
+    /// @return The number of frames which were rendered and saved
+    size_t render(Animator& animator, std::optional<rendered_frame> func = std::nullopt);
+
+    /// @return The name of the file for the frame, i.e. frame_0042.ppm
+    std::string filename(size_t frame) const;
+
+protected:
+    /// A rendered frame which is waiting to be saved
+    struct pending {
+        std::string filename;                             ///< Where to save it
+        fourcc::image<fourcc::PixelFormat::RGBId> image;  ///< The copy of the capture
+    };
+
+    /// Saves the frames from the queue until it is closed and empty
+    void write();
+
+    /// The scene which renders each frame
+    scene& m_scene;
+    /// The frames to render
+    Settings m_settings;
+    /// Guards the queue
+    std::mutex m_mutex;
+    /// Signals the writer that a frame was queued (or the queue was closed)
+    std::condition_variable m_queued;
+    /// Signals the renderer that a frame was taken off of the queue
+    std::condition_variable m_taken;
+    /// The frames waiting to be saved
+    std::deque<pending> m_queue;
+    /// Set once the last frame is queued
+    bool m_closed{false};
+    /// The number of frames which were saved
+    size_t m_saved{0U};
+};
+
+}  // namespace animation
+
+}  // namespace raytrace
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <raytrace/types.hpp>
 
 namespace raytrace {
@@ -38,6 +40,9 @@ struct Bounds {
     /// Determines if the bounds are infinite
     bool is_infinite() const;
 
+    /// @return The volume enclosed by the bounds (infinite if the bounds are)
+    precision volume() const;
+
     /// Grows the bounds to include another bounds
     void grow(Bounds const& b);
 
@@ -48,4 +53,17 @@ struct Bounds {
 
 std::ostream& operator<<(std::ostream& os, Bounds const& b);
 
+/// The slack added around the bounds of an object (or given to a flat side). In double precision this is a fixed
+/// @ref basal::epsilon, in single precision that epsilon is coarse enough to swell every bounds of the hierarchy so the
+/// slack is a few units in the last place instead.
+/// @param magnitude The largest magnitude of the values the coordinate was computed from. The rounding of a sum
+/// follows its terms, not its result, so a coordinate near zero made from large terms needs the slack of the terms.
+inline precision bounds_slack(precision magnitude) {
+    if constexpr (basal::use_high_precision) {
+        return basal::epsilon;
+    } else {
+        return std::max(precision(0x1.0p-20), std::abs(magnitude) * precision(0x1.0p-22));
+    }
+}
+
 }  // namespace raytrace
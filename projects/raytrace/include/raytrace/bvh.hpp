@@ -0,0 +1,282 @@
+#pragma once
+
+/// @file
+/// The Raytrace library flat Bounding Volume Hierarchy header
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "raytrace/bounds.hpp"
+#include "raytrace/objects/object.hpp"
+
+namespace raytrace {
+
+namespace tree {
+
+/// @brief A compact axis aligned box stored as plain arrays for the slab test.
+struct FlatBounds {
+    precision lower[dimensions];  //!< The inclusive lower corner of the bounds
+    precision upper[dimensions];  //!< The upper corner of the bounds
+
+    /// The slab test of a ray against the bounds.
+    /// @param origin The location of the ray
+    /// @param inverse The reciprocal of each component of the ray direction (may be infinite)
+    /// @param t_max The farthest distance along the ray to consider
+    /// @param t_enter [out] The distance along the ray where it enters the bounds (zero if it starts inside)
+    /// @return true if the ray enters the bounds within [0, t_max]
+    inline bool enters(precision const origin[dimensions], precision const inverse[dimensions], precision t_max,
+                       precision& t_enter) const {
+        // NaNs (from 0 * inf) fail the comparisons and so leave the interval unchanged.
+        precision t_exit = t_max;
+        t_enter = 0.0_p;
+        for (size_t a = 0; a < dimensions; a++) {
+            precision t_near = (lower[a] - origin[a]) * inverse[a];
+            precision t_far = (upper[a] - origin[a]) * inverse[a];
+            if (t_near > t_far) {
+                std::swap(t_near, t_far);
+            }
+            t_enter = t_near > t_enter ? t_near : t_enter;
+            t_exit = t_far < t_exit ? t_far : t_exit;
+            if (t_enter > t_exit) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// The slab test of each lane of a packet against the bounds.
+    /// @param rays The packet of rays (uses the origins and reciprocal directions)
+    /// @param t_max The farthest distance along each ray to consider
+    /// @param active The mask of lanes to test (bit n is lane n)
+    /// @return The mask of active lanes which enter the bounds within [0, t_max]
+    inline uint32_t enters(ray_packet const& rays, precision const (&t_max)[ray_packet::width], uint32_t active) const {
+        constexpr size_t W = ray_packet::width;
+        precision t_enter[W];
+        precision t_exit[W];
+        for (size_t lane = 0; lane < W; lane++) {
+            t_enter[lane] = 0.0_p;
+            t_exit[lane] = t_max[lane];
+        }
+        for (size_t a = 0; a < dimensions; a++) {
+            for (size_t lane = 0; lane < W; lane++) {
+                precision const t0 = (lower[a] - rays.origin[a][lane]) * rays.inverse[a][lane];
+                precision const t1 = (upper[a] - rays.origin[a][lane]) * rays.inverse[a][lane];
+                precision const t_near = t0 < t1 ? t0 : t1;
+                precision const t_far = t0 < t1 ? t1 : t0;
+                t_enter[lane] = t_near > t_enter[lane] ? t_near : t_enter[lane];
+                t_exit[lane] = t_far < t_exit[lane] ? t_far : t_exit[lane];
+            }
+        }
+        uint32_t mask = 0U;
+        for (size_t lane = 0; lane < W; lane++) {
+            mask |= (t_enter[lane] <= t_exit[lane] ? 1U : 0U) << lane;
+        }
+        return mask & active;
+    }
+};
+
+/// @brief A compact node within the flattened hierarchy. The nodes are stored in depth first order so the first (left)
+/// child of an interior node is always the next node in the array and only the second (right) child is stored.
+struct FlatNode : FlatBounds {
+    uint32_t offset;  //!< Leaf: index of the first object. Interior: index of the second child.
+    uint16_t count;   //!< Leaf: the number of objects. Interior: zero.
+    uint16_t axis;    //!< Interior: the split axis, used to visit the children near-to-far.
+
+    /// @return true if the node is a leaf
+    inline bool is_leaf() const {
+        return count > 0U;
+    }
+};
+
+/// Keeps the candidate hit if it is nearer than the current nearest hit (and not at the ray origin) and updates the
+/// running t-max. Counts the intersection statistics the same way @ref scene::find_intersections does.
+/// @param world_ray The (unit direction) ray which produced the candidate
+/// @param candidate The hit from an object
+/// @param nearest [in,out] The nearest hit so far
+/// @param t_max [in,out] The distance to the nearest hit so far
+/// @return true if the candidate became the nearest hit
+bool keep_nearest(raytrace::ray const& world_ray, objects::object::hit const& candidate, objects::object::hit& nearest,
+                  precision& t_max);
+
+/// Determines if the candidate hit blocks the ray somewhere within (0, max_distance), not counting the ray origin.
+/// Counts the intersection statistics the same way @ref keep_nearest does.
+/// @param world_ray The (unit direction) ray which produced the candidate
+/// @param candidate The hit from an object
+/// @param max_distance The distance along the ray beyond which hits do not block
+bool blocks(raytrace::ray const& world_ray, objects::object::hit const& candidate, precision max_distance);
+
+/// The record form of @ref keep_nearest, the candidate object writes its hit into the record only if it is nearer, so
+/// no surface is computed for hits which lose.
+/// @param world_ray The (unit direction) ray
+/// @param candidate The object to test
+/// @param nearest [in,out] The nearest hit so far (its distance is the running t-max)
+/// @return true if the candidate became the nearest hit
+bool keep_nearest(raytrace::ray const& world_ray, objects::object const* candidate, objects::hit_record& nearest);
+
+/// The record form of @ref blocks.
+/// @param world_ray The (unit direction) ray
+/// @param candidate The object to test
+/// @param max_distance The distance along the ray beyond which hits do not block
+bool blocks(raytrace::ray const& world_ray, objects::object const* candidate, precision max_distance);
+
+/// The nearest hit of each lane of a packet
+using packet_hits = objects::object::hit[ray_packet::width];
+
+/// The packet form of @ref keep_nearest. Uses the packet intersection of the candidate object if it has one, otherwise
+/// the scalar intersection of each lane. Hits found by the packet intersection only record the object and distance (the
+/// intersection type is None) and must be resolved with the scalar intersection of that object.
+/// @param rays The packet of rays in world space
+/// @param candidate The object to test
+/// @param active The mask of lanes to test
+/// @param nearest [in,out] The nearest hit of each lane
+/// @param t_max [in,out] The distance to the nearest hit of each lane
+/// @return The mask of lanes where the candidate became the nearest hit
+uint32_t keep_nearest(ray_packet const& rays, objects::object const* candidate, uint32_t active, packet_hits& nearest,
+                      precision (&t_max)[ray_packet::width]);
+
+/// The packet form of @ref blocks.
+/// @param rays The packet of rays in world space
+/// @param candidate The object to test
+/// @param active The mask of lanes to test
+/// @param max_distance The distance along each ray beyond which hits do not block
+/// @return The mask of lanes blocked by the candidate
+uint32_t blocks(ray_packet const& rays, objects::object const* candidate, uint32_t active,
+                precision const (&max_distance)[ray_packet::width]);
+
+/// @brief A Bounding Volume Hierarchy which is built with the Surface Area Heuristic (SAH) over the finite world bounds
+/// of a set of objects and then flattened into a single array of @ref FlatNode. Traversal uses a small fixed stack and
+/// visits the children near-to-far along the split axis. This replaces the recursive octree of @ref Node for the scene.
+class BVH {
+public:
+    using hits = objects::object::hits;
+    using object_list = std::vector<objects::object const*>;
+    /// The number of buckets used to bin the centroids when evaluating the SAH
+    static constexpr size_t NumBuckets{12U};
+    /// The number of objects at or below which a node is always a leaf
+    static constexpr size_t MaxLeafObjects{2U};
+    /// The maximum depth of the tree, which is also the size of the traversal stack
+    static constexpr size_t MaxDepth{64U};
+    /// The relative cost of traversing a node compared to intersecting an object
+    static constexpr precision TraversalCost{0.125_p};
+
+    /// Constructs an empty hierarchy
+    BVH();
+
+    /// (Re)builds the hierarchy over the given objects. All objects must have finite world bounds.
+    /// @param objects The list of objects to build over
+    void build(object_list const& objects);
+
+    /// Removes all nodes and objects from the hierarchy
+    void clear();
+
+    /// Determines the hits of the ray where it intersects with the objects in the hierarchy
+    /// @retval No hits if the ray does not intersect with anything in the hierarchy.
+    hits intersects(raytrace::ray const& ray) const;
+
+    /// Finds the nearest hit along the ray. Nodes and objects which the ray enters beyond the running t-max are skipped
+    /// and children are visited nearest first, so the search terminates early. Does not allocate.
+    /// @param ray The ray in world space (unit direction)
+    /// @param nearest [in,out] The nearest hit so far, replaced if a nearer hit is found
+    /// @param t_max [in,out] The distance to the nearest hit so far, reduced if a nearer hit is found
+    /// @return true if a nearer hit was found
+    bool closest(raytrace::ray const& ray, objects::object::hit& nearest, precision& t_max) const;
+
+    /// The record form of @ref closest, the surface of the nearest hit is not computed (see
+    /// @ref objects::object::resolve).
+    /// @param ray The ray in world space (unit direction)
+    /// @param nearest [in,out] The nearest hit so far (its distance is the running t-max), replaced if a nearer hit is
+    /// found
+    /// @return true if a nearer hit was found
+    bool closest(raytrace::ray const& ray, objects::hit_record& nearest) const;
+
+    /// Finds any object which blocks the ray before the maximum distance and returns as soon as one is found.
+    /// Does not allocate.
+    /// @param ray The ray in world space (unit direction)
+    /// @param max_distance The distance along the ray beyond which hits do not block (i.e. the light's distance)
+    /// @param skip An object which has already been tested and should not be tested again (may be nullptr)
+    /// @return The first blocking object found or nullptr if nothing blocks the ray
+    objects::object const* occluder(raytrace::ray const& ray, precision max_distance,
+                                    objects::object const* skip = nullptr) const;
+
+    /// The packet form of @ref closest. Every node is tested against all the active lanes at once and is visited if any
+    /// lane enters it. Does not allocate.
+    /// @param rays The packet of rays in world space (unit directions)
+    /// @param active The mask of lanes to trace
+    /// @param nearest [in,out] The nearest hit of each lane (see @ref tree::keep_nearest for unresolved hits)
+    /// @param t_max [in,out] The distance to the nearest hit of each lane
+    /// @return The mask of lanes where a nearer hit was found
+    uint32_t closest(ray_packet const& rays, uint32_t active, packet_hits& nearest,
+                     precision (&t_max)[ray_packet::width]) const;
+
+    /// The packet form of @ref occluder. Returns once every active lane is blocked. Does not allocate.
+    /// @param rays The packet of rays in world space (unit directions)
+    /// @param active The mask of lanes to test
+    /// @param max_distance The distance along each ray beyond which hits do not block
+    /// @param blockers [out] The blocking object of each lane which is blocked
+    /// @return The mask of lanes which are blocked
+    uint32_t occluders(ray_packet const& rays, uint32_t active, precision const (&max_distance)[ray_packet::width],
+                       objects::object const* (&blockers)[ray_packet::width]) const;
+
+    /// @return true if the hierarchy has not been built or contains nothing
+    inline bool empty() const {
+        return nodes_.empty();
+    }
+
+    /// @return the number of nodes (interior and leaf) in the hierarchy
+    inline size_t node_count() const {
+        return nodes_.size();
+    }
+
+    /// @return the number of objects in the hierarchy
+    inline size_t object_count() const {
+        return objects_.size();
+    }
+
+    /// @return the deepest level of the hierarchy (a single leaf is depth 1)
+    inline size_t depth() const {
+        return depth_;
+    }
+
+    /// @return the time the last build took
+    inline std::chrono::duration<double> build_time() const {
+        return build_time_;
+    }
+
+    /// @return the flattened nodes (for inspection)
+    inline std::vector<FlatNode> const& nodes() const {
+        return nodes_;
+    }
+
+    /// @return the objects in leaf order (for inspection)
+    inline object_list const& objects() const {
+        return objects_;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, BVH const& bvh);
+
+protected:
+    /// The flattened nodes in depth first order
+    std::vector<FlatNode> nodes_;
+    /// The objects ordered so that each leaf refers to a contiguous range
+    object_list objects_;
+    /// The world bounds of each object, in the same order as the objects
+    std::vector<FlatBounds> bounds_;
+    /// The deepest level reached during the build
+    size_t depth_;
+    /// The duration of the last build
+    std::chrono::duration<double> build_time_;
+};
+
+/// Builds a hierarchy over a set of boxes with the Surface Area Heuristic (using the constants of @ref BVH) and
+/// flattens it in depth first order. This is shared by the scene @ref BVH and the triangles of a @ref MeshBVH.
+/// @param boxes The bounds of each item
+/// @param max_leaf_items The number of items at or below which a node is always a leaf
+/// @param nodes [out] The flattened nodes, each leaf refers to a contiguous range of the order
+/// @param order [out] The index of the item in each slot of the leaves
+/// @return The deepest level of the hierarchy (zero when there are no boxes)
+size_t build_flat_hierarchy(std::vector<FlatBounds> const& boxes, size_t max_leaf_items, std::vector<FlatNode>& nodes,
+                            std::vector<uint32_t>& order);
+
+}  // namespace tree
+}  // namespace raytrace
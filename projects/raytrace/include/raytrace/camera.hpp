@@ -105,6 +105,7 @@ protected:
 
     linalg::matrix
         m_camera_to_object_rotation;  ///< Rotates the Camera Coordinate frame into the Object Coordinate frame.
+    raytrace::transform m_image_to_object;  ///< The intrinsics and the camera to object rotation combined
 };
 
 }  // namespace raytrace
@@ -43,6 +43,13 @@ static constexpr bool use_true_intensity{true};
 /// If true, use random sample points, otherwise use fixed sample points for samplers
 static constexpr bool use_random_sample_points{false};
 
+/// The number of samples adaptive sampling adds to a pixel at a time (after the first)
+static constexpr size_t adaptive_batch{4U};
+
+/// The number of standard errors within which the mean of the samples of a pixel must be inside the tolerance for
+/// adaptive sampling to stop (1.96 is 95% confidence)
+static constexpr geometry::precision adaptive_confidence{1.96_p};
+
 /// uses fixed color scheme for shadows, light, near-zero values
 static constexpr bool debug_shadows_and_light{false};
 static constexpr bool use_incident_scaling{true};
@@ -57,6 +64,30 @@ static constexpr bool check_on_surface = geometry::check_on_surface;
 /// Determine the number of objects in the scene to switch from brute force to a bounding box search
 static constexpr size_t brute_force_to_bounding_box{10U};
 
+/// Traces camera rays and the shadow rays of area lights in packets (see @ref ray_packet) instead of one at a time
+static constexpr bool use_ray_packets{true};
+
+/// Keeps a binary cache of each model (mesh and hierarchy) next to its OBJ file, which later loads map in place
+static constexpr bool use_mesh_cache{true};
+
+/// The number of lights with a falloff at which shading stops sampling every light at each surface point and instead
+/// chooses lights in proportion to their contribution (see @ref lights::selector)
+static constexpr size_t light_selection_threshold{8U};
+
+/// The number of lights (each with a single shadow ray) which are chosen at each surface point once there are enough
+/// lights to choose between
+static constexpr size_t light_selection_budget{4U};
+
+/// The number of bounces from the camera which are always traced before russian roulette can end a path (see
+/// @ref Termination)
+static constexpr size_t russian_roulette_depth{2U};
+
+/// The lowest chance that a path survives russian roulette, which bounds the weight given to the survivors
+static constexpr geometry::precision russian_roulette_survival{0.05_p};
+
+/// The number of collisions along a ray kept inline (without allocating), the most of any basic object (a torus)
+static constexpr size_t inline_collisions{4U};
+
 /// A flag to control if origin collisions are counted
 static constexpr bool can_ray_origin_be_collision{true};
 
@@ -2,6 +2,7 @@
 
 #include "geometry/extra_math.hpp"
 #include "linalg/matrix.hpp"
+#include "raytrace/transform.hpp"
 #include "raytrace/types.hpp"
 
 namespace raytrace {
@@ -20,8 +21,7 @@ public:
         , m_rotation{matrix::identity(DIMS, DIMS)}
         , m_inv_rotation{matrix::identity(DIMS, DIMS)}
         , m_scaling{{1.0_p, 1.0_p, 1.0_p}}
-        , m_transform{matrix::identity(DIMS + 1, DIMS + 1)}
-        , m_inv_transform{matrix::identity(DIMS + 1, DIMS + 1)} {
+        , m_transform{} {
     }
 
     explicit entity_(point const& position) : entity_{} {
@@ -39,8 +39,7 @@ public:
         , m_rotation{other.m_rotation}
         , m_inv_rotation{other.m_inv_rotation}
         , m_scaling{other.m_scaling}
-        , m_transform{other.m_transform}
-        , m_inv_transform{other.m_inv_transform} {
+        , m_transform{other.m_transform} {
     }
 
     entity_(entity_&& other)
@@ -48,8 +47,7 @@ public:
         , m_rotation{std::move(other.m_rotation)}
         , m_inv_rotation{std::move(other.m_inv_rotation)}
         , m_scaling{std::move(other.m_scaling)}
-        , m_transform{std::move(other.m_transform)}
-        , m_inv_transform{std::move(other.m_inv_transform)} {
+        , m_transform{other.m_transform} {
     }
 
     entity_& operator=(entity_ const& other) {
@@ -59,7 +57,6 @@ public:
             m_inv_rotation = other.m_inv_rotation;
             m_scaling = other.m_scaling;
             m_transform = other.m_transform;
-            m_inv_transform = other.m_inv_transform;
         }
         return *this;
     }
@@ -70,8 +67,7 @@ public:
             m_rotation = std::move(other.m_rotation);
             m_inv_rotation = std::move(other.m_inv_rotation);
             m_scaling = std::move(other.m_scaling);
-            m_transform = std::move(other.m_transform);
-            m_inv_transform = std::move(other.m_inv_transform);
+            m_transform = other.m_transform;
         }
         return *this;
     }
@@ -137,41 +133,32 @@ public:
 
     /// Finds the point in world space given the object point
     raytrace::point forward_transform(raytrace::point const& object_point) const {
-        geometry::point_<4> o(object_point);
-        geometry::point_<4> w(m_transform * o);
-        return point(w[0], w[1], w[2]);
+        return m_transform.forward(object_point);
     }
 
     /// Rotates the vector into the world space from the object space
     raytrace::vector forward_transform(raytrace::vector const& vec) const {
-        return vector(m_rotation * vec);
+        return m_transform.forward(vec);
     }
 
     /// Transforms a object ray into a world ray
     raytrace::ray forward_transform(raytrace::ray const& object_ray) const {
-        raytrace::point world_point = forward_transform(object_ray.location());
-        vector world_vector = forward_transform(object_ray.direction());
-        return ray(world_point, world_vector);
+        return m_transform.forward(object_ray);
     }
 
     /// Finds the point in object space which maps to the given world space point
     raytrace::point reverse_transform(raytrace::point const& world_point) const {
-        geometry::point_<4> w(world_point);          // create homogenized point
-        geometry::point_<4> o(m_inv_transform * w);  // 4x4 mult
-        return point(o[0], o[1], o[2]);              // drop the last var
+        return m_transform.reverse(world_point);
     }
 
     /// Rotates the vector into the object space.
     raytrace::vector reverse_transform(raytrace::vector const& vec) const {
-        vector v = m_inv_rotation * vec;
-        return vector(v);
+        return m_transform.reverse(vec);
     }
 
     /// Transforms the world space ray into the object space ray
     raytrace::ray reverse_transform(raytrace::ray const& world_ray) const {
-        point object_point = reverse_transform(world_ray.location());
-        vector object_vector = reverse_transform(world_ray.direction());
-        return ray(object_point, object_vector);
+        return m_transform.reverse(world_ray);
     }
 
     /// Updates the scaling values
@@ -183,25 +170,10 @@ public:
     }
 
 protected:
-    /// Creates the transform matrix and it's inverse
+    /// Creates the transform and it's inverse from the position, rotation and scaling.
+    /// The order applied is Scale, Rotate, then Translate.
     void compute_transforms() {
-        matrix t = matrix::identity(DIMS + 1, DIMS + 1);
-        t[0][3] = m_world_position.x();
-        t[1][3] = m_world_position.y();
-        t[2][3] = m_world_position.z();
-        matrix s = matrix::identity(DIMS + 1, DIMS + 1);
-        s[0][0] = m_scaling[0];
-        s[1][1] = m_scaling[1];
-        s[2][2] = m_scaling[2];
-        // expand rotation to 4x4
-        matrix r = matrix::identity(DIMS + 1, DIMS + 1);
-        // copy the rotation into r at 0,0 to 2,2
-        m_rotation.assignInto(r, 0, 0);
-
-        // the order applied is backwards from the multiplication order
-        // Rotate, Scale, then Translate.
-        m_transform = t * (r * s);
-        m_inv_transform = m_transform.inverse();
+        m_transform = raytrace::transform{m_rotation, m_inv_rotation, m_scaling, m_world_position};
     }
 
     /// The position of the object in 3d space
@@ -216,11 +188,8 @@ protected:
     /// The Scaling vector
     raytrace::vector m_scaling;
 
-    /// Contains the translation, scaling, and rotation as a single matrix
-    matrix m_transform;
-
-    /// Contains the inverse transform
-    matrix m_inv_transform;
+    /// Contains the translation, scaling, and rotation (and their inverses) inline
+    raytrace::transform m_transform;
 };
 
 ///  Raytracing uses 3D entities
@@ -5,8 +5,10 @@
 #include <functional>
 #include <linalg/linalg.hpp>
 #include <optional>
+#include <vector>
 
 #include "raytrace/color.hpp"
+#include "raytrace/tiles.hpp"
 
 namespace raytrace {
 
@@ -42,26 +44,85 @@ public:
     /// A function which gives an image point and expects a color returned.
     using subsampler = std::function<color(image::point const&)>;
 
-    /// A function callback which is called when a line is complete
-    using rendered_line = std::function<void(size_t row_index, bool completed)>;
+    /// A function which gives a row of neighboring image points and expects a color returned for each.
+    using packet_subsampler = std::function<void(image::point const* points, color* colors, size_t count)>;
+
+    /// A function callback which is called (from the rendering thread) when a tile is complete, or with completed set
+    /// to false when a region is about to be rendered again.
+    using rendered_tile = std::function<void(tile const& region, bool completed)>;
 
     ///
     /// The iterator for the image plane. It produces a subsampled point in the image plane and
     /// expects a color returned for each subsample. Each subsample will be averaged together.
-    /// After the pixel is computed, the optional renderer is called.
+    /// The image is split into tiles which are rendered in parallel (see @ref tile_scheduler) and after each tile is
+    /// computed, the optional renderer is called.
     /// @param sub_func The subsampler functor
     /// @param number_of_samples The number of samples per pixel.
-    /// @param opt_func The optional renderer callback
+    /// @param opt_func The optional tile completion callback
     /// @param mask The mask image to use
     /// @param mask_threshold Used to do adaptive anti-aliasing. If the mask pixel is above the threshold value, then it
     /// @param tone_mapping Whether to apply tone mapping to the final pixel value. If true, the Reinhard tone mapper is
     /// applied. This is typically used when rendering to an HDR format like RGBh. If false, no tone mapping is applied
     /// and the pixel value is directly converted to the output format. will attempt to recompute. If 255, anti-aliasing
     /// is disabled.
+    /// @param layout The size and order of the tiles
     void generate_each(subsampler sub_func, size_t number_of_samples = 1,
-                       std::optional<rendered_line> opt_func = std::nullopt,
+                       std::optional<rendered_tile> opt_func = std::nullopt,
                        fourcc::image<fourcc::PixelFormat::Y8>* mask = nullptr,
-                       uint8_t mask_threshold = AAA_MASK_DISABLED, bool tone_mapping = false);
+                       uint8_t mask_threshold = AAA_MASK_DISABLED, bool tone_mapping = false,
+                       tiling const& layout = tiling{});
+
+    ///
+    /// The same iteration as @ref generate_each, but the subsampler is given up to lanes neighboring pixels of a tile
+    /// row at a time (the same sample of each), so the caller can trace them together as a packet of rays.
+    /// @param sub_func The packet subsampler functor
+    /// @param lanes The most points to give the subsampler at once
+    /// @see generate_each for the other parameters
+    ///
+    void generate_each(packet_subsampler sub_func, size_t lanes, size_t number_of_samples = 1,
+                       std::optional<rendered_tile> opt_func = std::nullopt,
+                       fourcc::image<fourcc::PixelFormat::Y8>* mask = nullptr,
+                       uint8_t mask_threshold = AAA_MASK_DISABLED, bool tone_mapping = false,
+                       tiling const& layout = tiling{});
+
+    ///
+    /// Adds a single sample per pixel to the running sums of a progressive render and stores the average of all the
+    /// passes so far into the image. Each pass offsets the samples by the next low discrepancy offset, so after N
+    /// passes each pixel has been sampled at N well spread points and the image can be shown after every pass.
+    /// @param sub_func The packet subsampler functor
+    /// @param lanes The most points to give the subsampler at once
+    /// @param sums The running sum of the samples of each pixel (row major, height * width)
+    /// @param pass The number of passes already in the sums (0 for the first)
+    /// @see generate_each for the other parameters
+    ///
+    void accumulate_each(packet_subsampler sub_func, size_t lanes, std::vector<color>& sums, size_t pass,
+                         std::optional<rendered_tile> opt_func = std::nullopt, bool tone_mapping = false,
+                         tiling const& layout = tiling{});
+
+    ///
+    /// Renders each pixel with as many samples as it needs. Every pixel starts with a single sample at its center and a
+    /// pixel which matches its neighbors (within the tolerance) stops there. Any other pixel keeps adding small batches
+    /// of samples (see @ref adaptive_batch) while tracking the running mean and variance of its samples, until the mean
+    /// is known to within the tolerance (see @ref adaptive_confidence) or it has the most samples. All of this is done
+    /// as each tile is rendered so there are no extra passes over the image.
+    /// @param sub_func The packet subsampler functor
+    /// @param lanes The most points to give the subsampler at once
+    /// @param max_samples The most samples of any pixel
+    /// @param tolerance The largest error of the mean of any channel (in linear units) which is accepted
+    /// @param counts The optional image which is given the number of samples of each pixel as a heatmap (scaled so
+    /// max_samples is 255)
+    /// @see generate_each for the other parameters
+    ///
+    void generate_adaptive(packet_subsampler sub_func, size_t lanes, size_t max_samples, precision tolerance,
+                           fourcc::image<fourcc::PixelFormat::Y8>* counts = nullptr,
+                           std::optional<rendered_tile> opt_func = std::nullopt, bool tone_mapping = false,
+                           tiling const& layout = tiling{});
+
+    /// Returns the offset from the pixel center of a sample of a progressive render. These are the Halton sequence in
+    /// bases 2 and 3 (shifted so the first is the center) so that any number of passes covers the pixel evenly.
+    /// @param index The sample (pass) index
+    /// @return A vector within [-0.5, 0.5) in each dimension
+    static image::vector low_discrepancy_offset(size_t index);
 
     /// Returns the image pixel at the point (rounded raster coordinates)
     PixelStorageType& at(point const& p);
@@ -77,6 +138,10 @@ public:
 
     /// The value of the threshold in which the Adaptive Antialiasing is always enabled
     constexpr static uint8_t AAA_MASK_ENABLED = 1u;
+
+protected:
+    /// Stores the linear color (optionally tone mapped) into the pixel
+    void store(size_t y, size_t x, color value, bool tone_mapping);
 };
 
 }  // namespace raytrace
@@ -17,6 +17,7 @@ public:
     ray incident(point const& world_point, size_t sample_index) const override;
     void print(std::ostream& os, char const str[]) const override;
     ray emit() override;
+    precision radius() const override;
 
 protected:
     /// The radius of the bulb
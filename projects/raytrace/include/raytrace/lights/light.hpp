@@ -67,6 +67,17 @@ public:
         return m_samples;
     }
 
+    /// Returns the type of falloff of the intensity
+    inline Falloff falloff() const {
+        return m_falloff;
+    }
+
+    /// Returns the intensity at the source scaled by the brightest channel of the color, used to compare lights
+    precision power() const;
+
+    /// Returns the radius of the volume around the position which the samples of the light come from
+    virtual precision radius() const;
+
     /// @brief The base class stream operator
     /// @param os The output stream to write to
     /// @param l The light reference
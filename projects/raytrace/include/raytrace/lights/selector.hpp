@@ -0,0 +1,74 @@
+#pragma once
+
+/// @file
+/// The Raytrace library light selection header
+
+#include <vector>
+
+#include "raytrace/lights/light.hpp"
+#include "raytrace/types.hpp"
+
+namespace raytrace {
+namespace lights {
+
+/// Chooses lights in proportion to their estimated contribution at a surface point, so a scene with many lights can be
+/// shaded with a fixed number of shadow rays per hit. The lights are kept in a bounding volume hierarchy and each
+/// choice walks down from the root, taking each branch with the probability of its share of the estimated light. A
+/// branch is estimated from its total power over the squared distance to it and is skipped entirely when it is all
+/// behind the surface. A single light is estimated from its own intensity at the point (so its falloff and any cone
+/// are taken into account).
+class selector {
+public:
+    using light_list = std::vector<light const*>;
+
+    /// The light which was chosen and the probability of choosing it
+    struct choice {
+        light const* chosen{nullptr};  ///< The light or nullptr if nothing could be chosen
+        precision probability{0.0_p};  ///< The probability which the light was chosen with
+    };
+
+    selector() = default;
+
+    /// Builds the hierarchy of the lights (replacing any previous lights)
+    void build(light_list const& lights);
+
+    /// Removes all the lights
+    void clear();
+
+    /// Returns the number of lights in the hierarchy
+    size_t size() const;
+
+    /// Chooses a light for a surface point
+    /// @param world_point The point on the surface in world coordinates
+    /// @param world_normal The normal of the surface at the point in world coordinates
+    /// @param value A value in [0, 1) which decides the choice, so evenly spread values give choices in proportion
+    /// @return The light and its probability, or no light if all the lights are behind the surface
+    choice choose(point const& world_point, vector const& world_normal, precision value) const;
+
+    /// Returns the probability that @ref choose picks the light at the surface point (zero if never)
+    precision probability(point const& world_point, vector const& world_normal, light const* target) const;
+
+protected:
+    /// A branch (or a single light) of the hierarchy
+    struct node {
+        point min;                   ///< The lower corner of the volume of the lights
+        point max;                   ///< The upper corner of the volume of the lights
+        precision power{0.0_p};      ///< The total power of the lights
+        size_t left{0U};             ///< The index of the left branch
+        size_t right{0U};            ///< The index of the right branch
+        size_t parent{0U};           ///< The index of the parent (the root is its own parent)
+        light const* leaf{nullptr};  ///< The light if this is a leaf
+    };
+
+    /// Builds the nodes for a range of lights and returns the index of the top one
+    size_t build(light const** first, light const** last, size_t parent);
+
+    /// The estimated light from the node at the surface point (zero if it can not light the surface)
+    precision importance(node const& n, point const& world_point, vector const& world_normal) const;
+
+    /// The nodes with the root first
+    std::vector<node> m_nodes;
+};
+
+}  // namespace lights
+}  // namespace raytrace
@@ -0,0 +1,49 @@
+#pragma once
+
+/// @file
+/// The Raytrace library memory mapped file header
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace raytrace {
+
+/// A read only view of a whole file, mapped into memory where possible (or read whole where mapping is not
+/// available). The contents stay valid for the lifetime of the object.
+class MappedFile {
+public:
+    /// Maps the file
+    /// @param filename The path to the file
+    /// @throw basal::exception if the file can not be opened
+    explicit MappedFile(char const* const filename);
+
+    /// Unmaps the file
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    /// @return The contents of the file
+    inline std::string_view text() const {
+        return std::string_view{m_data, m_size};
+    }
+
+    /// @return The first byte of the file (page aligned when mapped)
+    inline void const* data() const {
+        return m_data;
+    }
+
+    /// @return The number of bytes in the file
+    inline size_t size() const {
+        return m_size;
+    }
+
+protected:
+    char const* m_data;
+    size_t m_size;
+    bool m_mapped;
+    std::string m_copy;
+};
+
+}  // namespace raytrace
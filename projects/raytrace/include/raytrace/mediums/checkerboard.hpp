@@ -7,7 +7,7 @@ namespace raytrace {
 namespace mediums {
 
 /// The checkerboard surface lets users define the size and color of the squares.
-class checkerboard : public opaque {
+class checkerboard final : public opaque {
 public:
     /// @param repeat repeat value (values under 1.0_p scale up pattern, values over 1.0_p scale down pattern)
     checkerboard(precision repeat, color dark, color light);
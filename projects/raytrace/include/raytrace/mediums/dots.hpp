@@ -7,7 +7,7 @@ namespace raytrace {
 namespace mediums {
 
 /// A polka dot styled surface
-class dots : public opaque {
+class dots final : public opaque {
 public:
     /// @param r The number of repeats of the pattern.
     /// @param dot The color of the dot
@@ -20,6 +20,7 @@ public:
 protected:
     precision m_repeat;
     color m_dot, m_background;
+    palette m_pal;  //!< The background and dot colors, made once so shading does not allocate
 };
 
 }  // namespace mediums
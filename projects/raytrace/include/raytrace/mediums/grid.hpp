@@ -7,7 +7,7 @@ namespace raytrace {
 namespace mediums {
 
 /// The grid surface lets users define the size and color of the squares.
-class grid : public opaque {
+class grid final : public opaque {
 public:
     /// @param scale The scaling factor
     grid(precision scale, color dark, color light);
@@ -18,6 +18,7 @@ public:
 protected:
     precision m_scale;
     color m_dark, m_light;
+    palette m_pal;  //!< The dark and light colors, made once so shading does not allocate
 };
 
 }  // namespace mediums
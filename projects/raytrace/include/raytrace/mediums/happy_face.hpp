@@ -7,7 +7,7 @@ namespace raytrace {
 namespace mediums {
 
 /// The stripes surface lets users define the size and color of the stripes.
-class happy_face : public opaque {
+class happy_face final : public opaque {
 public:
     /// @param repeat repeat value (values under 1.0_p scale up pattern, values over 1.0_p scale down pattern)
     happy_face(precision repeat, color dark, color light);
@@ -2,12 +2,15 @@
 
 #include <functional>
 #include <linalg/linalg.hpp>
+#include <memory>
 #include <noise/noise.hpp>
+#include <string>
 
 #include "raytrace/color.hpp"
 #include "raytrace/image.hpp"
 #include "raytrace/mapping.hpp"
 #include "raytrace/mediums/functions.hpp"
+#include "raytrace/texture.hpp"
 #include "raytrace/types.hpp"
 
 namespace raytrace {
@@ -15,6 +18,51 @@ namespace raytrace {
 /// The namespace that contains all surface/volumetric mediums
 namespace mediums {
 
+class medium;
+
+/// The kinds of mediums which are built into the library. Each is a final class, so the kind says exactly what a
+/// medium is and @ref medium::evaluate can call it directly instead of through its virtual methods.
+enum class Kind : uint8_t {
+    Custom,        //!< Any other medium, which is asked through its virtual methods
+    Plain,         //!< @ref plain
+    Metal,         //!< @ref metal
+    Transparent,   //!< @ref transparent
+    Checkerboard,  //!< @ref checkerboard
+    Dots,          //!< @ref dots
+    Grid,          //!< @ref grid
+    HappyFace,     //!< @ref happy_face
+    Perlin,        //!< @ref perlin
+    RandomNoise,   //!< @ref random_noise
+    Stripes,       //!< @ref stripes
+    Turbsin,       //!< @ref turbsin
+};
+
+/// The properties of a medium at a single point on a surface, all evaluated at once (see @ref medium::evaluate) so a
+/// hit makes one call for them rather than one per property and per light sample.
+struct surface {
+    color diffuse;                        ///< The diffuse color
+    color emissive;                       ///< The emitted light
+    color specularity;                    ///< The filter of the specular highlights (only used by metals)
+    precision tightness{0.0_p};           ///< The tightness of the specular highlight
+    precision smoothness{0.0_p};          ///< How much of a coherent mirror the surface is
+    precision refractive_index{0.0_p};    ///< The refractive index of the medium
+    precision reflectivity{0.0_p};        ///< The proportion of reflected light (of the built-in kinds)
+    Kind kind{Kind::Custom};              ///< The kind of the medium
+    medium const* source{nullptr};        ///< The medium, which is still asked by the custom kind
+    raytrace::point volumetric_point;     ///< The point on the surface in object space
+
+    /// Returns the specular highlight of a light (see @ref medium::specular)
+    color specular(precision scaling, color const& light_color) const;
+
+    /// Returns the color bounced from the surface given an incoming color (see @ref medium::bounced)
+    color bounced(color const& incoming) const;
+
+    /// Computes the emissive, reflected and transmitted components of the surface (see @ref medium::radiosity)
+    void radiosity(precision refractive_index, iso::radians const& incident_angle,
+                   iso::radians const& transmitted_angle, precision& emitted, precision& reflected,
+                   precision& transmitted) const;
+};
+
 /// A special mixin interface for mediums which are used to make objects
 class medium {
 public:
@@ -24,6 +72,14 @@ public:
     /// The default destructor
     virtual ~medium() = default;
 
+    /// Evaluates all the properties of the medium at a point on its surface. The built-in kinds are dispatched on
+    /// their @ref Kind without virtual calls, any other medium is asked through its virtual methods.
+    /// @param volumetric_point A point on the surface in object space (not world space)
+    surface evaluate(raytrace::point const& volumetric_point) const;
+
+    /// Returns the kind of the medium
+    Kind kind() const;
+
     /// Returns the overall ambient color, post-scaled. This is a stand-in for light in a scene the bounces around
     /// diffusely
     /// @param volumetric_point A point on the surface in object space (not world space)
@@ -88,7 +144,49 @@ public:
     /// @param volumetric_point A point on the surface in object space (not world space)
     virtual raytrace::vector perturbation(raytrace::point const& volumetric_point) const;
 
+    /// Bakes the diffuse color of the medium over the unit square of its mapper into a mip-mapped @ref texture, which
+    /// later diffuse lookups are filtered from instead of evaluating the (procedural) pattern at every hit. Only the
+    /// unit square is baked and the patterns do not repeat over it, so the texture is clamped (@ref Address::Clamp) at
+    /// its edges. A medium should only be baked when its mapper reduces every point into the unit square (as the
+    /// spherical and toroidal maps do), otherwise the points outside of it take the color of the nearest edge.
+    /// @param resolution The width and height of the largest level of the texture, a power of two
+    /// @param filter How the lookups are filtered
+    /// @param footprint The size in mapped units which a lookup covers, which picks the levels of a trilinear filter
+    /// @param cache_directory If not empty, the texture is loaded from (or else saved to) a file in this directory
+    /// which is named for the parameters of the medium and the resolution
+    /// @throw basal::exception if the medium has no mapper or can not be baked
+    void bake(size_t resolution, Filter filter, precision footprint = 0.0_p, std::string const& cache_directory = "");
+
+    /// Drops the baked texture so the pattern is evaluated again
+    void unbake();
+
+    /// @return True if the diffuse color comes from a baked texture
+    bool is_baked() const;
+
+    /// @return The name of the file which a bake of the medium at the resolution is cached in (without a directory)
+    /// @throw basal::exception if the medium can not be baked
+    std::string bake_name(size_t resolution) const;
+
 protected:
+    /// Returns the diffuse color at a point of the mapped space, which is what a bake samples
+    /// @param texture_point The point from the mapper
+    virtual color mapped_diffuse(image::point const& texture_point) const;
+
+    /// Describes the parameters which determine the pattern of the medium, which keys bakes of it on disk.
+    /// @return An empty string if the medium can not be baked
+    virtual std::string parameters() const;
+
+    /// @return The key of a bake, which is the @ref parameters with the version of the bakes and the precision
+    /// @throw basal::exception if the medium can not be baked
+    std::string bake_key() const;
+
+    /// @return A hash of the bytes which is the same in every build, for naming and keying bakes
+    static uint64_t fingerprint(void const* data, size_t bytes);
+
+    /// Returns the diffuse color of the baked texture at a point
+    /// @param volumetric_point A point on the surface in object space (not world space)
+    color baked_diffuse(raytrace::point const& volumetric_point) const;
+
     /// How bright the ambient color is in unit scale
     precision m_ambient_scale;
     /// The color of the materials under ambient conditions
@@ -119,8 +217,44 @@ protected:
 
     /// The mapping reduction function (if supplied) maps R3 to R2 for "surface mapping"
     mapping::reducer m_reducing_map;
+    /// The kind of the medium, only set by the final built-in classes
+    Kind m_kind;
+    /// The baked diffuse texture, if any
+    std::shared_ptr<texture const> m_baked;
+    /// How the baked texture is filtered
+    Filter m_filter;
+    /// The size of the area each lookup of the baked texture covers
+    precision m_footprint;
 };
 
+inline color medium::baked_diffuse(raytrace::point const& volumetric_point) const {
+    return m_baked->sample(m_reducing_map(volumetric_point), m_filter, m_footprint);
+}
+
+inline color surface::specular(precision scaling, color const& light_color) const {
+    using namespace operators;
+    switch (kind) {
+        case Kind::Custom:
+            return source->specular(volumetric_point, scaling, light_color);
+        case Kind::Metal:
+            return std::pow(scaling, tightness) * (specularity * light_color);
+        default:
+            return (scaling > 0) ? std::pow(scaling, tightness) * light_color : colors::black;
+    }
+}
+
+inline color surface::bounced(color const& incoming) const {
+    using namespace operators;
+    switch (kind) {
+        case Kind::Custom:
+            return source->bounced(volumetric_point, incoming);
+        case Kind::Metal:
+            return diffuse * incoming;
+        default:
+            return incoming;
+    }
+}
+
 /// This is a namespace of constants to use on mediums for smoothness to get a sense of what to expect
 namespace smoothness {
 /// This medium will not reflect *any* light and will only have diffuse and ambient components
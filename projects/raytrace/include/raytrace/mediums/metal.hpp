@@ -7,7 +7,7 @@ namespace raytrace {
 namespace mediums {
 
 /// A sub class of conductors
-class metal : public conductor {
+class metal final : public conductor {
 public:
     metal(color diffuse, precision smoothness, precision tightness, precision fuzz_scale = 0.0_p);
     virtual ~metal() = default;
@@ -17,6 +17,11 @@ public:
 
     vector perturbation(raytrace::point const& volumetric_point) const override;
 
+    /// Returns the color filter of the specular highlights
+    color const& specularity() const {
+        return m_specularity;
+    }
+
 protected:
     /// The color filter of the specular highlight (used only with metals)
     color m_specularity;
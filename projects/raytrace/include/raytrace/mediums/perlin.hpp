@@ -7,7 +7,7 @@ namespace raytrace {
 namespace mediums {
 
 /// A perlin noise generated is used to simulate (poorly) a perlin pattern
-class perlin : public opaque {
+class perlin final : public opaque {
 public:
     perlin(precision seed, precision scale, precision gain, color dark, color light);
     virtual ~perlin() = default;
@@ -15,6 +15,9 @@ public:
     color diffuse(raytrace::point const& volumetric_point) const final;
 
 protected:
+    color mapped_diffuse(image::point const& texture_point) const final;
+    std::string parameters() const final;
+
     color m_dark, m_light;
     noise::vector m_seed;
     precision m_gain;
@@ -7,7 +7,7 @@ namespace raytrace {
 namespace mediums {
 
 /// A standard binn-phong model diffuse surface with specular highlights
-class plain : public opaque {
+class plain final : public opaque {
 public:
     plain(color const& ambient, precision ambient_scale, color const& diffuse, precision smoothness, precision rough);
     virtual ~plain() = default;
@@ -7,7 +7,7 @@ namespace raytrace {
 namespace mediums {
 
 /// Generates seemingly pure random noise as colors per pixel
-class random_noise : public opaque {
+class random_noise final : public opaque {
 public:
     random_noise();
     virtual ~random_noise() = default;
@@ -7,7 +7,7 @@ namespace raytrace {
 namespace mediums {
 
 /// A class of mediums which are dominated by largely transmitted rays, like glass, etc
-class transparent : public dielectric {
+class transparent final : public dielectric {
 public:
     /// The medium's refractive index and fade factor
     transparent(precision eta, precision fade, color const& diffuse);
@@ -7,7 +7,7 @@ namespace raytrace {
 namespace mediums {
 
 /// A perlin noise generated is used to simulate (poorly) a perlin pattern
-class turbsin : public opaque {
+class turbsin final : public opaque {
 public:
     /// @brief The turbulent sin constructor
     /// @param xs X Scale factor
@@ -24,6 +24,9 @@ public:
     color diffuse(raytrace::point const& volumetric_point) const final;
 
 protected:
+    color mapped_diffuse(image::point const& texture_point) const final;
+    std::string parameters() const final;
+
     noise::pad m_pad;
     color m_dark, m_light;
     precision m_xs, m_ys;
@@ -0,0 +1,281 @@
+#pragma once
+
+/// @file
+/// The Raytrace library triangle mesh hierarchy header
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "raytrace/bvh.hpp"
+#include "raytrace/types.hpp"
+
+namespace raytrace {
+
+namespace tree {
+
+/// The signed (doubled) area of the origin and two corners projected along a @ref ShearedRay. The products are always
+/// made in the same order for an edge (whichever way round the corners are given) so the neighbor across a shared edge
+/// gets exactly the negated value, even when the compiler fuses a multiply into the subtraction.
+template <typename TYPE>
+inline TYPE edge_function(TYPE px, TYPE py, TYPE qx, TYPE qy) {
+    if (px < qx or (px == qx and py < qy)) {
+        return (px * qy) - (py * qx);
+    }
+    return -((qx * py) - (qy * px));
+}
+
+/// A ray permuted and sheared so it runs along +Z from the origin, which is computed once per ray for the
+/// @ref watertight_triangle tests (Woop, Benthin and Wald, "Watertight Ray/Triangle Intersection").
+struct ShearedRay {
+    /// @param ray_origin The location of the ray
+    /// @param direction The direction of the ray (must not be zero)
+    ShearedRay(precision const ray_origin[dimensions], precision const direction[dimensions]) {
+        // the largest component of the direction becomes Z, which keeps the shear bounded
+        kz = 0U;
+        for (size_t a = 1U; a < dimensions; a++) {
+            if (std::abs(direction[a]) > std::abs(direction[kz])) {
+                kz = a;
+            }
+        }
+        kx = (kz + 1U) % dimensions;
+        ky = (kx + 1U) % dimensions;
+        if (direction[kz] < 0.0_p) {
+            std::swap(kx, ky);  // keeps the winding of the triangles
+        }
+        Sx = direction[kx] / direction[kz];
+        Sy = direction[ky] / direction[kz];
+        Sz = 1.0_p / direction[kz];
+        for (size_t a = 0; a < dimensions; a++) {
+            origin[a] = ray_origin[a];
+        }
+    }
+    precision origin[dimensions];  //!< The location of the ray
+    size_t kx;                     //!< The axis which becomes X
+    size_t ky;                     //!< The axis which becomes Y
+    size_t kz;                     //!< The axis which becomes Z (the largest component of the direction)
+    precision Sx;                  //!< The shear of X along Z
+    precision Sy;                  //!< The shear of Y along Z
+    precision Sz;                  //!< The scale of Z
+};
+
+/// The watertight test of a ray against a single triangle (from either side). Each corner is moved into the space of
+/// the @ref ShearedRay on its own and the edges are tested with the @ref edge_function "edge functions" of the
+/// projected corners, which triangles sharing an edge compute identically (up to the sign). The tests are inclusive
+/// so a ray through a shared edge or vertex is never lost between the neighboring triangles.
+/// @param ray The sheared ray
+/// @param A The first corner of the triangle
+/// @param B The second corner of the triangle
+/// @param C The third corner of the triangle
+/// @param t [out] The distance along the ray to the hit
+/// @param u [out] The barycentric weight of B
+/// @param v [out] The barycentric weight of C
+/// @return false if the ray is parallel to the triangle or passes outside it
+inline bool watertight_triangle(ShearedRay const& ray, precision const A[dimensions], precision const B[dimensions],
+                                precision const C[dimensions], precision& t, precision& u, precision& v) {
+    precision const Az = A[ray.kz] - ray.origin[ray.kz];
+    precision const Bz = B[ray.kz] - ray.origin[ray.kz];
+    precision const Cz = C[ray.kz] - ray.origin[ray.kz];
+    precision const Ax = (A[ray.kx] - ray.origin[ray.kx]) - ray.Sx * Az;
+    precision const Ay = (A[ray.ky] - ray.origin[ray.ky]) - ray.Sy * Az;
+    precision const Bx = (B[ray.kx] - ray.origin[ray.kx]) - ray.Sx * Bz;
+    precision const By = (B[ray.ky] - ray.origin[ray.ky]) - ray.Sy * Bz;
+    precision const Cx = (C[ray.kx] - ray.origin[ray.kx]) - ray.Sx * Cz;
+    precision const Cy = (C[ray.ky] - ray.origin[ray.ky]) - ray.Sy * Cz;
+    precision U = edge_function(Cx, Cy, Bx, By);
+    precision V = edge_function(Ax, Ay, Cx, Cy);
+    precision W = edge_function(Bx, By, Ax, Ay);
+    if constexpr (sizeof(precision) < sizeof(double)) {
+        // an edge straight through the ray may have lost its sign, so it is decided in higher precision
+        if (U == 0.0_p or V == 0.0_p or W == 0.0_p) {
+            U = static_cast<precision>(edge_function<double>(Cx, Cy, Bx, By));
+            V = static_cast<precision>(edge_function<double>(Ax, Ay, Cx, Cy));
+            W = static_cast<precision>(edge_function<double>(Bx, By, Ax, Ay));
+        }
+    }
+    if ((U < 0.0_p or V < 0.0_p or W < 0.0_p) and (U > 0.0_p or V > 0.0_p or W > 0.0_p)) {
+        return false;
+    }
+    precision const det = U + V + W;
+    if (det == 0.0_p) {
+        return false;
+    }
+    precision const T = (U * Az + V * Bz + W * Cz) * ray.Sz;
+    t = T / det;
+    u = V / det;
+    v = W / det;
+    return true;
+}
+
+/// A read only view of a contiguous array which is owned elsewhere (either by the vectors of a built @ref MeshBVH or by
+/// the mapping of a cache file).
+template <typename TYPE>
+class View {
+public:
+    View() : data_{nullptr}, count_{0U} {
+    }
+    View(TYPE const* data, size_t count) : data_{data}, count_{count} {
+    }
+    /// Views the whole vector (which must outlive the view)
+    explicit View(std::vector<TYPE> const& vec) : data_{vec.data()}, count_{vec.size()} {
+    }
+
+    inline TYPE const& operator[](size_t index) const {
+        return data_[index];
+    }
+    inline size_t size() const {
+        return count_;
+    }
+    inline bool empty() const {
+        return count_ == 0U;
+    }
+    inline TYPE const* data() const {
+        return data_;
+    }
+    inline TYPE const* begin() const {
+        return data_;
+    }
+    inline TYPE const* end() const {
+        return data_ + count_;
+    }
+
+protected:
+    TYPE const* data_;
+    size_t count_;
+};
+
+/// A triangle found along a ray by a @ref MeshBVH
+struct TriangleHit {
+    precision t{basal::pos_inf};  //!< The distance along the ray
+    precision u{0.0_p};           //!< The barycentric weight of the second corner
+    precision v{0.0_p};           //!< The barycentric weight of the third corner
+    uint32_t triangle{0U};        //!< The index of the triangle (in the order it was given to the build)
+};
+
+/// @brief A bottom level hierarchy over the triangles of a mesh, in the mesh's own (object) space. The vertices are
+/// shared between triangles and stored as a Structure of Arrays with each triangle holding three vertex indices. The
+/// triangles are reordered so each leaf of the (SAH built) @ref FlatNode array refers to a contiguous range of them.
+/// The triangles are one sided, only the side their normal faces can be hit. An object (like @ref objects::Model) owns
+/// a mesh and is a single leaf in the scene hierarchy, so copies of the object at different transforms can share it.
+/// The arrays are @ref View "Views", so a mesh can be written to a binary cache with @ref save and later used in place
+/// from a memory mapping of the cache with @ref map without parsing or rebuilding anything.
+class MeshBVH {
+public:
+    /// Three vertex indices, in counter clockwise order around the normal
+    using indices = std::array<uint32_t, 3>;
+    /// The number of triangles at or below which a node is always a leaf
+    static constexpr size_t MaxLeafTriangles{4U};
+
+    /// The version of the cache layout, caches of any other version are ignored
+    static constexpr uint32_t CacheVersion{2U};
+
+    /// Constructs an empty mesh
+    MeshBVH();
+
+    // the views point into the storage so copies would have to fix them up
+    MeshBVH(MeshBVH const&) = delete;
+    MeshBVH& operator=(MeshBVH const&) = delete;
+
+    /// (Re)builds the mesh.
+    /// @param vertices The shared vertices of the mesh
+    /// @param triangles The vertex indices of each triangle
+    /// @param normals The shading normal of each triangle (may be empty to use the geometric normal of each)
+    /// @throw basal::exception if an index is out of range or the normals do not match the triangles
+    void build(std::vector<point> const& vertices, std::vector<indices> const& triangles,
+               std::vector<vector> const& normals = std::vector<vector>{});
+
+    /// Finds the nearest triangle facing the ray within (t_min, t_max). Does not allocate.
+    /// @param object_ray The ray in the mesh's space
+    /// @param t_min The nearest distance to consider
+    /// @param t_max The farthest distance to consider
+    /// @param nearest [out] The nearest triangle
+    /// @return true if a triangle was found
+    bool closest(ray const& object_ray, precision t_min, precision t_max, TriangleHit& nearest) const;
+
+    /// Finds every triangle facing the ray (as a line) in any order.
+    /// @param object_ray The ray in the mesh's space
+    /// @param found [out] Each triangle along the ray (appended)
+    void all(ray const& object_ray, std::vector<TriangleHit>& found) const;
+
+    /// Finds a triangle which contains the point.
+    /// @param object_point The point in the mesh's space
+    /// @param tolerance The distance from the plane of a triangle which still counts as on it
+    /// @param triangle [out] The index of the triangle (in the order it was given to the build)
+    /// @return true if the point is on a triangle
+    bool locate(point const& object_point, precision tolerance, uint32_t& triangle) const;
+
+    /// @return The unit (shading) normal of the triangle
+    vector normal(uint32_t triangle) const;
+
+    /// @return The distance of the farthest vertex from the origin of the mesh's space
+    precision extent() const;
+
+    /// @return The number of triangles
+    inline size_t triangle_count() const {
+        return order_.size();
+    }
+
+    /// @return The number of shared vertices
+    inline size_t vertex_count() const {
+        return vertices_[0].size();
+    }
+
+    /// @return The flattened nodes (for inspection)
+    inline View<FlatNode> const& nodes() const {
+        return nodes_;
+    }
+
+    /// Writes the mesh to a versioned binary cache. Every array starts on a cache line so @ref map can use them in
+    /// place.
+    /// @param filename The path of the cache
+    /// @param extra Any bytes the owner wants kept with the mesh (given back by @ref map)
+    /// @return false if the file could not be written
+    bool save(char const* const filename, std::string_view extra = std::string_view{}) const;
+
+    /// Maps a cache written by @ref save. The arrays are used in place in the mapping, which is kept until the mesh is
+    /// destroyed.
+    /// @param filename The path of the cache
+    /// @param extra [out] The owner's bytes (valid as long as the mesh)
+    /// @return nullptr if the file is missing, is not a cache, is truncated, has a different version or precision or
+    /// has an index which refers outside of its arrays
+    static std::shared_ptr<MeshBVH const> map(char const* const filename, std::string_view& extra);
+
+    /// @return The deepest level of the hierarchy
+    inline size_t depth() const {
+        return depth_;
+    }
+
+protected:
+    /// @return true if every index refers inside its array and the nodes form one tree no deeper than
+    /// @ref BVH::MaxDepth (which a mapped cache must be checked for before it is traversed)
+    bool valid() const;
+
+    /// Gathers the corners of the triangle in the leaf slot
+    void corners(size_t slot, precision (&A)[dimensions], precision (&B)[dimensions], precision (&C)[dimensions]) const;
+
+    /// Owns the memory the views refer to (the arrays of a build or the mapping of a cache)
+    std::shared_ptr<void const> storage_;
+    /// The coordinates of the shared vertices (x, y and z arrays)
+    View<precision> vertices_[dimensions];
+    /// The vertex indices of each corner of the triangles in leaf order (first, second and third corner arrays)
+    View<uint32_t> corners_[dimensions];
+    /// The unit normal of each triangle in leaf order (x, y and z arrays)
+    View<precision> normals_[dimensions];
+    /// The index of the triangle (in build order) in each leaf slot
+    View<uint32_t> order_;
+    /// The leaf slot of each triangle (in build order)
+    View<uint32_t> slots_;
+    /// The flattened nodes in depth first order
+    View<FlatNode> nodes_;
+    /// The deepest level reached during the build
+    size_t depth_;
+    /// The distance to the farthest vertex
+    precision extent_;
+};
+
+}  // namespace tree
+}  // namespace raytrace
@@ -23,10 +23,13 @@ public:
     // ┌─────────────────────────┐
     // │raytrace::objects::object│
     // └─────────────────────────┘
+    using object::intersect;
     hits collisions_along(ray const& object_ray) const override;
+    bool intersect(ray_packet const& world_rays, precision (&distances)[ray_packet::width]) const override;
     image::point map(point const& object_surface_point) const override;
     bool is_surface_point(point const& world_point) const override;
     precision get_object_extent(void) const override;
+    Bounds get_object_bounds(void) const override;
     void print(std::ostream& os, char const str[]) const override;
 
     precision const& x_half_width;
@@ -29,6 +29,7 @@ public:
     image::point map(point const& object_surface_point) const override;
     bool is_surface_point(point const& world_point) const override;
     precision get_object_extent(void) const override;
+    Bounds get_object_bounds(void) const override;
     void print(std::ostream& os, char const str[]) const override;
 
 protected:
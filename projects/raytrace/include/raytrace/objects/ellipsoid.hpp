@@ -9,6 +9,7 @@ public:
     ellipsoid(point const& center, precision a, precision b, precision c);
     ~ellipsoid() = default;
     precision get_object_extent(void) const override;
+    Bounds get_object_bounds(void) const override;
 };
 }  // namespace objects
 }  // namespace raytrace
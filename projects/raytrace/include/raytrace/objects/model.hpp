@@ -1,14 +1,17 @@
 #pragma once
 
+#include <memory>
+#include <raytrace/mesh.hpp>
 #include <raytrace/objects/object.hpp>
-#include <raytrace/objects/face.hpp>
+#include <raytrace/objloader.hpp>
 #include <raytrace/objparser.hpp>
 
 namespace raytrace {
 namespace objects {
 
 /// @class Model
-/// @brief Represents a 3D model object in the ray tracing system.
+/// @brief Represents a 3D model object in the ray tracing system. The triangles are held in a @ref tree::MeshBVH which
+/// is built once loading completes, so the scene hierarchy sees the whole model as a single object.
 
 class Model
     : public object
@@ -17,6 +20,11 @@ public:
     /// @brief Default constructor for the Model class.
     Model();
 
+    /// @brief Constructs an instance of an already loaded mesh (i.e. the @ref mesh of another Model). The instance has
+    /// its own transform and material but shares the triangles.
+    /// @param mesh The loaded mesh
+    explicit Model(std::shared_ptr<tree::MeshBVH const> mesh);
+
     /// @brief Prints the model information.
     /// @param name The name to be printed.
     void print(std::ostream& os, char const name[]) const override;
@@ -75,30 +83,80 @@ public:
     /// @return The number of faces.
     size_t GetNumberOfFaces(void) const;
 
-    /// @brief Loads the model from a file.
+    /// @brief The size and the modification time of the OBJ file a model was loaded from. A cache records the source
+    /// it was written from, so a cache of a file which has since changed (or been replaced) is not used.
+    struct Source {
+        uint64_t size{0U};  //!< The size of the file in bytes
+        int64_t time{0};    //!< The modification time of the file (in the ticks of the file clock)
+    };
+
+    /// @brief Loads the model from a file with the bulk @ref obj::load (memory mapped and parsed in parallel). When
+    /// @ref use_mesh_cache is set, a cache (the filename with @ref CacheSuffix) which was written from the same
+    /// @ref Source is used instead and otherwise one is written after the load.
     /// @param filename The path to the file.
     void LoadFromFile(char const* const filename);
 
+    /// @brief Writes the loaded model (the mesh, its hierarchy, the texels and the centroid) to a binary cache.
+    /// @param filename The path of the cache.
+    /// @return false if there is no mesh or the cache could not be written.
+    bool SaveCache(char const* const filename) const;
+
+    /// @brief Loads the model from a cache written by @ref SaveCache. The mesh is used in place from a mapping of the
+    /// cache, so nothing is parsed or rebuilt.
+    /// @param filename The path of the cache.
+    /// @param source When given, the cache is only used if it was written from this source.
+    /// @return false if the cache is missing or can not be used (the model is unchanged).
+    bool LoadFromCache(char const* const filename, Source const* source = nullptr);
+
+    /// The suffix added to the name of an OBJ file to name its cache
+    static constexpr char const* const CacheSuffix{".mesh"};
+
     /// @brief Loads the model from a string literal.
     /// @param literal The string containing the model data.
     void LoadFromString(char const* const literal);
 
-    /// @brief Gets the statistics of the model parser.
-    /// @return The statistics of the parser.
+    /// @brief Gets the statistics of the loaded file.
+    /// @return The number of each kind of line which was loaded.
     obj::Parser::Statistics const& GetStatistics() const;
 
+    /// @brief Gets the triangle hierarchy of the model.
+    /// @return The mesh, or nullptr before the model is loaded.
+    std::shared_ptr<tree::MeshBVH const> const& mesh() const;
+
+    using object::intersect;
+    /// @brief Finds the nearest triangle through the mesh hierarchy instead of testing every face.
+    hit intersect(ray const& world_ray) const override;
+    /// @brief Records the nearest triangle and its barycentric coordinates, the normal is found by @ref resolve.
+    bool intersect(ray const& world_ray, hit_record& record) const override;
+    hit resolve(ray const& world_ray, hit_record const& record) const override;
     bool is_surface_point(raytrace::point const& world_point) const override;
     hits collisions_along(ray const& object_ray) const override;
     image::point map(point const& object_surface_point) const override;
     precision get_object_extent(void) const override;
+    Bounds get_object_bounds(void) const override;
 
 protected:
     vector normal_(point const& object_surface_point) const override;
+    /// @brief Adds a triangle (if the indices are valid) with either the average of the given normals or the
+    /// geometric normal.
+    void addTriangle(uint32_t ia, uint32_t ib, uint32_t ic, raytrace::vector const* na = nullptr,
+                     raytrace::vector const* nb = nullptr, raytrace::vector const* nc = nullptr);
+    /// @brief Adds the loaded vertices, normals, texels and (valid) triangles.
+    void addContents(obj::Contents const& contents);
+    /// @brief The nearest distance along the object ray a triangle may be hit, which is just behind the origin when a
+    /// hit at the origin counts.
+    precision nearest_allowed(ray const& object_ray) const;
+    /// @brief Builds the mesh from the loaded triangles with every vertex moved by the offset.
+    void buildMesh(raytrace::vector const& offset);
     std::vector<raytrace::point> points_;
     std::vector<raytrace::vector> normals_;
     std::vector<image::point> texels_;
-    std::vector<raytrace::objects::face> faces_;
-    obj::Parser parser_;
+    std::vector<tree::MeshBVH::indices> triangles_;
+    std::vector<raytrace::vector> triangle_normals_;
+    std::shared_ptr<tree::MeshBVH const> mesh_;
+    obj::Parser::Statistics statistics_;
+    raytrace::vector centroid_;
+    Source source_;
     bool loaded_;
 };
 }  // namespace objects
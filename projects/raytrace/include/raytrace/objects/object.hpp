@@ -1,8 +1,10 @@
 #pragma once
 
+#include <algorithm>
 #include <iostream>
 
 #include "basal/basal.hpp"
+#include "basal/small_vector.hpp"
 #include "raytrace/entity.hpp"
 #include "raytrace/laws.hpp"
 #include "raytrace/bounds.hpp"
@@ -260,8 +262,20 @@ public:
                       << ", object=" << h.object << "}";
         }
     };
-    /// A set of distances along the world_ray which collide with the object, could be many.
-    using hits = std::vector<hit>;
+    /// A set of distances along the world_ray which collide with the object, could be many. Most objects have only a
+    /// few collisions so they are kept inline and finding them does not allocate.
+    using hits = basal::small_vector<hit, inline_collisions>;
+
+    /// A compact record of the nearest hit along a world ray. Only what is needed to choose between candidates is
+    /// kept, the surface of the winner (world point and normal) is computed once by @ref resolve.
+    struct hit_record {
+        precision distance{basal::pos_inf};  //!< The world space distance along the ray to the hit
+        precision t{basal::pos_inf};         //!< The distance along the object space ray to the hit
+        object_ const* object{nullptr};      //!< The object which was hit
+        uint32_t primitive{0U};              //!< The part of the object which was hit (a triangle, a collision, etc)
+        precision u{0.0_p};                  //!< The barycentric (or surface) coordinates within the primitive
+        precision v{0.0_p};                  //!< The barycentric (or surface) coordinates within the primitive
+    };
 
     /// Returns all the intersections with this object along the ray (extended as a line).
     /// @param object_ray The ray in object space.
@@ -282,45 +296,61 @@ public:
         ray object_ray = entity_<DIMS>::reverse_transform(world_ray);
         // get the set of all collisions with the object
         hits collisions = collisions_along(object_ray);
-        // ts could contain NaN and +Inf/-Inf
-        for (auto& collision : collisions) {
-            if (basal::is_nan(collision.distance)) {
-                continue;
-            }
-            if (collision.normal.is_zero()) {
-                std::cout << "Got a zero normal for collision " << collision << " on object " << this << std::endl;
-                continue;
-            }
-            // basal::exception::throw_if(collision.normal == R3::null, __FILE__, __LINE__, "The normal can't be null");
-            if constexpr (can_ray_origin_be_collision) {
-                if (basal::nearly_zero(collision.distance)) {
-                    vector const N = normal_(object_ray.location());
-                    vector const& I = object_ray.direction();
-                    precision d = dot(N, I);
-                    if (d < 0.0_p) {  // the ray points "into" the material so it's a collision
-                        // however if the material is transparent, that's ok and it should not count as a collision
-                        if (m_medium and m_medium->refractive_index(object_ray.location()) > 0.0_p) {
-                            continue;
-                        }
-                        closest = collision;
-                        closest.intersect = intersection{entity_<DIMS>::forward_transform(as_point(closest.intersect))};
-                        closest.normal = entity_<DIMS>::forward_transform(closest.normal);
-                        break;
-                    } else {
-                        // the ray points "out" of the material so no collision
-                    }
-                }
-            }
-            if (basal::epsilon < collision.distance and collision.distance < closest.distance) {
-                closest = collision;
-                // update the collision point to be in world space
-                closest.intersect = intersection{entity_<DIMS>::forward_transform(as_point(closest.intersect))};
-                closest.normal = entity_<DIMS>::forward_transform(closest.normal);
-            }
+        size_t index;
+        if (nearest_collision(object_ray, collisions, index)) {
+            // only the chosen collision is moved to world space
+            hit const& collision = collisions[index];
+            closest = hit{intersection{entity_<DIMS>::forward_transform(as_point(collision.intersect))},
+                          collision.distance, entity_<DIMS>::forward_transform(collision.normal), collision.object};
         }
         return closest;
     }
 
+    /// Finds the nearest hit with this object (by the rules of @ref intersect) and keeps it in the record if it is
+    /// nearer than the record's hit and not at the origin of the world ray. Nothing is moved to world space except the
+    /// distance. Objects override this to avoid making the list of @ref collisions_along.
+    /// @param world_ray The ray from the world space to test the intersection with.
+    /// @param record [in,out] The nearest hit so far, replaced if this object's hit is nearer.
+    /// @return true if the object was hit at all (nearer or not)
+    virtual bool intersect(ray const& world_ray, hit_record& record) const {
+        ray const object_ray = entity_<DIMS>::reverse_transform(world_ray);
+        hits const collisions = collisions_along(object_ray);
+        size_t index;
+        if (not nearest_collision(object_ray, collisions, index)) {
+            return false;
+        }
+        keep(world_ray, as_point(collisions[index].intersect), collisions[index].distance,
+             static_cast<uint32_t>(index), 0.0_p, 0.0_p, record);
+        return true;
+    }
+
+    /// Computes the surface (world point and normal) of a hit kept by @ref intersect "intersect" in a record. The
+    /// default finds the collisions again and moves the recorded one to world space.
+    /// @param world_ray The same ray given to intersect
+    /// @param record The record of a hit on this object
+    virtual hit resolve(ray const& world_ray, hit_record const& record) const {
+        ray const object_ray = entity_<DIMS>::reverse_transform(world_ray);
+        hits const collisions = collisions_along(object_ray);
+        if (record.primitive >= collisions.size()) {
+            return hit{};
+        }
+        hit const& collision = collisions[record.primitive];
+        return hit{intersection{entity_<DIMS>::forward_transform(as_point(collision.intersect))}, collision.distance,
+                   entity_<DIMS>::forward_transform(collision.normal), collision.object};
+    }
+
+    /// Finds the distance from the origin of each world ray in the packet to its nearest hit on this object, following
+    /// the same rules as @ref intersect. Lanes which miss are infinite. Lanes where the scalar rules are subtle (a hit
+    /// at the ray origin) are NaN and must use @ref intersect instead.
+    /// @param world_rays The packet of rays in world space
+    /// @param distances [out] The world space distance to the hit in each lane
+    /// @return false if the object has no packet intersection, in which case every lane must use @ref intersect
+    virtual bool intersect(ray_packet const& world_rays, precision (&distances)[ray_packet::width]) const {
+        (void)world_rays;
+        (void)distances;
+        return false;
+    }
+
     /// Maps a surface point (in R3 object space) to a image::point in u,v coordinates (R2)
     /// @param object_surface_point The point on the surface of the object in object space coordinates
     virtual image::point map(point const& object_surface_point) const = 0;
@@ -365,25 +395,69 @@ public:
         return false;  // override to correct
     }
 
-    /// Computes the Axis Aligned Bounding Box in World Coordinates for this object.
+    /// Computes the Axis Aligned Bounding Box in World Coordinates for this object. The corners of the object space
+    /// bounds are moved by the full transform (scale, rotation and translation) so the box stays tight around thin or
+    /// long objects.
     Bounds get_world_bounds(void) const {
-        // finds the object's maximum radial distance from the object origin
+        Bounds const object_bounds = get_object_bounds();
+        if (object_bounds.is_infinite()) {
+            return Bounds{};  // infinite bounds
+        }
+        point const& position = entity_<DIMS>::position();
+        point lower{basal::pos_inf, basal::pos_inf, basal::pos_inf};
+        point upper{basal::neg_inf, basal::neg_inf, basal::neg_inf};
+        // the largest term of the transform, the position plus the largest moved corner
+        precision magnitude = 0.0_p;
+        for (size_t c = 0; c < Bounds::NumSubBounds; c++) {
+            point const corner{(c & 1U) ? object_bounds.max.x() : object_bounds.min.x(),
+                               (c & 2U) ? object_bounds.max.y() : object_bounds.min.y(),
+                               (c & 4U) ? object_bounds.max.z() : object_bounds.min.z()};
+            point const world_corner = entity_<DIMS>::forward_transform(corner);
+            for (size_t a = 0; a < DIMS; a++) {
+                lower[a] = std::min(lower[a], world_corner[a]);
+                upper[a] = std::max(upper[a], world_corner[a]);
+                magnitude = std::max(magnitude, std::abs(world_corner[a] - position[a]) + std::abs(position[a]));
+            }
+        }
+        // a little slack for the rounding of the transform (and the exclusive upper side)
+        precision const slack = bounds_slack(magnitude);
+        for (size_t a = 0; a < DIMS; a++) {
+            lower[a] -= slack;
+            upper[a] += slack;
+        }
+        if constexpr (debug::bounds) {
+            std::cout << "Object position " << entity_<3>::position() << " object " << object_bounds << " world "
+                      << lower << " " << upper << std::endl;
+        }
+        // constructs a local with min (inclusive) and max (exclusive)
+        return Bounds{lower, upper};
+    }
+
+    /// Computes the former World Bounds, a cube around the position with the half size of the object extent (ignoring
+    /// rotation and scale). Kept to compare against @ref get_world_bounds.
+    Bounds get_radial_world_bounds(void) const {
         auto r = get_object_extent();
         basal::exception::throw_if(std::isnan(r) or r < 0.0_p, __FILE__, __LINE__, "Got a %lf from an extent\r\n", r);
         if (std::isinf(r)) {
             return Bounds{};  // infinite bounds
         }
-        // the bounding box should not take into account the rotation of the object, this will cause max < min.
         auto p0 = raytrace::point{-r, -r, -r} + (entity_<DIMS>::position() - R3::origin);
         auto p1 = raytrace::point{r, r, r} + (entity_<DIMS>::position() - R3::origin);
-        if constexpr (debug::bounds) {
-            std::cout << "Object position " << entity_<3>::position() << " extent: " << r << " p0 " << p0 << " p1 "
-                      << p1 << std::endl;
-        }
-        // constructs a local with min (inclusive) and max (exclusive)
         return Bounds{p0, p1};
     }
 
+    /// Returns the Axis Aligned Bounding Box of the object in its own (object) space. The default is a cube with the
+    /// half size of @ref get_object_extent, objects override it with their exact bounds. Flat objects are given a
+    /// little thickness.
+    virtual Bounds get_object_bounds(void) const {
+        auto r = get_object_extent();
+        basal::exception::throw_if(std::isnan(r) or r < 0.0_p, __FILE__, __LINE__, "Got a %lf from an extent\r\n", r);
+        if (std::isinf(r)) {
+            return Bounds{};  // infinite bounds
+        }
+        return Bounds{raytrace::point{-r, -r, -r}, raytrace::point{r, r, r}};
+    }
+
     /// Returns the maximum radial distance from the object origin on the surface of the object.
     /// @warning Objects which are not closed or have infinite dimensionality will return std::nan
     virtual precision get_object_extent(void) const = 0;
@@ -415,6 +489,113 @@ protected:
     /// @return
     virtual vector normal_(point const& object_surface_point) const = 0;
 
+    /// How @ref intersect treats a single collision
+    enum class Verdict : uint8_t {
+        Ignore,  //!< Not a hit (behind the ray, at a transparent or outward origin, or no nearer)
+        Nearer,  //!< Nearer than the nearest so far
+        Origin,  //!< At the origin of a ray which points into (opaque) material, it wins outright
+    };
+
+    /// The rules of @ref intersect for a collision at t along the object ray.
+    /// @param object_ray The ray in object space
+    /// @param t The distance along the object ray of the collision
+    /// @param nearest The distance of the nearest collision so far
+    Verdict judge(ray const& object_ray, precision t, precision nearest) const {
+        if (basal::is_nan(t)) {
+            return Verdict::Ignore;
+        }
+        if constexpr (can_ray_origin_be_collision) {
+            if (basal::nearly_zero(t)) {
+                vector const N = normal_(object_ray.location());
+                precision const d = dot(N, object_ray.direction());
+                if (d < 0.0_p) {  // the ray points "into" the material so it's a collision
+                    // however if the material is transparent, that's ok and it should not count as a collision
+                    if (m_medium and m_medium->refractive_index(object_ray.location()) > 0.0_p) {
+                        return Verdict::Ignore;
+                    }
+                    return Verdict::Origin;
+                }
+                // the ray points "out" of the material so no collision
+            }
+        }
+        return (basal::epsilon < t and t < nearest) ? Verdict::Nearer : Verdict::Ignore;
+    }
+
+    /// Chooses the collision which @ref intersect returns, without moving anything to world space.
+    /// @param object_ray The ray in object space
+    /// @param collisions The collisions along the object ray
+    /// @param index [out] The index of the chosen collision
+    /// @return false if none of the collisions count
+    bool nearest_collision(ray const& object_ray, hits const& collisions, size_t& index) const {
+        precision nearest = basal::pos_inf;
+        bool found = false;
+        // ts could contain NaN and +Inf/-Inf
+        for (size_t i = 0; i < collisions.size(); i++) {
+            hit const& collision = collisions[i];
+            if (basal::is_nan(collision.distance)) {
+                continue;
+            }
+            if (collision.normal.is_zero()) {
+                std::cout << "Got a zero normal for collision " << collision << " on object " << this << std::endl;
+                continue;
+            }
+            Verdict const verdict = judge(object_ray, collision.distance, nearest);
+            if (verdict == Verdict::Origin) {
+                index = i;
+                return true;
+            } else if (verdict == Verdict::Nearer) {
+                nearest = collision.distance;
+                index = i;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    /// Chooses the root which @ref intersect would return, for objects which find their collisions as plain distances.
+    /// @param object_ray The ray in object space
+    /// @param roots The distances along the object ray (which may be NaN)
+    /// @param count The number of roots
+    /// @param index [out] The index of the chosen root
+    /// @return false if none of the roots count
+    bool nearest_root(ray const& object_ray, precision const roots[], size_t count, size_t& index) const {
+        precision nearest = basal::pos_inf;
+        bool found = false;
+        for (size_t i = 0; i < count; i++) {
+            Verdict const verdict = judge(object_ray, roots[i], nearest);
+            if (verdict == Verdict::Origin) {
+                index = i;
+                return true;
+            } else if (verdict == Verdict::Nearer) {
+                nearest = roots[i];
+                index = i;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    /// Keeps a hit in the record if it is nearer (in world space) than the record's hit and not at the world ray's
+    /// origin, the same test as @ref tree::keep_nearest.
+    /// @param world_ray The ray in world space
+    /// @param object_point The hit in object space
+    /// @param t The distance along the object ray of the hit
+    /// @param primitive The part of the object which was hit
+    /// @param u The first surface coordinate
+    /// @param v The second surface coordinate
+    /// @param record [in,out] The nearest hit so far
+    /// @return true if the record was replaced
+    bool keep(ray const& world_ray, point const& object_point, precision t, uint32_t primitive, precision u,
+              precision v, hit_record& record) const {
+        point const world_point = entity_<DIMS>::forward_transform(object_point);
+        precision const distance2 = (world_point - world_ray.location()).quadrance();
+        if (basal::epsilon < distance2 and distance2 < (record.distance * record.distance)) {
+            record = hit_record{std::sqrt(distance2), t, this, primitive, u, v};
+            return true;
+        }
+        return false;
+    }
+
     /// the type of object, used for debugging and determining the type of in debugging windows when viewing the object
     Type m_type;
     /// The maximum number of collisions with the surface of this object
@@ -442,6 +623,9 @@ using hit = object::hit;
 /// A set of hits (from the object type)
 using hits = object::hits;
 
+/// The compact record of the nearest hit (from the object type)
+using hit_record = object::hit_record;
+
 /// A list of object pointers (can't name it objects as that's the namespace)
 using object_list = std::vector<object*>;
 
@@ -23,6 +23,7 @@ public:
     /// @param t The type of overlap
     /// When the type is subtractive, the position of the overlap object is at the center of A.
     /// All other types of overlaps have their position at the centroid of A and B.
+    /// @note A and B must be placed before the overlap is made
     overlap(object const& A, object const& B, type t);
 
     virtual ~overlap() = default;
@@ -35,6 +36,7 @@ public:
     void print(std::ostream& os, char const str[]) const override;
     bool is_surface_point(point const& world_point) const override;
     precision get_object_extent(void) const override;
+    Bounds get_object_bounds(void) const override;
     bool is_along_infinite_extent(ray const& world_ray) const override;
     bool is_outside(point const& world_point) const override;
     size_t max_collisions(void) const override;
@@ -24,7 +24,11 @@ public:
     // ┌─────────────────────────┐
     // │raytrace::objects::object│
     // └─────────────────────────┘
+    using object::intersect;
     hits collisions_along(ray const& object_ray) const override;
+    bool intersect(ray const& world_ray, hit_record& record) const override;
+    hit resolve(ray const& world_ray, hit_record const& record) const override;
+    bool intersect(ray_packet const& world_rays, precision (&distances)[ray_packet::width]) const override;
     image::point map(point const& object_surface_point) const override;
     void print(std::ostream& os, char const str[]) const override;
     bool is_surface_point(point const& world_point) const override;
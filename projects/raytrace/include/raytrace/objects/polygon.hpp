@@ -33,6 +33,7 @@ public:
     hits collisions_along(ray const& object_ray) const override;
     bool is_surface_point(point const& world_point) const override;
     precision get_object_extent(void) const override;
+    Bounds get_object_bounds(void) const override;
     void print(std::ostream& os, char const str[]) const override;
     image::point map(point const& object_surface_point) const override;
 
@@ -61,7 +62,7 @@ std::array<raytrace::point, N> make_polygon_points(precision radius, R3::point c
     R3::vector const offset = center - R3::origin;
     for (size_t i = 0; i < N; ++i) {
         precision angle = -iso::tau * static_cast<precision>(i) / static_cast<precision>(N);
-        points[i] = raytrace::point{radius * cos(angle), radius * sin(angle), 0} + offset;
+        points[i] = raytrace::point{radius * std::cos(angle), radius * std::sin(angle), 0} + offset;
     }
     return points;
 }
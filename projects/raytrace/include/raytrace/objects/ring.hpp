@@ -33,6 +33,7 @@ public:
     void print(std::ostream& os, char const str[]) const override;
     bool is_surface_point(point const& world_point) const override;
     precision get_object_extent(void) const override;
+    Bounds get_object_bounds(void) const override;
 
 private:
     precision m_inner_radius2;  ///< Squared Inner Radius
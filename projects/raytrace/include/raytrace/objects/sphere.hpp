@@ -19,11 +19,16 @@ public:
     // ┌─────────────────────────┐
     // │raytrace::objects::object│
     // └─────────────────────────┘
+    using object::intersect;
     bool is_surface_point(point const& world_surface_point) const override;
     hits collisions_along(ray const& object_ray) const override;
+    bool intersect(ray const& world_ray, hit_record& record) const override;
+    hit resolve(ray const& world_ray, hit_record const& record) const override;
+    bool intersect(ray_packet const& world_rays, precision (&distances)[ray_packet::width]) const override;
     image::point map(point const& object_surface_point) const override;
     void print(std::ostream& os, char const str[]) const override;
     precision get_object_extent(void) const override;
+    Bounds get_object_bounds(void) const override;
 
 protected:
     vector normal_(point const& object_surface_point) const override;
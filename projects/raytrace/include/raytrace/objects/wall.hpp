@@ -22,7 +22,9 @@ public:
     // ┌─────────────────────────┐
     // │raytrace::objects::object│
     // └─────────────────────────┘
+    using object::intersect;
     hits collisions_along(ray const& object_ray) const override;
+    bool intersect(ray_packet const& world_rays, precision (&distances)[ray_packet::width]) const override;
     image::point map(point const& object_surface_point) const override;
     bool is_surface_point(point const& world_point) const override;
     precision get_object_extent(void) const override;
@@ -0,0 +1,51 @@
+#pragma once
+
+/// @file
+/// The Raytrace library bulk OBJ loader header
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "raytrace/configuration.hpp"
+#include "raytrace/types.hpp"
+// the parser depends on the includes above
+#include "raytrace/objparser.hpp"
+
+namespace raytrace {
+namespace obj {
+
+/// The whole contents of an OBJ file in flat arrays. Unlike the @ref Parser, which calls an @ref Observer for each
+/// element, the loader sizes every array from a counting pass and then fills them in place, so a multi-million triangle
+/// file is a handful of allocations.
+struct Contents {
+    /// The corners of a triangle. Indices are zero based, the texture and normal indices are @ref Absent when the face
+    /// did not give them. Relative (negative) indices in the file are resolved.
+    struct Triangle {
+        std::array<uint32_t, 3> vertex;   //!< The vertex index of each corner
+        std::array<uint32_t, 3> texture;  //!< The texture coordinate index of each corner
+        std::array<uint32_t, 3> normal;   //!< The normal index of each corner
+    };
+    /// The index used when a face does not give a texture coordinate or normal
+    static constexpr uint32_t Absent{UINT32_MAX};
+
+    std::vector<std::array<float, 3>> vertices;  //!< The "v" lines
+    std::vector<std::array<float, 3>> normals;   //!< The "vn" lines
+    std::vector<std::array<float, 2>> textures;  //!< The "vt" lines
+    std::vector<Triangle> triangles;             //!< The "f" lines, polygons are split into a fan of triangles
+    Parser::Statistics statistics;               //!< The number of each kind of line (faces counts "f" lines)
+};
+
+/// Loads an OBJ file by mapping it into memory (or reading it whole where mapping is not available).
+/// The text is split into chunks at line boundaries which are counted and then parsed in parallel (with OpenMP).
+/// @param filename The path to the file
+/// @throw basal::exception if the file can not be opened
+Contents load(char const* const filename);
+
+/// Loads the OBJ text, the same as @ref load of a file.
+/// @param text The contents of an OBJ file
+Contents load(std::string_view text);
+
+}  // namespace obj
+}  // namespace raytrace
@@ -0,0 +1,75 @@
+#pragma once
+
+/// @file
+/// The Raytrace library ray packet header
+
+#include <cmath>
+
+#include "raytrace/types.hpp"
+
+namespace raytrace {
+
+/// A small set of (usually coherent) rays stored as a Structure of Arrays so that each step of a test is a single
+/// vector operation across all the lanes. Lanes at or beyond @ref count are unused and their results must be ignored.
+/// The width is part of the layout of the library's public types, so it comes from the build (RAYTRACE_PACKET_WIDTH,
+/// which CMake defines for the library and everything which links it) and never from the instruction set of whichever
+/// translation unit includes this.
+struct alignas(64) ray_packet {
+#if defined(RAYTRACE_PACKET_WIDTH)
+    /// The number of lanes in a packet
+    static constexpr size_t width{RAYTRACE_PACKET_WIDTH};
+#else
+    /// The number of lanes in a packet
+    static constexpr size_t width{8U};
+#endif
+    static_assert(0U < width and width <= 32U, "The lanes of a packet must fit in the 32 bit lane masks");
+
+    precision origin[dimensions][width];     //!< The location of each ray
+    precision direction[dimensions][width];  //!< The (unit) direction of each ray
+    precision inverse[dimensions][width];    //!< The reciprocal of each direction component (may be infinite)
+    size_t count;                            //!< The number of lanes in use
+
+    /// An empty packet
+    ray_packet() : origin{}, direction{}, inverse{}, count{0U} {
+    }
+
+    /// Places the ray into the lane, the lane must be less than width.
+    inline void set(size_t lane, ray const& r) {
+        for (size_t a = 0; a < dimensions; a++) {
+            origin[a][lane] = r.location()[a];
+            direction[a][lane] = r.direction()[a];
+            inverse[a][lane] = 1.0_p / r.direction()[a];
+        }
+    }
+
+    /// Appends a ray to the next unused lane
+    /// @return false if the packet is full
+    inline bool push(ray const& r) {
+        if (count >= width) {
+            return false;
+        }
+        set(count++, r);
+        return true;
+    }
+
+    /// @return The ray in the lane
+    inline ray get(size_t lane) const {
+        return ray{point{origin[0][lane], origin[1][lane], origin[2][lane]},
+                   vector{{direction[0][lane], direction[1][lane], direction[2][lane]}}};
+    }
+
+    /// The rays are coherent when every direction component has the same sign across the used lanes, so the rays
+    /// visit the hierarchy in the same order and the lanes mostly agree on which nodes to enter.
+    inline bool coherent() const {
+        for (size_t a = 0; a < dimensions; a++) {
+            for (size_t lane = 1; lane < count; lane++) {
+                if (std::signbit(direction[a][lane]) != std::signbit(direction[a][0])) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+}  // namespace raytrace
@@ -0,0 +1,96 @@
+#pragma once
+
+/// @file
+/// The Raytrace library render profiler header
+
+#include <chrono>
+#include <cstddef>
+#include <fourcc/image.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "raytrace/statistics.hpp"
+#include "raytrace/tiles.hpp"
+
+namespace raytrace {
+
+/// The costs of a render which are shown as heatmaps
+enum class Cost : char {
+    Time,           //!< The wall clock microseconds per pixel
+    Rays,           //!< The rays (camera, bounced, transmitted and sampled shadow rays) per pixel
+    Intersections,  //!< The intersection tests (with objects and with bounds) per pixel
+    Depth,          //!< The deepest ray traced in the tile (0 is a camera ray)
+};
+
+/// Records what each tile of a render cost and which thread rendered it, so slow regions of an image and idle threads
+/// can be found. It is built on the per thread @ref statistics counters and the rendered tile callback: each tile is
+/// charged the difference in the calling thread's counters and the time since that thread finished its previous tile
+/// (or since the render began). The costs are written as heatmaps of the image and as a Chrome trace (which
+/// chrome://tracing or Perfetto can show) of the tiles of each thread.
+/// @note With the statistics compiled out (see @ref statistics::enabled) only the times are recorded.
+class profiler {
+public:
+    /// The cost of a single tile
+    struct tile_cost {
+        tile region;                ///< The pixels of the tile
+        size_t thread{0U};          ///< The index of the thread which rendered it
+        double start_us{0.0};       ///< When the tile was started, in microseconds from the beginning of the render
+        double duration_us{0.0};    ///< How long the tile took, in microseconds
+        size_t rays{0U};            ///< The rays traced or tested for the tile
+        size_t intersections{0U};   ///< The intersection tests of the tile
+        size_t depth{0U};           ///< The deepest ray traced in the tile
+    };
+
+    profiler() = default;
+
+    /// Starts recording a render. This clears the per thread statistics (into the totals) so must be called while the
+    /// rendering threads are idle.
+    /// @param height The height of the image in pixels
+    /// @param width The width of the image in pixels
+    void begin(size_t height, size_t width);
+
+    /// Charges a tile with the costs of the calling thread since its last tile. Call this from the thread which
+    /// rendered the tile, right after it is done (i.e. from the rendered tile callback).
+    void record(tile const& region);
+
+    /// Stops recording and gathers the tiles of all the threads, in the order they started.
+    void end();
+
+    /// @return The tiles of the last render (after @ref end)
+    std::vector<tile_cost> const& costs() const;
+
+    /// Makes a heatmap of a cost where each pixel has the value of its tile (in all three channels)
+    fourcc::image<fourcc::PixelFormat::RGBf> heatmap(Cost which) const;
+
+    /// Writes the tiles as a Chrome trace JSON with an event per tile on the track of its thread
+    void write_trace(std::ostream& os) const;
+
+    /// Writes the heatmaps as <stem>_time.pfm, <stem>_rays.pfm, <stem>_intersections.pfm and <stem>_depth.pfm and the
+    /// trace as <stem>_trace.json
+    /// @return True if all the files were written
+    bool save(std::string const& stem) const;
+
+protected:
+    using clock = std::chrono::steady_clock;
+
+    /// What a thread has recorded, padded so the threads do not share a cache line
+    struct alignas(64) track {
+        clock::time_point last;          ///< When the thread finished its previous tile
+        statistics counted;              ///< The thread's counters as of its previous tile
+        std::vector<tile_cost> tiles;    ///< The tiles of the thread
+    };
+
+    /// The height of the image
+    size_t m_height{0U};
+    /// The width of the image
+    size_t m_width{0U};
+    /// When the render began
+    clock::time_point m_begin;
+    /// The tracks of each thread
+    std::vector<track> m_tracks;
+    /// The tiles of all the threads
+    std::vector<tile_cost> m_costs;
+};
+
+}  // namespace raytrace
@@ -13,7 +13,13 @@
 #include "raytrace/camera.hpp"
 #include "raytrace/stereocamera.hpp"
 
+#include "raytrace/mesh.hpp"
+#include "raytrace/packet.hpp"
+#include "raytrace/profiler.hpp"
 #include "raytrace/scene.hpp"
+#include "raytrace/texture.hpp"
+#include "raytrace/tiles.hpp"
+#include "raytrace/tree.hpp"
 #include "raytrace/types.hpp"
 
 #include "raytrace/mapping.hpp"
@@ -21,6 +27,7 @@
 // Lights
 #include "raytrace/lights/beam.hpp"
 #include "raytrace/lights/bulb.hpp"
+#include "raytrace/lights/selector.hpp"
 #include "raytrace/lights/speck.hpp"
 #include "raytrace/lights/spot.hpp"
 
@@ -62,3 +69,4 @@
 
 // Animator
 #include "raytrace/animator.hpp"
+#include "raytrace/batch.hpp"
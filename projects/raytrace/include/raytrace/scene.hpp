@@ -6,20 +6,28 @@
 #include <basal/printable.hpp>
 #include <vector>
 
-#include "raytrace/tree.hpp"
+#include "raytrace/bvh.hpp"
 #include "raytrace/camera.hpp"
 #include "raytrace/color.hpp"
 #include "raytrace/image.hpp"
 #include "raytrace/lights/light.hpp"
+#include "raytrace/lights/selector.hpp"
 #include "raytrace/mediums/transparent.hpp"
 #include "raytrace/objects/object.hpp"
 #include "raytrace/objects/group.hpp"
+#include "raytrace/profiler.hpp"
 
 namespace raytrace {
 
 /// A functor type that can return a color given the world ray
 using background_mapper = std::function<color(ray const&)>;
 
+/// The ways a path of reflected and transmitted rays can end before the reflection depth runs out
+enum class Termination : uint8_t {
+    Threshold,        ///< Paths end once their contribution falls below the adaptive reflection threshold (biased)
+    RussianRoulette,  ///< Paths continue with the chance of their contribution and the survivors are weighted up
+};
+
 /// A Class to hold all the components needed to render a scene
 class scene : public basal::printable {
 public:
@@ -51,6 +59,53 @@ public:
     ///
     objects::hit nearest_object(ray const& world_ray, objects::hits const& hits);
 
+    ///
+    /// Finds the nearest intersection along the world ray without collecting every hit. A running maximum distance
+    /// is carried through the objects and the hierarchy so that anything beyond the nearest hit so far is skipped.
+    /// @param [in] world_ray The ray to intersect with.
+    /// @param [in] max_distance Hits at or beyond this distance are ignored.
+    /// @return The nearest hit, or a hit with no intersection if nothing was hit.
+    ///
+    objects::hit nearest_intersection(ray const& world_ray,
+                                      precision max_distance = std::numeric_limits<precision>::infinity());
+
+    ///
+    /// Determines if anything blocks the world ray before the given distance. This returns at the first blocker found
+    /// instead of searching for the nearest one.
+    /// @param [in] world_ray The ray to test, usually from a surface point toward a light.
+    /// @param [in] max_distance The distance to the light, hits at or beyond this do not block.
+    /// @return true if the ray is blocked.
+    ///
+    bool occluded(ray const& world_ray, precision max_distance);
+
+    ///
+    /// Determines if anything blocks the world ray before the given distance, testing the last occluder first.
+    /// @param [in] world_ray The ray to test, usually from a surface point toward a light.
+    /// @param [in] max_distance The distance to the light, hits at or beyond this do not block.
+    /// @param [in,out] last_occluder The object which last blocked a ray to the same light (may be nullptr). It is
+    ///                 replaced by any new blocker found.
+    /// @return true if the ray is blocked.
+    ///
+    bool occluded(ray const& world_ray, precision max_distance, objects::object const*& last_occluder);
+
+    ///
+    /// Finds the nearest intersection of each ray in a packet. Coherent packets are traced together through the objects
+    /// and the hierarchy, packets which diverge fall back to finding each nearest intersection on its own.
+    /// @param [in] world_rays The packet of rays to intersect with.
+    /// @param [out] nearest The nearest hit of each used lane.
+    ///
+    void nearest_intersection(ray_packet const& world_rays, tree::packet_hits& nearest);
+
+    ///
+    /// Determines which rays of a packet are blocked before their distances, testing the last occluder first.
+    /// @param [in] world_rays The packet of rays to test, usually from a surface point toward the samples of a light.
+    /// @param [in] max_distance The distance to the light of each ray.
+    /// @param [in,out] last_occluder The object which last blocked a ray to the same light (may be nullptr).
+    /// @return The mask of blocked lanes (bit n is lane n).
+    ///
+    uint32_t occluded(ray_packet const& world_rays, precision const (&max_distance)[ray_packet::width],
+                      objects::object const*& last_occluder);
+
     ///
     /// Traces the path of a world ray within the scene and returns the color.
     /// @param world_ray The ray in world coordinates to trace.
@@ -63,21 +118,30 @@ public:
     color trace(ray const& world_ray, mediums::medium const& media, size_t depth = 1,
                 precision recursive_contribution = 1.0_p);
 
+    ///
+    /// Traces the path of a world ray whose nearest hit has already been found (i.e. as part of a packet).
+    /// @param world_ray The ray in world coordinates to trace.
+    /// @param nearest The nearest hit along the ray (may have no intersection).
+    /// @see trace
+    ///
+    color trace(ray const& world_ray, objects::hit const& nearest, mediums::medium const& media, size_t depth,
+                precision recursive_contribution = 1.0_p);
+
     /// The direct light from a single source of a single sample on a world point
     /// @param scene_light The light source in the scene
-    /// @param medium The medium being lit
+    /// @param surface The properties of the medium being lit at the point
     /// @param world_surface_point The point on the surface in world coordinates
-    /// @param object_surface_point The point on the object's surface in object coordinates
     /// @param world_surface_normal The normal vector on the surface at the point in world coordinates
     /// @param world_reflection The reflection ray in world coordinates
     /// @param sample_index The index of the sample for the light source
     /// @param reflection_depth The current recursive depth of reflections.
     /// @param recursive_contribution The amount of contribution from this level of recursion to the top level color.
+    /// @param in_shadow If already known (i.e. from a packet of shadow rays), whether the sample is in shadow.
     /// @return The color resulting from the direct light at the point
-    color direct_light(lights::light const& scene_light, mediums::medium const& medium,
-                       point const& world_surface_point, point const& object_surface_point,
-                       vector const& world_surface_normal, ray const& world_reflection, size_t sample_index,
-                       size_t reflection_depth, precision recursive_contribution);
+    color direct_light(lights::light const& scene_light, mediums::surface const& surface,
+                       point const& world_surface_point, vector const& world_surface_normal,
+                       ray const& world_reflection, size_t sample_index, size_t reflection_depth,
+                       precision recursive_contribution, std::optional<bool> in_shadow = std::nullopt);
 
     /// Computes the color from the emissive light at the point in the scene
     /// @param emissivity The emissivity of the medium at the point (0.0_p = non-emissive, 1.0_p = fully emissive)
@@ -87,22 +151,26 @@ public:
     color emissive_light(precision emissivity, mediums::medium const& medium,
                          raytrace::point const& object_surface_point) const;
 
+    /// Computes the color from the emissive light of the evaluated surface properties
+    /// @param emissivity The emissivity of the medium at the point (0.0_p = non-emissive, 1.0_p = fully emissive)
+    /// @param surface The properties of the medium being emitted from
+    color emissive_light(precision emissivity, mediums::surface const& surface) const;
+
     /// Computes the reflected light color from the medium at the point in the scene
     /// @param reflectivity The reflectivity of the medium at the point (0.0_p = non-reflective, 1.0_p = fully
     /// reflective)
-    /// @param medium The medium being reflected from
+    /// @param surface The properties of the medium being reflected from at the point
     /// @param media The current medium the ray is in
     /// @param world_surface_point The point on the object's surface in world coordinates
-    /// @param object_surface_point The point on the object's surface in object coordinates
     /// @param world_surface_normal The normal vector on the surface at the point in world coordinates
     /// @param world_reflection The reflection ray in world coordinates
     /// @param reflection_depth The current recursive depth of reflections.
     /// @param recursive_contribution The amount of contribution from this level of recursion to the top level color.
     ///                               When it falls below a global limit, the reflection will not be considered.
     ///                               @see adaptive_reflection_threshold
-    color reflected_light(precision reflectivity, mediums::medium const& medium, mediums::medium const& media,
-                          point const& world_surface_point, point const& object_surface_point,
-                          vector const& world_surface_normal, ray const& world_reflection, size_t reflection_depth,
+    color reflected_light(precision reflectivity, mediums::surface const& surface, mediums::medium const& media,
+                          point const& world_surface_point, vector const& world_surface_normal,
+                          ray const& world_reflection, size_t reflection_depth,
                           precision recursive_contribution = 1.0_p);
 
     /// Computes the transmitted light color through the medium at the point in the scene
@@ -123,22 +191,59 @@ public:
     /// @param filename The name of the file to write
     /// @param number_of_samples The number of subsamples per pixel.
     /// @param reflection_depth The depth of recursion for a traced ray. 1 equals no reflections.
-    /// @param func     The optional callback per pixel (used for updating UIs)
-    /// @param aaa_mask_threshold The threshold for the adaptive anti-aliasing mask. If the mask pixel is above the
-    /// threshold value, then it
-    ///                           will attempt to recompute. If 255, anti-aliasing is disabled. If 1, anti-aliasing is
-    ///                           enabled for all pixels.
+    /// @param func     The optional callback per completed tile (used for updating UIs)
+    /// @param aaa_mask_threshold The tolerance of adaptive sampling (in 1/255ths of full scale). Each pixel starts with
+    ///                           a single sample and keeps adding samples (up to the number of samples) until its mean
+    ///                           is known within the tolerance. The mask of the view is given the heatmap of the
+    ///                           samples of each pixel (which is also saved next to the file as *_samples.pgm). If
+    ///                           255, every pixel takes the number of samples. If 1, the tolerance is the tightest.
     /// @param filter_capture Whether to do a post-process filter on the capture before saving. This is separate from
     /// tone mapping as it is just a convolution filter, not a color mapping.
     /// @param tone_mapper Whether to apply tone mapping to the final image.
+    /// @note With profiling on (see @ref set_profiling) the costs of the tiles are kept (see @ref profile) and saved
+    /// next to the file as *_time.pfm, *_rays.pfm, *_intersections.pfm, *_depth.pfm and *_trace.json.
     void render(camera& view, std::string filename, size_t number_of_samples = 1, size_t reflection_depth = 1,
-                std::optional<image::rendered_line> func = std::nullopt,
+                std::optional<image::rendered_tile> func = std::nullopt,
                 uint8_t mask_threshold = raytrace::image::AAA_MASK_DISABLED, bool filter_capture = false,
                 bool tone_mapper = false);
 
+    ///
+    /// Renders one more pass of a progressive render into the camera capture. Each pass adds a single sample per pixel
+    /// (at the next low discrepancy offset) to an accumulation buffer kept by the scene and stores the average of all
+    /// the passes so far, so the capture can be shown after every pass and converges as passes are added. The buffer
+    /// is restarted whenever the camera (or its pose or size), the reflection depth or the scene contents change.
+    /// @param view The camera view to render to from.
+    /// @param reflection_depth The depth of recursion for a traced ray. 1 equals no reflections.
+    /// @param func     The optional callback per completed tile (used for updating UIs)
+    /// @param tone_mapper Whether to apply tone mapping to the capture.
+    /// @return The number of passes now in the capture.
+    size_t render_pass(camera& view, size_t reflection_depth = 1,
+                       std::optional<image::rendered_tile> func = std::nullopt, bool tone_mapper = false);
+
+    /// Forgets the accumulated passes so the next @ref render_pass starts a new progressive render.
+    void reset_accumulation();
+
+    /// Returns the number of passes in the accumulation buffer
+    size_t accumulated_passes(void) const;
+
     /// The limit for reflective contributions to the top level trace.
     precision adaptive_reflection_threshold;
 
+    /// Sets how paths end before the reflection depth runs out. With @ref Termination::RussianRoulette the
+    /// adaptive_reflection_threshold is not used, paths past the first russian_roulette_depth bounces continue with
+    /// the chance of their contribution instead, so deep reflection depths only cost where the paths still matter.
+    void set_termination(Termination mode);
+
+    /// Returns how paths end before the reflection depth runs out
+    Termination termination(void) const;
+
+    /// Sets whether @ref render records the costs of each tile (see @ref profiler). This is off by default as it
+    /// clears the per thread statistics at the start of each render and allocates a record per tile.
+    void set_profiling(bool enable);
+
+    /// Returns the costs of the tiles of the last profiled render
+    profiler const& profile(void) const;
+
     /// Allows the user to set a functor which returns the background color
     void set_background_mapper(background_mapper bgm);
 
@@ -160,12 +265,19 @@ public:
     ///       The color channels will set the color of the ambient light.
     void set_ambient_light(color ambient);
 
+    /// Sets the size and order of the tiles which the image is split into while rendering
+    void set_tiling(tiling const& layout);
+
     /// Removes all objects and lights from a scene
     void clear();
 
     // basal::printable
     void print(std::ostream& os, char const str[]) const override;
 
+    /// Prints the former (radial extent cube) and current (tight) world bounds volume of each object, to see how much
+    /// less space the hierarchy has to search.
+    void print_bounds(std::ostream& os) const;
+
     friend std::ostream& operator<<(std::ostream& os, scene const& sc);
 
     /// Returns the number of objects in the scene
@@ -174,13 +286,52 @@ public:
     /// Returns the number of lights in the scene
     size_t number_of_lights(void) const;
 
+    /// Returns the bounding volume hierarchy of the finite objects (empty until the first render)
+    tree::BVH const& hierarchy(void) const;
+
 protected:
+    /// Gets the scene ready to trace (builds the hierarchy if needed)
+    void prepare(size_t reflection_depth);
+
+    /// Makes the packet subsampler which traces camera rays from the view
+    image::packet_subsampler tracer(camera& view, size_t reflection_depth);
+
+    /// Plays russian roulette for the next ray of a path, counting the result by the depth of that ray.
+    /// @param world_surface_point The point the next ray leaves from (decides the outcome with the stream)
+    /// @param reflection_depth The current recursive depth of reflections
+    /// @param contribution The contribution of the next ray to the top level color
+    /// @param stream Separates the outcomes of different rays from the same point
+    /// @return The chance the ray survived with (the survivors are divided by it), or zero if the path ended
+    precision roulette(point const& world_surface_point, size_t reflection_depth, precision contribution,
+                       size_t stream) const;
+
+    /// The running sums of a progressive render and what they were rendered from
+    struct accumulation {
+        std::vector<color> sums;            ///< The sum of the samples of each pixel
+        size_t passes{0U};                  ///< The number of samples in each sum
+        camera const* view{nullptr};        ///< The camera which was rendered from
+        point from;                         ///< The camera position
+        point at;                           ///< The point the camera looked at
+        linalg::matrix intrinsics{3U, 3U};  ///< The camera intrinsics (field of view)
+        size_t reflection_depth{0U};        ///< The depth of the traced rays
+        size_t revision{0U};                ///< The scene revision
+    };
+
     /// The list of objects in the scene.
     object_list m_objects;
 
     /// The list of lights in the scene
     light_list m_lights;
 
+    /// The lights with a falloff (which light only their surroundings)
+    light_list m_local_lights;
+
+    /// The lights without a falloff (like a beam from the sun)
+    light_list m_distant_lights;
+
+    /// Chooses between the local lights by importance once there are enough of them (built with the hierarchy)
+    lights::selector m_light_selector;
+
     /// the Ambient light for the scene (defaults to black)
     color m_ambient_light;
 
@@ -196,8 +347,33 @@ protected:
     /// The infinite bounds object list
     object_list m_infinite_objects;
 
-    /// The finite bounds object list sorted into nodes
-    std::vector<tree::Node> m_nodes;
+    /// The finite bounds objects sorted into a bounding volume hierarchy
+    tree::BVH m_hierarchy;
+
+    /// A unique number which changes each render (or clear) so that per thread caches of objects can detect that they
+    /// are stale.
+    size_t m_generation;
+
+    /// The size and order of the tiles to render
+    tiling m_tiling;
+
+    /// The reflection depth of the current render, used to count the traced rays by depth from the camera
+    size_t m_reflection_depth;
+
+    /// Changes whenever the contents of the scene change (so any accumulated passes are stale)
+    size_t m_revision;
+
+    /// How paths end before the reflection depth runs out
+    Termination m_termination;
+
+    /// Whether renders are profiled
+    bool m_profiling;
+
+    /// The costs of the tiles of the last profiled render
+    profiler m_profiler;
+
+    /// The passes of the progressive render
+    accumulation m_accumulation;
 };
 
 }  // namespace raytrace
\ No newline at end of file
@@ -0,0 +1,133 @@
+#pragma once
+
+/// @file
+/// The Raytrace library statistics header
+
+#include <cstddef>
+#include <iostream>
+
+namespace raytrace {
+
+/// Collects the statistics from the raytracing library.
+/// Each thread counts into its own cache line aligned block (see @ref count) so threads never share a counter. The
+/// blocks are merged into the totals (see @ref get) by @ref collect, which @ref scene::render calls at the end of a
+/// render. Configuring with USE_RAYTRACE_STATISTICS=OFF (which defines RAYTRACE_STATISTICS_DISABLED) compiles all the
+/// counting away.
+struct alignas(64) statistics {
+public:
+#if defined(RAYTRACE_STATISTICS_DISABLED)
+    /// Statistics are compiled out
+    static constexpr bool enabled{false};
+#else
+    /// Statistics are counted
+    static constexpr bool enabled{true};
+#endif
+    /// The number of depths which are individually counted, deeper rays are counted in the last entry.
+    static constexpr size_t max_depth{16U};
+
+    /// The number of rays cast from the camera
+    size_t cast_rays_from_camera{0u};
+    /// Intersections with objects
+    size_t intersections_with_objects{0u};
+    /// Intersections with Single Point
+    size_t intersections_with_point{0u};
+    /// Intersections with multiple points
+    size_t intersections_with_points{0u};
+    /// Intersections with Lines
+    size_t intersections_with_line{0u};
+    /// Intersections with bounding boxes
+    size_t intersections_with_bounds{0u};
+    /// Intersection from the back side of an object (inside outwards or on the side away from the normal)
+    size_t inside_out_intersections{0u};
+    /// No intersections with objects
+    size_t missed_rays{0u};
+    /// The count of rays reflected off objects
+    size_t bounced_rays{0u};
+    /// The count of rays transmitted through mediums via refraction
+    size_t transmitted_rays{0u};
+    /// Saved Bounces from adaptive threshold
+    size_t saved_ray_traces{0u};
+    /// The count of shadow rays used to determine lighting
+    size_t shadow_rays{0u};
+    /// The count of rays added due to multiple samples from light sources
+    size_t sampled_rays{0u};
+    /// The count of sampled rays which actually contribute to the color of the scene.
+    size_t color_sampled_rays{0u};
+    /// The count of the points in the shadow which don't have a color contribution
+    size_t point_in_shadow{0u};
+    /// The count of shadow rays which were blocked by the last occluder of that light (no full search needed)
+    size_t occluder_cache_hits{0u};
+    /// The count of rays absorbed into a media
+    /// this will not be an accurate count until the per-frequency method is done.
+    size_t absorbed_rays{0u};
+    /// The number of rays emitted from light sources
+    size_t emitted_rays{0u};
+    /// The number of rays traced at each depth (0 is from the camera)
+    size_t traced_rays_at_depth[max_depth]{};
+    /// The number of rays at each depth which missed everything
+    size_t missed_rays_at_depth[max_depth]{};
+    /// The number of rays at each depth which played russian roulette
+    size_t roulette_rays_at_depth[max_depth]{};
+    /// The number of rays at each depth which survived russian roulette (and were traced)
+    size_t survived_rays_at_depth[max_depth]{};
+    /// The total time spent in rendering (only kept in the totals)
+    double render_seconds{0.0};
+
+    /// Accumulates another set of statistics into this one
+    statistics& operator+=(statistics const& other);
+
+    /// @return The total number of rays traced or tested (camera, bounced, transmitted and sampled shadow rays)
+    size_t total_rays() const;
+
+    /// @return The rays per second of rendering or zero if nothing has been timed
+    double rays_per_second() const;
+
+    /// Counts an event in the calling thread's block. Compiles to nothing if statistics are disabled.
+    /// @param counter The member to count, e.g. &statistics::missed_rays
+    /// @param amount The amount to add
+    static inline void count(size_t statistics::*counter, size_t amount = 1U) {
+        if constexpr (enabled) {
+            local().*counter += amount;
+        }
+    }
+
+    /// Counts a traced ray at the depth in the calling thread's block. Compiles to nothing if statistics are disabled.
+    /// @param depth The number of bounces from the camera (0 is a camera ray)
+    /// @param missed True if the ray did not hit anything
+    static inline void count_trace(size_t depth, bool missed) {
+        if constexpr (enabled) {
+            statistics& s = local();
+            size_t const index = depth < max_depth ? depth : max_depth - 1U;
+            s.traced_rays_at_depth[index]++;
+            s.missed_rays_at_depth[index] += (missed ? 1U : 0U);
+        }
+    }
+
+    /// Counts a ray which played russian roulette at the depth in the calling thread's block. Compiles to nothing if
+    /// statistics are disabled.
+    /// @param depth The number of bounces from the camera of the ray
+    /// @param survived True if the ray survived and was traced
+    static inline void count_roulette(size_t depth, bool survived) {
+        if constexpr (enabled) {
+            statistics& s = local();
+            size_t const index = depth < max_depth ? depth : max_depth - 1U;
+            s.roulette_rays_at_depth[index]++;
+            s.survived_rays_at_depth[index] += (survived ? 1U : 0U);
+        }
+    }
+
+    /// @return The calling thread's block of counters
+    static statistics& local();
+
+    /// Merges every thread's block into the totals and clears the blocks.
+    /// @note Call this when the rendering threads are idle (i.e. after the parallel section).
+    static void collect();
+
+    /// @return A copy of the totals as of the last @ref collect (taken under the same lock, so it can be read while
+    /// another thread collects)
+    static statistics get();
+
+    friend std::ostream& operator<<(std::ostream& os, statistics const& s);
+};
+
+}  // namespace raytrace
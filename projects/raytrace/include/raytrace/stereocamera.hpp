@@ -19,7 +19,7 @@ public:
         LeftRight
     };
 
-    stereo_camera(size_t image_height, size_t image_width, iso::degrees field_of_view, double camera_separation,
+    stereo_camera(size_t image_height, size_t image_width, iso::degrees field_of_view, precision camera_separation,
                   Layout layout = Layout::LeftRight);
     ~stereo_camera() = default;
 
@@ -0,0 +1,95 @@
+#pragma once
+
+/// @file
+/// The Raytrace library mip-mapped texture header
+
+#include <cstddef>
+#include <fourcc/types.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "raytrace/color.hpp"
+#include "raytrace/image.hpp"
+
+namespace raytrace {
+
+/// The way a lookup in a @ref texture blends the nearby texels
+enum class Filter : char {
+    Nearest,    //!< The closest texel of the largest level
+    Bilinear,   //!< The four closest texels of the largest level
+    Trilinear,  //!< The four closest texels of the two levels around the footprint of the lookup
+};
+
+/// How a lookup in a @ref texture treats the points outside of the unit square
+enum class Address : char {
+    Wrap,   //!< The texture repeats, for patterns which are periodic over the unit square
+    Clamp,  //!< The texels on the edges extend outward, so opposite edges are never blended together
+};
+
+/// A square color texture with a chain of mip levels, each half the size of the one before. The texture covers the
+/// unit square of a mapped (u, v) space and repeats or is clamped outside of it (see @ref Address). Texels are kept as
+/// 32 bit floats so the largest levels stay small enough to be cached well.
+class texture {
+public:
+    /// The function which gives the color at a point in the unit square
+    using pattern = std::function<color(image::point const& texture_point)>;
+
+    /// Bakes a pattern by sampling it at the center of each texel of the largest level, then builds the smaller levels
+    /// @param resolution The width and height of the largest level, a power of two
+    /// @param func The pattern to sample
+    /// @param address How lookups outside of the unit square are treated
+    /// @throw basal::exception if the resolution is not a power of two
+    texture(size_t resolution, pattern const& func, Address address = Address::Wrap);
+
+    /// Loads a texture which was saved with @ref save
+    /// @param filename The file to load
+    /// @param key The key the texture was saved with, which must match
+    /// @return The texture or nullptr if the file is missing, is from another key, is not a texture or its size does
+    /// not match its resolution
+    static std::shared_ptr<texture const> load(std::string const& filename, std::string const& key);
+
+    /// Saves the largest level of the texture (the others are rebuilt on load)
+    /// @param filename The file to write
+    /// @param key Identifies what the texture was baked from
+    /// @return True if the file was written
+    bool save(std::string const& filename, std::string const& key) const;
+
+    /// Looks up the color of the texture at a point
+    /// @param texture_point The point in (u, v) space, which is wrapped or clamped into the unit square
+    /// @param filter How the texels are blended
+    /// @param footprint The size in (u, v) of the area the lookup covers, which picks the levels of a trilinear lookup
+    color sample(image::point const& texture_point, Filter filter, precision footprint) const;
+
+    /// @return The width and height of the largest level
+    size_t resolution() const;
+
+    /// @return The number of levels, down to a single texel
+    size_t levels() const;
+
+    /// @return How lookups outside of the unit square are treated
+    Address address() const;
+
+    /// @return The texel of a level
+    fourcc::rgbf const& at(size_t level, size_t y, size_t x) const;
+
+protected:
+    /// Used by @ref load
+    texture() = default;
+
+    /// Builds each smaller level by averaging four texels of the level above
+    void build_levels();
+
+    /// Blends the four closest texels of a level
+    void bilinear(size_t level, precision u, precision v, float (&rgb)[3]) const;
+
+    /// The levels, largest first, each stored row by row
+    std::vector<std::vector<fourcc::rgbf>> m_levels;
+    /// The width and height of the largest level
+    size_t m_resolution{0U};
+    /// How lookups outside of the unit square are treated
+    Address m_address{Address::Wrap};
+};
+
+}  // namespace raytrace
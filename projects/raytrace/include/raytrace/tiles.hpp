@@ -0,0 +1,108 @@
+#pragma once
+
+/// @file
+/// The Raytrace library tile scheduling header
+
+#include <cstddef>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace raytrace {
+
+/// A rectangular region of an image, in pixels
+struct tile {
+    size_t x{0U};       //!< The left most column
+    size_t y{0U};       //!< The top most row
+    size_t width{0U};   //!< The number of columns
+    size_t height{0U};  //!< The number of rows
+
+    friend std::ostream& operator<<(std::ostream& os, tile const& t) {
+        return os << "tile{" << t.x << ", " << t.y << " " << t.width << "x" << t.height << "}";
+    }
+};
+
+/// The order in which the tiles of an image are handed out to the rendering threads
+enum class TileOrder : char {
+    Scanline,  //!< Left to right, top to bottom
+    Morton,    //!< Along a Z-order curve, which keeps neighboring tiles (and their objects) close in time
+    Spiral,    //!< From the center outwards, so the (usually) interesting part of the image shows up first
+};
+
+/// The way an image is split into tiles
+struct tiling {
+    size_t width{32U};                  //!< The width of each tile (edge tiles may be smaller)
+    size_t height{32U};                 //!< The height of each tile (edge tiles may be smaller)
+    TileOrder order{TileOrder::Spiral};  //!< The order the tiles are handed out in
+};
+
+/// Splits an image into tiles and sorts them into the order of the layout.
+/// @param image_height The height of the image in pixels
+/// @param image_width The width of the image in pixels
+/// @param layout The tile size and order
+/// @throw basal::exception if the tile size is zero
+std::vector<tile> make_tiles(size_t image_height, size_t image_width, tiling const& layout);
+
+/// Hands out tiles to a fixed number of workers. The tiles are dealt round-robin (in order) into a deque per worker.
+/// Each worker takes from the front of its own deque and when that is empty steals from the back of another worker's
+/// deque, so expensive tiles do not leave the other workers idle at the end of a frame.
+class tile_scheduler {
+public:
+    /// @param tiles The tiles in the order they should be rendered
+    /// @param number_of_workers The number of workers which will call @ref next (at least one)
+    tile_scheduler(std::vector<tile> const& tiles, size_t number_of_workers);
+
+    /// Gets the next tile for the worker.
+    /// @param worker The index of the calling worker [0, number_of_workers)
+    /// @param out [out] The tile to render
+    /// @return false when there are no tiles left anywhere
+    bool next(size_t worker, tile& out);
+
+    /// @return The number of tiles taken from another worker's deque
+    size_t steals() const;
+
+protected:
+    /// A deque with its own lock, padded so the workers' locks do not share a cache line
+    struct alignas(64) queue {
+        std::mutex mutex;
+        std::deque<tile> tiles;
+        size_t steals{0U};
+    };
+    std::vector<std::unique_ptr<queue>> m_queues;
+};
+
+/// Follows which lines of an image are finished from the notifications of a tiled render, for progress displays. A
+/// line is complete once every tile across it is. The notifications come from the rendering threads while a display
+/// reads from its own, so every access is locked.
+class line_progress {
+public:
+    /// @param image_height The number of lines
+    /// @param image_width The number of pixels in a line
+    line_progress(size_t image_height, size_t image_width);
+
+    /// Counts a notification of a tile (see @ref image::rendered_tile), a tile which is about to be rendered again
+    /// un-counts only its own pixels on its lines.
+    /// @param region The tile
+    /// @param completed True if the tile is finished
+    void update(tile const& region, bool completed);
+
+    /// @return True if every pixel of the line is finished
+    bool is_complete(size_t line) const;
+
+    /// @return The number of complete lines
+    size_t complete_lines() const;
+
+    /// @return The number of lines
+    size_t lines() const;
+
+protected:
+    mutable std::mutex m_mutex;
+    /// The number of finished pixels in each line
+    std::vector<size_t> m_finished;
+    /// The number of pixels in a line
+    size_t m_width;
+};
+
+}  // namespace raytrace
@@ -0,0 +1,181 @@
+#pragma once
+
+/// @file
+/// The Raytrace library fixed size affine transform header
+
+#include <iostream>
+
+#include "linalg/matrix.hpp"
+#include "raytrace/packet.hpp"
+#include "raytrace/types.hpp"
+
+namespace raytrace {
+
+/// A fixed size affine transform which keeps all of its values inline (no heap). Points are transformed by the full
+/// linear part (rotation and scale) and the translation. Vectors are transformed by the rotation alone, matching the
+/// historical behavior of @ref entity_. The inverses are kept so reverse transforms are also a single 3x3 + offset.
+class transform {
+public:
+    /// The identity transform
+    constexpr transform() noexcept
+        : m_linear{{1.0_p, 0.0_p, 0.0_p}, {0.0_p, 1.0_p, 0.0_p}, {0.0_p, 0.0_p, 1.0_p}}
+        , m_inverse{{1.0_p, 0.0_p, 0.0_p}, {0.0_p, 1.0_p, 0.0_p}, {0.0_p, 0.0_p, 1.0_p}}
+        , m_rotation{{1.0_p, 0.0_p, 0.0_p}, {0.0_p, 1.0_p, 0.0_p}, {0.0_p, 0.0_p, 1.0_p}}
+        , m_inv_rotation{{1.0_p, 0.0_p, 0.0_p}, {0.0_p, 1.0_p, 0.0_p}, {0.0_p, 0.0_p, 1.0_p}}
+        , m_translation{0.0_p, 0.0_p, 0.0_p} {
+    }
+
+    /// Composes the transform as Rotate(Scale(x)) + Translate
+    /// @param rotation The 3x3 rotation
+    /// @param inv_rotation The 3x3 inverse of the rotation
+    /// @param scale The per axis scaling (must not be zero)
+    /// @param translation The position of the origin
+    transform(linalg::matrix const& rotation, linalg::matrix const& inv_rotation, vector const& scale,
+              point const& translation)
+        : transform{} {
+        for (size_t r = 0; r < dimensions; r++) {
+            for (size_t c = 0; c < dimensions; c++) {
+                m_rotation[r][c] = rotation(r, c);
+                m_inv_rotation[r][c] = inv_rotation(r, c);
+                m_linear[r][c] = m_rotation[r][c] * scale[c];       // R * S
+                m_inverse[r][c] = m_inv_rotation[r][c] / scale[r];  // S^-1 * R^-1
+            }
+            m_translation[r] = translation[r];
+        }
+    }
+
+    /// Creates a transform from a general (invertible) 3x3 linear map and a translation. Vectors use the same linear
+    /// map as points.
+    transform(linalg::matrix const& linear, point const& translation) : transform{} {
+        linalg::matrix const inverse = linear.inverse();
+        for (size_t r = 0; r < dimensions; r++) {
+            for (size_t c = 0; c < dimensions; c++) {
+                m_linear[r][c] = m_rotation[r][c] = linear(r, c);
+                m_inverse[r][c] = m_inv_rotation[r][c] = inverse(r, c);
+            }
+            m_translation[r] = translation[r];
+        }
+    }
+
+    /// Finds the point in world space given the object point
+    inline point forward(point const& object_point) const {
+        precision out[dimensions];
+        multiply(m_linear, object_point, out);
+        return point{out[0] + m_translation[0], out[1] + m_translation[1], out[2] + m_translation[2]};
+    }
+
+    /// Rotates the vector into the world space from the object space
+    inline vector forward(vector const& object_vector) const {
+        precision out[dimensions];
+        multiply(m_rotation, object_vector, out);
+        return vector{out[0], out[1], out[2]};
+    }
+
+    /// Transforms a object ray into a world ray
+    inline ray forward(ray const& object_ray) const {
+        return ray{forward(object_ray.location()), forward(object_ray.direction())};
+    }
+
+    /// Finds the point in object space which maps to the given world space point
+    inline point reverse(point const& world_point) const {
+        precision const in[dimensions]{world_point[0] - m_translation[0], world_point[1] - m_translation[1],
+                                       world_point[2] - m_translation[2]};
+        precision out[dimensions];
+        multiply(m_inverse, in, out);
+        return point{out[0], out[1], out[2]};
+    }
+
+    /// Rotates the vector into the object space.
+    inline vector reverse(vector const& world_vector) const {
+        precision out[dimensions];
+        multiply(m_inv_rotation, world_vector, out);
+        return vector{out[0], out[1], out[2]};
+    }
+
+    /// Transforms the world space ray into the object space ray
+    inline ray reverse(ray const& world_ray) const {
+        return ray{reverse(world_ray.location()), reverse(world_ray.direction())};
+    }
+
+    /// Transforms every lane of the world space packet into the object space packet. The reciprocals of the object
+    /// directions are not computed.
+    inline void reverse(ray_packet const& world_rays, ray_packet& object_rays) const {
+        constexpr size_t W = ray_packet::width;
+        for (size_t lane = 0; lane < W; lane++) {
+            precision const x = world_rays.origin[0][lane] - m_translation[0];
+            precision const y = world_rays.origin[1][lane] - m_translation[1];
+            precision const z = world_rays.origin[2][lane] - m_translation[2];
+            precision const i = world_rays.direction[0][lane];
+            precision const j = world_rays.direction[1][lane];
+            precision const k = world_rays.direction[2][lane];
+            for (size_t r = 0; r < dimensions; r++) {
+                object_rays.origin[r][lane] = m_inverse[r][0] * x + m_inverse[r][1] * y + m_inverse[r][2] * z;
+                object_rays.direction[r][lane]
+                    = m_inv_rotation[r][0] * i + m_inv_rotation[r][1] * j + m_inv_rotation[r][2] * k;
+            }
+        }
+        object_rays.count = world_rays.count;
+    }
+
+    /// Converts the distances along the object space rays into distances in world space from the origin of each world
+    /// ray to the forward transformed object point. Infinite and NaN distances are kept as they are.
+    /// @param world_rays The packet in world space
+    /// @param object_rays The same packet in object space (see @ref reverse)
+    /// @param distances [in,out] The distances along the object rays, replaced by world distances
+    inline void distances(ray_packet const& world_rays, ray_packet const& object_rays,
+                          precision (&distances)[ray_packet::width]) const {
+        constexpr size_t W = ray_packet::width;
+        for (size_t lane = 0; lane < W; lane++) {
+            precision const t = distances[lane];
+            precision object_point[dimensions];
+            for (size_t a = 0; a < dimensions; a++) {
+                object_point[a] = object_rays.origin[a][lane] + t * object_rays.direction[a][lane];
+            }
+            precision d2 = 0.0_p;
+            for (size_t r = 0; r < dimensions; r++) {
+                precision const w = m_linear[r][0] * object_point[0] + m_linear[r][1] * object_point[1]
+                                    + m_linear[r][2] * object_point[2] + m_translation[r]
+                                    - world_rays.origin[r][lane];
+                d2 += w * w;
+            }
+            distances[lane] = std::isfinite(t) ? std::sqrt(d2) : t;
+        }
+    }
+
+    /// @return The linear (rotation and scale) element at row r and column c (zero based)
+    constexpr precision linear(size_t r, size_t c) const {
+        return m_linear[r][c];
+    }
+
+    /// @return The translation element (zero based)
+    constexpr precision translation(size_t i) const {
+        return m_translation[i];
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, transform const& t) {
+        os << "transform{";
+        for (size_t r = 0; r < dimensions; r++) {
+            os << "[" << t.m_linear[r][0] << ", " << t.m_linear[r][1] << ", " << t.m_linear[r][2] << " | "
+               << t.m_translation[r] << "]";
+        }
+        return os << "}";
+    }
+
+protected:
+    /// A 3x3 times a 3 element input
+    template <typename INPUT>
+    static inline void multiply(precision const (&m)[dimensions][dimensions], INPUT const& in,
+                                precision (&out)[dimensions]) {
+        out[0] = m[0][0] * in[0] + m[0][1] * in[1] + m[0][2] * in[2];
+        out[1] = m[1][0] * in[0] + m[1][1] * in[1] + m[1][2] * in[2];
+        out[2] = m[2][0] * in[0] + m[2][1] * in[1] + m[2][2] * in[2];
+    }
+
+    precision m_linear[dimensions][dimensions];        ///< The rotation and scaling applied to points
+    precision m_inverse[dimensions][dimensions];       ///< The inverse of the linear part
+    precision m_rotation[dimensions][dimensions];      ///< The rotation applied to vectors
+    precision m_inv_rotation[dimensions][dimensions];  ///< The inverse rotation applied to vectors
+    precision m_translation[dimensions];               ///< The translation applied to points
+};
+
+}  // namespace raytrace
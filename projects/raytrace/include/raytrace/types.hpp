@@ -2,6 +2,8 @@
 
 #include <geometry/geometry.hpp>
 
+#include "raytrace/statistics.hpp"
+
 namespace raytrace {
 using namespace geometry::operators;
 using namespace geometry::R3;  // only 3D functions
@@ -19,51 +21,6 @@ using line = geometry::R3::line;
 /// Reusing other matrix
 using matrix = linalg::matrix;
 
-/// Collects the statistics from the raytracing library
-struct statistics {
-public:
-    /// The number of rays cast from the camera
-    size_t cast_rays_from_camera{0u};
-    /// Intersections with objects
-    size_t intersections_with_objects{0u};
-    /// Intersections with Single Point
-    size_t intersections_with_point{0u};
-    /// Intersections with multiple points
-    size_t intersections_with_points{0u};
-    /// Intersections with Lines
-    size_t intersections_with_line{0u};
-    /// Intersections with bounding boxes
-    size_t intersections_with_bounds{0u};
-    /// Intersection from the back side of an object (inside outwards or on the side away from the normal)
-    size_t inside_out_intersections{0u};
-    /// No intersections with objects
-    size_t missed_rays{0u};
-    /// The count of rays reflected off objects
-    size_t bounced_rays{0u};
-    /// The count of rays transmitted through mediums via refraction
-    size_t transmitted_rays{0u};
-    /// Saved Bounces from adaptive threshold
-    size_t saved_ray_traces{0u};
-    /// The count of shadow rays used to determine lighting
-    size_t shadow_rays{0u};
-    /// The count of rays added due to multiple samples from light sources
-    size_t sampled_rays{0u};
-    /// The count of sampled rays which actually contribute to the color of the scene.
-    size_t color_sampled_rays{0u};
-    /// The count of the points in the shadow which don't have a color contribution
-    size_t point_in_shadow{0u};
-    /// The count of rays absorbed into a media
-    /// this will not be an accurate count until the per-frequency method is done.
-    size_t absorbed_rays{0u};
-    /// The number of rays emitted from light sources
-    size_t emitted_rays{0u};
-
-    static statistics& get() {
-        static statistics s;
-        return s;
-    }
-};
-
 /// Computes the values of a convex lens based on the diameter and angle of the lens.
 /// Once initialized use the values to construct two sphere at a +/- separation from the origin of the specific radius.
 /// Pass both into an inclusive overlap to make a convex lens.
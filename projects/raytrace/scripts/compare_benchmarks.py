@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""Compares the JSON results of the gbench_raytrace render benchmarks to a baseline.
+
+The throughput counters (rays and shadow rays per second) are better when higher, the times and the memory are better
+when lower. Each change is printed as a percentage of the baseline and any which is worse than the threshold is marked.
+Results are only compared to a baseline from the same kind of build (see CONTEXT), any other comparison is refused.
+The renders of the raytrace-benchmark target use a single thread, so a baseline from a machine with a different number
+of CPUs is still compared (see NOTED) but the difference is pointed out.
+"""
+
+import sys
+import json
+import argparse
+
+# the counter and whether a larger value is better
+COUNTERS = [
+    ("rays_per_second", True),
+    ("shadow_rays_per_second", True),
+    ("real_time", False),
+    ("bvh_build_ms", False),
+    ("peak_memory_mb", False),
+]
+
+# the parts of the context which must match, the build types of the raytrace library (recorded by gbench_raytrace) and
+# of the benchmark library, the precision and the number of threads the renders are spread over
+CONTEXT = [
+    "raytrace_build_type",
+    "raytrace_precision",
+    "raytrace_threads",
+    "library_build_type",
+]
+
+# the parts of the context which are only pointed out when they differ, the machine is not the same but the renders are
+# still comparable as they use the same number of threads
+NOTED = [
+    "num_cpus",
+]
+
+
+def load(filename: str) -> tuple:
+    with open(filename, "r") as file:
+        results = json.load(file)
+    # only the means of repeated runs (or the single runs) are compared
+    benchmarks = {
+        bench["run_name"]: bench
+        for bench in results.get("benchmarks", [])
+        if bench.get("run_type", "iteration") == "iteration" or bench.get("aggregate_name") == "mean"
+    }
+    return results.get("context", {}), benchmarks
+
+
+def mismatches(baseline: dict, current: dict, keys: list) -> list:
+    """Lists each of the keys of the context which differs (or is missing from either)"""
+    return [
+        f"{key}: baseline {baseline.get(key, '(missing)')} current {current.get(key, '(missing)')}"
+        for key in keys
+        if key not in baseline or key not in current or baseline[key] != current[key]
+    ]
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("baseline", help="The JSON results to compare to (i.e. the checked in baseline)")
+    parser.add_argument("current", help="The JSON results of the current build")
+    parser.add_argument("-t", "--threshold", type=float, default=10.0, help="The percent change which is marked")
+    parser.add_argument("-s", "--strict", action="store_true", help="Fails if any change is worse than the threshold")
+    args = parser.parse_args()
+
+    baseline_context, baseline = load(args.baseline)
+    current_context, current = load(args.current)
+    different = mismatches(baseline_context, current_context, CONTEXT)
+    if different:
+        print("The baseline is from a different kind of build, so the results can not be compared:")
+        for line in different:
+            print(f"    {line}")
+        print("Make a new baseline from this build (the raytrace-benchmark-baseline target) to compare against.")
+        return 2
+    noted = mismatches(baseline_context, current_context, NOTED)
+    if noted:
+        print("The baseline is from a different machine, the single threaded renders are compared anyway:")
+        for line in noted:
+            print(f"    {line}")
+    worse = 0
+    print(f"{'Benchmark':72} {'Counter':24} {'Baseline':>14} {'Current':>14} {'Change':>9}")
+    for name, bench in current.items():
+        if name not in baseline:
+            print(f"{name:72} (not in the baseline)")
+            continue
+        for counter, higher_is_better in COUNTERS:
+            if counter not in bench or counter not in baseline[name] or not baseline[name][counter]:
+                continue
+            before = float(baseline[name][counter])
+            after = float(bench[counter])
+            change = 100.0 * (after - before) / before
+            better = change if higher_is_better else -change
+            mark = ""
+            if better < -args.threshold:
+                mark = " <-- worse"
+                worse += 1
+            elif better > args.threshold:
+                mark = " better"
+            print(f"{name:72} {counter:24} {before:14.4g} {after:14.4g} {change:+8.1f}%{mark}")
+    for name in baseline:
+        if name not in current:
+            print(f"{name:72} (missing from the current results)")
+    if worse > 0:
+        print(f"{worse} counters are more than {args.threshold}% worse than the baseline")
+    return 1 if (args.strict and worse > 0) else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -22,8 +22,10 @@ Attributes Animator::operator()() {
     auto dt = (now_ - start_) / anchors_[index_].duration;
     std::cout << "Animator: " << index_ << " at " << now_.value << " with dt=" << dt << std::endl;
     auto a = interpolate(anchors_[index_].start, anchors_[index_].limit, anchors_[index_].mappers, dt);
-    now_ += delta_;
-    if (now_ >= (start_ + anchors_[index_].duration)) {
+    frame_++;
+    now_ = iso::seconds(delta_.value * static_cast<precision>(frame_));
+    // half a frame of slack so a frame which lands on the end of the anchor (within rounding) is still given
+    if (now_.value > (start_ + anchors_[index_].duration).value + 0.5_p * delta_.value) {
         start_ += anchors_[index_].duration;
         index_++;
     }
@@ -0,0 +1,98 @@
+#include "raytrace/batch.hpp"
+
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#include "basal/exception.hpp"
+
+namespace raytrace {
+
+namespace animation {
+
+Batch::Batch(scene& renderer, Settings const& settings) : m_scene{renderer}, m_settings{settings} {
+    basal::exception::throw_if(m_settings.height == 0U or m_settings.width == 0U, __FILE__, __LINE__,
+                               "Frames must not be empty");
+    basal::exception::throw_if(m_settings.queue_depth == 0U, __FILE__, __LINE__,
+                               "The queue must hold at least one frame");
+}
+
+std::string Batch::filename(size_t frame) const {
+    std::ostringstream name;
+    name << m_settings.prefix << std::setw(4) << std::setfill('0') << frame << m_settings.extension;
+    return name.str();
+}
+
+void Batch::write() {
+    while (true) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_queued.wait(lock, [this]() { return m_closed or not m_queue.empty(); });
+        if (m_queue.empty()) {
+            return;  // closed and nothing left
+        }
+        pending frame{std::move(m_queue.front())};
+        m_queue.pop_front();
+        lock.unlock();
+        m_taken.notify_one();
+        // the conversion and the write happen while the next frame renders
+        bool const saved = frame.image.save(frame.filename);
+        if (not saved) {
+            std::cerr << "Could not save " << frame.filename << std::endl;
+        }
+        lock.lock();
+        m_saved += (saved ? 1U : 0U);
+    }
+}
+
+size_t Batch::render(Animator& animator, std::optional<rendered_frame> func) {
+    m_closed = false;
+    m_saved = 0U;
+    std::thread writer{&Batch::write, this};
+    // lets the writer save what is left on the queue and waits for it
+    auto finish = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_queued.notify_one();
+        writer.join();
+    };
+    std::unique_ptr<camera> view;
+    iso::degrees fov{0.0_p};
+    try {
+        for (size_t frame = 0U; animator and frame < m_settings.last; frame++) {
+            Attributes const cam = animator();
+            if (frame < m_settings.first) {
+                continue;
+            }
+            // only a change in the field of view needs a new camera, moving it keeps the capture
+            if (not view or not(fov == cam.fov)) {
+                view = std::make_unique<camera>(m_settings.height, m_settings.width, cam.fov);
+                fov = cam.fov;
+            }
+            view->move_to(cam.from, cam.at);
+            // nothing is added or removed so the hierarchy of the first frame is kept
+            m_scene.render(*view, std::string{}, m_settings.number_of_samples, m_settings.reflection_depth,
+                           std::nullopt, image::AAA_MASK_DISABLED, false, m_settings.tone_mapping);
+            if (func != std::nullopt) {
+                func.value()(frame, *view);
+            }
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_taken.wait(lock, [this]() { return m_queue.size() < m_settings.queue_depth; });
+            m_queue.push_back(pending{filename(frame), fourcc::image<fourcc::PixelFormat::RGBId>{view->capture}});
+            lock.unlock();
+            m_queued.notify_one();
+        }
+    } catch (...) {
+        // save what was rendered before passing the error on
+        finish();
+        throw;
+    }
+    finish();
+    return m_saved;
+}
+
+}  // namespace animation
+
+}  // namespace raytrace
@@ -39,7 +39,7 @@ bool Bounds::intersects(ray const& r) const {
     precision const y = r.location().y();
     precision const z = r.location().z();
     if (contained(r.location())) {
-        raytrace::statistics::get().intersections_with_bounds++;
+        raytrace::statistics::count(&raytrace::statistics::intersections_with_bounds);
         return true;
     }
     precision const i = r.direction()[0];
@@ -50,7 +50,7 @@ bool Bounds::intersects(ray const& r) const {
         if (basal::is_greater_than_or_equal_to_zero(t_min)) {
             auto point_min = r.distance_along(t_min);
             if (contained(point_min)) {
-                raytrace::statistics::get().intersections_with_bounds++;
+                raytrace::statistics::count(&raytrace::statistics::intersections_with_bounds);
                 return true;
             }
         }
@@ -58,7 +58,7 @@ bool Bounds::intersects(ray const& r) const {
         if (basal::is_greater_than_or_equal_to_zero(t_max)) {
             auto point_max = r.distance_along(t_max);
             if (contained(point_max)) {
-                raytrace::statistics::get().intersections_with_bounds++;
+                raytrace::statistics::count(&raytrace::statistics::intersections_with_bounds);
                 return true;
             }
         }
@@ -68,7 +68,7 @@ bool Bounds::intersects(ray const& r) const {
         if (basal::is_greater_than_or_equal_to_zero(t_min)) {
             auto point_min = r.distance_along(t_min);
             if (contained(point_min)) {
-                raytrace::statistics::get().intersections_with_bounds++;
+                raytrace::statistics::count(&raytrace::statistics::intersections_with_bounds);
                 return true;
             }
         }
@@ -76,7 +76,7 @@ bool Bounds::intersects(ray const& r) const {
         if (basal::is_greater_than_or_equal_to_zero(t_max)) {
             auto point_max = r.distance_along(t_max);
             if (contained(point_max)) {
-                raytrace::statistics::get().intersections_with_bounds++;
+                raytrace::statistics::count(&raytrace::statistics::intersections_with_bounds);
                 return true;
             }
         }
@@ -86,7 +86,7 @@ bool Bounds::intersects(ray const& r) const {
         if (basal::is_greater_than_or_equal_to_zero(t_min)) {
             auto point_min = r.distance_along(t_min);
             if (contained(point_min)) {
-                raytrace::statistics::get().intersections_with_bounds++;
+                raytrace::statistics::count(&raytrace::statistics::intersections_with_bounds);
                 return true;
             }
         }
@@ -94,7 +94,7 @@ bool Bounds::intersects(ray const& r) const {
         if (basal::is_greater_than_or_equal_to_zero(t_max)) {
             auto point_max = r.distance_along(t_max);
             if (contained(point_max)) {
-                raytrace::statistics::get().intersections_with_bounds++;
+                raytrace::statistics::count(&raytrace::statistics::intersections_with_bounds);
                 return true;
             }
         }
@@ -113,6 +113,13 @@ bool Bounds::is_infinite() const {
             or std::isinf(max.y()) or std::isinf(max.z()));
 }
 
+precision Bounds::volume() const {
+    if (is_infinite()) {
+        return basal::pos_inf;
+    }
+    return (max.x() - min.x()) * (max.y() - min.y()) * (max.z() - min.z());
+}
+
 void Bounds::grow(Bounds const& b) {
     min.x() = std::min(min.x(), b.min.x());
     min.y() = std::min(min.y(), b.min.y());
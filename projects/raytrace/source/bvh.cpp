@@ -0,0 +1,650 @@
+#include "raytrace/bvh.hpp"
+
+#include <algorithm>
+#include <basal/exception.hpp>
+#include <basal/ieee754.hpp>
+#include <cmath>
+#include <limits>
+
+#include "raytrace/configuration.hpp"
+
+namespace raytrace {
+
+namespace tree {
+
+namespace {
+
+/// A simple axis aligned box which can be empty, unlike @ref Bounds
+struct Box {
+    precision lower[dimensions]{basal::pos_inf, basal::pos_inf, basal::pos_inf};
+    precision upper[dimensions]{basal::neg_inf, basal::neg_inf, basal::neg_inf};
+
+    void grow(precision const lo[dimensions], precision const hi[dimensions]) {
+        for (size_t a = 0; a < dimensions; a++) {
+            lower[a] = std::min(lower[a], lo[a]);
+            upper[a] = std::max(upper[a], hi[a]);
+        }
+    }
+
+    void grow(Box const& other) {
+        grow(other.lower, other.upper);
+    }
+
+    /// @return the surface area of the box or zero if it is empty
+    precision area() const {
+        if (lower[0] > upper[0]) {
+            return 0.0_p;
+        }
+        precision const dx = upper[0] - lower[0];
+        precision const dy = upper[1] - lower[1];
+        precision const dz = upper[2] - lower[2];
+        return 2.0_p * (dx * dy + dy * dz + dz * dx);
+    }
+};
+
+/// An entry in the traversal stack, the entry distance allows the node to be skipped once a nearer hit is found
+struct Pending {
+    uint32_t index;
+    precision t_enter;
+};
+
+/// Prepares the origin and reciprocal direction of a ray for the slab tests
+inline void prepare(raytrace::ray const& ray, precision origin[dimensions], precision inverse[dimensions]) {
+    for (size_t a = 0; a < dimensions; a++) {
+        origin[a] = ray.location()[a];
+        inverse[a] = 1.0_p / ray.direction()[a];
+    }
+}
+
+/// Counts the intersection statistics of a candidate hit
+inline void count(IntersectionType type) {
+    if (type != IntersectionType::None) {
+        statistics::count(&statistics::intersections_with_objects);
+    }
+    if (type == IntersectionType::Point) {
+        statistics::count(&statistics::intersections_with_point);
+    } else if (type == IntersectionType::Points) {
+        statistics::count(&statistics::intersections_with_points);
+    } else if (type == IntersectionType::Line) {
+        statistics::count(&statistics::intersections_with_line);
+    }
+}
+
+/// @return The index of the lowest set lane in the (non-zero) mask
+inline size_t first_lane(uint32_t mask) {
+    size_t lane = 0U;
+    while ((mask & (1U << lane)) == 0U) {
+        lane++;
+    }
+    return lane;
+}
+
+}  // namespace
+
+bool keep_nearest(raytrace::ray const& world_ray, objects::object::hit const& candidate, objects::object::hit& nearest,
+                  precision& t_max) {
+    IntersectionType const type = get_type(candidate.intersect);
+    count(type);
+    bool nearer = false;
+    precision const t_max2 = t_max * t_max;
+    if (type == IntersectionType::Point) {
+        // distance can't be negative but can be zero which means the ray is already touching
+        precision const distance2 = (as_point(candidate.intersect) - world_ray.location()).quadrance();
+        if (basal::epsilon < distance2 and distance2 < t_max2) {
+            t_max = std::sqrt(distance2);
+            nearer = true;
+        }
+    } else if (type == IntersectionType::Points) {
+        precision closest2 = t_max2;
+        for (auto const& pnt : as_points(candidate.intersect)) {
+            precision const distance2 = (pnt - world_ray.location()).quadrance();
+            if (basal::epsilon < distance2 and distance2 < closest2) {
+                closest2 = distance2;
+                nearer = true;
+            }
+        }
+        if (nearer) {
+            t_max = std::sqrt(closest2);
+        }
+    }
+    if (nearer) {
+        nearest = candidate;
+    }
+    return nearer;
+}
+
+bool blocks(raytrace::ray const& world_ray, objects::object::hit const& candidate, precision max_distance) {
+    IntersectionType const type = get_type(candidate.intersect);
+    count(type);
+    precision const max_distance2 = max_distance * max_distance;
+    if (type == IntersectionType::Point) {
+        precision const distance2 = (as_point(candidate.intersect) - world_ray.location()).quadrance();
+        return (basal::epsilon < distance2 and distance2 < max_distance2);
+    } else if (type == IntersectionType::Points) {
+        for (auto const& pnt : as_points(candidate.intersect)) {
+            precision const distance2 = (pnt - world_ray.location()).quadrance();
+            if (basal::epsilon < distance2 and distance2 < max_distance2) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool keep_nearest(raytrace::ray const& world_ray, objects::object const* candidate, objects::hit_record& nearest) {
+    precision const t_max = nearest.distance;
+    bool const hit = candidate->intersect(world_ray, nearest);
+    count(hit ? IntersectionType::Point : IntersectionType::None);
+    return nearest.distance < t_max;
+}
+
+bool blocks(raytrace::ray const& world_ray, objects::object const* candidate, precision max_distance) {
+    objects::hit_record record;
+    record.distance = max_distance;
+    bool const hit = candidate->intersect(world_ray, record);
+    count(hit ? IntersectionType::Point : IntersectionType::None);
+    return record.object != nullptr;
+}
+
+uint32_t keep_nearest(ray_packet const& rays, objects::object const* candidate, uint32_t active, packet_hits& nearest,
+                      precision (&t_max)[ray_packet::width]) {
+    uint32_t nearer = 0U;
+    precision distances[ray_packet::width];
+    bool const packed = candidate->intersect(rays, distances);
+    for (size_t lane = 0; lane < ray_packet::width; lane++) {
+        uint32_t const bit = 1U << lane;
+        if ((active & bit) == 0U) {
+            continue;
+        }
+        if (packed and not std::isnan(distances[lane])) {
+            precision const distance = distances[lane];
+            if (std::isfinite(distance)) {
+                count(IntersectionType::Point);
+            }
+            if (basal::epsilon < (distance * distance) and distance < t_max[lane]) {
+                // the surface is resolved later, only if this is still the nearest
+                t_max[lane] = distance;
+                nearest[lane] = objects::object::hit{};
+                nearest[lane].distance = distance;
+                nearest[lane].object = candidate;
+                nearer |= bit;
+            }
+        } else {
+            raytrace::ray const world_ray = rays.get(lane);
+            if (keep_nearest(world_ray, candidate->intersect(world_ray), nearest[lane], t_max[lane])) {
+                nearer |= bit;
+            }
+        }
+    }
+    return nearer;
+}
+
+uint32_t blocks(ray_packet const& rays, objects::object const* candidate, uint32_t active,
+                precision const (&max_distance)[ray_packet::width]) {
+    uint32_t blocked = 0U;
+    precision distances[ray_packet::width];
+    bool const packed = candidate->intersect(rays, distances);
+    for (size_t lane = 0; lane < ray_packet::width; lane++) {
+        uint32_t const bit = 1U << lane;
+        if ((active & bit) == 0U) {
+            continue;
+        }
+        if (packed and not std::isnan(distances[lane])) {
+            precision const distance = distances[lane];
+            if (std::isfinite(distance)) {
+                count(IntersectionType::Point);
+            }
+            if (basal::epsilon < (distance * distance) and distance < max_distance[lane]) {
+                blocked |= bit;
+            }
+        } else {
+            raytrace::ray const world_ray = rays.get(lane);
+            if (blocks(world_ray, candidate->intersect(world_ray), max_distance[lane])) {
+                blocked |= bit;
+            }
+        }
+    }
+    return blocked;
+}
+
+BVH::BVH() : nodes_{}, objects_{}, bounds_{}, depth_{0U}, build_time_{0.0} {
+}
+
+void BVH::clear() {
+    nodes_.clear();
+    objects_.clear();
+    bounds_.clear();
+    depth_ = 0U;
+}
+
+void BVH::build(object_list const& objects) {
+    auto start = std::chrono::steady_clock::now();
+    clear();
+    std::vector<FlatBounds> boxes;
+    boxes.reserve(objects.size());
+    for (auto const* object : objects) {
+        basal::exception::throw_if(object == nullptr, __FILE__, __LINE__, "Object can't be nullptr");
+        Bounds const bounds = object->get_world_bounds();
+        basal::exception::throw_if(bounds.is_infinite(), __FILE__, __LINE__, "Object must have finite bounds");
+        FlatBounds box;
+        for (size_t a = 0; a < dimensions; a++) {
+            box.lower[a] = bounds.min[a];
+            box.upper[a] = bounds.max[a];
+        }
+        boxes.push_back(box);
+    }
+    std::vector<uint32_t> order;
+    depth_ = build_flat_hierarchy(boxes, MaxLeafObjects, nodes_, order);
+    objects_.reserve(order.size());
+    bounds_.reserve(order.size());
+    for (uint32_t index : order) {
+        objects_.push_back(objects[index]);
+        bounds_.push_back(boxes[index]);
+    }
+    build_time_ = std::chrono::steady_clock::now() - start;
+    if constexpr (debug::tree) {
+        std::cout << *this << std::endl;
+    }
+}
+
+namespace {
+/// The per item information needed only during the build
+struct Primitive {
+    Box box;
+    precision centroid[dimensions];
+    uint32_t index;
+};
+
+/// Recursively splits the primitives into the flattened nodes
+class Builder {
+public:
+    Builder(size_t max_leaf_items, std::vector<FlatNode>& nodes)
+        : max_leaf_items_{max_leaf_items}, nodes_{nodes}, depth_{0U} {
+    }
+
+    /// Builds the subtree over [begin, end) of the primitives and returns the index of its node.
+    uint32_t subdivide(std::vector<Primitive>& primitives, size_t begin, size_t end, size_t depth);
+
+    /// @return The deepest level reached
+    size_t depth() const {
+        return depth_;
+    }
+
+protected:
+    size_t max_leaf_items_;
+    std::vector<FlatNode>& nodes_;
+    size_t depth_;
+};
+
+uint32_t Builder::subdivide(std::vector<Primitive>& primitives, size_t begin, size_t end, size_t depth) {
+    depth_ = std::max(depth_, depth);
+    Box bounds;
+    Box centroids;
+    for (size_t i = begin; i < end; i++) {
+        bounds.grow(primitives[i].box);
+        centroids.grow(primitives[i].centroid, primitives[i].centroid);
+    }
+    uint32_t const index = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+    for (size_t a = 0; a < dimensions; a++) {
+        nodes_[index].lower[a] = bounds.lower[a];
+        nodes_[index].upper[a] = bounds.upper[a];
+    }
+    size_t const count = end - begin;
+    auto make_leaf = [&]() -> uint32_t {
+        basal::exception::throw_if(count > std::numeric_limits<uint16_t>::max(), __FILE__, __LINE__,
+                                   "Too many items in a leaf: %zu", count);
+        nodes_[index].offset = static_cast<uint32_t>(begin);
+        nodes_[index].count = static_cast<uint16_t>(count);
+        nodes_[index].axis = 0U;
+        return index;
+    };
+    if (count <= max_leaf_items_ or depth >= BVH::MaxDepth) {
+        return make_leaf();
+    }
+    // split along the widest axis of the centroids
+    size_t axis = 0U;
+    for (size_t a = 1; a < dimensions; a++) {
+        if ((centroids.upper[a] - centroids.lower[a]) > (centroids.upper[axis] - centroids.lower[axis])) {
+            axis = a;
+        }
+    }
+    precision const extent = centroids.upper[axis] - centroids.lower[axis];
+    size_t middle = begin + (count / 2U);
+    if (extent > 0.0_p) {
+        // bin the centroids into buckets along the axis
+        struct Bucket {
+            size_t count{0U};
+            Box box;
+        } buckets[BVH::NumBuckets];
+        auto bucket_of = [&](Primitive const& primitive) -> size_t {
+            precision const fraction = (primitive.centroid[axis] - centroids.lower[axis]) / extent;
+            size_t b = static_cast<size_t>(BVH::NumBuckets * fraction);
+            return std::min(b, BVH::NumBuckets - 1U);
+        };
+        for (size_t i = begin; i < end; i++) {
+            Bucket& bucket = buckets[bucket_of(primitives[i])];
+            bucket.count++;
+            bucket.box.grow(primitives[i].box);
+        }
+        // sweep from both sides to compute the cost of each split plane
+        precision costs[BVH::NumBuckets - 1U];
+        Box left;
+        size_t left_count = 0U;
+        for (size_t b = 0; b < BVH::NumBuckets - 1U; b++) {
+            left.grow(buckets[b].box);
+            left_count += buckets[b].count;
+            costs[b] = left_count * left.area();
+        }
+        Box right;
+        size_t right_count = 0U;
+        for (size_t b = BVH::NumBuckets - 1U; b > 0U; b--) {
+            right.grow(buckets[b].box);
+            right_count += buckets[b].count;
+            costs[b - 1U] += right_count * right.area();
+        }
+        size_t best = 0U;
+        for (size_t b = 1; b < BVH::NumBuckets - 1U; b++) {
+            if (costs[b] < costs[best]) {
+                best = b;
+            }
+        }
+        precision const area = bounds.area();
+        precision const split_cost = BVH::TraversalCost + (area > 0.0_p ? costs[best] / area : precision(count));
+        precision const leaf_cost = precision(count);
+        if (leaf_cost <= split_cost and count <= std::numeric_limits<uint16_t>::max()) {
+            return make_leaf();
+        }
+        auto const first = primitives.begin();
+        middle = static_cast<size_t>(
+            std::partition(first + begin, first + end, [&](Primitive const& p) { return bucket_of(p) <= best; })
+            - first);
+    }
+    if (middle == begin or middle == end) {
+        // degenerate split, fall back to the median of the centroids
+        middle = begin + (count / 2U);
+        auto const first = primitives.begin();
+        std::nth_element(first + begin, first + middle, first + end, [axis](Primitive const& a, Primitive const& b) {
+            return a.centroid[axis] < b.centroid[axis];
+        });
+    }
+    nodes_[index].count = 0U;
+    nodes_[index].axis = static_cast<uint16_t>(axis);
+    subdivide(primitives, begin, middle, depth + 1U);  // always lands at index + 1
+    uint32_t const second = subdivide(primitives, middle, end, depth + 1U);
+    nodes_[index].offset = second;
+    return index;
+}
+}  // namespace
+
+size_t build_flat_hierarchy(std::vector<FlatBounds> const& boxes, size_t max_leaf_items, std::vector<FlatNode>& nodes,
+                            std::vector<uint32_t>& order) {
+    nodes.clear();
+    order.clear();
+    std::vector<Primitive> primitives;
+    primitives.reserve(boxes.size());
+    for (size_t i = 0; i < boxes.size(); i++) {
+        Primitive primitive;
+        for (size_t a = 0; a < dimensions; a++) {
+            primitive.box.lower[a] = boxes[i].lower[a];
+            primitive.box.upper[a] = boxes[i].upper[a];
+            primitive.centroid[a] = (boxes[i].lower[a] + boxes[i].upper[a]) / 2.0_p;
+        }
+        primitive.index = static_cast<uint32_t>(i);
+        primitives.push_back(primitive);
+    }
+    if (primitives.empty()) {
+        return 0U;
+    }
+    // a binary tree never has more than 2N-1 nodes
+    nodes.reserve(2U * primitives.size() - 1U);
+    Builder builder{max_leaf_items, nodes};
+    builder.subdivide(primitives, 0U, primitives.size(), 1U);
+    order.reserve(primitives.size());
+    for (auto const& primitive : primitives) {
+        order.push_back(primitive.index);
+    }
+    return builder.depth();
+}
+
+BVH::hits BVH::intersects(raytrace::ray const& ray) const {
+    hits found;
+    if (nodes_.empty()) {
+        return found;
+    }
+    precision origin[dimensions];
+    precision inverse[dimensions];
+    prepare(ray, origin, inverse);
+    uint32_t stack[MaxDepth + 1U];
+    size_t top = 0U;
+    stack[top++] = 0U;
+    while (top > 0U) {
+        uint32_t const index = stack[--top];
+        FlatNode const& node = nodes_[index];
+        precision t_enter;
+        if (not node.enters(origin, inverse, basal::pos_inf, t_enter)) {
+            continue;
+        }
+        statistics::count(&statistics::intersections_with_bounds);
+        if (node.is_leaf()) {
+            for (size_t i = node.offset; i < size_t(node.offset) + node.count; i++) {
+                auto hit = objects_[i]->intersect(ray);
+                if (get_type(hit.intersect) == IntersectionType::Point) {
+                    found.push_back(hit);
+                }
+            }
+        } else {
+            uint32_t near = index + 1U;
+            uint32_t far = node.offset;
+            if (ray.direction()[node.axis] < 0.0_p) {
+                std::swap(near, far);
+            }
+            // push the far child first so the near child is visited first
+            stack[top++] = far;
+            stack[top++] = near;
+        }
+    }
+    return found;
+}
+
+bool BVH::closest(raytrace::ray const& ray, objects::object::hit& nearest, precision& t_max) const {
+    objects::hit_record record;
+    record.distance = t_max;
+    if (not closest(ray, record)) {
+        return false;
+    }
+    // only the nearest hit's surface is computed
+    nearest = record.object->resolve(ray, record);
+    t_max = record.distance;
+    return true;
+}
+
+bool BVH::closest(raytrace::ray const& ray, objects::hit_record& nearest) const {
+    if (nodes_.empty()) {
+        return false;
+    }
+    precision origin[dimensions];
+    precision inverse[dimensions];
+    prepare(ray, origin, inverse);
+    precision t_max = nearest.distance;
+    bool found = false;
+    Pending stack[MaxDepth + 1U];
+    size_t top = 0U;
+    precision t_enter;
+    if (not nodes_[0].enters(origin, inverse, t_max, t_enter)) {
+        return false;
+    }
+    stack[top++] = Pending{0U, t_enter};
+    while (top > 0U) {
+        Pending const pending = stack[--top];
+        if (pending.t_enter > t_max) {
+            continue;  // a nearer hit was found since this node was pushed
+        }
+        FlatNode const& node = nodes_[pending.index];
+        statistics::count(&statistics::intersections_with_bounds);
+        if (node.is_leaf()) {
+            for (size_t i = node.offset; i < size_t(node.offset) + node.count; i++) {
+                if (not bounds_[i].enters(origin, inverse, t_max, t_enter)) {
+                    continue;
+                }
+                found |= keep_nearest(ray, objects_[i], nearest);
+                t_max = nearest.distance;
+            }
+        } else {
+            Pending near{pending.index + 1U, 0.0_p};
+            Pending far{node.offset, 0.0_p};
+            bool const near_entered = nodes_[near.index].enters(origin, inverse, t_max, near.t_enter);
+            bool const far_entered = nodes_[far.index].enters(origin, inverse, t_max, far.t_enter);
+            if (near_entered and far_entered) {
+                if (far.t_enter < near.t_enter) {
+                    std::swap(near, far);
+                }
+                // push the far child first so the near child is visited first
+                stack[top++] = far;
+                stack[top++] = near;
+            } else if (near_entered) {
+                stack[top++] = near;
+            } else if (far_entered) {
+                stack[top++] = far;
+            }
+        }
+    }
+    return found;
+}
+
+objects::object const* BVH::occluder(raytrace::ray const& ray, precision max_distance,
+                                     objects::object const* skip) const {
+    if (nodes_.empty()) {
+        return nullptr;
+    }
+    precision origin[dimensions];
+    precision inverse[dimensions];
+    prepare(ray, origin, inverse);
+    uint32_t stack[MaxDepth + 1U];
+    size_t top = 0U;
+    stack[top++] = 0U;
+    while (top > 0U) {
+        uint32_t const index = stack[--top];
+        FlatNode const& node = nodes_[index];
+        precision t_enter;
+        if (not node.enters(origin, inverse, max_distance, t_enter)) {
+            continue;
+        }
+        statistics::count(&statistics::intersections_with_bounds);
+        if (node.is_leaf()) {
+            for (size_t i = node.offset; i < size_t(node.offset) + node.count; i++) {
+                if (objects_[i] == skip or not bounds_[i].enters(origin, inverse, max_distance, t_enter)) {
+                    continue;
+                }
+                if (blocks(ray, objects_[i], max_distance)) {
+                    return objects_[i];
+                }
+            }
+        } else {
+            // any blocker will do, but nearer blockers are more likely so keep the near-to-far order
+            uint32_t near = index + 1U;
+            uint32_t far = node.offset;
+            if (ray.direction()[node.axis] < 0.0_p) {
+                std::swap(near, far);
+            }
+            stack[top++] = far;
+            stack[top++] = near;
+        }
+    }
+    return nullptr;
+}
+
+uint32_t BVH::closest(ray_packet const& rays, uint32_t active, packet_hits& nearest,
+                      precision (&t_max)[ray_packet::width]) const {
+    if (nodes_.empty() or active == 0U) {
+        return 0U;
+    }
+    // the lanes are coherent so the first one decides the order of the children
+    size_t const lead = first_lane(active);
+    uint32_t found = 0U;
+    uint32_t stack[MaxDepth + 1U];
+    size_t top = 0U;
+    stack[top++] = 0U;
+    while (top > 0U) {
+        uint32_t const index = stack[--top];
+        FlatNode const& node = nodes_[index];
+        uint32_t const entered = node.enters(rays, t_max, active);
+        if (entered == 0U) {
+            continue;  // no lane enters (or every lane has a nearer hit already)
+        }
+        statistics::count(&statistics::intersections_with_bounds);
+        if (node.is_leaf()) {
+            for (size_t i = node.offset; i < size_t(node.offset) + node.count; i++) {
+                uint32_t const lanes = bounds_[i].enters(rays, t_max, entered);
+                if (lanes != 0U) {
+                    found |= keep_nearest(rays, objects_[i], lanes, nearest, t_max);
+                }
+            }
+        } else {
+            uint32_t near = index + 1U;
+            uint32_t far = node.offset;
+            if (rays.direction[node.axis][lead] < 0.0_p) {
+                std::swap(near, far);
+            }
+            // push the far child first so the near child is visited first
+            stack[top++] = far;
+            stack[top++] = near;
+        }
+    }
+    return found;
+}
+
+uint32_t BVH::occluders(ray_packet const& rays, uint32_t active, precision const (&max_distance)[ray_packet::width],
+                        objects::object const* (&blockers)[ray_packet::width]) const {
+    if (nodes_.empty() or active == 0U) {
+        return 0U;
+    }
+    size_t const lead = first_lane(active);
+    uint32_t blocked = 0U;
+    uint32_t stack[MaxDepth + 1U];
+    size_t top = 0U;
+    stack[top++] = 0U;
+    while (top > 0U and active != 0U) {
+        uint32_t const index = stack[--top];
+        FlatNode const& node = nodes_[index];
+        uint32_t const entered = node.enters(rays, max_distance, active);
+        if (entered == 0U) {
+            continue;
+        }
+        statistics::count(&statistics::intersections_with_bounds);
+        if (node.is_leaf()) {
+            for (size_t i = node.offset; i < size_t(node.offset) + node.count and active != 0U; i++) {
+                uint32_t const lanes = bounds_[i].enters(rays, max_distance, entered & active);
+                if (lanes == 0U) {
+                    continue;
+                }
+                uint32_t const now_blocked = blocks(rays, objects_[i], lanes, max_distance);
+                for (size_t lane = 0; lane < ray_packet::width; lane++) {
+                    if (now_blocked & (1U << lane)) {
+                        blockers[lane] = objects_[i];
+                    }
+                }
+                blocked |= now_blocked;
+                active &= ~now_blocked;
+            }
+        } else {
+            uint32_t near = index + 1U;
+            uint32_t far = node.offset;
+            if (rays.direction[node.axis][lead] < 0.0_p) {
+                std::swap(near, far);
+            }
+            stack[top++] = far;
+            stack[top++] = near;
+        }
+    }
+    return blocked;
+}
+
+std::ostream& operator<<(std::ostream& os, BVH const& bvh) {
+    os << "BVH: nodes " << bvh.node_count() << " objects " << bvh.object_count() << " depth " << bvh.depth()
+       << " built in " << std::chrono::duration<double, std::milli>(bvh.build_time()).count() << " ms";
+    return os;
+}
+
+}  // namespace tree
+}  // namespace raytrace
@@ -122,6 +122,8 @@ void camera::move_to(point const& look_from, point const& look_at) {
     m_intrinsics[2][2] = image_distance;
     m_intrinsics[0][2] = -((w / 2.0_p) * m_pixel_scale);  // primary point x
     m_intrinsics[1][2] = -((h / 2.0_p) * m_pixel_scale);  // primary point y
+    // combine the intrinsics and the camera to object rotation so casting does not need any matrix math
+    m_image_to_object = raytrace::transform{m_camera_to_object_rotation * m_intrinsics, R3::origin};
 
     // now verify the look_at by casting a ray through the principal point and determine what t the look_at is at
     // (should be zero).
@@ -173,14 +175,13 @@ ray camera::cast(image::point const& image_point) const {
     // the image plane is in the x,y camera coordinates plane but at z=1
     // basically there has to be a assumed arrangement
     // of the camera point and the image plane.
-    raytrace::point camera_point(m_intrinsics * hg_image_point);
+    // then rotate the camera point into the object point (both steps are combined into one transform)
+    raytrace::point object_point = m_image_to_object.forward(hg_image_point);
     if constexpr (debug::cast) {
         std::cout << "\tCamera Intrinsics " << m_intrinsics << std::endl;
-        std::cout << "\tNew Camera Point " << camera_point << std::endl;
         std::cout << "\tCamera to Object Rotation " << m_camera_to_object_rotation << std::endl;
+        std::cout << "\tImage to Object " << m_image_to_object << std::endl;
     }
-    // now rotate and translate the camera point into the world point
-    raytrace::point object_point = m_camera_to_object_rotation * camera_point;
     // go from object point to world point
     raytrace::point world_point = forward_transform(object_point);
     // now that we know where the world_point is for this image point,
@@ -196,7 +197,7 @@ ray camera::cast(image::point const& image_point) const {
     // now base the ray starting at the image plane with the vector from above
     ray world_ray(world_point, world_direction.normalize());
     // increment the statistics
-    statistics::get().cast_rays_from_camera++;
+    statistics::count(&statistics::cast_rays_from_camera);
     // that's it
     return world_ray;
 }
@@ -1,12 +1,19 @@
 #include "raytrace/image.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <memory>
 #include <random>
 #include <thread>
 #include <vector>
 
 #include "basal/exception.hpp"
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 namespace raytrace {
 
 image::image(size_t h, size_t w) : fourcc::image<fourcc::PixelFormat::RGBId>(h, w) {
@@ -92,44 +99,323 @@ public:
     }
 };
 
-void image::generate_each(subsampler get_color, size_t number_of_samples, std::optional<rendered_line> row_notifier,
-                          fourcc::image<fourcc::PixelFormat::Y8>* mask, uint8_t mask_threshold, bool tone_mapping) {
-    SampleFuzzer* delta;
-    if constexpr (use_random_sample_points) {
-        delta = new RandomSampleFuzzer();
-    } else {
-        delta = new FixedSampleFuzzer();
+void image::generate_each(subsampler get_color, size_t number_of_samples, std::optional<rendered_tile> tile_notifier,
+                          fourcc::image<fourcc::PixelFormat::Y8>* mask, uint8_t mask_threshold, bool tone_mapping,
+                          tiling const& layout) {
+    packet_subsampler get_colors = [&](image::point const* points, color* colors, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            colors[i] = get_color(points[i]);
+        }
+    };
+    generate_each(get_colors, 1U, number_of_samples, tile_notifier, mask, mask_threshold, tone_mapping, layout);
+}
+
+/// Splits the image into tiles which are handed out to the worker threads.
+/// @param make_work Called once on each worker thread to make the functor which is given each tile to render. This lets
+/// each worker keep its own buffers so the pixels themselves do not allocate.
+template <typename MAKE_WORK>
+static void for_each_tile(size_t height, size_t width, tiling const& layout,
+                          std::optional<image::rendered_tile> const& tile_notifier, MAKE_WORK make_work) {
+#if defined(_OPENMP)
+    size_t const number_of_workers = static_cast<size_t>(omp_get_max_threads());
+#else
+    size_t const number_of_workers = 1U;
+#endif
+    tile_scheduler scheduler{make_tiles(height, width, layout), number_of_workers};
+
+#pragma omp parallel shared(scheduler, make_work) num_threads(number_of_workers)
+    {
+#if defined(_OPENMP)
+        size_t const worker = static_cast<size_t>(omp_get_thread_num());
+#else
+        size_t const worker = 0U;
+#endif
+        auto work = make_work();
+        tile region;
+        while (scheduler.next(worker, region)) {
+            work(region);
+            if (tile_notifier != std::nullopt) {
+                tile_notifier.value()(region, true);
+            }
+        }
     }
+}
 
-#pragma omp parallel for shared(data, delta, get_color)
-    for (size_t y = 0; y < height; y++) {
-        for (size_t x = 0; x < width; x++) {
-            if (mask and (mask->at(y, x) < mask_threshold)) {
-                // skip pixel that are below the threshold
-                continue;
+/// Splits the image into tiles (see @ref for_each_tile) and gives each worker the rows of up to lanes neighboring
+/// pixels of each tile which are not masked off.
+/// @param make_run Called once on each worker thread to make the functor which is given each row of columns as
+/// (y, columns, count).
+template <typename MAKE_RUN>
+static void for_each_run(size_t height, size_t width, size_t lanes, tiling const& layout,
+                         std::optional<image::rendered_tile> const& tile_notifier,
+                         fourcc::image<fourcc::PixelFormat::Y8> const* mask, uint8_t mask_threshold,
+                         MAKE_RUN make_run) {
+    for_each_tile(height, width, layout, tile_notifier, [&]() {
+        return [&, run = make_run(), columns = std::vector<size_t>(lanes)](tile const& region) mutable {
+            for (size_t y = region.y; y < (region.y + region.height); y++) {
+                size_t x = region.x;
+                while (x < (region.x + region.width)) {
+                    // gather the next unmasked pixels of the row
+                    size_t count = 0U;
+                    for (; x < (region.x + region.width) and count < lanes; x++) {
+                        if (mask and (mask->at(y, x) < mask_threshold)) {
+                            // skip pixel that are below the threshold
+                            continue;
+                        }
+                        columns[count++] = x;
+                    }
+                    if (count > 0U) {
+                        run(y, columns.data(), count);
+                    }
+                }
+            }
+        };
+    });
+}
+
+void image::generate_each(packet_subsampler get_colors, size_t lanes, size_t number_of_samples,
+                          std::optional<rendered_tile> tile_notifier, fourcc::image<fourcc::PixelFormat::Y8>* mask,
+                          uint8_t mask_threshold, bool tone_mapping, tiling const& layout) {
+    precision const weight = 1.0_p / static_cast<precision>(number_of_samples);
+    for_each_run(height, width, lanes, layout, tile_notifier, mask, mask_threshold, [&]() {
+        // each thread has its own fuzzer as the random one has state
+        std::unique_ptr<SampleFuzzer> delta;
+        if constexpr (use_random_sample_points) {
+            delta = std::make_unique<RandomSampleFuzzer>();
+        } else {
+            delta = std::make_unique<FixedSampleFuzzer>();
+        }
+        // the running blend of the samples of each lane and the points and colors of a single sample. These are made
+        // once per thread so the pixels themselves do not allocate.
+        return [&, delta = std::move(delta), blended = std::vector<color>(lanes),
+                points = std::vector<image::point>(lanes),
+                colors = std::vector<color>(lanes)](size_t y, size_t const* columns, size_t count) mutable {
+            for (size_t l = 0; l < count; l++) {
+                blended[l] = color{};
             }
-            std::vector<color> samples(number_of_samples);
             for (size_t s = 0; s < number_of_samples; s++) {
                 // create a random 2d unit vector from this point.
                 // except the first point, it should be dead center
-                image::point p = image::point{precision(x) + 0.5_p, precision(y) + 0.5_p} + (*delta)(s);
-                samples[s] = get_color(p);
+                image::vector const offset = (*delta)(s);
+                for (size_t l = 0; l < count; l++) {
+                    points[l] = image::point{precision(columns[l]) + 0.5_p, precision(y) + 0.5_p} + offset;
+                }
+                get_colors(points.data(), colors.data(), count);
+                // average all the samples together as they arrive (the same as blending them afterwards)
+                for (size_t l = 0; l < count; l++) {
+                    basal::exception::throw_unless(colors[l].GetEncoding() == fourcc::Encoding::Linear, __FILE__,
+                                                   __LINE__, "Color should be in linear Encoding");
+                    colors[l] *= weight;
+                    blended[l] += colors[l];
+                }
             }
-            // now average all the samples together.
-            color value = color::blend_samples(samples);
-            if (tone_mapping) {
-                ReinhardToneMapper mapper;
-                value = mapper(value);
+            for (size_t l = 0; l < count; l++) {
+                store(y, columns[l], blended[l], tone_mapping);
+            }
+        };
+    });
+}
+
+void image::accumulate_each(packet_subsampler get_colors, size_t lanes, std::vector<color>& sums, size_t pass,
+                            std::optional<rendered_tile> tile_notifier, bool tone_mapping, tiling const& layout) {
+    basal::exception::throw_unless(sums.size() == (height * width), __FILE__, __LINE__,
+                                   "Must have a sum for each pixel");
+    image::vector const offset = low_discrepancy_offset(pass);
+    precision const weight = 1.0_p / static_cast<precision>(pass + 1U);
+    for_each_run(height, width, lanes, layout, tile_notifier, nullptr, AAA_MASK_DISABLED, [&]() {
+        return [&, points = std::vector<image::point>(lanes), colors = std::vector<color>(lanes)](
+                   size_t y, size_t const* columns, size_t count) mutable {
+            for (size_t l = 0; l < count; l++) {
+                points[l] = image::point{precision(columns[l]) + 0.5_p, precision(y) + 0.5_p} + offset;
             }
-            auto out = value.to_<fourcc::PixelFormat::RGBId>();
-            fourcc::image<format>::at(y, x) = out;
+            get_colors(points.data(), colors.data(), count);
+            for (size_t l = 0; l < count; l++) {
+                basal::exception::throw_unless(colors[l].GetEncoding() == fourcc::Encoding::Linear, __FILE__,
+                                               __LINE__, "Color should be in linear Encoding");
+                color& sum = sums[y * width + columns[l]];
+                sum += colors[l];
+                color average = sum;
+                average *= weight;
+                store(y, columns[l], average, tone_mapping);
+            }
+        };
+    });
+}
+
+void image::generate_adaptive(packet_subsampler get_colors, size_t lanes, size_t max_samples, precision tolerance,
+                              fourcc::image<fourcc::PixelFormat::Y8>* counts,
+                              std::optional<rendered_tile> tile_notifier, bool tone_mapping, tiling const& layout) {
+    basal::exception::throw_if(lanes == 0U, __FILE__, __LINE__, "Must have at least one lane");
+    basal::exception::throw_if(max_samples == 0U, __FILE__, __LINE__, "Must have at least one sample");
+    basal::exception::throw_if(counts and (counts->height != height or counts->width != width), __FILE__, __LINE__,
+                               "The counts must be the same size as the image");
+    // the running statistics of the samples of a pixel (Welford's method)
+    struct moments {
+        size_t samples;
+        precision mean[3];
+        precision sum_of_squares[3];  // of the differences from the mean
+
+        void add(color const& value) {
+            precision const channels[3] = {static_cast<precision>(value.red()), static_cast<precision>(value.green()),
+                                           static_cast<precision>(value.blue())};
+            samples++;
+            for (size_t c = 0; c < 3U; c++) {
+                precision const before = channels[c] - mean[c];
+                mean[c] += before / static_cast<precision>(samples);
+                sum_of_squares[c] += before * (channels[c] - mean[c]);
+            }
+        }
+
+        // the half width of the confidence interval of the mean of the worst channel
+        precision error() const {
+            precision worst = 0.0_p;
+            for (size_t c = 0; c < 3U; c++) {
+                worst = std::max(worst, sum_of_squares[c]);
+            }
+            precision const variance = worst / static_cast<precision>(samples - 1U);
+            return adaptive_confidence * std::sqrt(variance / static_cast<precision>(samples));
         }
-        if (row_notifier != std::nullopt) {
-            rendered_line func = row_notifier.value();
-            func(y, true);
+    };
+    // the largest difference in any channel
+    auto difference = [](color const& a, color const& b) -> precision {
+        return std::max(
+            {std::abs(a.red() - b.red()), std::abs(a.green() - b.green()), std::abs(a.blue() - b.blue())});
+    };
+    for_each_tile(height, width, layout, tile_notifier, [&]() {
+        // the first sample of each pixel of the tile and the statistics, columns and points of a packet of the pixels
+        // which need more samples. These are made once per thread so the pixels themselves do not allocate.
+        return [&, first = std::vector<color>{}, columns = std::vector<size_t>(lanes),
+                stats = std::vector<moments>(lanes), active = std::vector<size_t>(lanes),
+                points = std::vector<image::point>(lanes),
+                colors = std::vector<color>(lanes)](tile const& region) mutable {
+            // the tile and a border of one pixel around it (within the image) are sampled once at their centers. The
+            // border lets the pixels along the edges of the tile be compared to all their neighbors too.
+            size_t const left = region.x > 0U ? region.x - 1U : region.x;
+            size_t const top = region.y > 0U ? region.y - 1U : region.y;
+            size_t const right = std::min(region.x + region.width + 1U, width);
+            size_t const bottom = std::min(region.y + region.height + 1U, height);
+            size_t const span = right - left;
+            first.resize(span * (bottom - top));  // only grows on the first (and largest) tile
+            for (size_t y = top; y < bottom; y++) {
+                for (size_t x = left; x < right; x += lanes) {
+                    size_t const count = std::min(lanes, right - x);
+                    for (size_t l = 0; l < count; l++) {
+                        points[l] = image::point{precision(x + l) + 0.5_p, precision(y) + 0.5_p};
+                    }
+                    get_colors(points.data(), &first[(y - top) * span + (x - left)], count);
+                }
+            }
+            auto sample = [&](size_t y, size_t x) -> color const& { return first[(y - top) * span + (x - left)]; };
+            // the pixels which differ from a neighbor take more samples, one packet at a time
+            auto refine = [&](size_t y, size_t count) {
+                size_t number_active = 0U;
+                for (size_t l = 0; l < count; l++) {
+                    stats[l] = moments{};
+                    stats[l].add(sample(y, columns[l]));
+                    active[number_active++] = l;
+                }
+                while (number_active > 0U) {
+                    for (size_t b = 0; b < adaptive_batch and number_active > 0U; b++) {
+                        for (size_t a = 0; a < number_active; a++) {
+                            size_t const l = active[a];
+                            points[a] = image::point{precision(columns[l]) + 0.5_p, precision(y) + 0.5_p}
+                                        + low_discrepancy_offset(stats[l].samples);
+                        }
+                        get_colors(points.data(), colors.data(), number_active);
+                        size_t remaining = 0U;
+                        for (size_t a = 0; a < number_active; a++) {
+                            size_t const l = active[a];
+                            basal::exception::throw_unless(colors[a].GetEncoding() == fourcc::Encoding::Linear,
+                                                           __FILE__, __LINE__, "Color should be in linear Encoding");
+                            stats[l].add(colors[a]);
+                            if (stats[l].samples < max_samples) {
+                                active[remaining++] = l;
+                            }
+                        }
+                        number_active = remaining;
+                    }
+                    // stop once the mean is known well enough
+                    size_t remaining = 0U;
+                    for (size_t a = 0; a < number_active; a++) {
+                        size_t const l = active[a];
+                        if (stats[l].error() > tolerance) {
+                            active[remaining++] = l;
+                        }
+                    }
+                    number_active = remaining;
+                }
+                for (size_t l = 0; l < count; l++) {
+                    store(y, columns[l], color(stats[l].mean[0], stats[l].mean[1], stats[l].mean[2]), tone_mapping);
+                    if (counts) {
+                        counts->at(y, columns[l]) = static_cast<uint8_t>((stats[l].samples * 255U) / max_samples);
+                    }
+                }
+            };
+            for (size_t y = region.y; y < (region.y + region.height); y++) {
+                size_t count = 0U;
+                for (size_t x = region.x; x < (region.x + region.width); x++) {
+                    color const& center = sample(y, x);
+                    basal::exception::throw_unless(center.GetEncoding() == fourcc::Encoding::Linear, __FILE__,
+                                                   __LINE__, "Color should be in linear Encoding");
+                    // the largest difference to the neighbors (left, right, above and below)
+                    precision contrast = 0.0_p;
+                    if (x > left) {
+                        contrast = std::max(contrast, difference(center, sample(y, x - 1U)));
+                    }
+                    if (x + 1U < right) {
+                        contrast = std::max(contrast, difference(center, sample(y, x + 1U)));
+                    }
+                    if (y > top) {
+                        contrast = std::max(contrast, difference(center, sample(y - 1U, x)));
+                    }
+                    if (y + 1U < bottom) {
+                        contrast = std::max(contrast, difference(center, sample(y + 1U, x)));
+                    }
+                    if (max_samples > 1U and contrast > tolerance) {
+                        columns[count++] = x;
+                        if (count == lanes) {
+                            refine(y, count);
+                            count = 0U;
+                        }
+                    } else {
+                        // a pixel like its neighbors is done
+                        store(y, x, center, tone_mapping);
+                        if (counts) {
+                            counts->at(y, x) = static_cast<uint8_t>(255U / max_samples);
+                        }
+                    }
+                }
+                if (count > 0U) {
+                    refine(y, count);
+                }
+            }
+        };
+    });
+}
+
+image::vector image::low_discrepancy_offset(size_t index) {
+    // the radical inverse of the index in a base, reflecting the digits about the decimal point
+    auto radical_inverse = [](size_t value, size_t base) -> precision {
+        precision const inverse = 1.0_p / static_cast<precision>(base);
+        precision fraction = inverse;
+        precision result = 0.0_p;
+        for (; value > 0U; value /= base) {
+            result += static_cast<precision>(value % base) * fraction;
+            fraction *= inverse;
         }
+        return result;
+    };
+    // the Halton sequence in bases 2 and 3, shifted by half a pixel (modulo 1) so that the first sample is the center
+    auto centered = [](precision h) -> precision { return (h < 0.5_p ? h + 0.5_p : h - 0.5_p) - 0.5_p; };
+    return image::vector{centered(radical_inverse(index, 2U)), centered(radical_inverse(index, 3U))};
+}
+
+void image::store(size_t y, size_t x, color value, bool tone_mapping) {
+    if (tone_mapping) {
+        ReinhardToneMapper mapper;
+        value = mapper(value);
     }
-    delete delta;
+    fourcc::image<format>::at(y, x) = value.to_<fourcc::PixelFormat::RGBId>();
 }
 
 }  // namespace raytrace
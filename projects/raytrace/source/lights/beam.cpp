@@ -28,7 +28,7 @@ void beam::print(std::ostream& os, char const str[]) const {
 
 ray beam::emit() {
     // beams don't know the camera frustrum so we just emit in the same direction as a the beam
-    statistics::get().emitted_rays++;
+    statistics::count(&statistics::emitted_rays);
     return ray(R3::origin, m_world_source);
 }
 
@@ -29,6 +29,10 @@ ray bulb::incident(point const& world_point, size_t sample_index) const {
     return ray(world_point, shadow + perturb);
 }
 
+precision bulb::radius() const {
+    return m_radius;
+}
+
 void bulb::print(std::ostream& os, char const str[]) const {
     os << " bulb @ " << this << " " << str << " " << m_samples << " @" << this << " " << position() << ", " << m_color
        << std::endl;
@@ -44,7 +48,7 @@ ray bulb::emit() {
     // Emit a ray in a random direction
     point pnt = raytrace::mapping::golden_ratio_mapper(s, limit);
     vector dir = (pnt - R3::origin);  // these don't need to be normalized since they are from a unit sphere.
-    statistics::get().emitted_rays++;
+    statistics::count(&statistics::emitted_rays);
     return ray(position(), dir);
 }
 
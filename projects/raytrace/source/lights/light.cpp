@@ -1,4 +1,7 @@
 #include "raytrace/lights/light.hpp"
+
+#include <algorithm>
+
 #include "raytrace/laws.hpp"
 
 namespace raytrace {
@@ -41,6 +44,14 @@ precision light::intensity_at(point const& world_point) const {
     }
 }
 
+precision light::power() const {
+    return m_intensity * std::max({m_color.red(), m_color.green(), m_color.blue()});
+}
+
+precision light::radius() const {
+    return 0.0_p;
+}
+
 std::ostream& operator<<(std::ostream& os, light const& l) {
     l.print(os, "Light");
     os << "Light " << l.position() << " with color " << l.m_color << " and intensity " << l.m_intensity
@@ -0,0 +1,151 @@
+#include "raytrace/lights/selector.hpp"
+
+#include <algorithm>
+
+namespace raytrace {
+namespace lights {
+
+using namespace linalg::operators;
+
+void selector::build(light_list const& lights) {
+    m_nodes.clear();
+    if (lights.empty()) {
+        return;
+    }
+    m_nodes.reserve(2U * lights.size() - 1U);
+    light_list sorted{lights};
+    build(sorted.data(), sorted.data() + sorted.size(), 0U);
+}
+
+size_t selector::build(light const** first, light const** last, size_t parent) {
+    size_t const index = m_nodes.size();
+    m_nodes.emplace_back();
+    m_nodes[index].parent = parent;
+    size_t const count = static_cast<size_t>(last - first);
+    if (count == 1U) {
+        light const* only = *first;
+        vector const extent{{only->radius(), only->radius(), only->radius()}};
+        m_nodes[index].min = only->position() - extent;
+        m_nodes[index].max = only->position() + extent;
+        m_nodes[index].power = only->power();
+        m_nodes[index].leaf = only;
+        return index;
+    }
+    // split the lights in half along the longest axis of their positions
+    point low = (*first)->position();
+    point high = (*first)->position();
+    for (light const** l = first; l != last; l++) {
+        for (size_t a = 0; a < 3U; a++) {
+            low[a] = std::min(low[a], (*l)->position()[a]);
+            high[a] = std::max(high[a], (*l)->position()[a]);
+        }
+    }
+    size_t axis = 0U;
+    for (size_t a = 1; a < 3U; a++) {
+        if ((high[a] - low[a]) > (high[axis] - low[axis])) {
+            axis = a;
+        }
+    }
+    light const** middle = first + (count / 2U);
+    std::nth_element(first, middle, last, [axis](light const* a, light const* b) {
+        return a->position()[axis] < b->position()[axis];
+    });
+    size_t const left = build(first, middle, index);
+    size_t const right = build(middle, last, index);
+    // the children may have moved the nodes
+    node& n = m_nodes[index];
+    n.left = left;
+    n.right = right;
+    for (size_t a = 0; a < 3U; a++) {
+        n.min[a] = std::min(m_nodes[left].min[a], m_nodes[right].min[a]);
+        n.max[a] = std::max(m_nodes[left].max[a], m_nodes[right].max[a]);
+    }
+    n.power = m_nodes[left].power + m_nodes[right].power;
+    return index;
+}
+
+void selector::clear() {
+    m_nodes.clear();
+}
+
+size_t selector::size() const {
+    return (m_nodes.size() + 1U) / 2U;
+}
+
+precision selector::importance(node const& n, point const& world_point, vector const& world_normal) const {
+    // nothing behind the surface can light it, so the volume must have a corner in front of it
+    bool in_front = false;
+    for (size_t c = 0; c < 8U and not in_front; c++) {
+        point const corner{(c & 1U) ? n.max.x() : n.min.x(), (c & 2U) ? n.max.y() : n.min.y(),
+                           (c & 4U) ? n.max.z() : n.min.z()};
+        in_front = dot(corner - world_point, world_normal) > 0.0_p;
+    }
+    if (not in_front) {
+        return 0.0_p;
+    }
+    if (n.leaf) {
+        color const lit = n.leaf->color_at(world_point);
+        return std::max({lit.red(), lit.green(), lit.blue()});
+    }
+    // the power falls off with the square of the distance to the center, but not closer than the size of the volume
+    point const center = point{(n.min.x() + n.max.x()) / 2.0_p, (n.min.y() + n.max.y()) / 2.0_p,
+                               (n.min.z() + n.max.z()) / 2.0_p};
+    precision const distance = (center - world_point).quadrance();
+    precision const size = (n.max - n.min).quadrance() / 4.0_p;
+    return n.power / std::max({distance, size, basal::epsilon});
+}
+
+selector::choice selector::choose(point const& world_point, vector const& world_normal, precision value) const {
+    choice result;
+    if (m_nodes.empty()) {
+        return result;
+    }
+    result.probability = 1.0_p;
+    size_t index = 0U;
+    while (m_nodes[index].leaf == nullptr) {
+        node const& n = m_nodes[index];
+        precision const left = importance(m_nodes[n.left], world_point, world_normal);
+        precision const right = importance(m_nodes[n.right], world_point, world_normal);
+        if ((left + right) <= 0.0_p) {
+            return choice{};
+        }
+        // take the left branch for its share of the values and rescale the value to [0, 1) within it
+        precision const share = left / (left + right);
+        if (value < share) {
+            value = value / share;
+            result.probability *= share;
+            index = n.left;
+        } else {
+            value = std::min((value - share) / (1.0_p - share), std::nextafter(1.0_p, 0.0_p));
+            result.probability *= (1.0_p - share);
+            index = n.right;
+        }
+    }
+    result.chosen = m_nodes[index].leaf;
+    return result;
+}
+
+precision selector::probability(point const& world_point, vector const& world_normal, light const* target) const {
+    auto const found
+        = std::find_if(m_nodes.begin(), m_nodes.end(), [target](node const& n) { return n.leaf == target; });
+    if (target == nullptr or found == m_nodes.end()) {
+        return 0.0_p;
+    }
+    // multiply the shares of each branch from the light up to the root
+    precision result = 1.0_p;
+    size_t index = static_cast<size_t>(found - m_nodes.begin());
+    while (index != 0U) {
+        node const& parent = m_nodes[m_nodes[index].parent];
+        precision const left = importance(m_nodes[parent.left], world_point, world_normal);
+        precision const right = importance(m_nodes[parent.right], world_point, world_normal);
+        if ((left + right) <= 0.0_p) {
+            return 0.0_p;
+        }
+        result *= ((index == parent.left) ? left : right) / (left + right);
+        index = m_nodes[index].parent;
+    }
+    return result;
+}
+
+}  // namespace lights
+}  // namespace raytrace
@@ -30,7 +30,7 @@ ray speck::emit() {
     // Emit a ray in a random direction
     point pnt = raytrace::mapping::golden_ratio_mapper(s, limit);
     vector dir = (pnt - R3::origin);  // these don't need to be normalized since they are from a unit sphere.
-    statistics::get().emitted_rays++;
+    statistics::count(&statistics::emitted_rays);
     return ray(position(), dir);
 }
 
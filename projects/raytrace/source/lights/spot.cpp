@@ -57,7 +57,7 @@ ray spot::emit() {
         iso::radians rad_angle = angle(m_direction, unit);
         iso::convert(deg_angle, rad_angle);
     } while (deg_angle > m_incoming_angle);
-    statistics::get().emitted_rays++;
+    statistics::count(&statistics::emitted_rays);
     return ray(position(), unit);
 }
 
@@ -0,0 +1,55 @@
+#include "raytrace/mappedfile.hpp"
+
+#include <basal/exception.hpp>
+#include <cstdio>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace raytrace {
+
+MappedFile::MappedFile(char const* const filename) : m_data{nullptr}, m_size{0U}, m_mapped{false}, m_copy{} {
+#if defined(__linux__) || defined(__APPLE__)
+    int fd = ::open(filename, O_RDONLY);
+    basal::exception::throw_if(fd < 0, __FILE__, __LINE__, "File %s was not found!", filename);
+    struct stat info;
+    if (::fstat(fd, &info) == 0 and info.st_size > 0) {
+        void* address = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            ::madvise(address, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+            m_data = static_cast<char const*>(address);
+            m_size = static_cast<size_t>(info.st_size);
+            m_mapped = true;
+        }
+    }
+    ::close(fd);
+    if (m_mapped) {
+        return;
+    }
+#endif
+    // read the whole file instead
+    FILE* file = fopen(filename, "rb");
+    basal::exception::throw_unless(file != nullptr, __FILE__, __LINE__, "File %s was not found!", filename);
+    char buffer[1U << 16U];
+    size_t count;
+    while ((count = fread(buffer, 1U, sizeof(buffer), file)) > 0U) {
+        m_copy.append(buffer, count);
+    }
+    fclose(file);
+    m_data = m_copy.data();
+    m_size = m_copy.size();
+}
+
+MappedFile::~MappedFile() {
+#if defined(__linux__) || defined(__APPLE__)
+    if (m_mapped) {
+        ::munmap(const_cast<char*>(m_data), m_size);
+    }
+#endif
+}
+
+}  // namespace raytrace
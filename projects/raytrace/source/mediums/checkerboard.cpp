@@ -5,6 +5,7 @@ namespace raytrace {
 namespace mediums {
 
 checkerboard::checkerboard(precision repeat, color dark, color light) : opaque{}, m_repeat{repeat}, m_pal{8} {
+    m_kind = Kind::Checkerboard;
     m_ambient = colors::white;
     m_ambient_scale = mediums::ambient::none;
     m_smoothness = mediums::smoothness::barely;
@@ -21,6 +22,7 @@ checkerboard::checkerboard(precision repeat, color dark, color light) : opaque{}
 checkerboard::checkerboard(precision repeat, color q1_dark, color q1_light, color q2_dark, color q2_light,
                            color q3_dark, color q3_light, color q4_dark, color q4_light)
     : opaque{}, m_repeat{repeat}, m_pal{8} {
+    m_kind = Kind::Checkerboard;
     m_ambient = colors::white;
     m_ambient_scale = mediums::ambient::none;
     m_smoothness = mediums::smoothness::barely;
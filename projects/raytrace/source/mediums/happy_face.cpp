@@ -5,6 +5,7 @@ namespace raytrace {
 namespace mediums {
 
 happy_face::happy_face(precision repeat, color dark, color light) : opaque{}, m_repeat{repeat}, m_pal{2} {
+    m_kind = Kind::HappyFace;
     m_ambient = colors::white;
     m_ambient_scale = mediums::ambient::none;
     m_smoothness = mediums::smoothness::barely;
@@ -1,7 +1,31 @@
 #include "raytrace/mediums/medium.hpp"
 
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+
+#include "raytrace/laws.hpp"
+#include "raytrace/mediums/checkerboard.hpp"
+#include "raytrace/mediums/dots.hpp"
+#include "raytrace/mediums/grid.hpp"
+#include "raytrace/mediums/happy_face.hpp"
+#include "raytrace/mediums/metal.hpp"
+#include "raytrace/mediums/perlin.hpp"
+#include "raytrace/mediums/plain.hpp"
+#include "raytrace/mediums/random_noise.hpp"
+#include "raytrace/mediums/stripes.hpp"
+#include "raytrace/mediums/transparent.hpp"
+#include "raytrace/mediums/turbsin.hpp"
+
 namespace raytrace {
 namespace mediums {
+
+namespace {
+/// The version of what a bake holds, which is raised whenever the texture format or a pattern (like a noise function)
+/// changes so older bakes on disk are not used
+constexpr unsigned bake_version{2U};
+}  // namespace
+
 // Surface Constructor
 medium::medium()
     : m_ambient_scale{mediums::ambient::none}
@@ -12,7 +36,95 @@ medium::medium()
     , m_reflectivity{0.5_p}  // start semi gloss
     , m_transmissivity{0.0_p}
     , m_refractive_index{0.0_p}
-    , m_reducing_map{nullptr} {
+    , m_reducing_map{nullptr}
+    , m_kind{Kind::Custom}
+    , m_baked{nullptr}
+    , m_filter{Filter::Bilinear}
+    , m_footprint{0.0_p} {
+}
+
+surface medium::evaluate(raytrace::point const& volumetric_point) const {
+    surface s;
+    s.kind = m_kind;
+    s.source = this;
+    s.volumetric_point = volumetric_point;
+    // the kinds are final classes, so these calls are direct
+    switch (m_kind) {
+        case Kind::Custom:
+            s.diffuse = diffuse(volumetric_point);
+            s.emissive = emissive(volumetric_point);
+            s.tightness = specular_tightness(volumetric_point);
+            s.smoothness = smoothness(volumetric_point);
+            s.refractive_index = refractive_index(volumetric_point);
+            return s;
+        case Kind::Metal:
+            s.diffuse = m_diffuse;
+            s.specularity = static_cast<metal const*>(this)->specularity();
+            break;
+        case Kind::Checkerboard:
+            s.diffuse = static_cast<checkerboard const*>(this)->diffuse(volumetric_point);
+            break;
+        case Kind::Dots:
+            s.diffuse = static_cast<dots const*>(this)->diffuse(volumetric_point);
+            break;
+        case Kind::Grid:
+            s.diffuse = static_cast<grid const*>(this)->diffuse(volumetric_point);
+            break;
+        case Kind::HappyFace:
+            s.diffuse = static_cast<happy_face const*>(this)->diffuse(volumetric_point);
+            break;
+        case Kind::Perlin:
+            s.diffuse = static_cast<perlin const*>(this)->diffuse(volumetric_point);
+            break;
+        case Kind::RandomNoise:
+            s.diffuse = static_cast<random_noise const*>(this)->diffuse(volumetric_point);
+            break;
+        case Kind::Stripes:
+            s.diffuse = static_cast<stripes const*>(this)->diffuse(volumetric_point);
+            break;
+        case Kind::Turbsin:
+            s.diffuse = static_cast<turbsin const*>(this)->diffuse(volumetric_point);
+            break;
+        case Kind::Plain:
+            [[fallthrough]];
+        case Kind::Transparent:
+            s.diffuse = m_diffuse;
+            break;
+    }
+    // none of the built-in kinds glow or vary these over their surface
+    s.emissive = colors::black;
+    s.tightness = m_tightness;
+    s.smoothness = m_smoothness;
+    s.refractive_index = m_refractive_index;
+    s.reflectivity = m_reflectivity;
+    return s;
+}
+
+Kind medium::kind() const {
+    return m_kind;
+}
+
+void surface::radiosity(precision other_refractive_index, iso::radians const& incident_angle,
+                        iso::radians const& transmitted_angle, precision& emitted, precision& reflected,
+                        precision& transmitted) const {
+    switch (kind) {
+        case Kind::Custom:
+            source->radiosity(volumetric_point, other_refractive_index, incident_angle, transmitted_angle, emitted,
+                              reflected, transmitted);
+            break;
+        case Kind::Transparent:
+            // the same as transparent::radiosity
+            emitted = 0.0_p;
+            reflected = laws::fresnel(other_refractive_index, refractive_index, incident_angle, transmitted_angle);
+            transmitted = 1.0_p - reflected;
+            break;
+        default:
+            // the same as medium::radiosity
+            emitted = 0.0_p;
+            reflected = reflectivity;
+            transmitted = 1.0_p - reflectivity;
+            break;
+    }
 }
 
 color medium::ambient(raytrace::point const& volumetric_point __attribute__((unused))) const {
@@ -81,5 +193,69 @@ raytrace::vector medium::perturbation(raytrace::point const&) const {
     return geometry::R3::null;
 }
 
+color medium::mapped_diffuse(image::point const&) const {
+    return m_diffuse;
+}
+
+std::string medium::parameters() const {
+    return std::string{};
+}
+
+uint64_t medium::fingerprint(void const* data, size_t bytes) {
+    // FNV-1a, which (unlike std::hash) gives the same value in every build
+    uint8_t const* const octets = static_cast<uint8_t const*>(data);
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < bytes; i++) {
+        hash = (hash ^ octets[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+std::string medium::bake_key() const {
+    std::string const key = parameters();
+    basal::exception::throw_if(key.empty(), __FILE__, __LINE__, "This medium can not be baked");
+    // the same parameters give a different pattern in a build of another precision or a later version
+    return "bake " + std::to_string(bake_version) + " " + std::to_string(sizeof(precision)) + " " + key;
+}
+
+std::string medium::bake_name(size_t resolution) const {
+    std::string const key = bake_key();
+    char name[64];
+    snprintf(name, sizeof(name), "bake_%016" PRIx64 "_%zu.tex", fingerprint(key.data(), key.size()), resolution);
+    return std::string{name};
+}
+
+void medium::bake(size_t resolution, Filter filter, precision footprint, std::string const& cache_directory) {
+    basal::exception::throw_unless(static_cast<bool>(m_reducing_map), __FILE__, __LINE__,
+                                   "A medium must have a mapper to be baked");
+    std::string const key = bake_key();
+    m_filter = filter;
+    m_footprint = footprint;
+    m_baked = nullptr;
+    std::string filename;
+    if (not cache_directory.empty()) {
+        filename = (std::filesystem::path{cache_directory} / bake_name(resolution)).string();
+        m_baked = texture::load(filename, key);
+    }
+    if (not m_baked) {
+        // the patterns are not periodic over the unit square so the edges of the bake are clamped, not wrapped
+        auto baked = std::make_shared<texture>(
+            resolution, [this](image::point const& texture_point) { return mapped_diffuse(texture_point); },
+            Address::Clamp);
+        if (not filename.empty() and not baked->save(filename, key)) {
+            std::cerr << "Could not cache the bake in " << filename << std::endl;
+        }
+        m_baked = baked;
+    }
+}
+
+void medium::unbake() {
+    m_baked = nullptr;
+}
+
+bool medium::is_baked() const {
+    return static_cast<bool>(m_baked);
+}
+
 }  // namespace mediums
 }  // namespace raytrace
@@ -8,6 +8,7 @@ metal::metal(color diffuse, precision smoothness, precision tightness, precision
     : conductor{}
     , m_specularity{diffuse}  // metals (conductors} can alter the color of the light
     , m_fuzz_scale{basal::clamp(0.0_p, fuzz_scale, 1.0_p)} {
+    m_kind = Kind::Metal;
     m_smoothness = basal::clamp(0.0_p, smoothness, 1.0_p);
     m_diffuse = diffuse;
     m_tightness = tightness;
@@ -1,11 +1,15 @@
 #include "raytrace/mediums/perlin.hpp"
 
+#include <iomanip>
+#include <sstream>
+
 namespace raytrace {
 
 namespace mediums {
 
 perlin::perlin(precision seed, precision scale, precision gain, color dark, color light)
     : opaque{}, m_dark{dark}, m_light{light}, m_seed{}, m_gain{gain}, m_scale{scale} {
+    m_kind = Kind::Perlin;
     m_ambient = colors::white;
     m_ambient_scale = mediums::ambient::none;
     m_smoothness = mediums::smoothness::small;  // moderate polish
@@ -14,11 +18,10 @@ perlin::perlin(precision seed, precision scale, precision gain, color dark, colo
 }
 
 color perlin::diffuse(raytrace::point const& volumetric_point) const {
-    if (m_reducing_map) {
-        auto map_pnt = m_reducing_map(volumetric_point);
-        noise::point pnt = noise::point{map_pnt.x(), map_pnt.y()};  // convert to noise point
-        precision alpha = noise::perlin(pnt, m_scale, m_seed, m_gain);
-        return fourcc::linear::interpolate(m_dark, m_light, alpha);
+    if (m_baked) {
+        return baked_diffuse(volumetric_point);
+    } else if (m_reducing_map) {
+        return mapped_diffuse(m_reducing_map(volumetric_point));
     } else {
         // FIXME implement a real volumetric perlin noise function.
         noise::point pnt(volumetric_point.x(), volumetric_point.y());
@@ -27,6 +30,19 @@ color perlin::diffuse(raytrace::point const& volumetric_point) const {
     }
 }
 
+color perlin::mapped_diffuse(image::point const& texture_point) const {
+    noise::point pnt = noise::point{texture_point.x(), texture_point.y()};  // convert to noise point
+    precision alpha = noise::perlin(pnt, m_scale, m_seed, m_gain);
+    return fourcc::linear::interpolate(m_dark, m_light, alpha);
+}
+
+std::string perlin::parameters() const {
+    std::ostringstream oss;
+    oss << std::setprecision(17) << "perlin " << m_seed[0] << " " << m_seed[1] << " " << m_scale << " " << m_gain
+        << " " << m_dark << " " << m_light;
+    return oss.str();
+}
+
 }  // namespace mediums
 
 }  // namespace raytrace
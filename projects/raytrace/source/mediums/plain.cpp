@@ -5,6 +5,7 @@ namespace raytrace {
 namespace mediums {
 
 plain::plain(color const& amb, precision amb_scale, color const& dif, precision ref, precision rough) : opaque{} {
+    m_kind = Kind::Plain;
     m_ambient = amb;
     m_ambient_scale = basal::clamp(0.0_p, amb_scale, 1.0_p);
     m_diffuse = dif;
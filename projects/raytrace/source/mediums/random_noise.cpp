@@ -8,6 +8,7 @@ namespace raytrace {
 namespace mediums {
 
 random_noise::random_noise() : opaque{} {
+    m_kind = Kind::RandomNoise;
     m_ambient = colors::white;
     m_ambient_scale = mediums::ambient::dim;
 }
@@ -8,6 +8,7 @@ namespace mediums {
 
 transparent::transparent(precision eta, precision fade, color const& diffuse)
     : dielectric{}, m_fade{basal::clamp(0.0_p, fade, 1.0_p)} {
+    m_kind = Kind::Transparent;
     m_diffuse = diffuse;
     m_smoothness = mediums::smoothness::perfect_mirror;  // no "surface colors"
     m_refractive_index = eta;
@@ -1,5 +1,9 @@
 #include "raytrace/mediums/turbsin.hpp"
 
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
 namespace raytrace {
 
 namespace mediums {
@@ -16,6 +20,7 @@ turbsin::turbsin(precision map2d_scale, precision xs, precision ys, precision po
     , m_scale{scale}
     , m_size{size}
     , m_2dscale{map2d_scale} {
+    m_kind = Kind::Turbsin;
     m_ambient = colors::white;
     m_ambient_scale = mediums::ambient::none;
     m_smoothness = mediums::smoothness::small;  // moderate polish
@@ -23,14 +28,10 @@ turbsin::turbsin(precision map2d_scale, precision xs, precision ys, precision po
 }
 
 color turbsin::diffuse(raytrace::point const& volumetric_point) const {
-    if (m_reducing_map) {
-        auto map_pnt = m_reducing_map(volumetric_point);
-        noise::point pnt = noise::point{map_pnt.x(), map_pnt.y()};  // convert to noise point
-        // the reduced map may be normal space (0 - 1) and may need some stretching to look good
-        pnt.x() *= m_2dscale;
-        pnt.y() *= m_2dscale;
-        precision alpha = noise::turbulentsin(pnt, m_xs, m_ys, m_power, m_size, m_scale, m_pad);
-        return fourcc::linear::interpolate(m_light, m_dark, alpha);
+    if (m_baked) {
+        return baked_diffuse(volumetric_point);
+    } else if (m_reducing_map) {
+        return mapped_diffuse(m_reducing_map(volumetric_point));
     } else {
         // FIXME implement a real volumetric turbulentsin noise function.
         noise::point pnt(volumetric_point.x(), volumetric_point.y());
@@ -39,6 +40,32 @@ color turbsin::diffuse(raytrace::point const& volumetric_point) const {
     }
 }
 
+color turbsin::mapped_diffuse(image::point const& texture_point) const {
+    noise::point pnt = noise::point{texture_point.x(), texture_point.y()};  // convert to noise point
+    // the reduced map may be normal space (0 - 1) and may need some stretching to look good
+    pnt.x() *= m_2dscale;
+    pnt.y() *= m_2dscale;
+    precision alpha = noise::turbulentsin(pnt, m_xs, m_ys, m_power, m_size, m_scale, m_pad);
+    return fourcc::linear::interpolate(m_light, m_dark, alpha);
+}
+
+std::string turbsin::parameters() const {
+    // the pad comes from the default seed of the standard library's default engine, which differs between libraries,
+    // so its values are part of the key
+    std::vector<precision> values;
+    values.reserve(noise::pad::dimensions * noise::pad::dimensions);
+    for (size_t y = 0; y < noise::pad::dimensions; y++) {
+        for (size_t x = 0; x < noise::pad::dimensions; x++) {
+            values.push_back(m_pad.at(y, x));
+        }
+    }
+    std::ostringstream oss;
+    oss << std::setprecision(17) << "turbsin " << m_2dscale << " " << m_xs << " " << m_ys << " " << m_power << " "
+        << m_scale << " " << m_size << " " << m_dark << " " << m_light << " " << std::hex
+        << fingerprint(values.data(), values.size() * sizeof(precision));
+    return oss.str();
+}
+
 }  // namespace mediums
 
 }  // namespace raytrace
@@ -0,0 +1,557 @@
+#include "raytrace/mesh.hpp"
+
+#include <algorithm>
+#include <basal/exception.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+
+#include "raytrace/mappedfile.hpp"
+#include "raytrace/statistics.hpp"
+
+namespace raytrace {
+
+namespace tree {
+
+namespace {
+
+/// An entry in the traversal stack, the entry distance allows the node to be skipped once a nearer hit is found
+struct Pending {
+    uint32_t index;
+    precision t_enter;
+};
+
+/// Prepares the origin, direction and reciprocal direction of a ray for the tests
+inline void prepare(raytrace::ray const& ray, precision origin[dimensions], precision direction[dimensions],
+                    precision inverse[dimensions]) {
+    for (size_t a = 0; a < dimensions; a++) {
+        origin[a] = ray.location()[a];
+        direction[a] = ray.direction()[a];
+        inverse[a] = 1.0_p / direction[a];
+    }
+}
+
+/// The slab test of a whole line (both directions) against the bounds
+inline bool crosses(FlatBounds const& bounds, precision const origin[dimensions], precision const inverse[dimensions]) {
+    precision t_enter = basal::neg_inf;
+    precision t_exit = basal::pos_inf;
+    for (size_t a = 0; a < dimensions; a++) {
+        precision const t0 = (bounds.lower[a] - origin[a]) * inverse[a];
+        precision const t1 = (bounds.upper[a] - origin[a]) * inverse[a];
+        t_enter = std::max(t_enter, std::min(t0, t1));
+        t_exit = std::min(t_exit, std::max(t0, t1));
+    }
+    return t_enter <= t_exit;
+}
+
+/// @return true if the bounds (grown by the tolerance) contain the point
+inline bool contains(FlatBounds const& bounds, precision const p[dimensions], precision tolerance) {
+    for (size_t a = 0; a < dimensions; a++) {
+        if (p[a] < (bounds.lower[a] - tolerance) or (bounds.upper[a] + tolerance) < p[a]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// The arrays of a built mesh, which the views of the mesh refer to
+struct Arrays {
+    std::vector<precision> vertices[dimensions];
+    std::vector<uint32_t> corners[dimensions];
+    std::vector<precision> normals[dimensions];
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> slots;
+    std::vector<FlatNode> nodes;
+};
+
+/// The first bytes of a cache file
+struct CacheHeader {
+    char magic[8];             //!< Identifies the file as a mesh cache
+    uint32_t version;          //!< The @ref MeshBVH::CacheVersion which wrote the file
+    uint32_t endian;           //!< Written as @ref cache_endian, so a cache from a different byte order is ignored
+    uint32_t precision_size;   //!< The size of a precision value, so a float cache is not used by a double build
+    uint32_t node_size;        //!< The size of a node
+    uint64_t vertices;         //!< The number of shared vertices
+    uint64_t triangles;        //!< The number of triangles
+    uint64_t nodes;            //!< The number of nodes
+    uint64_t depth;            //!< The deepest level of the hierarchy
+    uint64_t extra;            //!< The number of bytes the owner stored after the mesh
+    precision extent;          //!< The distance to the farthest vertex
+};
+
+constexpr char cache_magic[8] = {'R', 'T', 'M', 'E', 'S', 'H', '\0', '\0'};
+constexpr uint32_t cache_endian{0x01020304U};
+/// Each array in a cache starts on a boundary of this many bytes
+constexpr size_t cache_alignment{64U};
+
+inline size_t align(size_t offset) {
+    return (offset + cache_alignment - 1U) & ~(cache_alignment - 1U);
+}
+
+/// The byte offset of each array in a cache file, in the order they are written. The counts come from the file, so
+/// every size is checked for overflow and a layout which does not fit in a size_t is not valid.
+struct CacheLayout {
+    explicit CacheLayout(CacheHeader const& header) : valid{true} {
+        size_t const limit = std::numeric_limits<size_t>::max() - cache_alignment;
+        size_t at = align(sizeof(CacheHeader));
+        auto place = [&](uint64_t count, size_t size) {
+            size_t const here = at;
+            if (count > (limit - at) / size) {
+                valid = false;
+            } else {
+                at = align(at + static_cast<size_t>(count) * size);
+            }
+            return here;
+        };
+        for (size_t a = 0; a < dimensions; a++) {
+            vertices[a] = place(header.vertices, sizeof(precision));
+        }
+        for (size_t c = 0; c < dimensions; c++) {
+            corners[c] = place(header.triangles, sizeof(uint32_t));
+        }
+        for (size_t a = 0; a < dimensions; a++) {
+            normals[a] = place(header.triangles, sizeof(precision));
+        }
+        order = place(header.triangles, sizeof(uint32_t));
+        slots = place(header.triangles, sizeof(uint32_t));
+        nodes = place(header.nodes, sizeof(FlatNode));
+        extra = place(header.extra, 1U);
+        total = at;
+    }
+    size_t vertices[dimensions];
+    size_t corners[dimensions];
+    size_t normals[dimensions];
+    size_t order;
+    size_t slots;
+    size_t nodes;
+    size_t extra;
+    size_t total;
+    bool valid;  //!< false if a size overflowed (the offsets are then meaningless)
+};
+
+/// Writes the bytes at the offset, padding the file with zeros up to it
+inline bool write_at(FILE* file, size_t& position, size_t offset, void const* data, size_t bytes) {
+    char const zeros[cache_alignment] = {};
+    while (position < offset) {
+        size_t const pad = std::min(offset - position, sizeof(zeros));
+        if (fwrite(zeros, 1U, pad, file) != pad) {
+            return false;
+        }
+        position += pad;
+    }
+    if (bytes > 0U and fwrite(data, 1U, bytes, file) != bytes) {
+        return false;
+    }
+    position += bytes;
+    return true;
+}
+
+}  // namespace
+
+MeshBVH::MeshBVH()
+    : storage_{}, vertices_{}, corners_{}, normals_{}, order_{}, slots_{}, nodes_{}, depth_{0U}, extent_{0.0_p} {
+}
+
+void MeshBVH::build(std::vector<point> const& vertices, std::vector<indices> const& triangles,
+                    std::vector<vector> const& normals) {
+    basal::exception::throw_unless(normals.empty() or normals.size() == triangles.size(), __FILE__, __LINE__,
+                                   "Must have a normal for each triangle or none");
+    auto arrays = std::make_shared<Arrays>();
+    extent_ = 0.0_p;
+    for (size_t a = 0; a < dimensions; a++) {
+        arrays->vertices[a].reserve(vertices.size());
+    }
+    for (auto const& vertex : vertices) {
+        for (size_t a = 0; a < dimensions; a++) {
+            arrays->vertices[a].push_back(vertex[a]);
+        }
+        extent_ = std::max(extent_, (vertex - R3::origin).magnitude());
+    }
+    // the bounds of each triangle for the hierarchy, grown a little so the slab tests do not round away a ray
+    // through an edge which the triangle tests would hit
+    std::vector<FlatBounds> boxes;
+    boxes.reserve(triangles.size());
+    for (auto const& triangle : triangles) {
+        FlatBounds box;
+        for (size_t a = 0; a < dimensions; a++) {
+            box.lower[a] = basal::pos_inf;
+            box.upper[a] = basal::neg_inf;
+        }
+        for (uint32_t index : triangle) {
+            basal::exception::throw_unless(index < vertices.size(), __FILE__, __LINE__,
+                                           "Vertex index %u is out of range", index);
+            for (size_t a = 0; a < dimensions; a++) {
+                box.lower[a] = std::min(box.lower[a], arrays->vertices[a][index]);
+                box.upper[a] = std::max(box.upper[a], arrays->vertices[a][index]);
+            }
+        }
+        precision magnitude = 0.0_p;
+        for (size_t a = 0; a < dimensions; a++) {
+            magnitude = std::max({magnitude, std::abs(box.lower[a]), std::abs(box.upper[a])});
+        }
+        precision const slack = bounds_slack(magnitude);
+        for (size_t a = 0; a < dimensions; a++) {
+            box.lower[a] -= slack;
+            box.upper[a] += slack;
+        }
+        boxes.push_back(box);
+    }
+    depth_ = build_flat_hierarchy(boxes, MaxLeafTriangles, arrays->nodes, arrays->order);
+    // lay the triangles out in leaf order
+    std::vector<uint32_t> const& order = arrays->order;
+    arrays->slots.resize(order.size());
+    for (size_t a = 0; a < dimensions; a++) {
+        arrays->corners[a].reserve(order.size());
+        arrays->normals[a].reserve(order.size());
+    }
+    for (size_t slot = 0; slot < order.size(); slot++) {
+        uint32_t const index = order[slot];
+        arrays->slots[index] = static_cast<uint32_t>(slot);
+        indices const& triangle = triangles[index];
+        for (size_t c = 0; c < dimensions; c++) {
+            arrays->corners[c].push_back(triangle[c]);
+        }
+        vector N;
+        if (normals.empty()) {
+            point const& A = vertices[triangle[0]];
+            N = R3::cross(vertices[triangle[1]] - A, vertices[triangle[2]] - A);
+        } else {
+            N = normals[index];
+        }
+        if (not N.is_zero()) {
+            N = N.normalized();
+        }
+        for (size_t a = 0; a < dimensions; a++) {
+            arrays->normals[a].push_back(N[a]);
+        }
+    }
+    for (size_t a = 0; a < dimensions; a++) {
+        vertices_[a] = View<precision>{arrays->vertices[a]};
+        corners_[a] = View<uint32_t>{arrays->corners[a]};
+        normals_[a] = View<precision>{arrays->normals[a]};
+    }
+    order_ = View<uint32_t>{arrays->order};
+    slots_ = View<uint32_t>{arrays->slots};
+    nodes_ = View<FlatNode>{arrays->nodes};
+    storage_ = arrays;
+}
+
+bool MeshBVH::save(char const* const filename, std::string_view extra) const {
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = CacheVersion;
+    header.endian = cache_endian;
+    header.precision_size = sizeof(precision);
+    header.node_size = sizeof(FlatNode);
+    header.vertices = vertex_count();
+    header.triangles = triangle_count();
+    header.nodes = nodes_.size();
+    header.depth = depth_;
+    header.extra = extra.size();
+    header.extent = extent_;
+    CacheLayout const layout{header};
+    // write to the side and rename so a reader never maps a partial file
+    std::string const partial = std::string{filename} + ".partial";
+    FILE* file = fopen(partial.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    size_t position = 0U;
+    bool written = write_at(file, position, 0U, &header, sizeof(header));
+    size_t const vertex_bytes = header.vertices * sizeof(precision);
+    size_t const index_bytes = header.triangles * sizeof(uint32_t);
+    size_t const normal_bytes = header.triangles * sizeof(precision);
+    for (size_t a = 0; a < dimensions; a++) {
+        written = written and write_at(file, position, layout.vertices[a], vertices_[a].data(), vertex_bytes);
+    }
+    for (size_t c = 0; c < dimensions; c++) {
+        written = written and write_at(file, position, layout.corners[c], corners_[c].data(), index_bytes);
+    }
+    for (size_t a = 0; a < dimensions; a++) {
+        written = written and write_at(file, position, layout.normals[a], normals_[a].data(), normal_bytes);
+    }
+    written = written and write_at(file, position, layout.order, order_.data(), index_bytes);
+    written = written and write_at(file, position, layout.slots, slots_.data(), index_bytes);
+    written = written and write_at(file, position, layout.nodes, nodes_.data(), header.nodes * sizeof(FlatNode));
+    written = written and write_at(file, position, layout.extra, extra.data(), extra.size());
+    written = written and write_at(file, position, layout.total, nullptr, 0U);
+    written = (fclose(file) == 0) and written;
+    std::error_code error;
+    if (written) {
+        std::filesystem::rename(partial, filename, error);
+    }
+    if (not written or error) {
+        std::filesystem::remove(partial, error);
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<MeshBVH const> MeshBVH::map(char const* const filename, std::string_view& extra) {
+    std::error_code error;
+    if (not std::filesystem::is_regular_file(filename, error)) {
+        return nullptr;
+    }
+    auto file = std::make_shared<MappedFile>(filename);
+    CacheHeader header;
+    if (file->size() < sizeof(header)) {
+        return nullptr;
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 or header.version != CacheVersion
+        or header.endian != cache_endian or header.precision_size != sizeof(precision)
+        or header.node_size != sizeof(FlatNode) or header.nodes == 0U or header.depth > BVH::MaxDepth) {
+        return nullptr;
+    }
+    // the indices are 32 bits wide
+    if (header.vertices > std::numeric_limits<uint32_t>::max()
+        or header.triangles > std::numeric_limits<uint32_t>::max()) {
+        return nullptr;
+    }
+    CacheLayout const layout{header};
+    char const* const base = static_cast<char const*>(file->data());
+    if (not layout.valid or file->size() < layout.total
+        or (reinterpret_cast<uintptr_t>(base) % alignof(FlatNode)) != 0U) {
+        return nullptr;
+    }
+    std::shared_ptr<MeshBVH> mesh{new MeshBVH()};
+    size_t const vertices = header.vertices;
+    size_t const triangles = header.triangles;
+    for (size_t a = 0; a < dimensions; a++) {
+        mesh->vertices_[a] = View<precision>{reinterpret_cast<precision const*>(base + layout.vertices[a]), vertices};
+        mesh->corners_[a] = View<uint32_t>{reinterpret_cast<uint32_t const*>(base + layout.corners[a]), triangles};
+        mesh->normals_[a] = View<precision>{reinterpret_cast<precision const*>(base + layout.normals[a]), triangles};
+    }
+    mesh->order_ = View<uint32_t>{reinterpret_cast<uint32_t const*>(base + layout.order), triangles};
+    mesh->slots_ = View<uint32_t>{reinterpret_cast<uint32_t const*>(base + layout.slots), triangles};
+    mesh->nodes_ = View<FlatNode>{reinterpret_cast<FlatNode const*>(base + layout.nodes), header.nodes};
+    mesh->depth_ = header.depth;
+    mesh->extent_ = header.extent;
+    mesh->storage_ = file;
+    if (not mesh->valid()) {
+        return nullptr;
+    }
+    extra = std::string_view{base + layout.extra, header.extra};
+    return mesh;
+}
+
+bool MeshBVH::valid() const {
+    size_t const vertices = vertex_count();
+    size_t const triangles = triangle_count();
+    for (size_t slot = 0; slot < triangles; slot++) {
+        for (size_t c = 0; c < dimensions; c++) {
+            if (corners_[c][slot] >= vertices) {
+                return false;
+            }
+        }
+        // the order and the slots must be the inverse of each other
+        if (order_[slot] >= triangles or slots_[order_[slot]] != slot) {
+            return false;
+        }
+    }
+    // the nodes must form a single depth first tree, so the traversal stacks can not overflow or loop
+    struct Level {
+        uint32_t index;
+        size_t depth;
+    };
+    std::vector<Level> pending{Level{0U, 1U}};  // the root is the first level, as in the build
+    size_t visited = 0U;
+    size_t deepest = 0U;
+    while (not pending.empty()) {
+        Level const level = pending.back();
+        pending.pop_back();
+        FlatNode const& node = nodes_[level.index];
+        if (++visited > nodes_.size() or level.depth > BVH::MaxDepth) {
+            return false;
+        }
+        deepest = std::max(deepest, level.depth);
+        if (node.is_leaf()) {
+            if (size_t(node.offset) + node.count > triangles) {
+                return false;
+            }
+        } else {
+            if (size_t(level.index) + 1U >= node.offset or node.offset >= nodes_.size()) {
+                return false;
+            }
+            pending.push_back(Level{node.offset, level.depth + 1U});
+            pending.push_back(Level{level.index + 1U, level.depth + 1U});
+        }
+    }
+    return visited == nodes_.size() and deepest == depth_;
+}
+
+void MeshBVH::corners(size_t slot, precision (&A)[dimensions], precision (&B)[dimensions],
+                      precision (&C)[dimensions]) const {
+    uint32_t const a = corners_[0][slot];
+    uint32_t const b = corners_[1][slot];
+    uint32_t const c = corners_[2][slot];
+    for (size_t d = 0; d < dimensions; d++) {
+        A[d] = vertices_[d][a];
+        B[d] = vertices_[d][b];
+        C[d] = vertices_[d][c];
+    }
+}
+
+bool MeshBVH::closest(ray const& object_ray, precision t_min, precision t_max, TriangleHit& nearest) const {
+    if (nodes_.empty()) {
+        return false;
+    }
+    precision origin[dimensions];
+    precision direction[dimensions];
+    precision inverse[dimensions];
+    prepare(object_ray, origin, direction, inverse);
+    ShearedRay const sheared{origin, direction};
+    bool found = false;
+    Pending stack[BVH::MaxDepth + 1U];
+    size_t top = 0U;
+    precision t_enter;
+    if (not nodes_[0].enters(origin, inverse, t_max, t_enter)) {
+        return false;
+    }
+    stack[top++] = Pending{0U, t_enter};
+    while (top > 0U) {
+        Pending const pending = stack[--top];
+        if (pending.t_enter > t_max) {
+            continue;  // a nearer hit was found since this node was pushed
+        }
+        FlatNode const& node = nodes_[pending.index];
+        statistics::count(&statistics::intersections_with_bounds);
+        if (node.is_leaf()) {
+            for (size_t slot = node.offset; slot < size_t(node.offset) + node.count; slot++) {
+                // only the side the normal faces can be hit
+                precision const facing = direction[0] * normals_[0][slot] + direction[1] * normals_[1][slot]
+                                         + direction[2] * normals_[2][slot];
+                if (facing > -basal::epsilon) {
+                    continue;
+                }
+                precision A[dimensions], B[dimensions], C[dimensions];
+                corners(slot, A, B, C);
+                precision t, u, v;
+                if (watertight_triangle(sheared, A, B, C, t, u, v) and t_min < t and t < t_max) {
+                    t_max = t;
+                    nearest = TriangleHit{t, u, v, order_[slot]};
+                    found = true;
+                }
+            }
+        } else {
+            Pending near{pending.index + 1U, 0.0_p};
+            Pending far{node.offset, 0.0_p};
+            bool const near_entered = nodes_[near.index].enters(origin, inverse, t_max, near.t_enter);
+            bool const far_entered = nodes_[far.index].enters(origin, inverse, t_max, far.t_enter);
+            if (near_entered and far_entered) {
+                if (far.t_enter < near.t_enter) {
+                    std::swap(near, far);
+                }
+                // push the far child first so the near child is visited first
+                stack[top++] = far;
+                stack[top++] = near;
+            } else if (near_entered) {
+                stack[top++] = near;
+            } else if (far_entered) {
+                stack[top++] = far;
+            }
+        }
+    }
+    return found;
+}
+
+void MeshBVH::all(ray const& object_ray, std::vector<TriangleHit>& found) const {
+    if (nodes_.empty()) {
+        return;
+    }
+    precision origin[dimensions];
+    precision direction[dimensions];
+    precision inverse[dimensions];
+    prepare(object_ray, origin, direction, inverse);
+    ShearedRay const sheared{origin, direction};
+    uint32_t stack[BVH::MaxDepth + 1U];
+    size_t top = 0U;
+    stack[top++] = 0U;
+    while (top > 0U) {
+        uint32_t const index = stack[--top];
+        FlatNode const& node = nodes_[index];
+        if (not crosses(node, origin, inverse)) {
+            continue;
+        }
+        statistics::count(&statistics::intersections_with_bounds);
+        if (node.is_leaf()) {
+            for (size_t slot = node.offset; slot < size_t(node.offset) + node.count; slot++) {
+                precision const facing = direction[0] * normals_[0][slot] + direction[1] * normals_[1][slot]
+                                         + direction[2] * normals_[2][slot];
+                if (facing > -basal::epsilon) {
+                    continue;
+                }
+                precision A[dimensions], B[dimensions], C[dimensions];
+                corners(slot, A, B, C);
+                precision t, u, v;
+                if (watertight_triangle(sheared, A, B, C, t, u, v)) {
+                    found.push_back(TriangleHit{t, u, v, order_[slot]});
+                }
+            }
+        } else {
+            stack[top++] = node.offset;
+            stack[top++] = index + 1U;
+        }
+    }
+}
+
+bool MeshBVH::locate(point const& object_point, precision tolerance, uint32_t& triangle) const {
+    if (nodes_.empty()) {
+        return false;
+    }
+    precision const P[dimensions] = {object_point[0], object_point[1], object_point[2]};
+    uint32_t stack[BVH::MaxDepth + 1U];
+    size_t top = 0U;
+    stack[top++] = 0U;
+    while (top > 0U) {
+        uint32_t const index = stack[--top];
+        FlatNode const& node = nodes_[index];
+        if (not contains(node, P, tolerance)) {
+            continue;
+        }
+        if (node.is_leaf()) {
+            for (size_t slot = node.offset; slot < size_t(node.offset) + node.count; slot++) {
+                precision A[dimensions], B[dimensions], C[dimensions];
+                corners(slot, A, B, C);
+                vector const AB{{B[0] - A[0], B[1] - A[1], B[2] - A[2]}};
+                vector const AC{{C[0] - A[0], C[1] - A[1], C[2] - A[2]}};
+                vector const AP{{P[0] - A[0], P[1] - A[1], P[2] - A[2]}};
+                vector const N = R3::cross(AB, AC);
+                precision const area2 = N.magnitude();
+                if (basal::nearly_zero(area2) or std::abs(dot(N, AP)) > tolerance * area2) {
+                    continue;  // degenerate or off the plane of the triangle
+                }
+                // the signed areas of the sub triangles around the point must all follow the normal
+                vector const BC{{C[0] - B[0], C[1] - B[1], C[2] - B[2]}};
+                vector const BP{{P[0] - B[0], P[1] - B[1], P[2] - B[2]}};
+                vector const CA{{A[0] - C[0], A[1] - C[1], A[2] - C[2]}};
+                vector const CP{{P[0] - C[0], P[1] - C[1], P[2] - C[2]}};
+                precision const slack = -tolerance * area2;
+                if (dot(N, R3::cross(AB, AP)) >= slack and dot(N, R3::cross(BC, BP)) >= slack
+                    and dot(N, R3::cross(CA, CP)) >= slack) {
+                    triangle = order_[slot];
+                    return true;
+                }
+            }
+        } else {
+            stack[top++] = node.offset;
+            stack[top++] = index + 1U;
+        }
+    }
+    return false;
+}
+
+vector MeshBVH::normal(uint32_t triangle) const {
+    uint32_t const slot = slots_[triangle];
+    return vector{{normals_[0][slot], normals_[1][slot], normals_[2][slot]}};
+}
+
+precision MeshBVH::extent() const {
+    return extent_;
+}
+
+}  // namespace tree
+}  // namespace raytrace
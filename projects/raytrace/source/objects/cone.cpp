@@ -132,5 +132,13 @@ void cone::print(std::ostream& os, char const str[]) const {
 precision cone::get_object_extent(void) const {
     return sqrt((m_height * m_height) + (m_bottom_radius * m_bottom_radius));
 }
+
+Bounds cone::get_object_bounds(void) const {
+    if (std::isinf(m_height)) {
+        return Bounds{};
+    }
+    // the base is on the XY plane and the apex is up Z
+    return Bounds{point{-m_bottom_radius, -m_bottom_radius, 0.0_p}, point{m_bottom_radius, m_bottom_radius, m_height}};
+}
 }  // namespace objects
 }  // namespace raytrace
@@ -132,6 +132,34 @@ hits cuboid::collisions_along(ray const& object_ray) const {
     return ts;
 }
 
+bool cuboid::intersect(ray_packet const& world_rays, precision (&distances)[ray_packet::width]) const {
+    ray_packet object_rays;
+    m_transform.reverse(world_rays, object_rays);
+    for (size_t lane = 0; lane < ray_packet::width; lane++) {
+        // the slab test gives the same entry and exit as the face tests
+        precision t_enter = basal::neg_inf;
+        precision t_exit = basal::pos_inf;
+        bool subtle = false;
+        for (size_t a = 0; a < dimensions; a++) {
+            precision const o = object_rays.origin[a][lane];
+            precision const d = object_rays.direction[a][lane];
+            precision const t_lo = (-m_half_widths[a] - o) / d;
+            precision const t_hi = (m_half_widths[a] - o) / d;
+            subtle = subtle or std::isnan(t_lo) or std::isnan(t_hi);
+            t_enter = std::max(t_enter, std::min(t_lo, t_hi));
+            t_exit = std::min(t_exit, std::max(t_lo, t_hi));
+        }
+        precision const t
+            = (t_enter > basal::epsilon) ? t_enter : ((t_exit > basal::epsilon) ? t_exit : basal::pos_inf);
+        // hits at the origin and near the edges are left to the scalar rules
+        subtle = subtle or std::abs(t_enter) <= 2.0_p * basal::epsilon or std::abs(t_exit) <= 2.0_p * basal::epsilon
+                 or std::abs(t_exit - t_enter) <= 4.0_p * basal::epsilon;
+        distances[lane] = subtle ? basal::nan : ((t_enter <= t_exit) ? t : basal::pos_inf);
+    }
+    m_transform.distances(world_rays, object_rays, distances);
+    return true;
+}
+
 image::point cuboid::map(point const& object_surface_point) const {
     // map some range of object 3D points to some 2D u,v pair
     // isolate which axis this is on and return the forward_transformed normal
@@ -201,6 +229,10 @@ precision cuboid::get_object_extent(void) const {
     return vector{x_half_width, y_half_width, z_half_width}.magnitude();
 }
 
+Bounds cuboid::get_object_bounds(void) const {
+    return Bounds{point{-x_half_width, -y_half_width, -z_half_width}, point{x_half_width, y_half_width, z_half_width}};
+}
+
 }  // namespace objects
 
 }  // namespace raytrace
@@ -112,6 +112,13 @@ precision cylinder::get_object_extent(void) const {
     }
 }
 
+Bounds cylinder::get_object_bounds(void) const {
+    if (basal::is_exactly_zero(m_half_height)) {
+        return Bounds{};  // infinite along Z
+    }
+    return Bounds{point{-m_radius, -m_radius, -m_half_height}, point{m_radius, m_radius, m_half_height}};
+}
+
 }  // namespace objects
 
 }  // namespace raytrace
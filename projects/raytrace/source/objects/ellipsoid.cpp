@@ -13,11 +13,19 @@ ellipsoid::ellipsoid(point const& center, precision a, precision b, precision c)
 }
 
 precision ellipsoid::get_object_extent(void) const {
-    precision a = 1.0_p / m_coefficients[0][0];
-    precision b = 1.0_p / m_coefficients[1][1];
-    precision c = 1.0_p / m_coefficients[2][2];
+    // the coefficients are the inverse squares of the semi axes
+    precision a = 1.0_p / std::sqrt(m_coefficients[0][0]);
+    precision b = 1.0_p / std::sqrt(m_coefficients[1][1]);
+    precision c = 1.0_p / std::sqrt(m_coefficients[2][2]);
     return std::max(a, std::max(b, c));
 }
 
+Bounds ellipsoid::get_object_bounds(void) const {
+    precision const a = 1.0_p / std::sqrt(m_coefficients[0][0]);
+    precision const b = 1.0_p / std::sqrt(m_coefficients[1][1]);
+    precision const c = 1.0_p / std::sqrt(m_coefficients[2][2]);
+    return Bounds{point{-a, -b, -c}, point{a, b, c}};
+}
+
 }  // namespace objects
 }  // namespace raytrace
@@ -1,5 +1,9 @@
 #include <raytrace/objects/model.hpp>
 
+#include <cstring>
+#include <filesystem>
+#include <string>
+
 namespace raytrace {
 namespace objects {
 
@@ -8,38 +12,95 @@ Model::Model()
     , points_{}
     , normals_{}
     , texels_{}
-    , faces_{}
-    , parser_{*this}
+    , triangles_{}
+    , triangle_normals_{}
+    , mesh_{}
+    , statistics_{}
+    , centroid_{0.0_p, 0.0_p, 0.0_p}
+    , source_{}
     , loaded_{false} {
 }
 
+Model::Model(std::shared_ptr<tree::MeshBVH const> mesh)
+    : object{R3::origin, SIZE_MAX, Type::Model, true}
+    , points_{}
+    , normals_{}
+    , texels_{}
+    , triangles_{}
+    , triangle_normals_{}
+    , mesh_{mesh}
+    , statistics_{}
+    , centroid_{0.0_p, 0.0_p, 0.0_p}
+    , source_{}
+    , loaded_{true} {
+    basal::exception::throw_unless(mesh_ != nullptr, __FILE__, __LINE__, "An instance must have a mesh");
+}
+
 void Model::print(std::ostream& os, char const name[]) const {
-    os << "Model " << name << " has " << points_.size() << " points, " << normals_.size() << " normals, "
-       << texels_.size() << " texels, " << faces_.size() << " faces\n";
+    os << "Model " << name << " has " << statistics_.vertices << " points, " << statistics_.normals << " normals, "
+       << statistics_.textures << " texels, " << GetNumberOfFaces() << " faces\n";
 }
 
 bool Model::is_surface_point(raytrace::point const& world_point) const {
     raytrace::point object_point = reverse_transform(world_point);
-    for (auto const& f : faces_) {
-        if (f.is_surface_point(object_point)) {
-            return true;
+    uint32_t triangle;
+    return mesh_ and mesh_->locate(object_point, basal::epsilon, triangle);
+}
+
+Model::hit Model::intersect(ray const& world_ray) const {
+    hit closest;
+    if (not mesh_) {
+        return closest;
+    }
+    ray const object_ray = reverse_transform(world_ray);
+    tree::TriangleHit found;
+    if (mesh_->closest(object_ray, nearest_allowed(object_ray), basal::pos_inf, found)) {
+        point const object_point = object_ray.distance_along(found.t);
+        closest = hit{intersection{forward_transform(object_point)}, found.t,
+                      forward_transform(mesh_->normal(found.triangle)), this};
+    }
+    return closest;
+}
+
+bool Model::intersect(ray const& world_ray, hit_record& record) const {
+    if (not mesh_) {
+        return false;
+    }
+    ray const object_ray = reverse_transform(world_ray);
+    tree::TriangleHit found;
+    if (not mesh_->closest(object_ray, nearest_allowed(object_ray), basal::pos_inf, found)) {
+        return false;
+    }
+    keep(world_ray, object_ray.distance_along(found.t), found.t, found.triangle, found.u, found.v, record);
+    return true;
+}
+
+Model::hit Model::resolve(ray const& world_ray, hit_record const& record) const {
+    ray const object_ray = reverse_transform(world_ray);
+    point const object_point = object_ray.distance_along(record.t);
+    return hit{intersection{forward_transform(object_point)}, record.t,
+               forward_transform(mesh_->normal(record.primitive)), this};
+}
+
+precision Model::nearest_allowed(ray const& object_ray) const {
+    // a hit at the origin counts when the ray points into the material (which is the only side a triangle can be hit
+    // from) unless the material is transparent, the same as the rules of object::intersect.
+    if constexpr (can_ray_origin_be_collision) {
+        if (not(m_medium and m_medium->refractive_index(object_ray.location()) > 0.0_p)) {
+            return -basal::epsilon;
         }
     }
-    return false;
+    return basal::epsilon;
 }
 
 Model::hits Model::collisions_along(ray const& object_ray) const {
     hits hits;
-    for (auto const& face : faces_) {
-        // transform to each face's position
-        auto face_ray = face.reverse_transform(object_ray);
-        auto subhits = face.collisions_along(face_ray);
-        for (auto& h : subhits) {
-            auto face_point = as_point(h.intersect);
-            h.intersect = face.forward_transform(face_point);
-            h.normal = face.forward_transform(h.normal);
+    if (mesh_) {
+        std::vector<tree::TriangleHit> found;
+        mesh_->all(object_ray, found);
+        for (auto const& f : found) {
+            hits.emplace_back(intersection{object_ray.distance_along(f.t)}, f.t, mesh_->normal(f.triangle), this);
         }
-        hits.insert(hits.end(), subhits.begin(), subhits.end());
     }
     return hits;
 }
@@ -50,20 +111,30 @@ image::point Model::map(point const&) const {
 }
 
 precision Model::get_object_extent(void) const {
-    precision max_extent = 0.0_p;
-    for (auto const& point : points_) {
-        auto vec = point - R3::origin;
-        precision extent = vec.magnitude();
-        if (extent > max_extent) {
-            max_extent = extent;
-        }
-    }
+    precision const max_extent = mesh_ ? mesh_->extent() : 0.0_p;
     if constexpr (debug::model) {
         printf("Model: Returning %lf for max extent\r\n", max_extent);
     }
     return max_extent;
 }
 
+Bounds Model::get_object_bounds(void) const {
+    if (not mesh_ or mesh_->nodes().empty()) {
+        return object::get_object_bounds();
+    }
+    // the root of the mesh hierarchy holds every triangle
+    tree::FlatNode const& root = mesh_->nodes()[0];
+    point lower{root.lower[0], root.lower[1], root.lower[2]};
+    point upper{root.upper[0], root.upper[1], root.upper[2]};
+    for (size_t a = 0; a < dimensions; a++) {
+        if (not(lower[a] < upper[a])) {
+            lower[a] -= bounds_slack(lower[a]);  // flat models
+            upper[a] += bounds_slack(upper[a]);
+        }
+    }
+    return Bounds{lower, upper};
+}
+
 void Model::addVertex(float x, float y, float z) {
     if constexpr (debug::model) {
         printf("Model: Adding vertex %f %f %f\n", (double)x, (double)y, (double)z);
@@ -75,7 +146,7 @@ void Model::addNormal(float dx, float dy, float dz) {
     if constexpr (debug::model) {
         printf("Model: Adding vector %f %f %f\n", (double)dx, (double)dy, (double)dz);
     }
-    raytrace::vector normal{(double)dx, (double)dy, (double)dz};
+    raytrace::vector normal{dx, dy, dz};
     normals_.emplace_back(normal);
 }
 
@@ -95,8 +166,7 @@ void Model::addFace(uint32_t a, uint32_t b, uint32_t c) {
         if constexpr (debug::model) {
             printf("Model: Adding polygon %u %u %u\n", a, b, c);
         }
-        // swap the order of points so that the normal is facing the right way
-        faces_.emplace_back(points_[ic], points_[ib], points_[ia]);
+        addTriangle(ia, ib, ic);
     } else {
         if constexpr (debug::model) {
             printf("Model: Index out of bounds! %" PRIu32 " %" PRIu32 " %" PRIu32 "\n", a, b, c);
@@ -117,8 +187,7 @@ void Model::addFace(uint32_t a, uint32_t ta, uint32_t b, uint32_t tb, uint32_t c
         if constexpr (debug::model) {
             printf("Model: Adding polygon (%u %u %u), (%u %u %u)\n", a, b, c, ta, tb, tc);
         }
-        // swap the order of points so that the normal is facing the right way
-        faces_.emplace_back(points_[ic], points_[ib], points_[ia], texels_[ita], texels_[itb], texels_[itc]);
+        addTriangle(ia, ib, ic);
     } else {
         if constexpr (debug::model) {
             printf("Model: Index out of bounds! %" PRIu32 " %" PRIu32 " %" PRIu32 "\n", a, b, c);
@@ -145,9 +214,7 @@ void Model::addFace(uint32_t v1, uint32_t t1, uint32_t n1, uint32_t v2, uint32_t
             printf("Model: Adding polygon (%u, %u, %u), (%u, %u, %u), (%u, %u, %u)\n", v1, v2, v3, t1, t2, t3, n1, n2,
                    n3);
         }
-        // swap the order of points so that the normal is facing the right way
-        faces_.emplace_back(points_[iv3], points_[iv2], points_[iv1], texels_[it1], texels_[it2], texels_[it3],
-                            normals_[in1], normals_[in2], normals_[in3]);
+        addTriangle(iv1, iv2, iv3, &normals_[in1], &normals_[in2], &normals_[in3]);
     } else {
         if constexpr (debug::model) {
             printf("Model: Index out of bounds! %" PRIu32 " %" PRIu32 " %" PRIu32 "\n", v1, v2, v3);
@@ -155,19 +222,113 @@ void Model::addFace(uint32_t v1, uint32_t t1, uint32_t n1, uint32_t v2, uint32_t
     }
 }
 
+void Model::addTriangle(uint32_t ia, uint32_t ib, uint32_t ic, raytrace::vector const* na, raytrace::vector const* nb,
+                        raytrace::vector const* nc) {
+    triangles_.push_back(tree::MeshBVH::indices{ia, ib, ic});
+    if (na and nb and nc) {
+        triangle_normals_.push_back((*na + *nb + *nc).normalized());
+    } else {
+        // counter clockwise around the normal
+        triangle_normals_.push_back(R3::cross(points_[ib] - points_[ia], points_[ic] - points_[ia]));
+    }
+}
+
+void Model::addContents(obj::Contents const& contents) {
+    statistics_ = contents.statistics;
+    points_.reserve(points_.size() + contents.vertices.size());
+    for (auto const& v : contents.vertices) {
+        points_.emplace_back(precision(v[0]), precision(v[1]), precision(v[2]));
+    }
+    normals_.reserve(normals_.size() + contents.normals.size());
+    for (auto const& n : contents.normals) {
+        normals_.emplace_back(raytrace::vector{precision(n[0]), precision(n[1]), precision(n[2])});
+    }
+    texels_.reserve(texels_.size() + contents.textures.size());
+    for (auto const& t : contents.textures) {
+        texels_.emplace_back(precision(t[0]), precision(t[1]));
+    }
+    triangles_.reserve(triangles_.size() + contents.triangles.size());
+    triangle_normals_.reserve(triangle_normals_.size() + contents.triangles.size());
+    auto within = [](std::array<uint32_t, 3> const& indices, size_t limit) {
+        return indices[0] < limit and indices[1] < limit and indices[2] < limit;
+    };
+    auto absent = [](std::array<uint32_t, 3> const& indices) {
+        return indices[0] == obj::Contents::Absent and indices[1] == obj::Contents::Absent
+               and indices[2] == obj::Contents::Absent;
+    };
+    // the same rules as the addFace methods, a given texture or normal index must be valid too
+    for (auto const& triangle : contents.triangles) {
+        bool const points_ok = within(triangle.vertex, points_.size());
+        bool const texels_ok = absent(triangle.texture) or within(triangle.texture, texels_.size());
+        bool const normals_ok = absent(triangle.normal) or within(triangle.normal, normals_.size());
+        if (not(points_ok and texels_ok and normals_ok)) {
+            if constexpr (debug::model) {
+                printf("Model: Index out of bounds! %" PRIu32 " %" PRIu32 " %" PRIu32 "\n", triangle.vertex[0],
+                       triangle.vertex[1], triangle.vertex[2]);
+            }
+            continue;
+        }
+        if (absent(triangle.normal)) {
+            addTriangle(triangle.vertex[0], triangle.vertex[1], triangle.vertex[2]);
+        } else {
+            addTriangle(triangle.vertex[0], triangle.vertex[1], triangle.vertex[2], &normals_[triangle.normal[0]],
+                        &normals_[triangle.normal[1]], &normals_[triangle.normal[2]]);
+        }
+    }
+}
+
+void Model::buildMesh(raytrace::vector const& offset) {
+    std::vector<raytrace::point> vertices;
+    vertices.reserve(points_.size());
+    for (auto const& pnt : points_) {
+        vertices.push_back(pnt + offset);
+    }
+    auto mesh = std::make_shared<tree::MeshBVH>();
+    mesh->build(vertices, triangles_, triangle_normals_);
+    if constexpr (debug::model) {
+        std::cout << "Model: Built mesh of " << mesh->triangle_count() << " triangles with " << mesh->nodes().size()
+                  << " nodes" << std::endl;
+    }
+    mesh_ = mesh;
+}
+
 size_t Model::GetNumberOfFaces(void) const {
-    return faces_.size();
+    return mesh_ ? mesh_->triangle_count() : triangles_.size();
+}
+
+namespace {
+/// Finds the size and modification time of the file
+/// @return false if the file can not be inspected
+bool source_of(char const* const filename, Model::Source& source) {
+    std::error_code error;
+    auto const size = std::filesystem::file_size(filename, error);
+    if (error) {
+        return false;
+    }
+    auto const time = std::filesystem::last_write_time(filename, error);
+    if (error) {
+        return false;
+    }
+    source.size = size;
+    source.time = static_cast<int64_t>(time.time_since_epoch().count());
+    return true;
 }
+}  // namespace
 
 void Model::LoadFromFile(char const* const filename) {
     if (not loaded_) {
-        FILE* file = fopen(filename, "r");
-        basal::exception::throw_unless(file != nullptr, __FILE__, __LINE__, "File %s was not found!", filename);
-        char buffer[1024];
-        while (fgets(buffer, sizeof(buffer), file)) {
-            parser_.Parse(buffer);
+        std::string const cache = std::string{filename} + CacheSuffix;
+        // taken before the parse, so a file changed during it will not match the cache next time
+        Source source;
+        bool const inspected = source_of(filename, source);
+        if constexpr (use_mesh_cache) {
+            // only a cache written from the same file is used
+            if (inspected and LoadFromCache(cache.c_str(), &source)) {
+                return;
+            }
         }
-        fclose(file);
+        source_ = source;
+        addContents(obj::load(filename));
         loaded_ = true;
         // compute the center of the model
         vector computed_centroid;
@@ -182,40 +343,131 @@ void Model::LoadFromFile(char const* const filename) {
         if constexpr (debug::model) {
             std::cout << "Computed Centroid of Model: " << computed_centroid << std::endl;
         }
-        // adjust each face position now to be relative to the center
-        for (auto& face : faces_) {
-            face.print(std::cout, "Face");
-            auto _old = face.position();
-            auto _new = (_old - computed_centroid);
-            if constexpr (debug::model) {
-                std::cout << "Old Position " << _old << " New Position " << _new << std::endl;
+        // the triangles are relative to the center
+        buildMesh(-computed_centroid);
+        centroid_ = computed_centroid;
+        position(R3::origin + computed_centroid);  // this is the center of the model, not each face
+        if constexpr (use_mesh_cache) {
+            if (not SaveCache(cache.c_str()) and debug::model) {
+                printf("Model: Could not write the cache %s\n", cache.c_str());
             }
-            face.position(_new);
         }
-        position(R3::origin + computed_centroid);  // this is the center of the model, not each face
     }
 }
 
+namespace {
+/// The model's part of a cache, followed by the texels
+struct CacheExtra {
+    uint64_t version;  //!< The @ref cache_extra_version which wrote the cache
+    uint64_t source_size;
+    int64_t source_time;
+    precision centroid[dimensions];
+    uint64_t statistics[5];
+    uint64_t texels;
+};
+
+/// The version of the @ref CacheExtra layout, caches of any other version are ignored
+constexpr uint64_t cache_extra_version{2U};
+}  // namespace
+
+bool Model::SaveCache(char const* const filename) const {
+    if (not mesh_) {
+        return false;
+    }
+    CacheExtra header;
+    std::memset(&header, 0, sizeof(header));
+    header.version = cache_extra_version;
+    header.source_size = source_.size;
+    header.source_time = source_.time;
+    for (size_t a = 0; a < dimensions; a++) {
+        header.centroid[a] = centroid_[a];
+    }
+    header.statistics[0] = statistics_.object;
+    header.statistics[1] = statistics_.vertices;
+    header.statistics[2] = statistics_.normals;
+    header.statistics[3] = statistics_.textures;
+    header.statistics[4] = statistics_.faces;
+    header.texels = texels_.size();
+    std::string extra(sizeof(header) + texels_.size() * 2U * sizeof(precision), '\0');
+    std::memcpy(extra.data(), &header, sizeof(header));
+    char* texel = extra.data() + sizeof(header);
+    for (auto const& t : texels_) {
+        precision const uv[2] = {t[0], t[1]};
+        std::memcpy(texel, uv, sizeof(uv));
+        texel += sizeof(uv);
+    }
+    return mesh_->save(filename, extra);
+}
+
+bool Model::LoadFromCache(char const* const filename, Source const* source) {
+    if (loaded_) {
+        return false;
+    }
+    std::string_view extra;
+    auto mesh = tree::MeshBVH::map(filename, extra);
+    CacheExtra header;
+    if (not mesh or extra.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, extra.data(), sizeof(header));
+    if (header.version != cache_extra_version) {
+        return false;
+    }
+    if (source and (header.source_size != source->size or header.source_time != source->time)) {
+        return false;
+    }
+    // the count is checked by division so a damaged count can not overflow
+    size_t const texel_size = 2U * sizeof(precision);
+    size_t const texel_bytes = extra.size() - sizeof(header);
+    if ((texel_bytes % texel_size) != 0U or header.texels != texel_bytes / texel_size) {
+        return false;
+    }
+    mesh_ = mesh;
+    source_ = Source{header.source_size, header.source_time};
+    centroid_ = raytrace::vector{header.centroid[0], header.centroid[1], header.centroid[2]};
+    statistics_.object = header.statistics[0];
+    statistics_.vertices = header.statistics[1];
+    statistics_.normals = header.statistics[2];
+    statistics_.textures = header.statistics[3];
+    statistics_.faces = header.statistics[4];
+    texels_.resize(header.texels);
+    char const* texel = extra.data() + sizeof(header);
+    for (auto& t : texels_) {
+        precision uv[2];
+        std::memcpy(uv, texel, sizeof(uv));
+        texel += sizeof(uv);
+        t = image::point{uv[0], uv[1]};
+    }
+    loaded_ = true;
+    position(R3::origin + centroid_);
+    if constexpr (debug::model) {
+        printf("Model: Mapped %zu triangles from %s\n", mesh_->triangle_count(), filename);
+    }
+    return true;
+}
+
 void Model::LoadFromString(char const* const literal) {
     if (not loaded_) {
-        parser_.Parse(literal);
+        addContents(obj::load(std::string_view{literal}));
         loaded_ = true;
+        buildMesh(raytrace::vector{0.0_p, 0.0_p, 0.0_p});
     }
 }
 
 obj::Parser::Statistics const& Model::GetStatistics() const {
-    return parser_.GetStatistics();
+    return statistics_;
+}
+
+std::shared_ptr<tree::MeshBVH const> const& Model::mesh() const {
+    return mesh_;
 }
 
 vector Model::normal_(point const& object_surface_point) const {
-    vector object_surface_normal{0.0_p, 0.0_p, 0.0_p};
-    for (auto const& f : faces_) {
-        point face_surface_point = f.reverse_transform(object_surface_point);
-        if (f.is_contained(face_surface_point)) {
-            object_surface_normal = f.normal(face_surface_point);
-        }
+    uint32_t triangle;
+    if (mesh_ and mesh_->locate(object_surface_point, basal::epsilon, triangle)) {
+        return mesh_->normal(triangle);
     }
-    return entity::forward_transform(object_surface_normal);
+    return vector{0.0_p, 0.0_p, 0.0_p};
 }
 
 }  // namespace objects
@@ -2,7 +2,6 @@
 
 #include <algorithm>
 #include <iostream>
-#include <vector>
 
 namespace raytrace {
 namespace objects {
@@ -46,22 +45,115 @@ vector overlap::normal_(point const& overlap_point) const {
     }
 }
 
-hits overlap::collisions_along(ray const& overlap_ray) const {
-    /// @note overlap_ray is not in WORLD space, but is in the space of the overlap objects.
-    auto object_rayA = m_A.reverse_transform(overlap_ray);
-    auto object_rayB = m_B.reverse_transform(overlap_ray);
+namespace {
+/// Determines if any part of a line (in both directions from the location of the ray) passes through a bounds. Objects
+/// return their collisions behind the location too, so only a line which misses the bounds proves there are none.
+bool along(Bounds const& bounds, ray const& r) {
+    precision nearest = basal::neg_inf;
+    precision farthest = basal::pos_inf;
+    for (size_t a = 0; a < dimensions; a++) {
+        precision const location = r.location()[a];
+        precision const direction = r.direction()[a];
+        if (basal::is_exactly_zero(direction)) {
+            if (location < bounds.min[a] or bounds.max[a] < location) {
+                return false;  // parallel to and outside of this pair of sides
+            }
+            continue;
+        }
+        precision const t0 = (bounds.min[a] - location) / direction;
+        precision const t1 = (bounds.max[a] - location) / direction;
+        nearest = std::max(nearest, std::min(t0, t1));
+        farthest = std::min(farthest, std::max(t0, t1));
+    }
+    return nearest <= farthest;
+}
 
-    hits hitsA = m_A.collisions_along(object_rayA);
+/// Collects the hits of one of the objects of an overlap in the space of the overlap, in order of distance
+void collect(object const& obj, ray const& overlap_ray, hits& found) {
+    found = obj.collisions_along(obj.reverse_transform(overlap_ray));
     // all hits have to be translated to overlap space
-    for (auto& h : hitsA) {
-        h.intersect = m_A.forward_transform(as_point(h.intersect));
-        h.normal = m_A.forward_transform(h.normal);
+    for (auto& h : found) {
+        h.intersect = obj.forward_transform(as_point(h.intersect));
+        h.normal = obj.forward_transform(h.normal);
     }
-    hits hitsB = m_B.collisions_along(object_rayB);
-    // all hits have to be translated to overlap space
-    for (auto& h : hitsB) {
-        h.intersect = m_B.forward_transform(as_point(h.intersect));
-        h.normal = m_B.forward_transform(h.normal);
+    // most objects already give their hits in order
+    if (not std::is_sorted(found.begin(), found.end())) {
+        std::sort(found.begin(), found.end());
+    }
+}
+
+/// The hits of both objects of an overlap in order of distance, each remembering which object it came from, so the
+/// cases of the overlap are decided by position in the list instead of by comparing hits. Both lists are kept inline so
+/// even nested overlaps do not allocate.
+struct merged_hits {
+    /// Which object a hit came from and where it was in the hits of that object
+    struct origin {
+        bool from_B;   //!< From the second object (otherwise from the first)
+        size_t index;  //!< The index within the hits of that object
+    };
+
+    /// Merges two ordered lists of hits in one pass
+    merged_hits(hits const& A, hits const& B) {
+        size_t a = 0U, b = 0U;
+        while (a < A.size() or b < B.size()) {
+            // on a tie the hit of A comes first
+            if (b == B.size() or (a < A.size() and not(B[b] < A[a]))) {
+                list.push_back(A[a]);
+                origins.push_back(origin{false, a++});
+            } else {
+                list.push_back(B[b]);
+                origins.push_back(origin{true, b++});
+            }
+        }
+    }
+
+    /// @return True if the hit at a position of the merged list is the index-th hit of A (or of B)
+    bool is(size_t position, bool from_B, size_t index) const {
+        return position < origins.size() and origins[position].from_B == from_B and origins[position].index == index;
+    }
+
+    /// @return True if the merged list starts with every one of the count hits of A (or of B)
+    bool starts_with(bool from_B, size_t count) const {
+        return count > 0U and is(count - 1U, from_B, count - 1U);
+    }
+
+    /// @return The merged hits from first up to (but not including) last
+    hits slice(size_t first, size_t last) const {
+        auto const begin = list.begin();
+        return hits(begin + static_cast<std::ptrdiff_t>(first), begin + static_cast<std::ptrdiff_t>(last));
+    }
+
+    /// @return All of the merged hits
+    hits all() const {
+        return slice(0U, list.size());
+    }
+
+    basal::small_vector<hit, 2U * inline_collisions> list;
+    basal::small_vector<origin, 2U * inline_collisions> origins;
+};
+
+constexpr bool from_A{false};
+constexpr bool from_B{true};
+}  // namespace
+
+hits overlap::collisions_along(ray const& overlap_ray) const {
+    /// @note overlap_ray is not in WORLD space, but is in the space of the overlap objects.
+    // an object whose bounds the line misses has no hits so it is not asked for them (the bounds are taken now as
+    // either object may have been moved since the overlap was made)
+    bool const along_A = along(m_A.get_world_bounds(), overlap_ray);
+    bool const along_B = along(m_B.get_world_bounds(), overlap_ray);
+    bool const closed_inclusive = (m_type == overlap::type::inclusive) and m_closed_two_hit_surfaces_;
+    // early exit when there can be nothing left of the overlap
+    if ((not along_A and not along_B) or (not along_A and m_type == overlap::type::subtractive)
+        or (closed_inclusive and not(along_A and along_B))) {
+        return hits();  // empty
+    }
+    hits hitsA, hitsB;
+    if (along_A) {
+        collect(m_A, overlap_ray, hitsA);
+    }
+    if (along_B) {
+        collect(m_B, overlap_ray, hitsB);
     }
 
     // early exit
@@ -69,22 +161,14 @@ hits overlap::collisions_along(ray const& overlap_ray) const {
         return hits();  // empty
     }
 
-    auto sorter = [](hit a, hit b) -> bool { return (a < b); };
-
-    // sort them individually so we can make some logical deductions later.
-    std::sort(hitsA.begin(), hitsA.end(), sorter);
-    std::sort(hitsB.begin(), hitsB.end(), sorter);
-    // merge the lists, then sort distances.
-    hits hitsAB;
-    hitsAB.insert(hitsAB.end(), hitsA.begin(), hitsA.end());
     if (m_type == overlap::type::subtractive) {
         // reverse the normals on B so they point "into" the object
         for (auto& h : hitsB) {
             h.normal = !h.normal;
         }
     }
-    hitsAB.insert(hitsAB.end(), hitsB.begin(), hitsB.end());
-    std::sort(hitsAB.begin(), hitsAB.end(), sorter);
+    // the lists are each in order, so they are merged without sorting again
+    merged_hits hitsAB{hitsA, hitsB};
 
     if (m_type == overlap::type::additive) {
         // remove the inner alternating hit from the hits lists
@@ -98,19 +182,16 @@ hits overlap::collisions_along(ray const& overlap_ray) const {
         if (m_closed_two_hit_surfaces_) {
             // if [A0, A1, B0, B1] then return all
             // if [B0, B1, A0, A1] then return all
-            if (std::equal(hitsAB.begin(), hitsAB.begin() + static_cast<std::ptrdiff_t>(hitsA.size()), hitsA.begin())
-                or std::equal(hitsAB.begin(), hitsAB.begin() + static_cast<std::ptrdiff_t>(hitsB.size()),
-                              hitsB.begin())) {
+            if (hitsAB.starts_with(from_A, hitsA.size()) or hitsAB.starts_with(from_B, hitsB.size())) {
                 // if it starts with only hitsA or only hitsB
-                return hitsAB;
+                return hitsAB.all();
             }
             // if [A0, B0, A1, B1] then return [A0, B1]
             // if [B0, A0, B1, A1] then return [B0, A1]
-            if ((hitsAB[0] == hitsA[0] and hitsAB[1] == hitsB[0])
-                or (hitsAB[0] == hitsB[0] and hitsAB[1] == hitsA[0])) {
+            if ((hitsAB.is(0, from_A, 0) and hitsAB.is(1, from_B, 0))
+                or (hitsAB.is(0, from_B, 0) and hitsAB.is(1, from_A, 0))) {
                 // remove second and third (end is exclusive)
-                hitsAB.erase(hitsAB.begin() + 1, hitsAB.end());
-                return hitsAB;
+                return hitsAB.slice(0, 1);
             }
         }
         // if [A0, B0, B1, A0] them remove [B0, B1] and return [A0, A1] or reverse ?
@@ -127,30 +208,30 @@ hits overlap::collisions_along(ray const& overlap_ray) const {
 
         if (m_closed_two_hit_surfaces_ or m_open_two_hit_surfaces_) {
             // if [A0, A1, B0, B1] then return [A0, A1]
-            if (std::equal(hitsAB.begin(), hitsAB.begin() + static_cast<std::ptrdiff_t>(hitsA.size()), hitsA.begin())) {
+            if (hitsAB.starts_with(from_A, hitsA.size())) {
                 return hitsA;
             }
             // if [B0, B1, A0, A1] then return [A0, A1]
             // if starts with hitsB
-            if (std::equal(hitsAB.begin(), hitsAB.begin() + static_cast<std::ptrdiff_t>(hitsB.size()), hitsB.begin())) {
+            if (hitsAB.starts_with(from_B, hitsB.size())) {
                 return hitsA;
             }
             // if [B0, A0, A1, B1] then return empty
-            if (hitsAB[0] == hitsB[0] and hitsAB[3] == hitsB[1]) {
+            if (hitsAB.is(0, from_B, 0) and hitsAB.is(3, from_B, 1)) {
                 return hits();  // empty
             }
             // if [B0, A0, B1, A1] then return [B1, A1]
             // and reverse the B1 normal!
-            if (hitsAB[0] == hitsB[0] and hitsAB[1] == hitsA[0]) {
-                return hits(hitsAB.begin() + 2, hitsAB.end());
+            if (hitsAB.is(0, from_B, 0) and hitsAB.is(1, from_A, 0)) {
+                return hitsAB.slice(2, hitsAB.list.size());
             }
             // if [A0, B0, B1, A1] then return all
             // if [A0, B0, A1, B1] then return [A0, B0]
-            if (hitsAB[0] == hitsA[0] and hitsAB[1] == hitsB[0]) {
-                if (hitsAB[2] == hitsA[1]) {
-                    return hits(hitsAB.begin(), hitsAB.begin() + 2);
+            if (hitsAB.is(0, from_A, 0) and hitsAB.is(1, from_B, 0)) {
+                if (hitsAB.is(2, from_A, 1)) {
+                    return hitsAB.slice(0, 2);
                 } else {
-                    return hitsAB;
+                    return hitsAB.all();
                 }
             }
         }
@@ -163,9 +244,7 @@ hits overlap::collisions_along(ray const& overlap_ray) const {
             }
             // if [A0, A1, B0, B1] return empty
             // if [B0, B1, A0, A1] return empty
-            if (std::equal(hitsAB.begin(), hitsAB.begin() + static_cast<std::ptrdiff_t>(hitsA.size()), hitsA.begin())
-                or std::equal(hitsAB.begin(), hitsAB.begin() + static_cast<std::ptrdiff_t>(hitsB.size()),
-                              hitsB.begin())) {
+            if (hitsAB.starts_with(from_A, hitsA.size()) or hitsAB.starts_with(from_B, hitsB.size())) {
                 // if it starts with only hitsA or only hitsB
                 return hits();  // empty
             }
@@ -174,14 +253,15 @@ hits overlap::collisions_along(ray const& overlap_ray) const {
             // if [A0, B0, B1, A1] then return [B0, B1]
             // if [B0, A0, A1, B1] then return [A0, A1]
             // if the first and second elements are from different objects...
-            if ((hitsAB[0] == hitsA[0] and hitsAB[1] == hitsB[0])
-                or (hitsAB[0] == hitsB[0] and hitsAB[1] == hitsA[0])) {
-                return hits(hitsAB.begin() + 1, hitsAB.end() - 1);
+            if ((hitsAB.is(0, from_A, 0) and hitsAB.is(1, from_B, 0))
+                or (hitsAB.is(0, from_B, 0) and hitsAB.is(1, from_A, 0))) {
+                return hitsAB.slice(1, hitsAB.list.size() - 1);
             }
         }
         if (m_open_two_hit_surfaces_) {
             // if just [A0, A1] or [B0, B1] then check to see if those points are inside the other
             if (hitsA.size() == 0) {  // then B has to have hits
+                auto const object_rayB = m_B.reverse_transform(overlap_ray);
                 point const B0 = object_rayB.distance_along(hitsB[0].distance);
                 point const B1 = object_rayB.distance_along(hitsB[1].distance);
                 if (not m_A.is_outside(B0) and not m_A.is_outside(B1)) {
@@ -190,6 +270,7 @@ hits overlap::collisions_along(ray const& overlap_ray) const {
                 return hits{};
             }
             if (hitsB.size() == 0) {  // then A has to have hits
+                auto const object_rayA = m_A.reverse_transform(overlap_ray);
                 point const A0 = object_rayA.distance_along(hitsA[0].distance);
                 point const A1 = object_rayA.distance_along(hitsA[1].distance);
                 if (not m_B.is_outside(A0) and not m_B.is_outside(A1)) {
@@ -202,9 +283,9 @@ hits overlap::collisions_along(ray const& overlap_ray) const {
             // if [A0, B0, B1, A1] then return [B0, B1]
             // if [B0, A0, A1, B1] then return [A0, A1]
             // if the first and second elements are from different objects...
-            if ((hitsAB[0] == hitsA[0] and hitsAB[1] == hitsB[0])
-                or (hitsAB[0] == hitsB[0] and hitsAB[1] == hitsA[0])) {
-                return hits(hitsAB.begin() + 1, hitsAB.end() - 1);
+            if ((hitsAB.is(0, from_A, 0) and hitsAB.is(1, from_B, 0))
+                or (hitsAB.is(0, from_B, 0) and hitsAB.is(1, from_A, 0))) {
+                return hitsAB.slice(1, hitsAB.list.size() - 1);
             }
         }
     } else if (m_type == overlap::type::exclusive) {
@@ -219,36 +300,25 @@ hits overlap::collisions_along(ray const& overlap_ray) const {
         if (m_closed_two_hit_surfaces_) {
             // for a closed surface all the points are hits (the inner points have their normals reversed)
             // if [A0, B0, A1, B1] then return [A0, B0, A1, B1] (inner points have reversed normals)
-            if (hitsAB[0] == hitsA[0] and hitsAB[1] == hitsB[0] and hitsAB[2] == hitsA[1] and hitsAB[3] == hitsB[1]) {
-                hitsAB[1].normal = !hitsAB[1].normal;
-                hitsAB[2].normal = !hitsAB[2].normal;
-                return hitsAB;
-            }
             // if [B0, A0, B1, A1] then return [B0, A0, B1, A1] (inner points have reversed normals)
-            if (hitsAB[0] == hitsB[0] and hitsAB[1] == hitsA[0] and hitsAB[2] == hitsB[1] and hitsAB[3] == hitsA[1]) {
-                hitsAB[1].normal = !hitsAB[1].normal;
-                hitsAB[2].normal = !hitsAB[2].normal;
-                return hitsAB;
-            }
             // if [A0, B0, B1, A1] then return [A0, B0, B1, A1] (inner points have reversed normals)
-            if (hitsAB[0] == hitsA[0] and hitsAB[3] == hitsA[1] and hitsAB[1] == hitsB[0] and hitsAB[2] == hitsB[1]) {
-                hitsAB[1].normal = !hitsAB[1].normal;
-                hitsAB[2].normal = !hitsAB[2].normal;
-                return hitsAB;
-            }
             // if [B0, A0, A1, B1] then return [B0, A0, A1, B1] (inner points have reversed normals)
-            if (hitsAB[0] == hitsB[0] and hitsAB[3] == hitsB[1] and hitsAB[1] == hitsA[0] and hitsAB[2] == hitsA[1]) {
-                hitsAB[1].normal = !hitsAB[1].normal;
-                hitsAB[2].normal = !hitsAB[2].normal;
-                return hitsAB;
+            for (bool const first : {from_A, from_B}) {
+                bool const second = not first;
+                if (hitsAB.is(0, first, 0) and hitsAB.is(1, second, 0)
+                    and ((hitsAB.is(2, first, 1) and hitsAB.is(3, second, 1))
+                         or (hitsAB.is(2, second, 1) and hitsAB.is(3, first, 1)))) {
+                    hits inner = hitsAB.all();
+                    inner[1].normal = !inner[1].normal;
+                    inner[2].normal = !inner[2].normal;
+                    return inner;
+                }
             }
             // if [A0, A1, B0, B1] then return that (no reversed normals)
-            if (hitsAB[0] == hitsA[0] and hitsAB[1] == hitsA[0]) {
-                return hitsAB;
-            }
             // if [B0, B1, A0, A1] then return that (no reversed normals)
-            if (hitsAB[0] == hitsB[0] and hitsAB[1] == hitsB[1]) {
-                return hitsAB;
+            if ((hitsAB.is(0, from_A, 0) and hitsAB.is(1, from_A, 1))
+                or (hitsAB.is(0, from_B, 0) and hitsAB.is(1, from_B, 1))) {
+                return hitsAB.all();
             }
         }
         if (m_open_two_hit_surfaces_) {
@@ -258,7 +328,7 @@ hits overlap::collisions_along(ray const& overlap_ray) const {
             // if [A0, B0] then return [A0, B0]
             // if [B0, A0] then return [B0, A0]
             // either way, it's fine
-            return hitsAB;
+            return hitsAB.all();
         }
     }
     return hits();  // empty
@@ -323,5 +393,32 @@ precision overlap::get_object_extent(void) const {
     return std::max(m_A.get_object_extent(), m_B.get_object_extent());
 }
 
+Bounds overlap::get_object_bounds(void) const {
+    // the objects are in the space of the overlap
+    Bounds const A = m_A.get_world_bounds();
+    if (m_type == overlap::type::subtractive) {
+        return A;  // only ever smaller than A
+    }
+    Bounds const B = m_B.get_world_bounds();
+    if (m_type == overlap::type::inclusive) {
+        if (A.is_infinite() or B.is_infinite()) {
+            return A.is_infinite() ? B : A;
+        }
+        // only the common part of both
+        point lower, upper;
+        for (size_t a = 0; a < dimensions; a++) {
+            lower[a] = std::max(A.min[a], B.min[a]);
+            upper[a] = std::min(A.max[a], B.max[a]);
+            if (not(lower[a] < upper[a])) {
+                upper[a] = lower[a] + bounds_slack(lower[a]);  // they do not touch
+            }
+        }
+        return Bounds{lower, upper};
+    }
+    Bounds both = A;
+    both.grow(B);
+    return both;
+}
+
 }  // namespace objects
 }  // namespace raytrace
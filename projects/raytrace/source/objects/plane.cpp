@@ -48,6 +48,54 @@ hits plane::collisions_along(ray const& object_ray) const {
     return ts;
 }
 
+bool plane::intersect(ray const& world_ray, hit_record& record) const {
+    // squares and rings are planes with limits, they use their collisions
+    if (get_type() != Type::Plane) {
+        return object::intersect(world_ray, record);
+    }
+    ray const object_ray = reverse_transform(world_ray);
+    // in object space the plane is the XY plane with the normal as +Z
+    precision const proj = object_ray.direction()[2];
+    if (basal::nearly_zero(proj)) {
+        return false;
+    }
+    precision const t[] = {-object_ray.location().z() / proj};
+    size_t index;
+    if (not nearest_root(object_ray, t, 1U, index)) {
+        return false;
+    }
+    keep(world_ray, object_ray.distance_along(t[0]), t[0], 0U, 0.0_p, 0.0_p, record);
+    return true;
+}
+
+object::hit plane::resolve(ray const& world_ray, hit_record const& record) const {
+    if (get_type() != Type::Plane) {
+        return object::resolve(world_ray, record);
+    }
+    ray const object_ray = reverse_transform(world_ray);
+    point const D = object_ray.distance_along(record.t);
+    return hit{intersection{forward_transform(D)}, record.t, forward_transform(normal_(R3::origin)), this};
+}
+
+bool plane::intersect(ray_packet const& world_rays, precision (&distances)[ray_packet::width]) const {
+    // squares and rings are planes with limits, they use the scalar rules
+    if (get_type() != Type::Plane) {
+        return false;
+    }
+    ray_packet object_rays;
+    m_transform.reverse(world_rays, object_rays);
+    for (size_t lane = 0; lane < ray_packet::width; lane++) {
+        // in object space the plane is the XY plane with the normal as +Z
+        precision const proj = object_rays.direction[2][lane];
+        precision const t = -object_rays.origin[2][lane] / proj;
+        bool const subtle = std::abs(t) <= 2.0_p * basal::epsilon;
+        bool const miss = basal::nearly_zero(proj) or not(t > basal::epsilon);
+        distances[lane] = subtle ? basal::nan : (miss ? basal::pos_inf : t);
+    }
+    m_transform.distances(world_rays, object_rays, distances);
+    return true;
+}
+
 bool plane::is_surface_point(point const& world_point) const {
     vector world_delta = world_point - position();
     if (world_delta == R3::null) {
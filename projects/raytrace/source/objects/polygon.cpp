@@ -181,6 +181,24 @@ precision polygon<N>::get_object_extent(void) const {
     return sqrt(m_radius2);
 }
 
+template <size_t N>
+Bounds polygon<N>::get_object_bounds(void) const {
+    point lower{basal::pos_inf, basal::pos_inf, basal::pos_inf};
+    point upper{basal::neg_inf, basal::neg_inf, basal::neg_inf};
+    for (auto const& p : m_points) {
+        for (size_t a = 0; a < dimensions; a++) {
+            lower[a] = std::min(lower[a], p[a]);
+            upper[a] = std::max(upper[a], p[a]);
+        }
+    }
+    // a polygon is flat along at least one axis
+    for (size_t a = 0; a < dimensions; a++) {
+        lower[a] -= bounds_slack(lower[a]);
+        upper[a] += bounds_slack(upper[a]);
+    }
+    return Bounds{lower, upper};
+}
+
 // EXPLICIT INSTANTIATIONS
 template class polygon<3U>;
 template class polygon<4U>;
@@ -63,5 +63,12 @@ precision ring::get_object_extent(void) const {
     return sqrt(m_outer_radius2);
 }
 
+Bounds ring::get_object_bounds(void) const {
+    // flat on the XY plane
+    precision const r = std::sqrt(m_outer_radius2);
+    precision const slack = bounds_slack(0.0_p);
+    return Bounds{point{-r, -r, -slack}, point{r, r, slack}};
+}
+
 }  // namespace objects
 }  // namespace raytrace
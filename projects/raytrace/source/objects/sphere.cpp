@@ -51,6 +51,63 @@ hits sphere::collisions_along(ray const& object_ray) const {
     return ts;
 }
 
+bool sphere::intersect(ray const& world_ray, hit_record& record) const {
+    ray const object_ray = reverse_transform(world_ray);
+    precision const px = object_ray.location().x();
+    precision const py = object_ray.location().y();
+    precision const pz = object_ray.location().z();
+    precision const dx = object_ray.direction()[0];
+    precision const dy = object_ray.direction()[1];
+    precision const dz = object_ray.direction()[2];
+    precision const a = (dx * dx + dy * dy + dz * dz);
+    precision const b = 2.0_p * (dx * px + dy * py + dz * pz);
+    precision const c = (px * px + py * py + pz * pz) - (m_radius * m_radius);
+    auto const roots = linalg::quadratic_roots(a, b, c);
+    precision const ts[] = {std::get<0>(roots), std::get<1>(roots)};
+    size_t index;
+    if (not nearest_root(object_ray, ts, 2U, index)) {
+        return false;
+    }
+    keep(world_ray, object_ray.distance_along(ts[index]), ts[index], static_cast<uint32_t>(index), 0.0_p, 0.0_p,
+         record);
+    return true;
+}
+
+object::hit sphere::resolve(ray const& world_ray, hit_record const& record) const {
+    ray const object_ray = reverse_transform(world_ray);
+    point const R = object_ray.distance_along(record.t);
+    return hit{intersection{forward_transform(R)}, record.t, forward_transform(normal_(R)), this};
+}
+
+bool sphere::intersect(ray_packet const& world_rays, precision (&distances)[ray_packet::width]) const {
+    ray_packet object_rays;
+    m_transform.reverse(world_rays, object_rays);
+    precision const r2 = m_radius * m_radius;
+    for (size_t lane = 0; lane < ray_packet::width; lane++) {
+        precision const px = object_rays.origin[0][lane];
+        precision const py = object_rays.origin[1][lane];
+        precision const pz = object_rays.origin[2][lane];
+        precision const dx = object_rays.direction[0][lane];
+        precision const dy = object_rays.direction[1][lane];
+        precision const dz = object_rays.direction[2][lane];
+        precision const a = (dx * dx + dy * dy + dz * dz);
+        precision const b = 2.0_p * (dx * px + dy * py + dz * pz);
+        precision const c = (px * px + py * py + pz * pz) - r2;
+        precision const i = (b * b) - (4.0_p * a * c);
+        precision const s = std::sqrt(i < 0.0_p ? 0.0_p : i);
+        precision const t0 = (-b - s) / (2.0_p * a);
+        precision const t1 = (-b + s) / (2.0_p * a);
+        precision const t = (t0 > basal::epsilon) ? t0 : ((t1 > basal::epsilon) ? t1 : basal::pos_inf);
+        // hits at the origin and grazing hits are left to the scalar rules
+        bool const subtle = std::abs(t0) <= 2.0_p * basal::epsilon or std::abs(t1) <= 2.0_p * basal::epsilon
+                            or std::abs(i) <= basal::epsilon;
+        bool const miss = basal::nearly_zero(a) or i < 0.0_p;
+        distances[lane] = miss ? basal::pos_inf : (subtle ? basal::nan : t);
+    }
+    m_transform.distances(world_rays, object_rays, distances);
+    return true;
+}
+
 image::point sphere::map(point const& object_surface_point) const {
     return mapping::spherical(object_surface_point);
 }
@@ -63,5 +120,9 @@ precision sphere::get_object_extent(void) const {
     return m_radius;
 }
 
+Bounds sphere::get_object_bounds(void) const {
+    return Bounds{point{-m_radius, -m_radius, -m_radius}, point{m_radius, m_radius, m_radius}};
+}
+
 }  // namespace objects
 }  // namespace raytrace
@@ -73,5 +73,11 @@ precision square::get_object_extent(void) const {
     return (max_ - R2::origin).magnitude();
 }
 
+Bounds square::get_object_bounds(void) const {
+    // flat on the XY plane
+    precision const slack = bounds_slack(0.0_p);
+    return Bounds{point{min_[0], min_[1], -slack}, point{max_[0], max_[1], slack}};
+}
+
 }  // namespace objects
 }  // namespace raytrace
@@ -141,5 +141,11 @@ precision torus::get_object_extent(void) const {
     return m_ring_radius + m_tube_radius;
 }
 
+Bounds torus::get_object_bounds(void) const {
+    // the ring is around Z
+    precision const r = m_ring_radius + m_tube_radius;
+    return Bounds{point{-r, -r, -m_tube_radius}, point{r, r, m_tube_radius}};
+}
+
 }  // namespace objects
 }  // namespace raytrace
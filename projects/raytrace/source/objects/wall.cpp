@@ -70,6 +70,22 @@ hits wall::collisions_along(ray const& wall_ray) const {
     return ts0;
 }
 
+bool wall::intersect(ray_packet const& world_rays, precision (&distances)[ray_packet::width]) const {
+    ray_packet wall_rays;
+    m_transform.reverse(world_rays, wall_rays);
+    // the planes find the distances in wall space
+    precision front[ray_packet::width];
+    precision back[ray_packet::width];
+    m_front_.intersect(wall_rays, front);
+    m_back_.intersect(wall_rays, back);
+    for (size_t lane = 0; lane < ray_packet::width; lane++) {
+        bool const subtle = std::isnan(front[lane]) or std::isnan(back[lane]);
+        distances[lane] = subtle ? basal::nan : std::min(front[lane], back[lane]);
+    }
+    m_transform.distances(world_rays, wall_rays, distances);
+    return true;
+}
+
 bool wall::is_surface_point(point const& world_point) const {
     point wall_point = reverse_transform(world_point);
     return m_front_.is_surface_point(wall_point) or m_back_.is_surface_point(wall_point);
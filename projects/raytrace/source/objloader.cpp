@@ -0,0 +1,343 @@
+#include "raytrace/objloader.hpp"
+
+#include <algorithm>
+#include <basal/exception.hpp>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+#include "raytrace/mappedfile.hpp"
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+namespace raytrace {
+namespace obj {
+
+namespace {
+
+/// The smallest chunk of text worth giving to a thread
+constexpr size_t minimum_chunk_size{1U << 16U};
+
+/// A run of whole lines and the number of each element in it. The firsts are the number of each element in all the
+/// chunks before this one, which is where this chunk writes its elements and what relative indices refer to.
+struct Chunk {
+    char const* begin{nullptr};
+    char const* end{nullptr};
+    Parser::Statistics counts;
+    size_t triangles{0U};
+    size_t first_vertex{0U};
+    size_t first_normal{0U};
+    size_t first_texture{0U};
+    size_t first_triangle{0U};
+};
+
+/// The kinds of line the loader understands
+enum class Line : char {
+    Other,
+    Object,
+    Vertex,
+    Normal,
+    Texture,
+    Face,
+};
+
+inline bool is_blank(char c) {
+    return (c == ' ' or c == '\t');
+}
+
+inline char const* skip_blanks(char const* p, char const* end) {
+    while (p < end and is_blank(*p)) {
+        p++;
+    }
+    return p;
+}
+
+/// @return The start of the next line
+inline char const* next_line(char const* p, char const* end) {
+    while (p < end and *p != '\n') {
+        p++;
+    }
+    return (p < end) ? p + 1 : end;
+}
+
+/// Determines the kind of line and moves past the keyword
+inline Line classify(char const*& p, char const* end) {
+    p = skip_blanks(p, end);
+    if (p >= end) {
+        return Line::Other;
+    }
+    char const c0 = p[0];
+    char const c1 = (p + 1 < end) ? p[1] : '\n';
+    char const c2 = (p + 2 < end) ? p[2] : '\n';
+    if (c0 == 'v' and is_blank(c1)) {
+        p += 1;
+        return Line::Vertex;
+    } else if (c0 == 'v' and c1 == 'n' and is_blank(c2)) {
+        p += 2;
+        return Line::Normal;
+    } else if (c0 == 'v' and c1 == 't' and is_blank(c2)) {
+        p += 2;
+        return Line::Texture;
+    } else if (c0 == 'f' and is_blank(c1)) {
+        p += 1;
+        return Line::Face;
+    } else if (c0 == 'o' and is_blank(c1)) {
+        p += 1;
+        return Line::Object;
+    }
+    return Line::Other;
+}
+
+/// Parses a floating point number and moves past it
+inline bool parse_float(char const*& p, char const* end, float& value) {
+    p = skip_blanks(p, end);
+    if (p < end and *p == '+') {
+        p++;  // from_chars does not take a leading plus
+    }
+#if defined(__cpp_lib_to_chars)
+    auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc{}) {
+        return false;
+    }
+    p = result.ptr;
+#else
+    // the text is not terminated, so copy the number out first
+    char number[64];
+    size_t length = 0U;
+    while ((p + length) < end and length < (sizeof(number) - 1U) and not is_blank(p[length]) and p[length] != '\n'
+           and p[length] != '\r') {
+        number[length] = p[length];
+        length++;
+    }
+    number[length] = '\0';
+    char* stop = nullptr;
+    value = std::strtof(number, &stop);
+    if (stop == number) {
+        return false;
+    }
+    p += (stop - number);
+#endif
+    return true;
+}
+
+/// Parses a (possibly negative) integer and moves past it
+inline bool parse_integer(char const*& p, char const* end, int64_t& value) {
+    if (p < end and *p == '+') {
+        p++;
+    }
+    auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc{}) {
+        return false;
+    }
+    p = result.ptr;
+    return true;
+}
+
+/// Converts a one based (or negative relative) index into a zero based index
+inline uint32_t resolve(int64_t index, size_t defined) {
+    if (index > 0) {
+        return static_cast<uint32_t>(index - 1);
+    } else if (index < 0 and static_cast<size_t>(-index) <= defined) {
+        return static_cast<uint32_t>(static_cast<int64_t>(defined) + index);
+    }
+    return Contents::Absent;
+}
+
+/// @return The number of corners (blank separated groups) on a face line
+inline size_t count_corners(char const* p, char const* end) {
+    size_t corners = 0U;
+    while (true) {
+        p = skip_blanks(p, end);
+        if (p >= end or *p == '\n' or *p == '\r' or *p == '#') {
+            break;
+        }
+        corners++;
+        while (p < end and not is_blank(*p) and *p != '\n' and *p != '\r') {
+            p++;
+        }
+    }
+    return corners;
+}
+
+/// The first pass, counts each kind of line in the chunk
+void count(Chunk& chunk) {
+    for (char const* p = chunk.begin; p < chunk.end; p = next_line(p, chunk.end)) {
+        char const* q = p;
+        switch (classify(q, chunk.end)) {
+            case Line::Vertex:
+                chunk.counts.vertices++;
+                break;
+            case Line::Normal:
+                chunk.counts.normals++;
+                break;
+            case Line::Texture:
+                chunk.counts.textures++;
+                break;
+            case Line::Face: {
+                size_t const corners = count_corners(q, chunk.end);
+                if (corners >= 3U) {
+                    chunk.counts.faces++;
+                    chunk.triangles += corners - 2U;
+                }
+                break;
+            }
+            case Line::Object:
+                chunk.counts.object++;
+                break;
+            case Line::Other:
+                break;
+        }
+    }
+}
+
+/// The second pass, parses each element into its place in the contents
+void parse(Chunk const& chunk, Contents& contents) {
+    size_t vertex = chunk.first_vertex;
+    size_t normal = chunk.first_normal;
+    size_t texture = chunk.first_texture;
+    size_t triangle = chunk.first_triangle;
+    for (char const* p = chunk.begin; p < chunk.end; p = next_line(p, chunk.end)) {
+        char const* q = p;
+        switch (classify(q, chunk.end)) {
+            case Line::Vertex: {
+                auto& v = contents.vertices[vertex++];
+                for (auto& component : v) {
+                    if (not parse_float(q, chunk.end, component)) {
+                        component = std::numeric_limits<float>::quiet_NaN();
+                    }
+                }
+                break;
+            }
+            case Line::Normal: {
+                auto& n = contents.normals[normal++];
+                for (auto& component : n) {
+                    if (not parse_float(q, chunk.end, component)) {
+                        component = std::numeric_limits<float>::quiet_NaN();
+                    }
+                }
+                break;
+            }
+            case Line::Texture: {
+                auto& t = contents.textures[texture++];
+                for (auto& component : t) {
+                    if (not parse_float(q, chunk.end, component)) {
+                        component = std::numeric_limits<float>::quiet_NaN();
+                    }
+                }
+                break;
+            }
+            case Line::Face: {
+                size_t const corners = count_corners(q, chunk.end);
+                if (corners < 3U) {
+                    break;
+                }
+                // each corner is v, v/t, v/t/n or v//n
+                std::array<uint32_t, 3> first{};
+                std::array<uint32_t, 3> previous{};
+                for (size_t c = 0; c < corners; c++) {
+                    std::array<uint32_t, 3> indices = {Contents::Absent, Contents::Absent, Contents::Absent};
+                    size_t const defined[3] = {vertex, texture, normal};
+                    q = skip_blanks(q, chunk.end);
+                    for (size_t k = 0; k < 3U; k++) {
+                        int64_t index = 0;
+                        if (parse_integer(q, chunk.end, index)) {
+                            indices[k] = resolve(index, defined[k]);
+                        }
+                        if (q < chunk.end and *q == '/') {
+                            q++;
+                        } else {
+                            break;
+                        }
+                    }
+                    // move past anything left in the corner
+                    while (q < chunk.end and not is_blank(*q) and *q != '\n' and *q != '\r') {
+                        q++;
+                    }
+                    if (c == 0U) {
+                        first = indices;
+                    } else if (c >= 2U) {
+                        // fan out from the first corner
+                        Contents::Triangle& out = contents.triangles[triangle++];
+                        out.vertex = {first[0], previous[0], indices[0]};
+                        out.texture = {first[1], previous[1], indices[1]};
+                        out.normal = {first[2], previous[2], indices[2]};
+                    }
+                    previous = indices;
+                }
+                break;
+            }
+            case Line::Object:
+            case Line::Other:
+                break;
+        }
+    }
+}
+
+}  // namespace
+
+Contents load(std::string_view text) {
+    char const* const begin = text.data();
+    char const* const end = text.data() + text.size();
+#if defined(_OPENMP)
+    size_t const workers = static_cast<size_t>(omp_get_max_threads());
+#else
+    size_t const workers = 1U;
+#endif
+    // split into a few chunks per worker at line boundaries
+    size_t const wanted = std::max<size_t>(1U, std::min(workers * 4U, text.size() / minimum_chunk_size));
+    size_t const step = text.size() / wanted;
+    std::vector<Chunk> chunks;
+    chunks.reserve(wanted);
+    char const* p = begin;
+    for (size_t c = 0; c < wanted and p < end; c++) {
+        Chunk chunk;
+        chunk.begin = p;
+        chunk.end = (c + 1U == wanted) ? end : next_line(std::max(p, begin + (c + 1U) * step) - 1, end);
+        chunks.push_back(chunk);
+        p = chunk.end;
+    }
+    size_t const number_of_chunks = chunks.size();
+#pragma omp parallel for schedule(dynamic) if (number_of_chunks > 1U)
+    for (size_t c = 0; c < number_of_chunks; c++) {
+        count(chunks[c]);
+    }
+    // the prefix sums place each chunk's elements
+    Contents contents;
+    size_t vertices = 0U, normals = 0U, textures = 0U, triangles = 0U;
+    for (auto& chunk : chunks) {
+        chunk.first_vertex = vertices;
+        chunk.first_normal = normals;
+        chunk.first_texture = textures;
+        chunk.first_triangle = triangles;
+        vertices += chunk.counts.vertices;
+        normals += chunk.counts.normals;
+        textures += chunk.counts.textures;
+        triangles += chunk.triangles;
+        contents.statistics.object += chunk.counts.object;
+        contents.statistics.faces += chunk.counts.faces;
+    }
+    contents.statistics.vertices = vertices;
+    contents.statistics.normals = normals;
+    contents.statistics.textures = textures;
+    contents.vertices.resize(vertices);
+    contents.normals.resize(normals);
+    contents.textures.resize(textures);
+    contents.triangles.resize(triangles);
+#pragma omp parallel for schedule(dynamic) if (number_of_chunks > 1U)
+    for (size_t c = 0; c < number_of_chunks; c++) {
+        parse(chunks[c], contents);
+    }
+    return contents;
+}
+
+Contents load(char const* const filename) {
+    MappedFile file{filename};
+    return load(file.text());
+}
+
+}  // namespace obj
+}  // namespace raytrace
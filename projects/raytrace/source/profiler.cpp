@@ -0,0 +1,150 @@
+#include "raytrace/profiler.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+#include "basal/exception.hpp"
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+namespace raytrace {
+
+namespace {
+/// @return The intersection tests counted in the statistics
+size_t intersection_tests(statistics const& s) {
+    return s.intersections_with_objects + s.intersections_with_bounds;
+}
+}  // namespace
+
+void profiler::begin(size_t height, size_t width) {
+#if defined(_OPENMP)
+    size_t const number_of_threads = static_cast<size_t>(omp_get_max_threads());
+#else
+    size_t const number_of_threads = 1U;
+#endif
+    // every thread starts counting from zero
+    statistics::collect();
+    m_height = height;
+    m_width = width;
+    m_begin = clock::now();
+    m_tracks.resize(number_of_threads);
+    for (track& t : m_tracks) {
+        t.last = m_begin;
+        t.counted = statistics{};
+        t.tiles.clear();
+    }
+    m_costs.clear();
+}
+
+void profiler::record(tile const& region) {
+#if defined(_OPENMP)
+    size_t const thread = static_cast<size_t>(omp_get_thread_num());
+#else
+    size_t const thread = 0U;
+#endif
+    basal::exception::throw_unless(thread < m_tracks.size(), __FILE__, __LINE__, "Thread %zu was not expected", thread);
+    track& t = m_tracks[thread];
+    clock::time_point const now = clock::now();
+    statistics const& counted = statistics::local();
+    tile_cost cost;
+    cost.region = region;
+    cost.thread = thread;
+    cost.start_us = std::chrono::duration<double, std::micro>(t.last - m_begin).count();
+    cost.duration_us = std::chrono::duration<double, std::micro>(now - t.last).count();
+    cost.rays = counted.total_rays() - t.counted.total_rays();
+    cost.intersections = intersection_tests(counted) - intersection_tests(t.counted);
+    for (size_t d = 0; d < statistics::max_depth; d++) {
+        if (counted.traced_rays_at_depth[d] > t.counted.traced_rays_at_depth[d]) {
+            cost.depth = d;
+        }
+    }
+    t.tiles.push_back(cost);
+    t.last = now;
+    t.counted = counted;
+}
+
+void profiler::end() {
+    m_costs.clear();
+    for (track const& t : m_tracks) {
+        m_costs.insert(m_costs.end(), t.tiles.begin(), t.tiles.end());
+    }
+    std::sort(m_costs.begin(), m_costs.end(),
+              [](tile_cost const& a, tile_cost const& b) { return a.start_us < b.start_us; });
+}
+
+std::vector<profiler::tile_cost> const& profiler::costs() const {
+    return m_costs;
+}
+
+fourcc::image<fourcc::PixelFormat::RGBf> profiler::heatmap(Cost which) const {
+    fourcc::image<fourcc::PixelFormat::RGBf> output{m_height, m_width};
+    for (tile_cost const& cost : m_costs) {
+        double const pixels = static_cast<double>(cost.region.width * cost.region.height);
+        double value = 0.0;
+        switch (which) {
+            case Cost::Time:
+                value = cost.duration_us / pixels;
+                break;
+            case Cost::Rays:
+                value = static_cast<double>(cost.rays) / pixels;
+                break;
+            case Cost::Intersections:
+                value = static_cast<double>(cost.intersections) / pixels;
+                break;
+            case Cost::Depth:
+                value = static_cast<double>(cost.depth);
+                break;
+        }
+        for (size_t y = cost.region.y; y < (cost.region.y + cost.region.height); y++) {
+            for (size_t x = cost.region.x; x < (cost.region.x + cost.region.width); x++) {
+                fourcc::rgbf& pixel = output.at(y, x);
+                pixel.components.r = pixel.components.g = pixel.components.b = static_cast<float>(value);
+            }
+        }
+    }
+    return output;
+}
+
+void profiler::write_trace(std::ostream& os) const {
+    // the times are in microseconds, kept to the nanosecond
+    std::ios::fmtflags const flags = os.flags();
+    std::streamsize const digits = os.precision();
+    os << std::fixed << std::setprecision(3);
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    // name the track of each thread
+    for (size_t thread = 0; thread < m_tracks.size(); thread++) {
+        os << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread
+           << ",\"args\":{\"name\":\"worker " << thread << "\"}}";
+        first = false;
+    }
+    for (tile_cost const& cost : m_costs) {
+        os << (first ? "" : ",") << "\n{\"name\":\"tile " << cost.region.x << "," << cost.region.y << "\""
+           << ",\"cat\":\"render\",\"ph\":\"X\",\"ts\":" << cost.start_us << ",\"dur\":" << cost.duration_us
+           << ",\"pid\":0,\"tid\":" << cost.thread
+           << ",\"args\":{\"x\":" << cost.region.x << ",\"y\":" << cost.region.y << ",\"width\":" << cost.region.width
+           << ",\"height\":" << cost.region.height << ",\"rays\":" << cost.rays
+           << ",\"intersections\":" << cost.intersections << ",\"depth\":" << cost.depth << "}}";
+        first = false;
+    }
+    os << "\n]}\n";
+    os.flags(flags);
+    os.precision(digits);
+}
+
+bool profiler::save(std::string const& stem) const {
+    bool saved = heatmap(Cost::Time).save(stem + "_time.pfm");
+    saved = heatmap(Cost::Rays).save(stem + "_rays.pfm") and saved;
+    saved = heatmap(Cost::Intersections).save(stem + "_intersections.pfm") and saved;
+    saved = heatmap(Cost::Depth).save(stem + "_depth.pfm") and saved;
+    std::ofstream trace{stem + "_trace.json"};
+    if (trace) {
+        write_trace(trace);
+    }
+    return saved and trace.good();
+}
+
+}  // namespace raytrace
@@ -1,15 +1,82 @@
 #include "raytrace/scene.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <bitset>
 #include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 
 namespace raytrace {
 
-scene::scene(double art)
+namespace {
+/// Hands out a unique number for each scene generation so that the per thread caches can tell when they are stale
+size_t next_generation() {
+    static std::atomic<size_t> generation{0U};
+    return ++generation;
+}
+
+/// The last object to block a shadow ray toward each light. This is kept per thread so no locking is needed.
+struct OccluderCache {
+    size_t generation{0U};
+    std::vector<std::pair<lights::light const*, objects::object const*>> entries;
+
+    /// Finds the slot for the light, forgetting everything if the generation has changed.
+    /// @warning The reference is only valid until the next call.
+    objects::object const*& slot(size_t current_generation, lights::light const* light) {
+        if (generation != current_generation) {
+            generation = current_generation;
+            entries.clear();  // keeps the capacity
+        }
+        for (auto& entry : entries) {
+            if (entry.first == light) {
+                return entry.second;
+            }
+        }
+        entries.emplace_back(light, nullptr);
+        return entries.back().second;
+    }
+};
+
+thread_local OccluderCache occluder_cache;
+
+/// The first index of the values which decide russian roulette (after those which choose the lights)
+constexpr size_t roulette_stream{1U << 16U};
+
+/// Returns a value in [0, 1) which is decided by the point and the index, so that the choices made at a point (like
+/// which lights to sample) are spread out but are the same every time the point is rendered.
+precision sample_value(point const& p, size_t index) {
+    // splitmix64 of the bits of the coordinates and the index
+    auto mix = [](uint64_t z) -> uint64_t {
+        z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31U);
+    };
+    uint64_t h = mix(index + 0x9E3779B97F4A7C15ULL);
+    for (size_t a = 0; a < 3U; a++) {
+        h = mix(h ^ static_cast<uint64_t>(std::hash<precision>{}(p[a])));
+    }
+    // as many of the top bits as the precision holds exactly, as a fraction (so it never rounds up to 1)
+    constexpr int digits = std::numeric_limits<precision>::digits;
+    return static_cast<precision>(h >> (64 - digits)) * std::ldexp(1.0_p, -digits);
+}
+}  // namespace
+
+scene::scene(precision art)
     : adaptive_reflection_threshold{art}
     , m_objects{}
     , m_lights{}
     , m_background{[](raytrace::ray const&) { return colors::black; }}
     , m_media{&mediums::vacuum}  // default to a vacuum
+    , m_generation{next_generation()}
+    , m_tiling{}
+    , m_reflection_depth{0U}
+    , m_revision{0U}
+    , m_termination{Termination::Threshold}
+    , m_profiling{false}
+    , m_profiler{}
+    , m_accumulation{}
 {
 }
 
@@ -25,7 +92,10 @@ void scene::add_group(objects::group const* grp) {
 }
 
 void scene::add_object(objects::object const* obj) {
+    m_revision++;
     m_objects.push_back(obj);
+    // the hierarchy must be built again to include the object
+    m_hierarchy.clear();
     // compute the bounding box for the scene
     auto object_bounds = obj->get_world_bounds();
     if constexpr (debug::scene) {
@@ -47,18 +117,35 @@ void scene::add_object(objects::object const* obj) {
 }
 
 void scene::add_light(lights::light const* lit) {
+    m_revision++;
     m_lights.push_back(lit);
+    if (lit->falloff() == Falloff::None) {
+        m_distant_lights.push_back(lit);
+    } else {
+        m_local_lights.push_back(lit);
+    }
+    // the selection must be built again to include the light
+    m_light_selector.clear();
 }
 
 void scene::add_media(mediums::medium const* media) {
     if (media) {
+        m_revision++;
         m_media = media;
     }
 }
 
 void scene::clear() {
     m_objects.clear();
+    m_infinite_objects.clear();
+    m_bounds = Bounds{};
     m_lights.clear();
+    m_local_lights.clear();
+    m_distant_lights.clear();
+    m_light_selector.clear();
+    m_hierarchy.clear();
+    m_generation = next_generation();
+    m_revision++;
 }
 
 size_t scene::number_of_objects(void) const {
@@ -69,6 +156,10 @@ size_t scene::number_of_lights(void) const {
     return m_lights.size();
 }
 
+tree::BVH const& scene::hierarchy(void) const {
+    return m_hierarchy;
+}
+
 objects::hits scene::find_intersections(ray const& world_ray) {
     // find collisions (objects determine number of collisions) with the environment
     objects::hits hits;
@@ -81,16 +172,16 @@ objects::hits scene::find_intersections(ray const& world_ray) {
             }
             auto collision = objptr->intersect(world_ray);
             if (get_type(collision.intersect) != IntersectionType::None) {
-                statistics::get().intersections_with_objects++;
+                statistics::count(&statistics::intersections_with_objects);
             } else {
                 continue;  // skip this object as it didn't hit anything
             }
             if (get_type(collision.intersect) == IntersectionType::Point) {
-                statistics::get().intersections_with_point++;
+                statistics::count(&statistics::intersections_with_point);
             } else if (get_type(collision.intersect) == IntersectionType::Points) {
-                statistics::get().intersections_with_points++;
+                statistics::count(&statistics::intersections_with_points);
             } else if (get_type(collision.intersect) == IntersectionType::Line) {
-                statistics::get().intersections_with_line++;
+                statistics::count(&statistics::intersections_with_line);
             }
             hits.push_back(collision);
         }
@@ -102,38 +193,38 @@ objects::hits scene::find_intersections(ray const& world_ray) {
             }
             auto collision = objptr->intersect(world_ray);
             if (get_type(collision.intersect) != IntersectionType::None) {
-                statistics::get().intersections_with_objects++;
+                statistics::count(&statistics::intersections_with_objects);
             } else {
                 continue;  // skip this object as it didn't hit anything
             }
             if (get_type(collision.intersect) == IntersectionType::Point) {
-                statistics::get().intersections_with_point++;
+                statistics::count(&statistics::intersections_with_point);
             } else if (get_type(collision.intersect) == IntersectionType::Points) {
-                statistics::get().intersections_with_points++;
+                statistics::count(&statistics::intersections_with_points);
             } else if (get_type(collision.intersect) == IntersectionType::Line) {
-                statistics::get().intersections_with_line++;
+                statistics::count(&statistics::intersections_with_line);
             }
             hits.push_back(collision);
         }
-        auto fast_hits = m_nodes.front().intersects(world_ray);
-        // search for the intersection in the nodes of the tree.
+        auto fast_hits = m_hierarchy.intersects(world_ray);
+        // search for the intersection in the nodes of the hierarchy.
         for (auto& collision : fast_hits) {
             // each collision is a definite hit, but may not be the first hit.
             if (get_type(collision.intersect) != IntersectionType::None) {
-                statistics::get().intersections_with_objects++;
+                statistics::count(&statistics::intersections_with_objects);
             }
             if (get_type(collision.intersect) == IntersectionType::Point) {
-                statistics::get().intersections_with_point++;
+                statistics::count(&statistics::intersections_with_point);
             } else if (get_type(collision.intersect) == IntersectionType::Points) {
-                statistics::get().intersections_with_points++;
+                statistics::count(&statistics::intersections_with_points);
             } else if (get_type(collision.intersect) == IntersectionType::Line) {
-                statistics::get().intersections_with_line++;
+                statistics::count(&statistics::intersections_with_line);
             }
             hits.push_back(collision);
         }
     }
     if (hits.size() == 0) {
-        statistics::get().missed_rays++;
+        statistics::count(&statistics::missed_rays);
     }
     return hits;
 }
@@ -174,6 +265,159 @@ objects::hit scene::nearest_object(ray const& world_ray, objects::hits const& hi
     return closest_hit;
 }
 
+objects::hit scene::nearest_intersection(ray const& world_ray, precision max_distance) {
+    objects::hit_record record;
+    record.distance = max_distance;
+    if (m_objects.size() < brute_force_to_bounding_box) {
+        // for a low number of objects it's faster to check each one than to use the hierarchy
+        for (auto objptr : m_objects) {
+            if constexpr (enforce_contracts) {
+                basal::exception::throw_if(objptr == nullptr, __FILE__, __LINE__, "Object can't be nullptr");
+            }
+            tree::keep_nearest(world_ray, objptr, record);
+        }
+    } else {
+        // the infinite objects are checked first as they are likely to be hit and will shrink the range
+        for (auto objptr : m_infinite_objects) {
+            if constexpr (enforce_contracts) {
+                basal::exception::throw_if(objptr == nullptr, __FILE__, __LINE__, "Object can't be nullptr");
+            }
+            tree::keep_nearest(world_ray, objptr, record);
+        }
+        m_hierarchy.closest(world_ray, record);
+    }
+    if (record.object == nullptr) {
+        statistics::count(&statistics::missed_rays);
+        return objects::hit{};
+    }
+    // the point, normal and object of the nearest hit are only computed once the winner is known
+    return record.object->resolve(world_ray, record);
+}
+
+bool scene::occluded(ray const& world_ray, precision max_distance) {
+    objects::object const* last_occluder = nullptr;
+    return occluded(world_ray, max_distance, last_occluder);
+}
+
+bool scene::occluded(ray const& world_ray, precision max_distance, objects::object const*& last_occluder) {
+    // the last occluder of a light is very likely to block the next ray to the same light
+    if (last_occluder != nullptr and tree::blocks(world_ray, last_occluder, max_distance)) {
+        statistics::count(&statistics::occluder_cache_hits);
+        return true;
+    }
+    objects::object const* blocker = nullptr;
+    if (m_objects.size() < brute_force_to_bounding_box) {
+        for (auto objptr : m_objects) {
+            if (objptr != last_occluder and tree::blocks(world_ray, objptr, max_distance)) {
+                blocker = objptr;
+                break;
+            }
+        }
+    } else {
+        for (auto objptr : m_infinite_objects) {
+            if (objptr != last_occluder and tree::blocks(world_ray, objptr, max_distance)) {
+                blocker = objptr;
+                break;
+            }
+        }
+        if (blocker == nullptr) {
+            blocker = m_hierarchy.occluder(world_ray, max_distance, last_occluder);
+        }
+    }
+    if (blocker != nullptr) {
+        last_occluder = blocker;
+        return true;
+    }
+    return false;
+}
+
+void scene::nearest_intersection(ray_packet const& world_rays, tree::packet_hits& nearest) {
+    constexpr size_t W = ray_packet::width;
+    if (not world_rays.coherent()) {
+        // the rays go different ways through the hierarchy, so trace them one at a time
+        for (size_t lane = 0; lane < world_rays.count; lane++) {
+            nearest[lane] = nearest_intersection(world_rays.get(lane));
+        }
+        return;
+    }
+    uint32_t const active = (1U << world_rays.count) - 1U;
+    precision t_max[W];
+    for (size_t lane = 0; lane < W; lane++) {
+        nearest[lane] = objects::hit{};
+        t_max[lane] = std::numeric_limits<precision>::infinity();
+    }
+    object_list const& objects = (m_objects.size() < brute_force_to_bounding_box) ? m_objects : m_infinite_objects;
+    for (auto objptr : objects) {
+        if constexpr (enforce_contracts) {
+            basal::exception::throw_if(objptr == nullptr, __FILE__, __LINE__, "Object can't be nullptr");
+        }
+        tree::keep_nearest(world_rays, objptr, active, nearest, t_max);
+    }
+    if (m_objects.size() >= brute_force_to_bounding_box) {
+        m_hierarchy.closest(world_rays, active, nearest, t_max);
+    }
+    for (size_t lane = 0; lane < world_rays.count; lane++) {
+        if (nearest[lane].object != nullptr and get_type(nearest[lane].intersect) == IntersectionType::None) {
+            // the packet test only found the object and distance, the scalar test finds the point and normal
+            ray const world_ray = world_rays.get(lane);
+            nearest[lane] = nearest[lane].object->intersect(world_ray);
+            if (get_type(nearest[lane].intersect) != IntersectionType::Point) {
+                // the scalar test disagrees at the edge, so trust the scalar path entirely
+                nearest[lane] = nearest_intersection(world_ray);
+            }
+        } else if (get_type(nearest[lane].intersect) == IntersectionType::None) {
+            statistics::count(&statistics::missed_rays);
+        }
+    }
+}
+
+uint32_t scene::occluded(ray_packet const& world_rays, precision const (&max_distance)[ray_packet::width],
+                         objects::object const*& last_occluder) {
+    uint32_t blocked = 0U;
+    if (not world_rays.coherent()) {
+        for (size_t lane = 0; lane < world_rays.count; lane++) {
+            if (occluded(world_rays.get(lane), max_distance[lane], last_occluder)) {
+                blocked |= (1U << lane);
+            }
+        }
+        return blocked;
+    }
+    uint32_t active = (1U << world_rays.count) - 1U;
+    // the last occluder of a light is very likely to block the next rays to the same light
+    if (last_occluder != nullptr) {
+        blocked = tree::blocks(world_rays, last_occluder, active, max_distance);
+        statistics::count(&statistics::occluder_cache_hits, std::bitset<32>(blocked).count());
+        active &= ~blocked;
+    }
+    objects::object const* blockers[ray_packet::width] = {};
+    object_list const& objects = (m_objects.size() < brute_force_to_bounding_box) ? m_objects : m_infinite_objects;
+    for (auto objptr : objects) {
+        if (active == 0U) {
+            break;
+        }
+        if (objptr != last_occluder) {
+            uint32_t const hits = tree::blocks(world_rays, objptr, active, max_distance);
+            for (size_t lane = 0; lane < world_rays.count; lane++) {
+                if (hits & (1U << lane)) {
+                    blockers[lane] = objptr;
+                }
+            }
+            active &= ~hits;
+        }
+    }
+    if (active != 0U and m_objects.size() >= brute_force_to_bounding_box) {
+        active &= ~m_hierarchy.occluders(world_rays, active, max_distance, blockers);
+    }
+    // remember any new blocker for the next packet to the same light
+    for (size_t lane = 0; lane < world_rays.count; lane++) {
+        if (blockers[lane] != nullptr) {
+            blocked |= (1U << lane);
+            last_occluder = blockers[lane];
+        }
+    }
+    return blocked;
+}
+
 color scene::emissive_light(precision emissivity, mediums::medium const& medium,
                             raytrace::point const& object_surface_point) const {
     using namespace raytrace::operators;
@@ -182,13 +426,18 @@ color scene::emissive_light(precision emissivity, mediums::medium const& medium,
     return glow * emissivity;
 }
 
-color scene::direct_light(lights::light const& scene_light, mediums::medium const& medium,
-                          point const& world_surface_point, point const& object_surface_point,
-                          vector const& world_surface_normal, ray const& world_reflection, size_t sample_index,
-                          size_t reflection_depth, precision recursive_contribution) {
+color scene::emissive_light(precision emissivity, mediums::surface const& surface) const {
+    using namespace raytrace::operators;
+    return surface.emissive * emissivity;
+}
+
+color scene::direct_light(lights::light const& scene_light, mediums::surface const& surface,
+                          point const& world_surface_point, vector const& world_surface_normal,
+                          ray const& world_reflection, size_t sample_index, size_t reflection_depth,
+                          precision recursive_contribution, std::optional<bool> in_shadow) {
     using namespace raytrace::operators;
     color direct_color;  // defaults to black
-    statistics::get().sampled_rays++;
+    statistics::count(&statistics::sampled_rays);
     // get the ray to the light source (full magnitude)
     ray ray_to_light = scene_light.incident(world_surface_point, sample_index);
     // just the vector to the light from P
@@ -197,31 +446,19 @@ color scene::direct_light(lights::light const& scene_light, mediums::medium cons
     vector normalized_light_direction = light_direction.normalized();
     // construct a world ray from that point and normalized vector
     ray world_ray(world_surface_point, normalized_light_direction);
-    // is the light blocked by anything?
-    objects::hits blockers = find_intersections(world_ray);
-    // find the nearest object in the light path, which may include P (at/near zero)
-    // if the current object is blocking the light.
-    objects::hit blocker = nearest_object(world_ray, blockers);
-    // is this point in a shadow of this light?
-    // either there's no intersection to the light, or
-    // there is one but it's farther away than the light itself.
-    bool no_intersection = (get_type(blocker.intersect) == IntersectionType::None);
-    bool point_farther_than_light = false;
+    // is the light blocked by anything closer than the light itself?
+    if (not in_shadow.has_value()) {
+        objects::object const*& last_occluder = occluder_cache.slot(m_generation, &scene_light);
+        in_shadow = occluded(world_ray, light_direction.norm(), last_occluder);
+    }
     bool object_is_transparent = false;
     bool object_is_emissive = false;
-    if (get_type(blocker.intersect) == IntersectionType::Point) {
-        point_farther_than_light = (blocker.distance > light_direction.norm());
-        if (blocker.object != nullptr) {
-            auto other_world_point = as_point(blocker.intersect);
-            // FIXME is a refractive object so it must be transparent?
-            // object_is_transparent =
-            // (nearest.objptr->material().refractive_index(other_world_point) > 0.0_p);
-            // object_is_emissive = (nearest.objptr->material().emissive(other_world_point) > 0.0_p);
-        }
-    }
-    bool not_in_shadow = (no_intersection or point_farther_than_light or object_is_transparent or object_is_emissive);
+    // FIXME is a refractive object so it must be transparent?
+    // object_is_transparent = (blocker->material().refractive_index(other_world_point) > 0.0_p);
+    // object_is_emissive = (blocker->material().emissive(other_world_point) > 0.0_p);
+    bool not_in_shadow = (not in_shadow.value() or object_is_transparent or object_is_emissive);
     if (not_in_shadow) {
-        statistics::get().color_sampled_rays++;
+        statistics::count(&statistics::color_sampled_rays);
         // get the light color at this distance
         color raw_light_color = scene_light.color_at(world_surface_point);
         // the scaling at this point due to this light source's
@@ -233,13 +470,13 @@ color scene::direct_light(lights::light const& scene_light, mediums::medium cons
                                            "Incident Scaling must be within bounds");
         }
         color incident_light = (incident_scaling > 0.0_p) ? incident_scaling * raw_light_color : colors::black;
-        color diffuse_light = medium.diffuse(object_surface_point);
+        color const& diffuse_light = surface.diffuse;
         precision specular_scaling = dot(normalized_light_direction, world_reflection.direction());
         if constexpr (enforce_contracts) {
             basal::exception::throw_unless(within_inclusive(-1.0_p, specular_scaling, 1.0_p), __FILE__, __LINE__,
                                            "Specular Scaling must be within bounds");
         }
-        color specular_light = medium.specular(object_surface_point, specular_scaling, raw_light_color);
+        color specular_light = surface.specular(specular_scaling, raw_light_color);
         // blend the light color and the surface color together
         direct_color = (diffuse_light * incident_light);
         // don't use color + color as that "blends", use accumulate for specular light.
@@ -253,67 +490,127 @@ color scene::direct_light(lights::light const& scene_light, mediums::medium cons
             // // convenience reference
             // raytrace::mediums::medium const& mat = obj.material();
             // trace another ray through the object
-            direct_color += trace(world_ray, medium, reflection_depth - 1, recursive_contribution);
+            direct_color += trace(world_ray, *surface.source, reflection_depth - 1, recursive_contribution);
         }
     } else {
-        statistics::get().point_in_shadow++;
+        statistics::count(&statistics::point_in_shadow);
     }
     return direct_color;
 }
 
-color scene::reflected_light(precision reflectivity, mediums::medium const& medium, mediums::medium const& media,
-                             point const& world_surface_point, point const& object_surface_point,
-                             vector const& world_surface_normal, ray const& world_reflection, size_t reflection_depth,
-                             precision recursive_contribution) {
+color scene::reflected_light(precision reflectivity, mediums::surface const& surface, mediums::medium const& media,
+                             point const& world_surface_point, vector const& world_surface_normal,
+                             ray const& world_reflection, size_t reflection_depth, precision recursive_contribution) {
     using namespace raytrace::operators;
     color reflected_color;  // defaults to black
     // on the very last depth call we still have to return the surface color, just no more casts
     if (reflectivity > 0.0_p) {
         // find the *reflected* medium color from all lights (without blocked paths)
-        // The set of colors from each light source (including ambient)
-        std::vector<color> surface_colors;
+        // The sum of the colors from each light source, accumulated as each light is sampled so nothing is allocated
+        color surface_properties_color;
         // the medium starts at the ambient light from the scene
-        // surface_colors.push_back(medium.ambient(object_surface_point));
-        // surface_colors.push_back(m_ambient_light);
+        // surface_properties_color += medium.ambient(object_surface_point);
+        // surface_properties_color += m_ambient_light;
         // for each light in the scene... check the SHADOW rays!
-        statistics::get().shadow_rays++;
-        for (auto& light_ : m_lights) {
-            // convenience variable
-            lights::light const& scene_light = *light_;
-            // the samples for this light
-            std::vector<color> surface_color_samples(
-                scene_light.number_of_samples());  // should initialize to all black
-            // for each sample, get the color
-            for (size_t sample_index = 0; sample_index < scene_light.number_of_samples(); sample_index++) {
-                surface_color_samples[sample_index]
-                    = direct_light(scene_light, medium, world_surface_point, object_surface_point, world_surface_normal,
-                                   world_reflection, sample_index, reflection_depth, recursive_contribution);
+        statistics::count(&statistics::shadow_rays);
+        // adds the average of all the samples of the light
+        auto sample_every = [&](lights::light const& scene_light) {
+            // the running blend (linear average) of the samples of this light, in sample order
+            color surface_color;  // should initialize to black
+            precision const weight = 1.0_p / static_cast<precision>(scene_light.number_of_samples());
+            auto blend = [&](color sample) {
+                sample *= weight;
+                surface_color += sample;
+            };
+            if (use_ray_packets and scene_light.number_of_samples() > 1U) {
+                // the shadow rays from a point to the samples of an area light are coherent, so test them in packets
+                objects::object const*& last_occluder = occluder_cache.slot(m_generation, &scene_light);
+                for (size_t first = 0; first < scene_light.number_of_samples(); first += ray_packet::width) {
+                    ray_packet shadow_rays;
+                    precision max_distance[ray_packet::width] = {};
+                    size_t const last = std::min(first + ray_packet::width, scene_light.number_of_samples());
+                    for (size_t s = first; s < last; s++) {
+                        ray const ray_to_light = scene_light.incident(world_surface_point, s);
+                        max_distance[shadow_rays.count] = ray_to_light.direction().norm();
+                        shadow_rays.push(ray{world_surface_point, ray_to_light.direction().normalized()});
+                    }
+                    uint32_t const blocked = occluded(shadow_rays, max_distance, last_occluder);
+                    for (size_t lane = 0; lane < shadow_rays.count; lane++) {
+                        blend(direct_light(scene_light, surface, world_surface_point, world_surface_normal,
+                                           world_reflection, first + lane, reflection_depth, recursive_contribution,
+                                           (blocked & (1U << lane)) != 0U));
+                    }
+                }
+            } else {
+                // for each sample, get the color
+                for (size_t sample_index = 0; sample_index < scene_light.number_of_samples(); sample_index++) {
+                    blend(direct_light(scene_light, surface, world_surface_point, world_surface_normal,
+                                       world_reflection, sample_index, reflection_depth, recursive_contribution));
+                }
+            }
+            // now accumulate all the light sources together (not blended)
+            surface_properties_color += surface_color;
+        };
+        if (m_light_selector.size() > 0U and m_light_selector.size() == m_local_lights.size()) {
+            // a fixed number of single samples of the local lights, each chosen by its estimated contribution and
+            // weighted by the inverse of its chance of being chosen (so the expected color is the same as sampling
+            // every light)
+            for (size_t c = 0; c < light_selection_budget; c++) {
+                lights::selector::choice const pick = m_light_selector.choose(
+                    world_surface_point, world_surface_normal, sample_value(world_surface_point, 2U * c));
+                if (pick.chosen == nullptr) {
+                    break;  // every local light is behind the surface
+                }
+                size_t const samples = pick.chosen->number_of_samples();
+                size_t const sample_index = std::min(
+                    static_cast<size_t>(sample_value(world_surface_point, 2U * c + 1U) * precision(samples)),
+                    samples - 1U);
+                color sample = direct_light(*pick.chosen, surface, world_surface_point, world_surface_normal,
+                                            world_reflection, sample_index, reflection_depth, recursive_contribution);
+                sample *= 1.0_p / (precision(light_selection_budget) * pick.probability);
+                surface_properties_color += sample;
+            }
+            for (auto& light_ : m_distant_lights) {
+                sample_every(*light_);
+            }
+        } else {
+            for (auto& light_ : m_lights) {
+                sample_every(*light_);
             }
-            // blend (linearly) all the surface samples from this light (could be all black)
-            color surface_color = fourcc::color::blend_samples(surface_color_samples);
-            surface_colors.push_back(surface_color);
         }
-        // now accumulate all the light sources together (including ambient)
-        color surface_properties_color = fourcc::accumulate_samples(surface_colors);
 
         if (reflection_depth > 0) {
             // mix how much local surface color versus reflected surface there should be
-            precision smoothness = medium.smoothness(object_surface_point);
+            precision smoothness = surface.smoothness;
             if (smoothness > 0.0_p) {
+                // the chance the bounce is traced (zero if the path ends here)
+                precision survival = 1.0_p;
+                if (m_termination == Termination::RussianRoulette) {
+                    survival = roulette(world_surface_point, reflection_depth, recursive_contribution * smoothness, 0U);
+                } else if (recursive_contribution < adaptive_reflection_threshold) {
+                    survival = 0.0_p;
+                }
                 // should we continue bouncing given the contribution?
-                if (recursive_contribution < adaptive_reflection_threshold) {
+                if (survival <= 0.0_p) {
                     // count this as a save bounce (plus the rest we won't do)
-                    statistics::get().saved_ray_traces += reflection_depth;
-                    // just use the surface color
-                    reflected_color = surface_properties_color;
+                    statistics::count(&statistics::saved_ray_traces, reflection_depth);
+                    if (m_termination == Termination::RussianRoulette) {
+                        // the weighted survivors make up for the ended paths, so nothing is bounced here
+                        reflected_color = fourcc::linear::interpolate(colors::black, surface_properties_color,
+                                                                      smoothness);
+                    } else {
+                        // just use the surface color
+                        reflected_color = surface_properties_color;
+                    }
                 } else {  // only cast the ray if it's more than zero
                     // this ray was bounced off an object
-                    statistics::get().bounced_rays++;
+                    statistics::count(&statistics::bounced_rays);
 
                     // find out what the reflection adds to this
-                    color bounced_color = medium.bounced(
-                        world_surface_point,
-                        trace(world_reflection, media, reflection_depth - 1, recursive_contribution * smoothness));
+                    color incoming
+                        = trace(world_reflection, media, reflection_depth - 1, recursive_contribution * smoothness);
+                    incoming *= 1.0_p / survival;
+                    color bounced_color = surface.bounced(incoming);
 
                     // somehow interpolate the two based on how much of a smooth mirror this medium is.
                     reflected_color = fourcc::linear::interpolate(bounced_color, surface_properties_color, smoothness);
@@ -334,28 +631,44 @@ color scene::reflected_light(precision reflectivity, mediums::medium const& medi
 color scene::transmitted_light(precision transparency, mediums::medium const& medium, ray const& world_refraction,
                                size_t reflection_depth, precision recursive_contribution) {
     if (reflection_depth > 0 and transparency > 0.0_p and not world_refraction.direction().is_zero()) {
+        // the chance the transmission is traced (zero if the path ends here)
+        precision const survival
+            = (m_termination == Termination::RussianRoulette)
+                  ? roulette(world_refraction.location(), reflection_depth, recursive_contribution * transparency, 1U)
+                  : 1.0_p;
+        if (survival <= 0.0_p) {
+            statistics::count(&statistics::saved_ray_traces, reflection_depth);
+            return colors::black;
+        }
         // this ray was transmitted through the new medium
-        statistics::get().transmitted_rays++;
+        statistics::count(&statistics::transmitted_rays);
         // get the colors from the transmitted light
         // diminish the recursive contribution by the transparency (similar to smoothness for reflections)
         // TODO improve this mechanism to account for more realistic effects.
-        return trace(world_refraction, medium, reflection_depth - 1, recursive_contribution * transparency);
+        color transmitted
+            = trace(world_refraction, medium, reflection_depth - 1, recursive_contribution * transparency);
+        transmitted *= 1.0_p / survival;
+        return transmitted;
     }
     return colors::black;
 }
 
 color scene::trace(ray const& world_ray, mediums::medium const& media, size_t reflection_depth,
                    precision recursive_contribution) {
+    // find the closest intersection object
+    return trace(world_ray, nearest_intersection(world_ray), media, reflection_depth, recursive_contribution);
+}
+
+color scene::trace(ray const& world_ray, objects::hit const& nearest, mediums::medium const& media,
+                   size_t reflection_depth, precision recursive_contribution) {
     using namespace operators;
 
     // this will store the final traced value for this call.
     color traced_color;
 
-    // finds all the intersections with the objects
-    objects::hits hits = find_intersections(world_ray);
-
-    // find the closest intersection object
-    objects::hit nearest = nearest_object(world_ray, hits);
+    // the depth counts up from the camera (0) while the reflection depth counts down
+    statistics::count_trace(m_reflection_depth > reflection_depth ? m_reflection_depth - reflection_depth : 0U,
+                            get_type(nearest.intersect) != IntersectionType::Point);
 
     // if it was a point...
     if (get_type(nearest.intersect) == IntersectionType::Point) {
@@ -376,14 +689,18 @@ color scene::trace(ray const& world_ray, mediums::medium const& media, size_t re
         }
         // if this is true, we've collided with something from the inside or the "backside"
         bool inside_out = (dot(world_surface_normal, world_ray.direction()) > 0);
-        raytrace::statistics::get().inside_out_intersections += (inside_out ? 1 : 0);
+        raytrace::statistics::count(&raytrace::statistics::inside_out_intersections, inside_out ? 1U : 0U);
+
+        // every property of the medium at the point at once
+        mediums::surface const surface = medium.evaluate(object_surface_point);
+        // the refractive index of the medium the ray is in
+        precision const media_refractive_index = media.refractive_index(object_surface_point);
 
         // compute the reflection vector
         ray world_reflection = obj.reflection(world_ray, world_surface_normal, world_surface_point);
         // compute the refracted vector
         ray world_refraction = obj.refraction(world_ray, world_surface_normal, world_surface_point,
-                                              media.refractive_index(object_surface_point),
-                                              medium.refractive_index(object_surface_point));
+                                              media_refractive_index, surface.refractive_index);
         if constexpr (enforce_contracts) {
             basal::exception::throw_if(dot(world_ray.direction(), world_refraction.direction()) < 0, __FILE__, __LINE__,
                                        "Refracted ray should not be opposites");
@@ -409,15 +726,15 @@ color scene::trace(ray const& world_ray, mediums::medium const& media, size_t re
 
         // get the light scalar components, emission, reflection and refraction given the environment
         /// @internal (diffraction, phosphorescence and fluorescence are not computed, yet)
-        medium.radiosity(object_surface_point, media.refractive_index(object_surface_point), incident_angle,
-                         transmitted_angle, emissivity, reflectivity, transparency);
+        surface.radiosity(media_refractive_index, incident_angle, transmitted_angle, emissivity, reflectivity,
+                          transparency);
 
         // ======================================================
-        emitted_color = emissive_light(emissivity, medium, object_surface_point);
+        emitted_color = emissive_light(emissivity, surface);
         // ======================================================
         reflected_color
-            = reflected_light(reflectivity, medium, media, world_surface_point, object_surface_point,
-                              world_surface_normal, world_reflection, reflection_depth, recursive_contribution);
+            = reflected_light(reflectivity, surface, media, world_surface_point, world_surface_normal,
+                              world_reflection, reflection_depth, recursive_contribution);
         // ======================================================
         transmitted_color
             = transmitted_light(transparency, medium, world_refraction, reflection_depth, recursive_contribution);
@@ -435,76 +752,105 @@ color scene::trace(ray const& world_ray, mediums::medium const& media, size_t re
     return traced_color;
 }
 
-void scene::render(camera& view, std::string filename, size_t number_of_samples, size_t reflection_depth,
-                   std::optional<image::rendered_line> row_notifier, uint8_t aaa_mask_threshold, bool filter_capture,
-                   bool tone_mapper) {
-    bool adaptive_antialiasing = aaa_mask_threshold != raytrace::image::AAA_MASK_DISABLED;
-    if constexpr (debug::camera) {
-        view.print(std::cout, "Camera Info:\n");
-    }
-    if constexpr (debug::tree) {
-        std::cout << "Number of Nodes: " << m_nodes.size() << std::endl;
-    }
-    // create the tree here as it can't be done in the add_object method correctly
-    if (m_nodes.size() == 0U) {
-        // creates a Node in the list with the given bounds
-        m_nodes.emplace_back(m_bounds);
-        if constexpr (debug::tree) {
-            std::cout << "Outer: " << m_bounds << std::endl;
-        }
-        // insert everything from the objects list into the nodes if it is not in the infinite list.
-        size_t items{0UL};
+void scene::prepare(size_t reflection_depth) {
+    // create the hierarchy here as it can't be done in the add_object method correctly
+    // any cached objects from a previous render may no longer be in the scene
+    m_generation = next_generation();
+    m_reflection_depth = reflection_depth;
+    if (m_hierarchy.empty()) {
+        // insert everything from the objects list into the hierarchy if it is not in the infinite list.
+        object_list finite_objects;
         for (auto const* obj : m_objects) {
             if (std::find(m_infinite_objects.begin(), m_infinite_objects.end(), obj) == m_infinite_objects.end()) {
-                m_nodes.back().add_object(obj);
-                items++;
+                finite_objects.push_back(obj);
             }
         }
+        m_hierarchy.build(finite_objects);
+        if constexpr (debug::bounds) {
+            print_bounds(std::cout);
+        }
         if constexpr (debug::tree) {
-            std::cout << "Added " << items << " items" << std::endl;
-            std::cout << "Nodes think there are " << m_nodes.back().all_object_count() << " items" << std::endl;
+            std::cout << "Outer: " << m_bounds << std::endl;
+            std::cout << "Added " << finite_objects.size() << " items" << std::endl;
         }
     }
+    if (m_local_lights.size() >= light_selection_threshold and m_light_selector.size() != m_local_lights.size()) {
+        m_light_selector.build(m_local_lights);
+    }
+}
+
+precision scene::roulette(point const& world_surface_point, size_t reflection_depth, precision contribution,
+                          size_t stream) const {
+    // the depth of the next ray from the camera
+    size_t const depth = (m_reflection_depth > reflection_depth ? m_reflection_depth - reflection_depth : 0U) + 1U;
+    if (depth <= russian_roulette_depth) {
+        return 1.0_p;
+    }
+    // contributions only shrink along a path, but the chance is kept from being so small that survivors are outliers
+    precision const survival = std::clamp(contribution, russian_roulette_survival, 1.0_p);
+    bool const survived = sample_value(world_surface_point, roulette_stream + stream) < survival;
+    statistics::count_roulette(depth, survived);
+    return survived ? survival : 0.0_p;
+}
+
+image::packet_subsampler scene::tracer(camera& view, size_t reflection_depth) {
+    return [this, &view, reflection_depth](image::point const* points, color* colors, size_t count) {
+        // create the rays at each point in the image along the vector
+        // from the image plane along the camera ray.
+        ray_packet world_rays;
+        for (size_t i = 0; i < count; i++) {
+            world_rays.push(view.cast(points[i]));
+        }
+        // neighboring camera rays are coherent so find their nearest hits together
+        tree::packet_hits nearest;
+        nearest_intersection(world_rays, nearest);
+        for (size_t i = 0; i < count; i++) {
+            // trace the ray out to the world, starting from a vacuum
+            colors[i] = trace(world_rays.get(i), nearest[i], *m_media, reflection_depth);
+            // Ensure our color spaces are correct for the renderer (should be in linear space)
+            basal::exception::throw_unless(colors[i].GetEncoding() == fourcc::Encoding::Linear, __FILE__, __LINE__,
+                                           "Color should be in linear space");
+        }
+    };
+}
 
+void scene::render(camera& view, std::string filename, size_t number_of_samples, size_t reflection_depth,
+                   std::optional<image::rendered_tile> tile_notifier, uint8_t aaa_mask_threshold, bool filter_capture,
+                   bool tone_mapper) {
+    bool adaptive_antialiasing = aaa_mask_threshold != raytrace::image::AAA_MASK_DISABLED;
+    if constexpr (debug::camera) {
+        view.print(std::cout, "Camera Info:\n");
+    }
+    auto const start = std::chrono::steady_clock::now();
+    prepare(reflection_depth);
     if constexpr (debug::render) {
         std::cout << "Rendering with " << number_of_samples << " samples and reflection depth of " << reflection_depth
                   << std::endl
                   << std::flush;
     }
-
-    auto tracer = [&](image::point const& pnt) -> color {
-        // create the ray at each point in the image along the vector
-        // from the image plane along the camera ray.
-        ray world_ray = view.cast(pnt);
-
-        // trace the ray out to the world, starting from a vacuum
-        color c = trace(world_ray, *m_media, reflection_depth);
-        // Ensure our color spaces are correct for the renderer (should be in linear space)
-        basal::exception::throw_unless(c.GetEncoding() == fourcc::Encoding::Linear, __FILE__, __LINE__,
-                                       "Color should be in linear space");
-        return c;
-    };
-    // if we're doing adaptive anti-aliasing we only shoot 1 ray at first and then compute a contrast mask
-    // later
-    view.capture.generate_each(tracer, adaptive_antialiasing ? 1 : number_of_samples, row_notifier, &view.mask,
-                               image::AAA_MASK_DISABLED, tone_mapper);
-
-    // if the threshold is not disabled, then compute the extra pixels based on the mask
-    if (aaa_mask_threshold < image::AAA_MASK_DISABLED) {
-        // reset all rendered lines
-        if (row_notifier != std::nullopt) {
-            image::rendered_line func = row_notifier.value();
-            for (size_t y = 0; y < view.capture.height; y++) {
-                func(y, false);
+    image::packet_subsampler const camera_tracer = tracer(view, reflection_depth);
+    size_t const lanes = use_ray_packets ? ray_packet::width : 1U;
+    if (m_profiling) {
+        // each tile is charged by the thread which rendered it as it is done, then passed on
+        m_profiler.begin(view.capture.height, view.capture.width);
+        tile_notifier = [this, notifier = tile_notifier](tile const& region, bool completed) {
+            m_profiler.record(region);
+            if (notifier != std::nullopt) {
+                notifier.value()(region, completed);
             }
-        }
-        // create the sRGB image
-        fourcc::image<fourcc::PixelFormat::RGB8> first_srgb_image{view.capture.height, view.capture.width};
-        fourcc::convert(view.capture, first_srgb_image);
-        // compute the mask
-        fourcc::sobel_mask(first_srgb_image, view.mask);
-        // update the image based on the mask
-        view.capture.generate_each(tracer, number_of_samples, row_notifier, &view.mask, aaa_mask_threshold);
+        };
+    }
+    if (adaptive_antialiasing) {
+        // each pixel takes as many samples as it needs (up to the number of samples) and the mask shows how many
+        precision const tolerance = static_cast<precision>(aaa_mask_threshold) / 255.0_p;
+        view.capture.generate_adaptive(camera_tracer, lanes, number_of_samples, tolerance, &view.mask,
+                                       tile_notifier, tone_mapper, m_tiling);
+    } else {
+        view.capture.generate_each(camera_tracer, lanes, number_of_samples, tile_notifier, nullptr,
+                                   image::AAA_MASK_DISABLED, tone_mapper, m_tiling);
+    }
+    if (m_profiling) {
+        m_profiler.end();
     }
 
     // if we want to filter the image before viewing or saving, do that here.
@@ -519,7 +865,60 @@ void scene::render(camera& view, std::string filename, size_t number_of_samples,
     if (not filename.empty()) {
         // This will save based on the file extension
         view.capture.save(filename);
+        if (adaptive_antialiasing) {
+            // the heatmap of the samples of each pixel goes next to it
+            view.mask.save(filename.substr(0, filename.find_last_of('.')) + "_samples.pgm");
+        }
+        if (m_profiling) {
+            // the costs go next to it too
+            m_profiler.save(filename.substr(0, filename.find_last_of('.')));
+        }
     }
+
+    // merge the per thread counters (with the time in this thread's) now that the rendering threads are idle
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+    statistics::local().render_seconds += elapsed.count();
+    statistics::collect();
+}
+
+size_t scene::render_pass(camera& view, size_t reflection_depth, std::optional<image::rendered_tile> tile_notifier,
+                          bool tone_mapper) {
+    auto const start = std::chrono::steady_clock::now();
+    size_t const pixels = view.capture.height * view.capture.width;
+    accumulation& acc = m_accumulation;
+    // any change to what would be seen starts over
+    if (acc.view != &view or acc.sums.size() != pixels or acc.from != view.position() or acc.at != view.at()
+        or not(acc.intrinsics == view.intrinsics()) or acc.reflection_depth != reflection_depth
+        or acc.revision != m_revision) {
+        acc.view = &view;
+        acc.from = view.position();
+        acc.at = view.at();
+        acc.intrinsics = view.intrinsics();
+        acc.reflection_depth = reflection_depth;
+        acc.revision = m_revision;
+        acc.sums.assign(pixels, color{});
+        acc.passes = 0U;
+    }
+    prepare(reflection_depth);
+    size_t const lanes = use_ray_packets ? ray_packet::width : 1U;
+    view.capture.accumulate_each(tracer(view, reflection_depth), lanes, acc.sums, acc.passes, tile_notifier,
+                                 tone_mapper, m_tiling);
+    acc.passes++;
+
+    // merge the per thread counters (with the time in this thread's) now that the rendering threads are idle
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+    statistics::local().render_seconds += elapsed.count();
+    statistics::collect();
+    return acc.passes;
+}
+
+void scene::reset_accumulation() {
+    m_accumulation.view = nullptr;
+    m_accumulation.passes = 0U;
+}
+
+size_t scene::accumulated_passes(void) const {
+    return m_accumulation.passes;
 }
 
 void scene::print(std::ostream& os, char const str[]) const {
@@ -532,24 +931,69 @@ void scene::print(std::ostream& os, char const str[]) const {
     }
 }
 
+void scene::print_bounds(std::ostream& os) const {
+    precision radial_total = 0.0_p;
+    precision tight_total = 0.0_p;
+    for (size_t i = 0; i < m_objects.size(); i++) {
+        objects::object const* obj = m_objects[i];
+        precision const radial = obj->get_radial_world_bounds().volume();
+        precision const tight = obj->get_world_bounds().volume();
+        os << "Object " << i << " type " << basal::to_underlying(obj->get_type()) << " radial volume " << radial
+           << " tight volume " << tight;
+        if (std::isfinite(radial) and std::isfinite(tight)) {
+            os << " (" << (100.0_p * tight / radial) << "%)";
+            radial_total += radial;
+            tight_total += tight;
+        }
+        os << std::endl;
+    }
+    os << "Finite objects: radial volume " << radial_total << " tight volume " << tight_total << std::endl;
+}
+
 std::ostream& operator<<(std::ostream& os, scene const& sc) {
     os << "Scene: " << std::endl;
     os << "  Objects: " << sc.number_of_objects() << std::endl;
     os << "  Lights: " << sc.number_of_lights() << std::endl;
     os << "  Outer: " << sc.m_bounds << std::endl;
+    os << "  " << sc.m_hierarchy << std::endl;
     os << "  Media: " << (sc.m_media ? "Some" : "none") << std::endl;
     return os;
 }
 
 void scene::set_background_mapper(background_mapper mapper) {
     if (mapper) {
+        m_revision++;
         m_background = mapper;
     }
 }
 
+void scene::set_tiling(tiling const& layout) {
+    basal::exception::throw_if(layout.width == 0U or layout.height == 0U, __FILE__, __LINE__,
+                               "Tiles must not be empty");
+    m_tiling = layout;
+}
+
+void scene::set_termination(Termination mode) {
+    m_revision++;
+    m_termination = mode;
+}
+
+Termination scene::termination(void) const {
+    return m_termination;
+}
+
+void scene::set_profiling(bool enable) {
+    m_profiling = enable;
+}
+
+profiler const& scene::profile(void) const {
+    return m_profiler;
+}
+
 void scene::set_ambient_light(color ambient) {
     using fourcc::operators::operator*;
     // use the intensity channel as the brightness value for the light
+    m_revision++;
     m_ambient_light = ambient;
     m_ambient_light *= ambient.intensity();
 }
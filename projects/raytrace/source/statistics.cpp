@@ -0,0 +1,143 @@
+#include "raytrace/statistics.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace raytrace {
+
+namespace {
+
+/// Keeps track of every thread's block so they can be merged. The lock is only taken when a thread first counts, when
+/// it exits and when collecting, never while counting.
+struct Registry {
+    std::mutex mutex;
+    statistics totals;
+    std::vector<statistics*> active;
+    std::vector<statistics*> spare;
+    std::vector<std::unique_ptr<statistics>> storage;
+};
+
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+/// Owns a block for the lifetime of a thread. When the thread exits the counts are merged and the block is reused.
+struct Holder {
+    statistics* block{nullptr};
+
+    Holder() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        if (r.spare.empty()) {
+            r.storage.emplace_back(std::make_unique<statistics>());
+            block = r.storage.back().get();
+        } else {
+            block = r.spare.back();
+            r.spare.pop_back();
+        }
+        r.active.push_back(block);
+    }
+
+    ~Holder() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.totals += *block;
+        *block = statistics{};
+        r.active.erase(std::remove(r.active.begin(), r.active.end(), block), r.active.end());
+        r.spare.push_back(block);
+    }
+};
+
+}  // namespace
+
+statistics& statistics::operator+=(statistics const& other) {
+    cast_rays_from_camera += other.cast_rays_from_camera;
+    intersections_with_objects += other.intersections_with_objects;
+    intersections_with_point += other.intersections_with_point;
+    intersections_with_points += other.intersections_with_points;
+    intersections_with_line += other.intersections_with_line;
+    intersections_with_bounds += other.intersections_with_bounds;
+    inside_out_intersections += other.inside_out_intersections;
+    missed_rays += other.missed_rays;
+    bounced_rays += other.bounced_rays;
+    transmitted_rays += other.transmitted_rays;
+    saved_ray_traces += other.saved_ray_traces;
+    shadow_rays += other.shadow_rays;
+    sampled_rays += other.sampled_rays;
+    color_sampled_rays += other.color_sampled_rays;
+    point_in_shadow += other.point_in_shadow;
+    occluder_cache_hits += other.occluder_cache_hits;
+    absorbed_rays += other.absorbed_rays;
+    emitted_rays += other.emitted_rays;
+    for (size_t d = 0; d < max_depth; d++) {
+        traced_rays_at_depth[d] += other.traced_rays_at_depth[d];
+        missed_rays_at_depth[d] += other.missed_rays_at_depth[d];
+        roulette_rays_at_depth[d] += other.roulette_rays_at_depth[d];
+        survived_rays_at_depth[d] += other.survived_rays_at_depth[d];
+    }
+    render_seconds += other.render_seconds;
+    return *this;
+}
+
+size_t statistics::total_rays() const {
+    return cast_rays_from_camera + bounced_rays + transmitted_rays + sampled_rays;
+}
+
+double statistics::rays_per_second() const {
+    return render_seconds > 0.0 ? static_cast<double>(total_rays()) / render_seconds : 0.0;
+}
+
+statistics& statistics::local() {
+    thread_local Holder holder;
+    return *holder.block;
+}
+
+void statistics::collect() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (statistics* block : r.active) {
+        r.totals += *block;
+        *block = statistics{};
+    }
+}
+
+statistics statistics::get() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    return r.totals;
+}
+
+std::ostream& operator<<(std::ostream& os, statistics const& s) {
+    os << "Statistics:" << std::endl;
+    os << "  Camera Rays: " << s.cast_rays_from_camera << " Bounced: " << s.bounced_rays
+       << " Transmitted: " << s.transmitted_rays << " Sampled: " << s.sampled_rays << " Missed: " << s.missed_rays
+       << std::endl;
+    os << "  Intersections: " << s.intersections_with_objects << " (point " << s.intersections_with_point
+       << ", points " << s.intersections_with_points << ", line " << s.intersections_with_line << ") Bounds: "
+       << s.intersections_with_bounds << std::endl;
+    os << "  Shadow: " << s.shadow_rays << " In Shadow: " << s.point_in_shadow
+       << " Occluder Cache Hits: " << s.occluder_cache_hits << " Saved: " << s.saved_ray_traces << std::endl;
+    os << "  Rays: " << s.total_rays() << " in " << s.render_seconds << " sec = " << s.rays_per_second()
+       << " rays/sec" << std::endl;
+    os << "  Depth: traced/missed";
+    for (size_t d = 0; d < statistics::max_depth; d++) {
+        if (s.traced_rays_at_depth[d] > 0U) {
+            os << " [" << d << "] " << s.traced_rays_at_depth[d] << "/" << s.missed_rays_at_depth[d];
+        }
+    }
+    os << std::endl;
+    bool played = false;
+    for (size_t d = 0; d < statistics::max_depth; d++) {
+        if (s.roulette_rays_at_depth[d] > 0U) {
+            os << (played ? "" : "  Roulette: survived/played") << " [" << d << "] " << s.survived_rays_at_depth[d]
+               << "/" << s.roulette_rays_at_depth[d];
+            played = true;
+        }
+    }
+    return played ? (os << std::endl) : os;
+}
+
+}  // namespace raytrace
@@ -4,7 +4,7 @@
 namespace raytrace {
 
 stereo_camera::stereo_camera(size_t image_height, size_t image_width, iso::degrees field_of_view,
-                             double camera_separation, Layout layout)
+                             precision camera_separation, Layout layout)
     : m_separation{camera_separation}
     , m_toe_in{0u}
     , m_layout{layout}
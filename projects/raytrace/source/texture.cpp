@@ -0,0 +1,258 @@
+#include "raytrace/texture.hpp"
+
+#include <algorithm>
+#include <basal/exception.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+namespace raytrace {
+
+namespace {
+/// The first bytes of a texture file
+struct TextureHeader {
+    char magic[8];        //!< Identifies the file as a texture
+    uint32_t version;     //!< The @ref texture_version which wrote the file
+    uint32_t endian;      //!< Written as @ref texture_endian, so a texture from a different byte order is ignored
+    uint32_t address;     //!< The @ref Address of the lookups
+    uint32_t reserved;    //!< Zero
+    uint64_t resolution;  //!< The width and height of the largest level
+    uint64_t key;         //!< The number of bytes of the key, which follows the header (then the texels)
+};
+
+constexpr char texture_magic[8] = {'R', 'T', 'T', 'E', 'X', '\0', '\0', '\0'};
+constexpr uint32_t texture_version{2U};
+constexpr uint32_t texture_endian{0x01020304U};
+
+inline bool is_power_of_two(size_t value) {
+    return value > 0U and (value & (value - 1U)) == 0U;
+}
+
+/// @return The coordinate wrapped into [0, 1)
+inline precision wrap(precision value) {
+    return value - std::floor(value);
+}
+
+/// @return The index wrapped into [0, size)
+inline size_t wrap(int64_t index, size_t size) {
+    int64_t const n = static_cast<int64_t>(size);
+    return static_cast<size_t>(((index % n) + n) % n);
+}
+
+/// @return The coordinate wrapped or clamped into [0, 1]
+inline precision addressed(precision value, Address mode) {
+    return (mode == Address::Wrap) ? wrap(value) : std::clamp(value, 0.0_p, 1.0_p);
+}
+
+/// @return The index wrapped or clamped into [0, size)
+inline size_t addressed(int64_t index, size_t size, Address mode) {
+    if (mode == Address::Wrap) {
+        return wrap(index, size);
+    }
+    return static_cast<size_t>(std::clamp(index, int64_t{0}, static_cast<int64_t>(size) - 1));
+}
+}  // namespace
+
+texture::texture(size_t resolution, pattern const& func, Address address)
+    : m_levels{}, m_resolution{resolution}, m_address{address} {
+    basal::exception::throw_unless(is_power_of_two(resolution), __FILE__, __LINE__,
+                                   "The resolution %zu must be a power of two", resolution);
+    m_levels.emplace_back(resolution * resolution);
+    std::vector<fourcc::rgbf>& texels = m_levels.front();
+    precision const size = static_cast<precision>(resolution);
+    // the rows are independent so the (expensive) pattern is sampled in parallel
+#pragma omp parallel for schedule(dynamic)
+    for (size_t y = 0; y < resolution; y++) {
+        for (size_t x = 0; x < resolution; x++) {
+            image::point const texture_point{(static_cast<precision>(x) + 0.5_p) / size,
+                                             (static_cast<precision>(y) + 0.5_p) / size};
+            color const c = func(texture_point);
+            fourcc::rgbf& texel = texels[y * resolution + x];
+            texel.components.r = static_cast<float>(c.red());
+            texel.components.g = static_cast<float>(c.green());
+            texel.components.b = static_cast<float>(c.blue());
+        }
+    }
+    build_levels();
+}
+
+void texture::build_levels() {
+    m_levels.resize(1U);
+    for (size_t size = m_resolution / 2U; size > 0U; size /= 2U) {
+        std::vector<fourcc::rgbf> const& above = m_levels.back();
+        size_t const stride = size * 2U;
+        std::vector<fourcc::rgbf> level(size * size);
+        for (size_t y = 0; y < size; y++) {
+            for (size_t x = 0; x < size; x++) {
+                fourcc::rgbf const* const texels[] = {
+                    &above[(2U * y) * stride + (2U * x)], &above[(2U * y) * stride + (2U * x) + 1U],
+                    &above[(2U * y + 1U) * stride + (2U * x)], &above[(2U * y + 1U) * stride + (2U * x) + 1U]};
+                for (size_t c = 0; c < fourcc::rgbf::channel_count; c++) {
+                    level[y * size + x].channels[c] = 0.25f * (texels[0]->channels[c] + texels[1]->channels[c]
+                                                               + texels[2]->channels[c] + texels[3]->channels[c]);
+                }
+            }
+        }
+        m_levels.push_back(std::move(level));
+    }
+}
+
+size_t texture::resolution() const {
+    return m_resolution;
+}
+
+size_t texture::levels() const {
+    return m_levels.size();
+}
+
+Address texture::address() const {
+    return m_address;
+}
+
+fourcc::rgbf const& texture::at(size_t level, size_t y, size_t x) const {
+    size_t const size = m_resolution >> level;
+    return m_levels[level][y * size + x];
+}
+
+void texture::bilinear(size_t level, precision u, precision v, float (&rgb)[3]) const {
+    size_t const size = m_resolution >> level;
+    // the texel centers are at the halves
+    precision const x = u * static_cast<precision>(size) - 0.5_p;
+    precision const y = v * static_cast<precision>(size) - 0.5_p;
+    precision const fx = std::floor(x);
+    precision const fy = std::floor(y);
+    float const ax = static_cast<float>(x - fx);
+    float const ay = static_cast<float>(y - fy);
+    size_t const x0 = addressed(static_cast<int64_t>(fx), size, m_address);
+    size_t const x1 = addressed(static_cast<int64_t>(fx) + 1, size, m_address);
+    size_t const y0 = addressed(static_cast<int64_t>(fy), size, m_address);
+    size_t const y1 = addressed(static_cast<int64_t>(fy) + 1, size, m_address);
+    std::vector<fourcc::rgbf> const& texels = m_levels[level];
+    fourcc::rgbf const& t00 = texels[y0 * size + x0];
+    fourcc::rgbf const& t01 = texels[y0 * size + x1];
+    fourcc::rgbf const& t10 = texels[y1 * size + x0];
+    fourcc::rgbf const& t11 = texels[y1 * size + x1];
+    for (size_t c = 0; c < fourcc::rgbf::channel_count; c++) {
+        float const top = t00.channels[c] + ax * (t01.channels[c] - t00.channels[c]);
+        float const bottom = t10.channels[c] + ax * (t11.channels[c] - t10.channels[c]);
+        rgb[c] = top + ay * (bottom - top);
+    }
+}
+
+color texture::sample(image::point const& texture_point, Filter filter, precision footprint) const {
+    precision const u = addressed(texture_point.x(), m_address);
+    precision const v = addressed(texture_point.y(), m_address);
+    precision const size = static_cast<precision>(m_resolution);
+    float rgb[3] = {0.0f, 0.0f, 0.0f};
+    switch (filter) {
+        case Filter::Nearest: {
+            size_t const x = std::min(static_cast<size_t>(u * size), m_resolution - 1U);
+            size_t const y = std::min(static_cast<size_t>(v * size), m_resolution - 1U);
+            fourcc::rgbf const& texel = m_levels.front()[y * m_resolution + x];
+            return color{texel.components.r, texel.components.g, texel.components.b};
+        }
+        case Filter::Bilinear:
+            bilinear(0U, u, v, rgb);
+            break;
+        case Filter::Trilinear: {
+            // the level where a texel is as large as the footprint
+            precision const texels = footprint * size;
+            precision const last = static_cast<precision>(m_levels.size() - 1U);
+            precision const level = (texels > 1.0_p) ? std::min(std::log2(texels), last) : 0.0_p;
+            precision const lower = std::floor(level);
+            size_t const l0 = static_cast<size_t>(lower);
+            bilinear(l0, u, v, rgb);
+            float const t = static_cast<float>(level - lower);
+            if (t > 0.0f) {
+                float coarse[3];
+                bilinear(l0 + 1U, u, v, coarse);
+                for (size_t c = 0; c < 3U; c++) {
+                    rgb[c] += t * (coarse[c] - rgb[c]);
+                }
+            }
+            break;
+        }
+    }
+    return color{rgb[0], rgb[1], rgb[2]};
+}
+
+bool texture::save(std::string const& filename, std::string const& key) const {
+    TextureHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, texture_magic, sizeof(texture_magic));
+    header.version = texture_version;
+    header.endian = texture_endian;
+    header.address = static_cast<uint32_t>(m_address);
+    header.resolution = m_resolution;
+    header.key = key.size();
+    // write to the side and rename so a reader never loads a partial file
+    std::string const partial = filename + ".partial";
+    FILE* file = fopen(partial.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    std::vector<fourcc::rgbf> const& texels = m_levels.front();
+    bool written = fwrite(&header, sizeof(header), 1U, file) == 1U;
+    written = written and fwrite(key.data(), 1U, key.size(), file) == key.size();
+    written = written and fwrite(texels.data(), sizeof(fourcc::rgbf), texels.size(), file) == texels.size();
+    written = (fclose(file) == 0) and written;
+    std::error_code error;
+    if (written) {
+        std::filesystem::rename(partial, filename, error);
+    }
+    if (not written or error) {
+        std::filesystem::remove(partial, error);
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<texture const> texture::load(std::string const& filename, std::string const& key) {
+    std::error_code error;
+    if (not std::filesystem::is_regular_file(filename, error)) {
+        return nullptr;
+    }
+    uint64_t const file_size = std::filesystem::file_size(filename, error);
+    if (error) {
+        return nullptr;
+    }
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (file == nullptr) {
+        return nullptr;
+    }
+    std::shared_ptr<texture> baked{new texture()};
+    TextureHeader header;
+    bool read = fread(&header, sizeof(header), 1U, file) == 1U;
+    read = read and std::memcmp(header.magic, texture_magic, sizeof(texture_magic)) == 0
+           and header.version == texture_version and header.endian == texture_endian
+           and header.address <= static_cast<uint32_t>(Address::Clamp) and is_power_of_two(header.resolution)
+           and header.key == key.size() and file_size >= sizeof(header) + key.size();
+    if (read) {
+        // the texels must fill the rest of the file exactly, which is checked by division so a damaged resolution
+        // can not overflow (or ask for more memory than the file holds)
+        uint64_t const texel_bytes = file_size - sizeof(header) - key.size();
+        uint64_t const texels = texel_bytes / sizeof(fourcc::rgbf);
+        read = (texel_bytes % sizeof(fourcc::rgbf)) == 0U and header.resolution <= texels
+               and texels / header.resolution == header.resolution and (texels % header.resolution) == 0U;
+    }
+    if (read) {
+        std::string stored(key.size(), '\0');
+        read = fread(stored.data(), 1U, stored.size(), file) == stored.size() and stored == key;
+    }
+    if (read) {
+        baked->m_resolution = header.resolution;
+        baked->m_address = static_cast<Address>(header.address);
+        baked->m_levels.emplace_back(header.resolution * header.resolution);
+        std::vector<fourcc::rgbf>& texels = baked->m_levels.front();
+        read = fread(texels.data(), sizeof(fourcc::rgbf), texels.size(), file) == texels.size();
+    }
+    fclose(file);
+    if (not read) {
+        return nullptr;
+    }
+    baked->build_levels();
+    return baked;
+}
+
+}  // namespace raytrace
@@ -0,0 +1,146 @@
+#include "raytrace/tiles.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "basal/exception.hpp"
+
+namespace raytrace {
+
+namespace {
+/// Spreads the lower 32 bits of the value out to the even bits
+uint64_t spread_bits(uint64_t v) {
+    v &= 0x00000000FFFFFFFFULL;
+    v = (v | (v << 16)) & 0x0000FFFF0000FFFFULL;
+    v = (v | (v << 8)) & 0x00FF00FF00FF00FFULL;
+    v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    v = (v | (v << 2)) & 0x3333333333333333ULL;
+    v = (v | (v << 1)) & 0x5555555555555555ULL;
+    return v;
+}
+
+/// The Z-order curve index of the tile column and row
+uint64_t morton(size_t column, size_t row) {
+    return spread_bits(column) | (spread_bits(row) << 1);
+}
+}  // namespace
+
+std::vector<tile> make_tiles(size_t image_height, size_t image_width, tiling const& layout) {
+    basal::exception::throw_if(layout.width == 0U or layout.height == 0U, __FILE__, __LINE__,
+                               "Tiles must not be empty");
+    size_t const columns = (image_width + layout.width - 1U) / layout.width;
+    size_t const rows = (image_height + layout.height - 1U) / layout.height;
+    std::vector<tile> tiles;
+    tiles.reserve(columns * rows);
+    for (size_t r = 0; r < rows; r++) {
+        for (size_t c = 0; c < columns; c++) {
+            size_t const x = c * layout.width;
+            size_t const y = r * layout.height;
+            tiles.push_back(
+                tile{x, y, std::min(layout.width, image_width - x), std::min(layout.height, image_height - y)});
+        }
+    }
+    auto column_of = [&](tile const& t) { return t.x / layout.width; };
+    auto row_of = [&](tile const& t) { return t.y / layout.height; };
+    if (layout.order == TileOrder::Morton) {
+        std::stable_sort(tiles.begin(), tiles.end(), [&](tile const& a, tile const& b) {
+            return morton(column_of(a), row_of(a)) < morton(column_of(b), row_of(b));
+        });
+    } else if (layout.order == TileOrder::Spiral) {
+        // rings of tiles around the center, each ring walked by angle
+        double const center_column = (static_cast<double>(columns) - 1.0) * 0.5;
+        double const center_row = (static_cast<double>(rows) - 1.0) * 0.5;
+        auto ring = [&](tile const& t) {
+            double const dx = std::abs(static_cast<double>(column_of(t)) - center_column);
+            double const dy = std::abs(static_cast<double>(row_of(t)) - center_row);
+            return std::floor(std::max(dx, dy));
+        };
+        auto angle = [&](tile const& t) {
+            return std::atan2(static_cast<double>(row_of(t)) - center_row,
+                              static_cast<double>(column_of(t)) - center_column);
+        };
+        std::stable_sort(tiles.begin(), tiles.end(), [&](tile const& a, tile const& b) {
+            double const ra = ring(a);
+            double const rb = ring(b);
+            return (ra < rb) or (ra == rb and angle(a) < angle(b));
+        });
+    }
+    return tiles;
+}
+
+tile_scheduler::tile_scheduler(std::vector<tile> const& tiles, size_t number_of_workers) : m_queues{} {
+    basal::exception::throw_if(number_of_workers == 0U, __FILE__, __LINE__, "Must have at least one worker");
+    for (size_t w = 0; w < number_of_workers; w++) {
+        m_queues.emplace_back(std::make_unique<queue>());
+    }
+    for (size_t i = 0; i < tiles.size(); i++) {
+        m_queues[i % number_of_workers]->tiles.push_back(tiles[i]);
+    }
+}
+
+bool tile_scheduler::next(size_t worker, tile& out) {
+    {
+        queue& own = *m_queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (not own.tiles.empty()) {
+            out = own.tiles.front();
+            own.tiles.pop_front();
+            return true;
+        }
+    }
+    // steal the last tile of the next busy worker, starting with the neighbor to spread out the thieves
+    for (size_t offset = 1; offset < m_queues.size(); offset++) {
+        queue& victim = *m_queues[(worker + offset) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (not victim.tiles.empty()) {
+            out = victim.tiles.back();
+            victim.tiles.pop_back();
+            victim.steals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t tile_scheduler::steals() const {
+    size_t count = 0U;
+    for (auto const& q : m_queues) {
+        std::lock_guard<std::mutex> lock(q->mutex);
+        count += q->steals;
+    }
+    return count;
+}
+
+line_progress::line_progress(size_t image_height, size_t image_width)
+    : m_mutex{}, m_finished(image_height, 0U), m_width{image_width} {
+}
+
+void line_progress::update(tile const& region, bool completed) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t y = region.y; y < (region.y + region.height) and y < m_finished.size(); y++) {
+        if (completed) {
+            m_finished[y] += region.width;
+        } else {
+            // only this tile's pixels are un-counted, the other tiles on the line are still finished
+            m_finished[y] -= std::min(m_finished[y], region.width);
+        }
+    }
+}
+
+bool line_progress::is_complete(size_t line) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_finished[line] >= m_width;
+}
+
+size_t line_progress::complete_lines() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<size_t>(
+        std::count_if(m_finished.begin(), m_finished.end(), [this](size_t finished) { return finished >= m_width; }));
+}
+
+size_t line_progress::lines() const {
+    return m_finished.size();
+}
+
+}  // namespace raytrace
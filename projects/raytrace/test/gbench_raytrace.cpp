@@ -1,3 +1,7 @@
+#include <omp.h>
+
+#include <string>
+
 #include "benchmark/benchmark.h"
 #include <raytrace/raytrace.hpp>
 
@@ -38,4 +42,22 @@ static void BM_CylinderIntersections(benchmark::State& state) {
 }
 BENCHMARK(BM_CylinderIntersections);
 
-BENCHMARK_MAIN();
\ No newline at end of file
+#ifndef RAYTRACE_BUILD_TYPE
+#define RAYTRACE_BUILD_TYPE "unknown"
+#endif
+
+int main(int argc, char** argv) {
+    // recorded in the context of the results so a comparison to a baseline from another kind of build is refused
+    benchmark::AddCustomContext("raytrace_build_type", RAYTRACE_BUILD_TYPE);
+    benchmark::AddCustomContext("raytrace_precision", basal::use_high_precision ? "double" : "float");
+    // the renders are spread over this many threads (OMP_NUM_THREADS), the raytrace-benchmark target uses one so the
+    // results of machines with different numbers of CPUs can be compared
+    benchmark::AddCustomContext("raytrace_threads", std::to_string(omp_get_max_threads()));
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
\ No newline at end of file
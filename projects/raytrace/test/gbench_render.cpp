@@ -0,0 +1,170 @@
+#include <sys/resource.h>
+
+#include <basal/module.hpp>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <raytrace/objects/model.hpp>
+#include <raytrace/raytrace.hpp>
+
+#include "benchmark/benchmark.h"
+#include "world.hpp"
+
+/// @file
+/// Benchmarks whole renders of some of the demo worlds (loaded from their modules like the demos do) and of a large
+/// OBJ model. Each reports the rays and shadow rays per second (from the @ref raytrace::statistics of the renders), the
+/// time to build the scene hierarchy and the peak memory of the process. The raytrace-benchmark target writes these as
+/// JSON and compares them to the checked in baseline (test/gbench_raytrace_baseline.json).
+
+using namespace raytrace;
+
+namespace {
+
+/// The reflection depth of every render (the default of the demos)
+constexpr size_t render_depth{4U};
+
+/// Exposes the preparation of the scene so the build of the hierarchy is timed apart from the render
+class timed_scene : public scene {
+public:
+    using scene::prepare;
+};
+
+/// @return The peak resident memory of the process in MiB (it never goes down, so later benchmarks include earlier)
+double peak_memory_mb() {
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);  // bytes
+#else
+    return static_cast<double>(usage.ru_maxrss) / 1024.0;  // kibibytes
+#endif
+}
+
+/// Renders a new scene each iteration (at the height, width and number of samples from the arguments) and sets the
+/// counters from the statistics of the renders. Only the renders are timed.
+void measure(benchmark::State& state, std::function<void(scene&)> const& populate, point const& from,
+             point const& at) {
+    size_t const height = static_cast<size_t>(state.range(0));
+    size_t const width = static_cast<size_t>(state.range(1));
+    size_t const samples = static_cast<size_t>(state.range(2));
+    camera view{height, width, iso::degrees(55)};
+    view.move_to(from, at);
+    double build_seconds = 0.0;
+    raytrace::statistics totals;
+    for (auto _ : state) {
+        state.PauseTiming();
+        timed_scene renderer;
+        populate(renderer);
+        auto const start = std::chrono::steady_clock::now();
+        renderer.prepare(render_depth);
+        build_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        raytrace::statistics::collect();
+        raytrace::statistics const before = raytrace::statistics::get();
+        state.ResumeTiming();
+
+        renderer.render(view, std::string{}, samples, render_depth);
+
+        state.PauseTiming();
+        raytrace::statistics const& after = raytrace::statistics::get();
+        totals.cast_rays_from_camera += after.cast_rays_from_camera - before.cast_rays_from_camera;
+        totals.bounced_rays += after.bounced_rays - before.bounced_rays;
+        totals.transmitted_rays += after.transmitted_rays - before.transmitted_rays;
+        totals.sampled_rays += after.sampled_rays - before.sampled_rays;
+        totals.render_seconds += after.render_seconds - before.render_seconds;
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * height * width * samples));
+    state.counters["rays_per_second"] = totals.rays_per_second();
+    state.counters["shadow_rays_per_second"]
+        = totals.render_seconds > 0.0 ? static_cast<double>(totals.sampled_rays) / totals.render_seconds : 0.0;
+    state.counters["bvh_build_ms"] = benchmark::Counter(build_seconds * 1000.0, benchmark::Counter::kAvgIterations);
+    state.counters["peak_memory_mb"] = peak_memory_mb();
+}
+
+/// The sizes of the renders as {height, width, samples}
+void render_sizes(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"height", "width", "samples"});
+    bench->Args({120, 160, 1});
+    bench->Args({240, 320, 2});
+    bench->Unit(benchmark::kMillisecond)->UseRealTime();
+}
+
+/// Writes a bumpy torus of 2 x rings x segments triangles as an OBJ file, so the benchmark does not need a model to be
+/// downloaded. The bumps keep the triangles from all lying in a few planes.
+void write_model(std::filesystem::path const& path, size_t rings, size_t segments) {
+    std::ofstream file{path};
+    constexpr double major = 3.0;
+    constexpr double minor = 1.0;
+    for (size_t r = 0; r < rings; r++) {
+        double const u = 2.0 * M_PI * static_cast<double>(r) / static_cast<double>(rings);
+        for (size_t s = 0; s < segments; s++) {
+            double const v = 2.0 * M_PI * static_cast<double>(s) / static_cast<double>(segments);
+            double const tube = minor * (1.0 + 0.05 * std::sin(9.0 * u) * std::cos(7.0 * v));
+            double const ring = major + (tube * std::cos(v));
+            file << "v " << ring * std::cos(u) << " " << ring * std::sin(u) << " " << tube * std::sin(v) << "\n";
+        }
+    }
+    // the indices (from 1) wrap around both ways
+    auto index = [&](size_t r, size_t s) { return ((r % rings) * segments) + (s % segments) + 1U; };
+    for (size_t r = 0; r < rings; r++) {
+        for (size_t s = 0; s < segments; s++) {
+            file << "f " << index(r, s) << " " << index(r + 1U, s) << " " << index(r + 1U, s + 1U) << "\n";
+            file << "f " << index(r, s) << " " << index(r + 1U, s + 1U) << " " << index(r, s + 1U) << "\n";
+        }
+    }
+}
+
+}  // namespace
+
+// Renders a demo world from its module
+static void BM_RenderWorld(benchmark::State& state, char const* name) {
+    basal::module mod(name);
+    if (not mod.is_loaded()) {
+        state.SkipWithError("Could not load the world module (is it on the library path?)");
+        return;
+    }
+    auto get_world = mod.get_symbol<world_getter>("get_world");
+    world& demo = *get_world();
+    measure(
+        state,
+        [&](scene& renderer) {
+            renderer.set_background_mapper(std::bind(&world::background, &demo, std::placeholders::_1));
+            demo.add_to(renderer);
+            renderer.set_ambient_light(demo.ambient());
+        },
+        demo.looking_from(), demo.looking_at());
+}
+BENCHMARK_CAPTURE(BM_RenderWorld, example, "world_example")->Apply(render_sizes);
+BENCHMARK_CAPTURE(BM_RenderWorld, spheres, "world_spheres")->Apply(render_sizes);
+BENCHMARK_CAPTURE(BM_RenderWorld, glass, "world_glass")->Apply(render_sizes);
+BENCHMARK_CAPTURE(BM_RenderWorld, cornell, "world_cornell")->Apply(render_sizes);
+
+// Renders a large OBJ model (about a quarter million triangles) on a floor
+static void BM_RenderModel(benchmark::State& state) {
+    std::filesystem::path const path = std::filesystem::temp_directory_path() / "gbench_raytrace_model.obj";
+    std::filesystem::path const cache = path.string() + objects::Model::CacheSuffix;
+    write_model(path, 256U, 512U);
+    std::filesystem::remove(cache);  // so the load parses the file and builds the mesh hierarchy
+    objects::Model model;
+    auto const start = std::chrono::steady_clock::now();
+    model.LoadFromFile(path.string().c_str());
+    double const load_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    objects::plane floor{point{0, 0, -1}, R3::identity};
+    lights::speck light{point{5, -5, 10}, colors::white, lights::intensities::radiant};
+    lights::beam sunlight{vector{{1, 1, -1}}, colors::white, lights::intensities::dim};
+    measure(
+        state,
+        [&](scene& renderer) {
+            renderer.add_object(&model);
+            renderer.add_object(&floor);
+            renderer.add_light(&light);
+            renderer.add_light(&sunlight);
+        },
+        point{0, -10, 6}, point{0, 0, 0});
+    state.counters["model_load_ms"] = load_seconds * 1000.0;
+    std::filesystem::remove(path);
+    std::filesystem::remove(cache);
+}
+BENCHMARK(BM_RenderModel)->Apply(render_sizes);
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <raytrace/raytrace.hpp>
+
+#include "raytrace/gtest_helper.hpp"
+#include "world.hpp"
+
+/// @file
+/// Counts the heap allocations of a render by replacing the global allocation functions, so it is built as its own test
+/// program with the example world linked in.
+
+namespace {
+std::atomic<bool> counting{false};
+std::atomic<size_t> allocations{0U};
+
+void* allocate(std::size_t size) {
+    if (counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1U, std::memory_order_relaxed);
+    }
+    void* pointer = std::malloc(size == 0U ? 1U : size);
+    if (pointer == nullptr) {
+        throw std::bad_alloc{};
+    }
+    return pointer;
+}
+
+void* allocate(std::size_t size, std::align_val_t alignment) {
+    if (counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1U, std::memory_order_relaxed);
+    }
+    std::size_t const align = static_cast<std::size_t>(alignment);
+    void* pointer = std::aligned_alloc(align, ((size + align - 1U) / align) * align);
+    if (pointer == nullptr) {
+        throw std::bad_alloc{};
+    }
+    return pointer;
+}
+}  // namespace
+
+void* operator new(std::size_t size) {
+    return allocate(size);
+}
+void* operator new[](std::size_t size) {
+    return allocate(size);
+}
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate(size, alignment);
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocate(size, alignment);
+}
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+void operator delete[](void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+using namespace raytrace;
+
+class AllocationTest : public ::testing::Test {
+public:
+    void SetUp() override {
+        world& example = *get_world();
+        example.add_to(scene_);
+        scene_.set_ambient_light(example.ambient());
+        view_.move_to(example.looking_from(), example.looking_at());
+        // the first render builds the hierarchy and the per thread buffers
+        scene_.render(view_, std::string{}, 1U, depth);
+    }
+
+    /// Renders the example world and returns the number of allocations it made
+    size_t render(size_t number_of_samples) {
+        allocations = 0U;
+        counting = true;
+        scene_.render(view_, std::string{}, number_of_samples, depth);
+        counting = false;
+        return allocations;
+    }
+
+    static constexpr size_t height{60U};
+    static constexpr size_t width{80U};
+    static constexpr size_t depth{4U};
+    scene scene_;
+    camera view_{height, width, iso::degrees(55)};
+};
+
+TEST_F(AllocationTest, WorldExampleDoesNotAllocatePerRay) {
+    size_t const single = render(1U);
+    size_t const many = render(8U);
+    std::cout << "Allocations with 1 sample " << single << " with 8 samples " << many << std::endl;
+    // the tiles and per thread buffers are allocated per render, never per ray (far fewer than the camera rays)
+    EXPECT_LT(single, height * width / 4U);
+    EXPECT_LE(many, single);
+}
+
+TEST(OverlapAllocationTest, NestedOverlapsDoNotAllocate) {
+    // the shape of the desk toy world, an overlap of an overlap
+    objects::cuboid box{R3::origin, 8, 8, 2};
+    objects::sphere cutout{point{0, 0, 4}, 4};
+    objects::overlap block{box, cutout, objects::overlap::type::subtractive};
+    objects::sphere rounder{point{0, 0, -15}, 20};
+    objects::overlap shape{block, rounder, objects::overlap::type::inclusive};
+    size_t found = 0U;
+    allocations = 0U;
+    counting = true;
+    for (int y = -10; y <= 10; y++) {
+        for (int x = -10; x <= 10; x++) {
+            ray const r{point{0, 0, 20}, vector{{0.05_p * x, 0.05_p * y, -1.0_p}}.normalized()};
+            found += (get_type(shape.intersect(r).intersect) == geometry::IntersectionType::Point) ? 1U : 0U;
+        }
+    }
+    counting = false;
+    EXPECT_GT(found, 0U);
+    EXPECT_EQ(0U, allocations.load());
+}
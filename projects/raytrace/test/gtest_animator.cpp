@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <filesystem>
+#include <fstream>
 #include <raytrace/raytrace.hpp>
 
 #include "geometry/gtest_helper.hpp"
@@ -69,4 +71,55 @@ TEST(AnimatorTest, Default) {
     EXPECT_POINT_EQ(cam.at, raytrace::point(0, 0, -10));
     EXPECT_EQ(cam.fov, 45.0_deg);
     EXPECT_FALSE(animator);
-}
\ No newline at end of file
+}
+
+TEST(AnimatorTest, BatchRendersARangeOfFrames) {
+    std::vector<raytrace::animation::Anchor> anchors;
+    anchors.push_back(raytrace::animation::Anchor{
+        raytrace::animation::Attributes{raytrace::point(0, 10, 10), raytrace::point(0, 0, 0), 55.0_deg},
+        raytrace::animation::Attributes{raytrace::point(10, 0, 10), raytrace::point(0, 0, -10), 45.0_deg},
+        raytrace::animation::Mappers{}, iso::seconds(1.0_p)});
+    raytrace::objects::sphere ball{raytrace::point{0, 0, 0}, 2};
+    raytrace::lights::speck light{raytrace::point{0, 0, 20}, colors::white, 1E3};
+    raytrace::scene scene;
+    scene.add_object(&ball);
+    scene.add_light(&light);
+    std::string const prefix = (std::filesystem::temp_directory_path() / "gtest_batch_").string();
+    animation::Batch::Settings settings;
+    settings.height = 24U;
+    settings.width = 32U;
+    settings.prefix = prefix;
+    settings.first = 2U;
+    settings.last = 5U;
+    settings.queue_depth = 1U;
+    animation::Batch batch{scene, settings};
+    EXPECT_EQ(prefix + "0003.ppm", batch.filename(3U));
+    std::vector<size_t> rendered;
+    auto animator = animation::Animator{10.0_p, anchors};
+    EXPECT_EQ(3U, batch.render(animator, [&](size_t frame, raytrace::camera const&) { rendered.push_back(frame); }));
+    EXPECT_EQ((std::vector<size_t>{2U, 3U, 4U}), rendered);
+    EXPECT_TRUE(animator);  // the rest of the animation is left for another batch
+    for (size_t frame : {1U, 5U}) {
+        EXPECT_FALSE(std::filesystem::exists(batch.filename(frame))) << frame;
+    }
+    // each saved frame is the same as a render of that frame which is saved right away
+    auto replay = animation::Animator{10.0_p, anchors};
+    for (size_t frame = 0U; frame < settings.last; frame++) {
+        auto const cam = replay();
+        if (frame < settings.first) {
+            continue;
+        }
+        raytrace::camera view{settings.height, settings.width, cam.fov};
+        view.move_to(cam.from, cam.at);
+        std::string const expected = prefix + "expected.ppm";
+        scene.render(view, expected, settings.number_of_samples, settings.reflection_depth);
+        std::ifstream a{batch.filename(frame), std::ios::binary};
+        std::ifstream b{expected, std::ios::binary};
+        std::string const saved{std::istreambuf_iterator<char>{a}, std::istreambuf_iterator<char>{}};
+        std::string const direct{std::istreambuf_iterator<char>{b}, std::istreambuf_iterator<char>{}};
+        EXPECT_FALSE(saved.empty());
+        EXPECT_TRUE(saved == direct) << "frame " << frame;
+        std::filesystem::remove(batch.filename(frame));
+        std::filesystem::remove(expected);
+    }
+}
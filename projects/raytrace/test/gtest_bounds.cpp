@@ -149,3 +149,62 @@ TEST(BoundsTest, EveryAngle) {
         ASSERT_TRUE(bounds.intersects(R)) << "Ray: " << R << " Outside: " << bounds;
     }
 }
+
+TEST(BoundsTest, Volume) {
+    EXPECT_DOUBLE_EQ(24.0_p, (raytrace::Bounds{raytrace::point(-1, 0, 1), raytrace::point(1, 3, 5)}.volume()));
+    EXPECT_TRUE(std::isinf(raytrace::Bounds{}.volume()));
+}
+
+TEST(BoundsTest, TightObjectBounds) {
+    using namespace raytrace;
+    // a long thin cylinder is much smaller than the cube around its extent
+    objects::cylinder rod{point{1, 2, 3}, 10.0_p, 0.5_p};
+    Bounds bounds = rod.get_world_bounds();
+    EXPECT_NEAR(-0.5_p + 1.0_p, bounds.min.x(), 1E-5);
+    EXPECT_NEAR(0.5_p + 2.0_p, bounds.max.y(), 1E-5);
+    EXPECT_NEAR(10.0_p + 3.0_p, bounds.max.z(), 1E-5);
+    EXPECT_LT(bounds.volume(), 0.1_p * rod.get_radial_world_bounds().volume());
+
+    // a rotated cuboid covers its rotated corners
+    objects::cuboid box{point{0, 0, 0}, 2.0_p, 1.0_p, 0.5_p};
+    box.rotation(iso::degrees{0}, iso::degrees{0}, iso::degrees{90});
+    bounds = box.get_world_bounds();
+    EXPECT_NEAR(-1.0_p, bounds.min.x(), 1E-5);
+    EXPECT_NEAR(2.0_p, bounds.max.y(), 1E-5);
+    EXPECT_NEAR(0.5_p, bounds.max.z(), 1E-5);
+
+    // the scale is included
+    objects::sphere ball{point{0, 0, 0}, 1.0_p};
+    ball.scale(3.0_p, 1.0_p, 1.0_p);
+    bounds = ball.get_world_bounds();
+    EXPECT_NEAR(3.0_p, bounds.max.x(), 1E-5);
+    EXPECT_NEAR(1.0_p, bounds.max.y(), 1E-5);
+
+    // flat objects get a little thickness (the bounds all have a little slack)
+    objects::square tile{point{0, 0, 4}, R3::identity, 2.0_p};
+    bounds = tile.get_world_bounds();
+    EXPECT_NEAR(1.0_p, bounds.max.x(), 1E-5);
+    EXPECT_LT(bounds.min.z(), 4.0_p);
+    EXPECT_GT(bounds.max.z(), 4.0_p);
+    EXPECT_LT(bounds.max.z() - bounds.min.z(), 1E-5);
+
+    // infinite objects stay infinite
+    objects::plane ground{point{0, 0, 0}, R3::identity};
+    EXPECT_TRUE(ground.get_world_bounds().is_infinite());
+}
+
+TEST(BoundsTest, SlackFollowsTheTransformTerms) {
+    using namespace raytrace;
+    // the lower side of each box is near zero but is the sum of terms near 100, which round like 100 does
+    for (size_t d = 1; d < 90; d += 7) {
+        precision const theta = static_cast<precision>(d) * iso::pi / 180.0_p;
+        long double const reach = 100.0L * (std::cos(static_cast<long double>(theta))
+                                            + std::sin(static_cast<long double>(theta)));
+        objects::cuboid box{point{static_cast<precision>(reach), 0, 0}, 100.0_p, 100.0_p, 1.0_p};
+        box.rotation(iso::radians{0}, iso::radians{0}, iso::radians{theta});
+        Bounds const bounds = box.get_world_bounds();
+        long double const lower = static_cast<long double>(box.position().x()) - reach;
+        EXPECT_LT(static_cast<long double>(bounds.min.x()), lower) << d << " degrees";
+        EXPECT_NEAR(lower, bounds.min.x(), 1E-3) << d << " degrees";
+    }
+}
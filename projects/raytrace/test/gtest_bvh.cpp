@@ -0,0 +1,251 @@
+#include "basal/gtest_helper.hpp"
+
+#include <basal/basal.hpp>
+#include <raytrace/raytrace.hpp>
+#include <vector>
+
+#include "geometry/gtest_helper.hpp"
+#include "linalg/gtest_helper.hpp"
+#include "raytrace/gtest_helper.hpp"
+
+using namespace raytrace;
+using namespace geometry::operators;
+
+class BVHTest : public ::testing::Test {
+public:
+    void SetUp() override {
+        for (size_t z = 0; z < 4; z++) {
+            for (size_t y = 0; y < 4; y++) {
+                for (size_t x = 0; x < 4; x++) {
+                    raytrace::point center{3.0_p * x, 3.0_p * y, 3.0_p * z};
+                    spheres.emplace_back(center, 1.0_p);
+                }
+            }
+        }
+        for (auto& s : spheres) {
+            list.push_back(&s);
+        }
+    }
+
+    std::vector<objects::sphere> spheres;
+    tree::BVH::object_list list;
+};
+
+TEST_F(BVHTest, Empty) {
+    tree::BVH bvh;
+    EXPECT_TRUE(bvh.empty());
+    bvh.build(tree::BVH::object_list{});
+    EXPECT_TRUE(bvh.empty());
+    EXPECT_EQ(0U, bvh.node_count());
+    raytrace::ray r{raytrace::point{0, 0, 0}, R3::basis::X};
+    EXPECT_EQ(0U, bvh.intersects(r).size());
+}
+
+TEST_F(BVHTest, Structure) {
+    tree::BVH bvh;
+    bvh.build(list);
+    ASSERT_FALSE(bvh.empty());
+    EXPECT_EQ(list.size(), bvh.object_count());
+    EXPECT_LE(bvh.node_count(), 2U * list.size() - 1U);
+    EXPECT_LE(bvh.depth(), tree::BVH::MaxDepth);
+    // every object is in exactly one leaf and every child is contained in its parent
+    std::vector<size_t> counts(list.size(), 0U);
+    auto const& nodes = bvh.nodes();
+    for (size_t n = 0; n < nodes.size(); n++) {
+        auto const& node = nodes[n];
+        if (node.is_leaf()) {
+            for (size_t i = node.offset; i < size_t(node.offset) + node.count; i++) {
+                auto it = std::find(list.begin(), list.end(), bvh.objects()[i]);
+                ASSERT_NE(list.end(), it);
+                counts[size_t(it - list.begin())]++;
+            }
+        } else {
+            for (uint32_t c : {uint32_t(n + 1U), node.offset}) {
+                ASSERT_LT(c, nodes.size());
+                for (size_t a = 0; a < raytrace::dimensions; a++) {
+                    EXPECT_LE(node.lower[a], nodes[c].lower[a]);
+                    EXPECT_GE(node.upper[a], nodes[c].upper[a]);
+                }
+            }
+        }
+    }
+    for (auto c : counts) {
+        EXPECT_EQ(1U, c);
+    }
+}
+
+TEST_F(BVHTest, MatchesBruteForce) {
+    tree::BVH bvh;
+    bvh.build(list);
+    std::vector<raytrace::ray> rays{
+        raytrace::ray{raytrace::point{-5, 0, 0}, R3::basis::X},
+        raytrace::ray{raytrace::point{20, 3, 6}, -R3::basis::X},
+        raytrace::ray{raytrace::point{3, -5, 9}, R3::basis::Y},
+        raytrace::ray{raytrace::point{9, 9, 20}, -R3::basis::Z},
+        raytrace::ray{raytrace::point{-5, -5, -5}, R3::vector{1, 1, 1}.normalized()},
+        raytrace::ray{raytrace::point{20, -5, 4}, R3::vector{-1, 1, 0}.normalized()},
+        raytrace::ray{raytrace::point{1.5_p, 1.5_p, 30}, -R3::basis::Z},  // misses everything
+    };
+    for (auto const& r : rays) {
+        size_t expected = 0U;
+        for (auto const* obj : list) {
+            auto hit = obj->intersect(r);
+            if (get_type(hit.intersect) == IntersectionType::Point) {
+                expected++;
+            }
+        }
+        auto found = bvh.intersects(r);
+        EXPECT_EQ(expected, found.size());
+    }
+}
+
+TEST_F(BVHTest, ClosestMatchesNearest) {
+    tree::BVH bvh;
+    bvh.build(list);
+    raytrace::scene scene;
+    for (auto const* obj : list) {
+        scene.add_object(obj);
+    }
+    for (size_t i = 0; i < 64; i++) {
+        // rays from outside the grid aimed at various points within it
+        raytrace::point from{-6.0_p + precision(i % 4), -7.0_p + precision(i % 7), 14.0_p - precision(i % 5)};
+        raytrace::point to{0.5_p * precision(i % 19), 0.75_p * precision(i % 13), 0.6_p * precision(i % 17)};
+        raytrace::ray r{from, (to - from).normalized()};
+        objects::hits all;
+        for (auto const* obj : list) {
+            all.push_back(obj->intersect(r));
+        }
+        auto expected = scene.nearest_object(r, all);
+        objects::hit nearest;
+        precision t_max = std::numeric_limits<precision>::infinity();
+        bool found = bvh.closest(r, nearest, t_max);
+        ASSERT_EQ(get_type(expected.intersect), get_type(nearest.intersect));
+        if (get_type(expected.intersect) == IntersectionType::Point) {
+            EXPECT_TRUE(found);
+            EXPECT_EQ(expected.object, nearest.object);
+            EXPECT_POINT_EQ(as_point(expected.intersect), as_point(nearest.intersect));
+            EXPECT_PRECISION_EQ((as_point(nearest.intersect) - from).norm(), t_max);
+        } else {
+            EXPECT_FALSE(found);
+        }
+    }
+}
+
+TEST_F(BVHTest, ClosestRespectsMaximum) {
+    tree::BVH bvh;
+    bvh.build(list);
+    // the first sphere along this ray is at 4 units, the next at 7
+    raytrace::ray r{raytrace::point{-5, 0, 0}, R3::basis::X};
+    objects::hit nearest;
+    precision t_max = 3.5_p;
+    EXPECT_FALSE(bvh.closest(r, nearest, t_max));
+    EXPECT_EQ(IntersectionType::None, get_type(nearest.intersect));
+    EXPECT_PRECISION_EQ(3.5_p, t_max);
+    t_max = std::numeric_limits<precision>::infinity();
+    EXPECT_TRUE(bvh.closest(r, nearest, t_max));
+    EXPECT_EQ(&spheres[0], nearest.object);
+    EXPECT_PRECISION_EQ(4.0_p, t_max);
+}
+
+TEST(HitRecordTest, ResolveMatchesIntersect) {
+    objects::sphere ball{raytrace::point{0, 0, 0}, 1.0_p};
+    ball.scale(2.0_p, 1.0_p, 0.5_p);  // object and world distances differ
+    objects::plane floor{raytrace::point{0, 0, -3}, R3::identity};
+    objects::square tile{raytrace::point{0, 0, 3}, R3::identity, 2.0_p};  // the default (collisions) path
+    objects::cuboid box{raytrace::point{0, 0, 6}, 1.0_p, 1.0_p, 1.0_p};
+    std::vector<objects::object const*> const objects{&ball, &floor, &tile, &box};
+    for (size_t i = 0; i < 32; i++) {
+        raytrace::point from{-9.0_p + precision(i % 5), -8.0_p + precision(i % 3), 1.5_p * precision(i % 7) - 4.0_p};
+        raytrace::point to{0.1_p * precision(i % 11), 0.2_p * precision(i % 5), 0.5_p * precision(i % 13) - 3.0_p};
+        raytrace::ray r{from, (to - from).normalized()};
+        for (auto const* obj : objects) {
+            objects::hit const expected = obj->intersect(r);
+            objects::hit_record record;
+            bool const hit = obj->intersect(r, record);
+            ASSERT_EQ(get_type(expected.intersect) == IntersectionType::Point, hit) << " ray " << i;
+            if (not hit) {
+                EXPECT_EQ(nullptr, record.object);
+                continue;
+            }
+            ASSERT_EQ(obj, record.object);
+            EXPECT_PRECISION_EQ((as_point(expected.intersect) - from).norm(), record.distance);
+            objects::hit const resolved = obj->resolve(r, record);
+            EXPECT_POINT_EQ(as_point(expected.intersect), as_point(resolved.intersect));
+            EXPECT_VECTOR_EQ(expected.normal, resolved.normal);
+            EXPECT_PRECISION_EQ(expected.distance, resolved.distance);
+            // a nearer hit in the record is kept
+            objects::hit_record nearer;
+            nearer.distance = record.distance * 0.5_p;
+            EXPECT_TRUE(obj->intersect(r, nearer));
+            EXPECT_EQ(nullptr, nearer.object);
+        }
+    }
+}
+
+TEST_F(BVHTest, ClosestRecord) {
+    tree::BVH bvh;
+    bvh.build(list);
+    raytrace::ray r{raytrace::point{-5, 0, 0}, R3::basis::X};
+    objects::hit_record record;
+    record.distance = 3.5_p;
+    EXPECT_FALSE(bvh.closest(r, record));
+    EXPECT_EQ(nullptr, record.object);
+    record.distance = basal::pos_inf;
+    EXPECT_TRUE(bvh.closest(r, record));
+    EXPECT_EQ(&spheres[0], record.object);
+    EXPECT_PRECISION_EQ(4.0_p, record.distance);
+    EXPECT_PRECISION_EQ(4.0_p, record.t);  // the nearer root, the same as the distance without scaling
+}
+
+TEST_F(BVHTest, Occluder) {
+    tree::BVH bvh;
+    bvh.build(list);
+    // the first sphere along this ray is at 4 units
+    raytrace::ray r{raytrace::point{-5, 0, 0}, R3::basis::X};
+    EXPECT_EQ(nullptr, bvh.occluder(r, 3.5_p));
+    EXPECT_NE(nullptr, bvh.occluder(r, 4.5_p));
+    EXPECT_NE(nullptr, bvh.occluder(r, std::numeric_limits<precision>::infinity()));
+    // skipping the only sphere in range means nothing blocks
+    EXPECT_EQ(nullptr, bvh.occluder(r, 4.5_p, &spheres[0]));
+    // a ray through the gaps is never blocked
+    raytrace::ray gap{raytrace::point{1.5_p, 1.5_p, -5}, R3::basis::Z};
+    EXPECT_EQ(nullptr, bvh.occluder(gap, std::numeric_limits<precision>::infinity()));
+}
+
+TEST_F(BVHTest, SceneOccludedCachesBlocker) {
+    raytrace::scene scene;
+    for (auto const* obj : list) {
+        scene.add_object(obj);
+    }
+    raytrace::camera view{8, 8, iso::degrees(55)};
+    view.move_to(raytrace::point{-10, -10, 20}, raytrace::point{4.5_p, 4.5_p, 4.5_p});
+    scene.render(view, std::string{});  // builds the hierarchy
+    raytrace::ray r{raytrace::point{-5, 0, 0}, R3::basis::X};
+    objects::object const* last_occluder = nullptr;
+    EXPECT_FALSE(scene.occluded(r, 3.5_p, last_occluder));
+    EXPECT_EQ(nullptr, last_occluder);
+    EXPECT_TRUE(scene.occluded(r, 20.0_p, last_occluder));
+    EXPECT_EQ(&spheres[0], last_occluder);
+    raytrace::statistics::collect();
+    size_t const cache_hits = raytrace::statistics::get().occluder_cache_hits;
+    EXPECT_TRUE(scene.occluded(r, 20.0_p, last_occluder));
+    raytrace::statistics::collect();
+    EXPECT_EQ(cache_hits + 1U, raytrace::statistics::get().occluder_cache_hits);
+    // the cached occluder does not block this ray, but another sphere does
+    raytrace::ray r2{raytrace::point{-5, 3, 0}, R3::basis::X};
+    EXPECT_TRUE(scene.occluded(r2, 20.0_p, last_occluder));
+    EXPECT_EQ(&spheres[4], last_occluder);
+    EXPECT_FALSE(scene.occluded(raytrace::ray{raytrace::point{1.5_p, 1.5_p, -5}, R3::basis::Z}, 100.0_p));
+}
+
+TEST_F(BVHTest, SceneReportsHierarchy) {
+    raytrace::scene scene;
+    for (auto const* obj : list) {
+        scene.add_object(obj);
+    }
+    raytrace::camera view{8, 8, iso::degrees(55)};
+    view.move_to(raytrace::point{-10, -10, 20}, raytrace::point{4.5_p, 4.5_p, 4.5_p});
+    scene.render(view, std::string{});
+    EXPECT_EQ(list.size(), scene.hierarchy().object_count());
+    EXPECT_LT(0U, scene.hierarchy().node_count());
+}
@@ -121,4 +121,31 @@ TEST(EntityTest, RotationScaleTranslate) {
     ASSERT_POINT_EQ(raytrace::point(-5 * 1 + 1, -7 * 1 + 2, 9 * 1 + 3), E.forward_transform(raytrace::point(1, 1, 1)));
     // -4, -5, 12 -> 1, 1, 1
     ASSERT_POINT_EQ(raytrace::point(1, 1, 1), E.reverse_transform(raytrace::point(-5 * 1 + 1, -7 * 1 + 2, 9 * 1 + 3)));
-}
\ No newline at end of file
+}
+
+TEST(EntityTest, TransformMatchesMatrix) {
+    // compose the same transform the long way with 4x4 matrices
+    matrix R = geometry::rotation(iso::radians{0.3_p}, iso::radians{-1.1_p}, iso::radians{2.4_p});
+    raytrace::vector S{{2.0_p, 0.5_p, 3.0_p}};
+    raytrace::point T{-4, 7, 1};
+    matrix m4 = matrix::identity(4, 4);
+    for (size_t r = 0; r < 3; r++) {
+        for (size_t c = 0; c < 3; c++) {
+            m4[r][c] = R[r][c] * S[c];
+        }
+        m4[r][3] = T[r];
+    }
+    raytrace::transform xform{R, R.inverse(), S, T};
+    raytrace::point P{1.5_p, -2.0_p, 0.25_p};
+    geometry::point_<4> W4(m4 * geometry::point_<4>(P));
+    raytrace::point W = xform.forward(P);
+    ASSERT_POINT_EQ(raytrace::point(W4[0], W4[1], W4[2]), W);
+    ASSERT_POINT_EQ(P, xform.reverse(W));
+    raytrace::vector V{{0.0_p, 1.0_p, 0.0_p}};
+    ASSERT_VECTOR_EQ(raytrace::vector(R * V), xform.forward(V));
+    ASSERT_VECTOR_EQ(V, xform.reverse(xform.forward(V)));
+    // the default is the identity
+    constexpr raytrace::transform identity;
+    static_assert(identity.linear(1, 1) == 1.0_p and identity.translation(2) == 0.0_p, "Must be identity");
+    ASSERT_POINT_EQ(P, identity.forward(P));
+}
@@ -82,16 +82,16 @@ TEST(ImageTest, SubsamplerTest) {
         }
         return samples[2];
     };
-    auto renderer = [&](size_t row_index, bool is_completed) -> void {
-        image::point pnt(row_index, 0);
-        auto pix = img4.at(pnt);
+    auto renderer = [&](raytrace::tile const& region, bool is_completed) -> void {
         EXPECT_TRUE(is_completed);
-        EXPECT_EQ(dark_grey.components.r, pix.components.r)
-            << pix.components.r << " at " << pnt.x() << ", " << pnt.y() << std::endl;
-        EXPECT_EQ(dark_grey.components.g, pix.components.g)
-            << pix.components.g << " at " << pnt.x() << ", " << pnt.y() << std::endl;
-        EXPECT_EQ(dark_grey.components.b, pix.components.b)
-            << pix.components.b << " at " << pnt.x() << ", " << pnt.y() << std::endl;
+        for (size_t y = region.y; y < region.y + region.height; y++) {
+            for (size_t x = region.x; x < region.x + region.width; x++) {
+                auto pix = img4.at(y, x);
+                EXPECT_EQ(dark_grey.components.r, pix.components.r) << pix.components.r << " at " << x << ", " << y;
+                EXPECT_EQ(dark_grey.components.g, pix.components.g) << pix.components.g << " at " << x << ", " << y;
+                EXPECT_EQ(dark_grey.components.b, pix.components.b) << pix.components.b << " at " << x << ", " << y;
+            }
+        }
     };
     img4.generate_each(subsampler, samples.size(), renderer);
     img4.save("averaged_dark_grey.ppm");
@@ -126,3 +126,95 @@ TEST(ImageTest, SubsamplingChecker) {
     fourcc::convert(image5, image7);
     image7.save("subsampling.ppm");
 }
+
+TEST(ImageTest, LowDiscrepancyOffsets) {
+    // the first sample is the center and the rest stay within the pixel without repeating
+    ASSERT_EQ(0.0_p, image::low_discrepancy_offset(0U).x());
+    ASSERT_EQ(0.0_p, image::low_discrepancy_offset(0U).y());
+    std::vector<image::vector> offsets;
+    for (size_t i = 0; i < 64U; i++) {
+        image::vector const offset = image::low_discrepancy_offset(i);
+        EXPECT_LE(-0.5_p, offset.x());
+        EXPECT_GT(0.5_p, offset.x());
+        EXPECT_LE(-0.5_p, offset.y());
+        EXPECT_GT(0.5_p, offset.y());
+        for (auto const& other : offsets) {
+            EXPECT_FALSE(other.x() == offset.x() and other.y() == offset.y()) << "Sample " << i << " repeats";
+        }
+        offsets.push_back(offset);
+    }
+}
+
+TEST(ImageTest, AccumulationAverages) {
+    // three passes of red, green then blue average to the same dark grey as three subsamples would
+    image img(2, 4);
+    precision g = 1.0_p / 3.0_p;
+    color tmp0(g, g, g);
+    fourcc::rgbid dark_grey = tmp0.to_<fourcc::PixelFormat::RGBId>();
+    std::array<color, 3> samples = {colors::red, colors::green, colors::blue};
+    std::vector<color> sums(img.height * img.width);
+    for (size_t pass = 0; pass < samples.size(); pass++) {
+        img.accumulate_each(
+            [&](image::point const* points, color* colors, size_t count) {
+                for (size_t i = 0; i < count; i++) {
+                    image::vector const offset = points[i] - image::point{std::floor(points[i].x()) + 0.5_p,
+                                                                          std::floor(points[i].y()) + 0.5_p};
+                    EXPECT_NEAR(image::low_discrepancy_offset(pass).x(), offset.x(), basal::epsilon);
+                    EXPECT_NEAR(image::low_discrepancy_offset(pass).y(), offset.y(), basal::epsilon);
+                    colors[i] = samples[pass];
+                }
+            },
+            2U, sums, pass);
+    }
+    for (size_t y = 0; y < img.height; y++) {
+        for (size_t x = 0; x < img.width; x++) {
+            auto pix = img.at(y, x);
+            EXPECT_EQ(dark_grey.components.r, pix.components.r) << " at " << x << ", " << y;
+            EXPECT_EQ(dark_grey.components.g, pix.components.g) << " at " << x << ", " << y;
+            EXPECT_EQ(dark_grey.components.b, pix.components.b) << " at " << x << ", " << y;
+        }
+    }
+    // the wrong number of sums is an error
+    sums.pop_back();
+    EXPECT_THROW(img.accumulate_each([](image::point const*, color*, size_t) {}, 1U, sums, 0U), basal::exception);
+}
+
+TEST(ImageTest, AdaptiveSamplingFollowsTheVariance) {
+    // the left half is red, the right half is blue with the edge within the pixels of column 8
+    image img(16, 16);
+    fourcc::image<fourcc::PixelFormat::Y8> counts(16, 16);
+    constexpr size_t max_samples = 64U;
+    // every pixel (and the border around each tile) is sampled at the center once, so only the others are counted
+    std::vector<size_t> samples(img.height * img.width, 1U);
+    auto subsampler = [&](image::point const* points, color* colors, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            precision const fx = points[i].x() - std::floor(points[i].x());
+            precision const fy = points[i].y() - std::floor(points[i].y());
+            if (fx != 0.5_p or fy != 0.5_p) {
+                samples[static_cast<size_t>(points[i].y()) * img.width + static_cast<size_t>(points[i].x())]++;
+            }
+            colors[i] = (points[i].x() < 8.5_p) ? colors::red : colors::blue;
+        }
+    };
+    img.generate_adaptive(subsampler, 4U, max_samples, 1.0_p / 64.0_p, &counts, std::nullopt, false,
+                          tiling{4U, 4U, TileOrder::Scanline});
+    for (size_t y = 0; y < img.height; y++) {
+        for (size_t x = 0; x < img.width; x++) {
+            size_t const n = samples[y * img.width + x];
+            EXPECT_EQ((n * 255U) / max_samples, counts.at(y, x)) << " at " << x << ", " << y;
+            if (x == 8U) {
+                // the edge is noisy
+                EXPECT_EQ(max_samples, n) << " at " << x << ", " << y;
+            } else if (x == 7U) {
+                // the other side of the edge looks again but is flat
+                EXPECT_EQ(1U + adaptive_batch, n) << " at " << x << ", " << y;
+            } else {
+                // the flat areas (even along the tile borders) stop at a single sample
+                EXPECT_EQ(1U, n) << " at " << x << ", " << y;
+            }
+        }
+    }
+    // which looks like a blend at the edge
+    EXPECT_LT(0.0_p, img.at(0, 8).components.r);
+    EXPECT_LT(0.0_p, img.at(0, 8).components.b);
+}
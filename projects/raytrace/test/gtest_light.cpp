@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <map>
+#include <memory>
 #include <raytrace/raytrace.hpp>
 #include "raytrace/gtest_helper.hpp"
 
@@ -139,4 +141,63 @@ TEST(LightTest, EmittedSpotLight) {
         iso::convert(angle_deg, angle_rad);
         ASSERT_LE(angle_deg, iso::degrees(25));
     }
-}
\ No newline at end of file
+}
+TEST(LightSelectorTest, ChoosesInProportion) {
+    // a grid of lights above and a few below the floor
+    std::vector<std::unique_ptr<lights::speck>> specks;
+    lights::selector::light_list list;
+    for (int y = -2; y <= 2; y++) {
+        for (int x = -2; x <= 2; x++) {
+            specks.push_back(std::make_unique<lights::speck>(raytrace::point(5.0_p * x, 5.0_p * y, 4.0_p),
+                                                             colors::white, 100.0_p + x));
+            list.push_back(specks.back().get());
+        }
+    }
+    for (int x = -1; x <= 1; x++) {
+        specks.push_back(
+            std::make_unique<lights::speck>(raytrace::point(3.0_p * x, 0.0_p, -2.0_p), colors::white, 1E3));
+        list.push_back(specks.back().get());
+    }
+    lights::selector lights_selector;
+    EXPECT_EQ(0U, lights_selector.size());
+    EXPECT_EQ(nullptr, lights_selector.choose(R3::origin, R3::basis::Z, 0.5_p).chosen);
+    lights_selector.build(list);
+    ASSERT_EQ(list.size(), lights_selector.size());
+
+    raytrace::point const surface{1.0_p, -1.0_p, 0.0_p};
+    precision total = 0.0_p;
+    for (auto const* light : list) {
+        precision const probability = lights_selector.probability(surface, R3::basis::Z, light);
+        if (light->position().z() < 0.0_p) {
+            EXPECT_EQ(0.0_p, probability) << "Lights behind the surface are never chosen";
+        } else {
+            EXPECT_LT(0.0_p, probability) << "Every light in front of the surface can be chosen";
+        }
+        total += probability;
+    }
+    EXPECT_NEAR(1.0_p, total, basal::epsilon);
+
+    // the choices agree with the probabilities
+    std::map<lights::light const*, size_t> chosen;
+    constexpr size_t choices = 4096U;
+    for (size_t i = 0; i < choices; i++) {
+        precision const value = (static_cast<precision>(i) + 0.5_p) / static_cast<precision>(choices);
+        lights::selector::choice const pick = lights_selector.choose(surface, R3::basis::Z, value);
+        ASSERT_NE(nullptr, pick.chosen);
+        EXPECT_NEAR(lights_selector.probability(surface, R3::basis::Z, pick.chosen), pick.probability, basal::epsilon);
+        chosen[pick.chosen]++;
+    }
+    // the hierarchy only estimates its branches, yet the light right above is chosen more than the far corner
+    EXPECT_LT(chosen[list[24]], chosen[list[12]]);
+    for (auto const& [light, count] : chosen) {
+        precision const expected = lights_selector.probability(surface, R3::basis::Z, light) * choices;
+        EXPECT_NEAR(expected, static_cast<precision>(count), 1.0_p + basal::epsilon);
+    }
+    // facing down only the lights below can be chosen
+    for (size_t i = 0; i < 16U; i++) {
+        precision const value = (static_cast<precision>(i) + 0.5_p) / 16.0_p;
+        lights::selector::choice const pick = lights_selector.choose(surface, -R3::basis::Z, value);
+        ASSERT_NE(nullptr, pick.chosen);
+        EXPECT_GT(0.0_p, pick.chosen->position().z());
+    }
+}
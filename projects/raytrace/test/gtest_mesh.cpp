@@ -0,0 +1,318 @@
+#include <gtest/gtest.h>
+
+#include <basal/basal.hpp>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <raytrace/objects/model.hpp>
+#include <raytrace/raytrace.hpp>
+#include <vector>
+
+#include "geometry/gtest_helper.hpp"
+#include "linalg/gtest_helper.hpp"
+#include "raytrace/gtest_helper.hpp"
+
+using namespace raytrace;
+
+namespace {
+/// A bumpy height field of (2 * size * size) triangles over [0, size] in X and Y, facing +Z
+void make_terrain(size_t size, std::vector<point>& vertices, std::vector<tree::MeshBVH::indices>& triangles) {
+    for (size_t y = 0; y <= size; y++) {
+        for (size_t x = 0; x <= size; x++) {
+            precision const h = 0.5_p * std::sin(0.7_p * x) * std::cos(0.9_p * y);
+            vertices.emplace_back(precision(x), precision(y), h);
+        }
+    }
+    auto index = [&](size_t x, size_t y) { return static_cast<uint32_t>(y * (size + 1U) + x); };
+    for (size_t y = 0; y < size; y++) {
+        for (size_t x = 0; x < size; x++) {
+            triangles.push_back({index(x, y), index(x + 1, y), index(x + 1, y + 1)});
+            triangles.push_back({index(x, y), index(x + 1, y + 1), index(x, y + 1)});
+        }
+    }
+}
+
+char const* const cube_literal
+    = "v 1.000000 -1.000000 -1.000000\n"
+      "v 1.000000 -1.000000 1.000000\n"
+      "v -1.000000 -1.000000 1.000000\n"
+      "v -1.000000 -1.000000 -1.000000\n"
+      "v 1.000000 1.000000 -1.000000\n"
+      "v 1.000000 1.000000 1.000000\n"
+      "v -1.000000 1.000000 1.000000\n"
+      "v -1.000000 1.000000 -1.000000\n"
+      "f 2 3 4\n"
+      "f 8 7 6\n"
+      "f 5 6 2\n"
+      "f 6 7 3\n"
+      "f 3 7 8\n"
+      "f 1 4 8\n"
+      "f 1 2 4\n"
+      "f 5 8 6\n"
+      "f 1 5 2\n"
+      "f 2 6 3\n"
+      "f 4 3 8\n"
+      "f 5 1 8\n";
+}  // namespace
+
+TEST(MeshTest, WatertightTriangle) {
+    precision const A[] = {0, 0, 0};
+    precision const B[] = {1, 0, 0};
+    precision const C[] = {0, 1, 0};
+    precision const origin[] = {0.25_p, 0.25_p, 2.0_p};
+    precision const down[] = {0, 0, -1};
+    precision t, u, v;
+    ASSERT_TRUE(tree::watertight_triangle(tree::ShearedRay{origin, down}, A, B, C, t, u, v));
+    EXPECT_DOUBLE_EQ(2.0_p, t);
+    EXPECT_DOUBLE_EQ(0.25_p, u);
+    EXPECT_DOUBLE_EQ(0.25_p, v);
+    // from the other side too
+    precision const below[] = {0.25_p, 0.25_p, -2.0_p};
+    precision const up[] = {0, 0, 1};
+    ASSERT_TRUE(tree::watertight_triangle(tree::ShearedRay{below, up}, A, B, C, t, u, v));
+    EXPECT_DOUBLE_EQ(2.0_p, t);
+    // the edges and corners are inclusive
+    precision const corner[] = {1.0_p, 0.0_p, 2.0_p};
+    EXPECT_TRUE(tree::watertight_triangle(tree::ShearedRay{corner, down}, A, B, C, t, u, v));
+    precision const edge[] = {0.5_p, 0.5_p, 2.0_p};
+    EXPECT_TRUE(tree::watertight_triangle(tree::ShearedRay{edge, down}, A, B, C, t, u, v));
+    // outside and parallel
+    precision const outside[] = {0.75_p, 0.75_p, 2.0_p};
+    EXPECT_FALSE(tree::watertight_triangle(tree::ShearedRay{outside, down}, A, B, C, t, u, v));
+    precision const across[] = {1, 0, 0};
+    EXPECT_FALSE(tree::watertight_triangle(tree::ShearedRay{origin, across}, A, B, C, t, u, v));
+}
+
+TEST(MeshTest, SharedEdgesAreWatertight) {
+    std::vector<point> vertices;
+    std::vector<tree::MeshBVH::indices> triangles;
+    make_terrain(4, vertices, triangles);
+    tree::MeshBVH mesh;
+    mesh.build(vertices, triangles);
+    // every ray down through a shared edge or vertex must hit something
+    for (size_t i = 0; i <= 64; i++) {
+        precision const s = 4.0_p * precision(i) / 64.0_p;
+        for (point const& from : {point{s, s, 5}, point{s, 2, 5}, point{1, s, 5}}) {
+            tree::TriangleHit found;
+            ASSERT_TRUE(mesh.closest(ray{from, vector{{0, 0, -1}}}, 0.0_p, basal::pos_inf, found)) << from;
+        }
+    }
+}
+
+TEST(MeshTest, ObliqueRaysThroughSharedEdgesAreNotLost) {
+    std::vector<point> vertices;
+    std::vector<tree::MeshBVH::indices> triangles;
+    make_terrain(8, vertices, triangles);
+    tree::MeshBVH mesh;
+    mesh.build(vertices, triangles);
+    std::mt19937 generator{7U};
+    std::uniform_real_distribution<precision> along{0.0_p, 1.0_p};
+    std::uniform_real_distribution<precision> lean{-0.5_p, 0.5_p};
+    size_t lost = 0U;
+    for (size_t r = 0; r < 4096; r++) {
+        // aim at a point on an edge which two triangles share (the diagonal of a square or its inner sides)
+        auto const& triangle = triangles[r % triangles.size()];
+        point const& from_corner = vertices[triangle[r % 2U]];
+        point const& to_corner = vertices[triangle[2]];
+        precision const s = along(generator);
+        point const target = from_corner + (to_corner - from_corner) * s;
+        if (target.x() <= 0.0_p or target.y() <= 0.0_p or target.x() >= 8.0_p or target.y() >= 8.0_p) {
+            continue;  // the outer edges are not shared
+        }
+        vector const direction = vector{{lean(generator), lean(generator), -1.0_p}}.normalized();
+        tree::TriangleHit found;
+        if (not mesh.closest(ray{target - direction * 10.0_p, direction}, 0.0_p, basal::pos_inf, found)) {
+            lost++;
+        }
+    }
+    EXPECT_EQ(0U, lost);
+}
+
+TEST(MeshTest, MatchesBruteForce) {
+    std::vector<point> vertices;
+    std::vector<tree::MeshBVH::indices> triangles;
+    make_terrain(24, vertices, triangles);
+    tree::MeshBVH mesh;
+    mesh.build(vertices, triangles);
+    ASSERT_EQ(triangles.size(), mesh.triangle_count());
+    ASSERT_EQ(vertices.size(), mesh.vertex_count());
+    EXPECT_LE(mesh.nodes().size(), 2U * triangles.size() - 1U);
+    std::mt19937 generator{42U};
+    std::uniform_real_distribution<precision> spread{0.0_p, 24.0_p};
+    for (size_t r = 0; r < 256; r++) {
+        point const from{spread(generator), spread(generator), 8.0_p};
+        point const to{spread(generator), spread(generator), -1.0_p};
+        ray const object_ray{from, (to - from).normalized()};
+        precision origin[raytrace::dimensions], direction[raytrace::dimensions];
+        for (size_t a = 0; a < raytrace::dimensions; a++) {
+            origin[a] = object_ray.location()[a];
+            direction[a] = object_ray.direction()[a];
+        }
+        tree::ShearedRay const sheared{origin, direction};
+        precision expected = basal::pos_inf;
+        for (auto const& triangle : triangles) {
+            precision A[raytrace::dimensions], B[raytrace::dimensions], C[raytrace::dimensions];
+            for (size_t a = 0; a < raytrace::dimensions; a++) {
+                A[a] = vertices[triangle[0]][a];
+                B[a] = vertices[triangle[1]][a];
+                C[a] = vertices[triangle[2]][a];
+            }
+            precision t, u, v;
+            if (tree::watertight_triangle(sheared, A, B, C, t, u, v) and t > 0.0_p) {
+                expected = std::min(expected, t);
+            }
+        }
+        tree::TriangleHit found;
+        bool const hit = mesh.closest(object_ray, 0.0_p, basal::pos_inf, found);
+        // single precision keeps about 7 digits of the distance
+        precision const tolerance = basal::use_high_precision ? 1E-9 : 1E-4;
+        ASSERT_EQ(std::isfinite(expected), hit) << " ray " << r;
+        if (hit) {
+            EXPECT_NEAR(expected, found.t, tolerance) << " ray " << r;
+            point const P = object_ray.distance_along(found.t);
+            uint32_t located;
+            ASSERT_TRUE(mesh.locate(P, tolerance, located));
+        }
+    }
+}
+
+TEST(MeshTest, BackFacesAreNotHit) {
+    std::vector<point> vertices;
+    std::vector<tree::MeshBVH::indices> triangles;
+    make_terrain(2, vertices, triangles);
+    tree::MeshBVH mesh;
+    mesh.build(vertices, triangles);
+    tree::TriangleHit found;
+    EXPECT_TRUE(mesh.closest(ray{point{0.5, 0.5, 5}, vector{{0, 0, -1}}}, 0.0_p, basal::pos_inf, found));
+    EXPECT_FALSE(mesh.closest(ray{point{0.5, 0.5, -5}, vector{{0, 0, 1}}}, 0.0_p, basal::pos_inf, found));
+}
+
+TEST(MeshTest, ModelUsesMesh) {
+    objects::Model model;
+    model.LoadFromString(cube_literal);
+    ASSERT_EQ(12U, model.GetNumberOfFaces());
+    ASSERT_NE(nullptr, model.mesh());
+    EXPECT_DOUBLE_EQ(std::sqrt(3.0_p), model.get_object_extent());
+    ray const up{point{0.25, -5, 0.5}, R3::basis::Y};
+    auto hit = model.intersect(up);
+    ASSERT_EQ(IntersectionType::Point, get_type(hit.intersect));
+    EXPECT_POINT_EQ(point(0.25_p, -1.0_p, 0.5_p), as_point(hit.intersect));
+    EXPECT_VECTOR_EQ(vector({0, -1, 0}), hit.normal);
+    EXPECT_TRUE(model.is_surface_point(as_point(hit.intersect)));
+    EXPECT_FALSE(model.is_surface_point(point{0.25, 0, 0.5}));
+    objects::hit_record record;
+    ASSERT_TRUE(model.intersect(up, record));
+    ASSERT_EQ(&model, record.object);
+    EXPECT_PRECISION_EQ(4.0_p, record.distance);
+    EXPECT_LT(record.primitive, model.GetNumberOfFaces());
+    EXPECT_LE(0.0_p, record.u);
+    EXPECT_LE(0.0_p, record.v);
+    EXPECT_GE(1.0_p, record.u + record.v);
+    auto const resolved = model.resolve(up, record);
+    EXPECT_POINT_EQ(as_point(hit.intersect), as_point(resolved.intersect));
+    EXPECT_VECTOR_EQ(hit.normal, resolved.normal);
+    // the far side faces away from the ray so only the near side is a collision
+    EXPECT_EQ(1U, model.collisions_along(up).size());
+
+    // an instance shares the triangles but has its own transform
+    objects::Model instance{model.mesh()};
+    instance.position(point{10, 0, 0});
+    EXPECT_EQ(model.mesh().get(), instance.mesh().get());
+    EXPECT_EQ(IntersectionType::None, get_type(instance.intersect(up).intersect));
+    ray const shifted{point{10.25, -5, 0.5}, R3::basis::Y};
+    hit = instance.intersect(shifted);
+    ASSERT_EQ(IntersectionType::Point, get_type(hit.intersect));
+    EXPECT_POINT_EQ(point(10.25_p, -1.0_p, 0.5_p), as_point(hit.intersect));
+}
+
+TEST(MeshTest, CacheIsUsedInPlace) {
+    std::vector<point> vertices;
+    std::vector<tree::MeshBVH::indices> triangles;
+    make_terrain(16, vertices, triangles);
+    tree::MeshBVH mesh;
+    mesh.build(vertices, triangles);
+    std::string const path = (std::filesystem::temp_directory_path() / "gtest_mesh_terrain.mesh").string();
+    ASSERT_TRUE(mesh.save(path.c_str(), "extra"));
+    std::string_view extra;
+    auto mapped = tree::MeshBVH::map(path.c_str(), extra);
+    ASSERT_NE(nullptr, mapped);
+    EXPECT_EQ("extra", extra);
+    ASSERT_EQ(mesh.triangle_count(), mapped->triangle_count());
+    ASSERT_EQ(mesh.vertex_count(), mapped->vertex_count());
+    ASSERT_EQ(mesh.nodes().size(), mapped->nodes().size());
+    EXPECT_EQ(mesh.depth(), mapped->depth());
+    EXPECT_DOUBLE_EQ(mesh.extent(), mapped->extent());
+    // the arrays are cache line aligned in the mapping
+    EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(mapped->nodes().data()) % 64U);
+    std::mt19937 generator{7U};
+    std::uniform_real_distribution<precision> spread{0.0_p, 16.0_p};
+    for (size_t r = 0; r < 64; r++) {
+        point const from{spread(generator), spread(generator), 8.0_p};
+        ray const down{from, vector{{0.1_p, -0.2_p, -1.0_p}}};
+        tree::TriangleHit expected, found;
+        ASSERT_EQ(mesh.closest(down, 0.0_p, basal::pos_inf, expected),
+                  mapped->closest(down, 0.0_p, basal::pos_inf, found));
+        EXPECT_EQ(expected.triangle, found.triangle);
+        EXPECT_DOUBLE_EQ(expected.t, found.t);
+        EXPECT_VECTOR_EQ(mesh.normal(expected.triangle), mapped->normal(found.triangle));
+    }
+    // a damaged cache is not used
+    auto damage = [&](long offset, auto value) {
+        ASSERT_TRUE(mesh.save(path.c_str(), "extra"));
+        FILE* file = fopen(path.c_str(), "r+b");
+        ASSERT_NE(nullptr, file);
+        fseek(file, offset, SEEK_SET);
+        fwrite(&value, sizeof(value), 1U, file);
+        fclose(file);
+        EXPECT_EQ(nullptr, tree::MeshBVH::map(path.c_str(), extra)) << " offset " << offset;
+    };
+    damage(8, uint32_t{tree::MeshBVH::CacheVersion + 1U});
+    damage(24, uint64_t{1U});        // fewer vertices than the corners refer to
+    damage(40, uint64_t{1U} << 61);  // so many nodes the size wraps around to nothing
+    std::filesystem::remove(path);
+    EXPECT_EQ(nullptr, tree::MeshBVH::map(path.c_str(), extra));
+}
+
+TEST(MeshTest, ModelCache) {
+    std::filesystem::path const path = std::filesystem::temp_directory_path() / "gtest_mesh_cube.obj";
+    std::string const cache = path.string() + objects::Model::CacheSuffix;
+    FILE* file = fopen(path.string().c_str(), "wb");
+    ASSERT_NE(nullptr, file);
+    fputs(cube_literal, file);
+    fclose(file);
+    std::filesystem::remove(cache);
+
+    objects::Model model;
+    model.LoadFromFile(path.string().c_str());
+    ASSERT_TRUE(std::filesystem::exists(cache));
+    objects::Model cached;
+    ASSERT_TRUE(cached.LoadFromCache(cache.c_str()));
+    EXPECT_FALSE(cached.LoadFromCache(cache.c_str()));  // already loaded
+    EXPECT_EQ(model.GetNumberOfFaces(), cached.GetNumberOfFaces());
+    EXPECT_EQ(model.GetStatistics().vertices, cached.GetStatistics().vertices);
+    EXPECT_EQ(model.GetStatistics().faces, cached.GetStatistics().faces);
+    EXPECT_POINT_EQ(model.position(), cached.position());
+    ray const up{point{0.25, -5, 0.5}, R3::basis::Y};
+    auto const expected = model.intersect(up);
+    auto const found = cached.intersect(up);
+    ASSERT_EQ(IntersectionType::Point, get_type(found.intersect));
+    EXPECT_POINT_EQ(as_point(expected.intersect), as_point(found.intersect));
+    EXPECT_VECTOR_EQ(expected.normal, found.normal);
+    // loading the file again maps the cache
+    objects::Model again;
+    again.LoadFromFile(path.string().c_str());
+    EXPECT_EQ(model.GetNumberOfFaces(), again.GetNumberOfFaces());
+    // a changed file is loaded again even if it keeps the old time
+    auto const time = std::filesystem::last_write_time(path);
+    file = fopen(path.string().c_str(), "ab");
+    ASSERT_NE(nullptr, file);
+    fputs("f 1 2 3\n", file);
+    fclose(file);
+    std::filesystem::last_write_time(path, time);
+    objects::Model changed;
+    changed.LoadFromFile(path.string().c_str());
+    EXPECT_EQ(model.GetNumberOfFaces() + 1U, changed.GetNumberOfFaces());
+    std::filesystem::remove(path);
+    std::filesystem::remove(cache);
+}
@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <raytrace/objects/model.hpp>
+#include <raytrace/objloader.hpp>
+#include <raytrace/raytrace.hpp>
+#include <string>
+
+#include "raytrace/gtest_helper.hpp"
+
+using namespace raytrace;
+
+namespace {
+using Indices = std::array<uint32_t, 3>;
+constexpr uint32_t X = obj::Contents::Absent;
+
+/// A grid of (2 * size * size) triangles written as quads, large enough to be split into many chunks
+std::string make_grid(size_t size) {
+    std::string text{"o Grid\n"};
+    char line[128];
+    for (size_t y = 0; y <= size; y++) {
+        for (size_t x = 0; x <= size; x++) {
+            snprintf(line, sizeof(line), "v %zu.5 %zu.25 -1e-3\n", x, y);
+            text += line;
+        }
+    }
+    for (size_t y = 0; y < size; y++) {
+        for (size_t x = 0; x < size; x++) {
+            size_t const a = y * (size + 1U) + x + 1U;
+            snprintf(line, sizeof(line), "f %zu %zu %zu %zu\n", a, a + 1U, a + size + 2U, a + size + 1U);
+            text += line;
+        }
+    }
+    return text;
+}
+}  // namespace
+
+TEST(ObjLoader, Elements) {
+    char const* const literal
+        = "# comment\n"
+          "o Object\n"
+          "v 3.0 2.0 1.0\n"
+          "  v\t5.0 +4.0 6.0\r\n"
+          "v 7.0 8.0 -9.5e1\n"
+          "vt 0.5 0.25 1.0\n"
+          "vn 0.0 0.0 1.0\n"
+          "f 1 2 3\n"
+          "f 1/1 2/1 3/1\n"
+          "f 1/1/1 2/1/1 3/1/1\n"
+          "f 1//1 2//1 3//1 # trailing\n"
+          "f 1 2\n";
+    obj::Contents contents = obj::load(std::string_view{literal});
+    EXPECT_EQ(1U, contents.statistics.object);
+    ASSERT_EQ(3U, contents.statistics.vertices);
+    ASSERT_EQ(1U, contents.statistics.textures);
+    ASSERT_EQ(1U, contents.statistics.normals);
+    ASSERT_EQ(4U, contents.statistics.faces);
+    ASSERT_EQ(3U, contents.vertices.size());
+    EXPECT_FLOAT_EQ(5.0f, contents.vertices[1][0]);
+    EXPECT_FLOAT_EQ(4.0f, contents.vertices[1][1]);
+    EXPECT_FLOAT_EQ(6.0f, contents.vertices[1][2]);
+    EXPECT_FLOAT_EQ(-95.0f, contents.vertices[2][2]);
+    EXPECT_FLOAT_EQ(0.5f, contents.textures[0][0]);
+    EXPECT_FLOAT_EQ(0.25f, contents.textures[0][1]);
+    EXPECT_FLOAT_EQ(1.0f, contents.normals[0][2]);
+    ASSERT_EQ(4U, contents.triangles.size());
+    for (auto const& triangle : contents.triangles) {
+        EXPECT_EQ((Indices{0, 1, 2}), triangle.vertex);
+    }
+    EXPECT_EQ((Indices{X, X, X}), contents.triangles[0].texture);
+    EXPECT_EQ((Indices{X, X, X}), contents.triangles[0].normal);
+    EXPECT_EQ((Indices{0, 0, 0}), contents.triangles[1].texture);
+    EXPECT_EQ((Indices{X, X, X}), contents.triangles[1].normal);
+    EXPECT_EQ((Indices{0, 0, 0}), contents.triangles[2].texture);
+    EXPECT_EQ((Indices{0, 0, 0}), contents.triangles[2].normal);
+    EXPECT_EQ((Indices{X, X, X}), contents.triangles[3].texture);
+    EXPECT_EQ((Indices{0, 0, 0}), contents.triangles[3].normal);
+}
+
+TEST(ObjLoader, PolygonsAndRelativeIndices) {
+    char const* const literal
+        = "v 0 0 0\n"
+          "v 1 0 0\n"
+          "v 1 1 0\n"
+          "v 0 1 0\n"
+          "f 1 2 3 4\n"
+          "v 0 2 0\n"
+          "f -5 -3 -2 -1 -4\n"
+          "f -9 1 2\n";
+    obj::Contents contents = obj::load(std::string_view{literal});
+    ASSERT_EQ(3U, contents.statistics.faces);
+    ASSERT_EQ(6U, contents.triangles.size());
+    // a quad is a fan of two triangles
+    EXPECT_EQ((Indices{0, 1, 2}), contents.triangles[0].vertex);
+    EXPECT_EQ((Indices{0, 2, 3}), contents.triangles[1].vertex);
+    // relative to the vertices before the line
+    EXPECT_EQ((Indices{0, 2, 3}), contents.triangles[2].vertex);
+    EXPECT_EQ((Indices{0, 3, 4}), contents.triangles[3].vertex);
+    EXPECT_EQ((Indices{0, 4, 1}), contents.triangles[4].vertex);
+    // too far back is not a vertex
+    EXPECT_EQ((Indices{X, 0, 1}), contents.triangles[5].vertex);
+}
+
+TEST(ObjLoader, ChunksMatchWholeText) {
+    size_t const size = 160U;
+    std::string const text = make_grid(size);
+    ASSERT_GT(text.size(), 4U * 65536U);  // enough text for several chunks
+    obj::Contents contents = obj::load(std::string_view{text});
+    ASSERT_EQ((size + 1U) * (size + 1U), contents.vertices.size());
+    ASSERT_EQ(size * size, contents.statistics.faces);
+    ASSERT_EQ(2U * size * size, contents.triangles.size());
+    for (size_t y = 0; y <= size; y++) {
+        for (size_t x = 0; x <= size; x++) {
+            auto const& v = contents.vertices[y * (size + 1U) + x];
+            ASSERT_FLOAT_EQ(float(x) + 0.5f, v[0]);
+            ASSERT_FLOAT_EQ(float(y) + 0.25f, v[1]);
+            ASSERT_FLOAT_EQ(-1E-3f, v[2]);
+        }
+    }
+    for (size_t q = 0; q < size * size; q++) {
+        uint32_t const a = static_cast<uint32_t>((q / size) * (size + 1U) + (q % size));
+        uint32_t const b = a + 1U;
+        uint32_t const c = a + static_cast<uint32_t>(size) + 2U;
+        uint32_t const d = c - 1U;
+        ASSERT_EQ((Indices{a, b, c}), contents.triangles[2U * q].vertex) << " quad " << q;
+        ASSERT_EQ((Indices{a, c, d}), contents.triangles[2U * q + 1U].vertex) << " quad " << q;
+    }
+}
+
+TEST(ObjLoader, FromFile) {
+    std::string const text = make_grid(8U);
+    std::filesystem::path const path = std::filesystem::temp_directory_path() / "gtest_objloader_grid.obj";
+    FILE* file = fopen(path.string().c_str(), "wb");
+    ASSERT_NE(nullptr, file);
+    fwrite(text.data(), 1U, text.size(), file);
+    fclose(file);
+    obj::Contents from_file = obj::load(path.string().c_str());
+    obj::Contents from_text = obj::load(std::string_view{text});
+    ASSERT_EQ(from_text.vertices, from_file.vertices);
+    ASSERT_EQ(from_text.triangles.size(), from_file.triangles.size());
+
+    objects::Model model;
+    model.LoadFromFile(path.string().c_str());
+    EXPECT_EQ(81U, model.GetStatistics().vertices);
+    EXPECT_EQ(64U, model.GetStatistics().faces);
+    EXPECT_EQ(128U, model.GetNumberOfFaces());
+    std::filesystem::remove(path);
+    std::filesystem::remove(path.string() + objects::Model::CacheSuffix);
+
+    EXPECT_THROW(obj::load("/this/file/does/not/exist.obj"), basal::exception);
+}
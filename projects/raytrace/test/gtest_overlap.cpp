@@ -342,4 +342,50 @@ TEST(OverlapTest, CuboidSphereSubtractiveAndSphereInclusive) {
         raytrace::vector N{0, 0, 1};
         ASSERT_VECTOR_EQ(N, h.normal);
     }
-}
\ No newline at end of file
+}
+
+TEST(OverlapTest, SeparateObjectsAndMissedBounds) {
+    using namespace raytrace;
+    using namespace raytrace::objects;
+
+    objects::sphere s0{R3::point(-3, 0, 0), 1};
+    objects::sphere s1{R3::point(3, 0, 0), 1};
+    overlap shape(s0, s1, overlap::type::exclusive);  // centered at the origin
+    // both objects are kept when they do not touch
+    hits both = shape.collisions_along(raytrace::ray{raytrace::point{-10, 0, 0}, R3::basis::X});
+    ASSERT_EQ(4U, both.size());
+    EXPECT_PRECISION_EQ(6.0_p, both[0].distance);
+    EXPECT_PRECISION_EQ(14.0_p, both[3].distance);
+    // only the object the ray passes is asked
+    hits one = shape.collisions_along(raytrace::ray{raytrace::point{-3, -10, 0}, R3::basis::Y});
+    ASSERT_EQ(2U, one.size());
+    EXPECT_PRECISION_EQ(9.0_p, one[0].distance);
+    // a ray which passes beside both has nothing
+    EXPECT_EQ(0U, shape.collisions_along(raytrace::ray{raytrace::point{-10, 5, 0}, R3::basis::X}).size());
+    // the subtracted object alone leaves nothing
+    overlap cut(s0, s1, overlap::type::subtractive);
+    EXPECT_EQ(0U, cut.collisions_along(cut.reverse_transform(raytrace::ray{raytrace::point{3, -10, 0}, R3::basis::Y}))
+                      .size());
+}
+
+TEST(OverlapTest, ObjectMovedAfterTheOverlap) {
+    using namespace raytrace;
+    using namespace raytrace::objects;
+
+    objects::sphere s0{R3::point(-3, 0, 0), 1};
+    objects::sphere s1{R3::point(3, 0, 0), 1};
+    overlap shape(s0, s1, overlap::type::exclusive);  // centered at the origin
+    raytrace::ray const beside{raytrace::point{-10, 5, 0}, R3::basis::X};
+    EXPECT_EQ(0U, shape.collisions_along(beside).size());
+    // the ray which passed beside both now passes through the moved object
+    s1.position(R3::point(3, 5, 0));
+    hits const moved = shape.collisions_along(beside);
+    ASSERT_EQ(2U, moved.size());
+    EXPECT_PRECISION_EQ(12.0_p, moved[0].distance);
+    EXPECT_PRECISION_EQ(14.0_p, moved[1].distance);
+    // and where it was is empty
+    EXPECT_EQ(2U, shape.collisions_along(raytrace::ray{raytrace::point{-10, 0, 0}, R3::basis::X}).size());
+    // the bounds of the overlap follow it too
+    Bounds const bounds = shape.get_object_bounds();
+    EXPECT_TRUE(bounds.contained(raytrace::point{3, 5, 0}));
+}
@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <basal/basal.hpp>
+#include <cmath>
+#include <random>
+#include <raytrace/raytrace.hpp>
+#include <vector>
+
+#include "geometry/gtest_helper.hpp"
+#include "linalg/gtest_helper.hpp"
+#include "raytrace/gtest_helper.hpp"
+
+using namespace raytrace;
+
+namespace {
+/// Makes packets of rays which start around the origin and point near the target
+class RayMaker {
+public:
+    RayMaker() : m_generator{1234U}, m_spread{-1.0_p, 1.0_p} {
+    }
+
+    ray_packet make(point const& target, precision radius, size_t count = ray_packet::width) {
+        ray_packet rays;
+        for (size_t i = 0; i < count; i++) {
+            point const origin{10.0_p * m_spread(m_generator), 10.0_p * m_spread(m_generator),
+                               10.0_p * m_spread(m_generator)};
+            point const aim{target.x() + radius * m_spread(m_generator), target.y() + radius * m_spread(m_generator),
+                            target.z() + radius * m_spread(m_generator)};
+            vector const direction = aim - origin;
+            rays.push(ray{origin, direction.normalized()});
+        }
+        return rays;
+    }
+
+protected:
+    std::mt19937 m_generator;
+    std::uniform_real_distribution<precision> m_spread;
+};
+
+/// Checks the packet distances of an object against the scalar intersection of each lane
+void expect_same_distances(objects::object const& obj, point const& target, precision radius) {
+    RayMaker maker;
+    size_t compared = 0U;
+    size_t hits = 0U;
+    for (size_t p = 0; p < 64; p++) {
+        ray_packet rays = maker.make(target, radius);
+        precision distances[ray_packet::width];
+        ASSERT_TRUE(obj.intersect(rays, distances));
+        for (size_t lane = 0; lane < rays.count; lane++) {
+            if (std::isnan(distances[lane])) {
+                continue;  // left to the scalar path
+            }
+            ray const world_ray = rays.get(lane);
+            objects::hit const h = obj.intersect(world_ray);
+            compared++;
+            if (get_type(h.intersect) == IntersectionType::Point) {
+                precision const expected = (as_point(h.intersect) - world_ray.location()).magnitude();
+                // single precision keeps about 7 digits of the distance
+                precision const tolerance = basal::use_high_precision ? 1E-6 : 1E-5 * std::max(1.0_p, expected);
+                ASSERT_NEAR(expected, distances[lane], tolerance) << " lane " << lane << " of packet " << p;
+                hits++;
+            } else {
+                ASSERT_TRUE(std::isinf(distances[lane])) << " lane " << lane << " of packet " << p;
+            }
+        }
+    }
+    // most lanes should have been decided by the packet test and some of them should hit
+    EXPECT_GT(compared, 64U * ray_packet::width * 9U / 10U);
+    EXPECT_GT(hits, 0U);
+}
+}  // namespace
+
+TEST(PacketTest, SetAndGet) {
+    ray_packet rays;
+    EXPECT_EQ(0U, rays.count);
+    ray const r{point{1, 2, 3}, vector{{0, 0, 1}}};
+    for (size_t i = 0; i < ray_packet::width; i++) {
+        EXPECT_TRUE(rays.push(r));
+    }
+    EXPECT_FALSE(rays.push(r));
+    EXPECT_EQ(ray_packet::width, rays.count);
+    ray const g = rays.get(ray_packet::width - 1U);
+    ASSERT_POINT_EQ(r.location(), g.location());
+    ASSERT_VECTOR_EQ(r.direction(), g.direction());
+    EXPECT_TRUE(std::isinf(rays.inverse[0][0]));
+    EXPECT_DOUBLE_EQ(1.0_p, rays.inverse[2][0]);
+}
+
+TEST(PacketTest, Coherence) {
+    ray_packet rays;
+    rays.push(ray{point{0, 0, 0}, vector{{1, 1, 1}}.normalized()});
+    rays.push(ray{point{5, 0, 0}, vector{{1, 2, 3}}.normalized()});
+    EXPECT_TRUE(rays.coherent());
+    rays.push(ray{point{0, 0, 0}, vector{{1, -1, 1}}.normalized()});
+    EXPECT_FALSE(rays.coherent());
+}
+
+TEST(PacketTest, Sphere) {
+    objects::sphere s0{point{1, 2, 3}, 2.0_p};
+    expect_same_distances(s0, s0.position(), 2.0_p);
+}
+
+TEST(PacketTest, Plane) {
+    objects::plane p0{point{0, 0, -1}, R3::identity};
+    p0.rotation(iso::degrees{20}, iso::degrees{-30}, iso::degrees{0});
+    expect_same_distances(p0, p0.position(), 5.0_p);
+}
+
+TEST(PacketTest, Wall) {
+    objects::wall w0{point{1, 0, 0}, R3::identity, 1.0_p};
+    w0.rotation(iso::degrees{0}, iso::degrees{45}, iso::degrees{10});
+    expect_same_distances(w0, w0.position(), 3.0_p);
+}
+
+TEST(PacketTest, Cuboid) {
+    objects::cuboid c0{point{-1, 1, 2}, 1.0_p, 2.0_p, 3.0_p};
+    c0.rotation(iso::degrees{15}, iso::degrees{0}, iso::degrees{30});
+    expect_same_distances(c0, c0.position(), 4.0_p);
+}
+
+TEST(PacketTest, SubclassesUseScalar) {
+    objects::square q0{point{0, 0, 0}, R3::identity, 2.0_p};
+    ray_packet rays;
+    rays.push(ray{point{0, 0, 5}, vector{{0, 0, -1}}});
+    precision distances[ray_packet::width];
+    EXPECT_FALSE(q0.intersect(rays, distances));
+}
+
+TEST(PacketTest, HierarchyMatchesScalar) {
+    std::vector<objects::sphere> spheres;
+    for (size_t i = 0; i < 27; i++) {
+        spheres.emplace_back(point{3.0_p * (i % 3), 3.0_p * ((i / 3) % 3), 3.0_p * (i / 9)}, 1.0_p);
+    }
+    tree::BVH::object_list list;
+    for (auto& s : spheres) {
+        list.push_back(&s);
+    }
+    tree::BVH bvh;
+    bvh.build(list);
+    RayMaker maker;
+    for (size_t p = 0; p < 32; p++) {
+        ray_packet const rays = maker.make(point{3, 3, 3}, 4.0_p);
+        uint32_t const active = (1U << rays.count) - 1U;
+        tree::packet_hits nearest;
+        precision t_max[ray_packet::width];
+        precision max_distance[ray_packet::width];
+        objects::object const* blockers[ray_packet::width] = {};
+        for (size_t lane = 0; lane < ray_packet::width; lane++) {
+            t_max[lane] = basal::pos_inf;
+            max_distance[lane] = 8.0_p;
+        }
+        bvh.closest(rays, active, nearest, t_max);
+        uint32_t const blocked = bvh.occluders(rays, active, max_distance, blockers);
+        for (size_t lane = 0; lane < rays.count; lane++) {
+            ray const world_ray = rays.get(lane);
+            objects::hit expected;
+            precision expected_t_max = basal::pos_inf;
+            bvh.closest(world_ray, expected, expected_t_max);
+            EXPECT_EQ(expected.object, nearest[lane].object) << " lane " << lane << " of packet " << p;
+            bool const occluded = bvh.occluder(world_ray, 8.0_p) != nullptr;
+            EXPECT_EQ(occluded, (blocked & (1U << lane)) != 0U) << " lane " << lane << " of packet " << p;
+        }
+    }
+}
+
+TEST(PacketTest, SceneMatchesScalar) {
+    raytrace::scene scene;
+    std::vector<objects::sphere> spheres;
+    spheres.reserve(16);
+    for (size_t i = 0; i < 16; i++) {
+        spheres.emplace_back(point{2.5_p * (i % 4), 2.5_p * (i / 4), 0.0_p}, 1.0_p);
+    }
+    objects::plane floor{point{0, 0, -2}, R3::identity};
+    objects::cuboid box{point{4, 4, 3}, 1.0_p, 1.0_p, 1.0_p};
+    for (auto& s : spheres) {
+        scene.add_object(&s);
+    }
+    scene.add_object(&floor);
+    scene.add_object(&box);
+    // the hierarchy is built by a render
+    raytrace::camera view{8, 8, iso::degrees{60}};
+    view.move_to(point{20, 4, 8}, point{4, 4, 0});
+    scene.render(view, "", 1, 1, std::nullopt);
+    RayMaker maker;
+    for (size_t p = 0; p < 32; p++) {
+        ray_packet rays = maker.make(point{4, 4, 0}, 6.0_p, 1U + (p % ray_packet::width));
+        tree::packet_hits nearest;
+        scene.nearest_intersection(rays, nearest);
+        for (size_t lane = 0; lane < rays.count; lane++) {
+            objects::hit const expected = scene.nearest_intersection(rays.get(lane));
+            ASSERT_EQ(get_type(expected.intersect), get_type(nearest[lane].intersect));
+            EXPECT_EQ(expected.object, nearest[lane].object) << " lane " << lane << " of packet " << p;
+            if (get_type(expected.intersect) == IntersectionType::Point) {
+                ASSERT_POINT_EQ(as_point(expected.intersect), as_point(nearest[lane].intersect));
+            }
+        }
+    }
+}
@@ -1,6 +1,9 @@
 #include "basal/gtest_helper.hpp"
 
+#include <algorithm>
 #include <basal/basal.hpp>
+#include <filesystem>
+#include <fstream>
 #include <raytrace/raytrace.hpp>
 #include <vector>
 
@@ -224,3 +227,274 @@ TEST(SceneTest, MultipleEmissiveObjectsContributeLight) {
     ASSERT_PRECISION_EQ(0.0_p, blue_emitted.green());
     ASSERT_PRECISION_EQ(0.625_p, blue_emitted.blue());
 }
+
+TEST(SceneTest, ProgressivePassesRestartOnChange) {
+    using namespace raytrace;
+    raytrace::objects::sphere s0{raytrace::point{4, 0, 0}, 1.0_p};
+    raytrace::objects::sphere s1{raytrace::point{4, 2, 0}, 0.5_p};
+    raytrace::lights::beam sunlight{raytrace::vector{-1, 0, -1}, raytrace::colors::white, lights::intensities::full};
+    scene scene;
+    scene.add_object(&s0);
+    scene.add_light(&sunlight);
+    raytrace::camera view(12, 16, iso::degrees(55));
+    view.move_to(raytrace::point{-1, 0, 0}, raytrace::point{4, 0, 0});
+    ASSERT_EQ(0U, scene.accumulated_passes());
+    ASSERT_EQ(1U, scene.render_pass(view));
+    ASSERT_EQ(2U, scene.render_pass(view));
+    ASSERT_EQ(3U, scene.render_pass(view));
+    // moving the camera restarts
+    view.move_to(raytrace::point{-2, 0, 0}, raytrace::point{4, 0, 0});
+    ASSERT_EQ(1U, scene.render_pass(view));
+    ASSERT_EQ(2U, scene.render_pass(view));
+    // a deeper trace restarts
+    ASSERT_EQ(1U, scene.render_pass(view, 2U));
+    // changing the scene restarts
+    scene.add_object(&s1);
+    ASSERT_EQ(1U, scene.render_pass(view, 2U));
+    // so does asking for it
+    scene.reset_accumulation();
+    ASSERT_EQ(0U, scene.accumulated_passes());
+    ASSERT_EQ(1U, scene.render_pass(view, 2U));
+}
+
+TEST(SceneTest, ObjectsAddedAfterARenderAreTraced) {
+    using namespace raytrace;
+    // enough spheres that the scene uses its hierarchy
+    std::vector<objects::sphere> row;
+    row.reserve(brute_force_to_bounding_box);
+    for (size_t i = 0; i < brute_force_to_bounding_box; i++) {
+        row.emplace_back(raytrace::point{4, precision(i) * 3.0_p, 0}, 1.0_p);
+    }
+    raytrace::lights::beam sunlight{raytrace::vector{-1, 0, -1}, raytrace::colors::white, lights::intensities::full};
+    scene scene;
+    for (auto const& s : row) {
+        scene.add_object(&s);
+    }
+    scene.add_light(&sunlight);
+    raytrace::camera view(12, 16, iso::degrees(55));
+    view.move_to(raytrace::point{-1, 0, 0}, raytrace::point{4, 0, 0});
+    ASSERT_EQ(1U, scene.render_pass(view));
+    ASSERT_FALSE(scene.hierarchy().empty());
+    // a sphere below the row is added once the hierarchy has been built
+    raytrace::objects::sphere late{raytrace::point{4, 0, -3}, 1.0_p};
+    ray const down{raytrace::point{4, 0, -10}, vector{{0, 0, 1}}};
+    scene.add_object(&late);
+    ASSERT_EQ(1U, scene.render_pass(view));
+    objects::hits const list = scene.find_intersections(down);
+    bool const found = std::any_of(list.begin(), list.end(), [&](auto const& h) { return h.object == &late; });
+    EXPECT_TRUE(found);
+}
+
+TEST(SceneTest, ClearForgetsEveryObject) {
+    using namespace raytrace;
+    raytrace::objects::plane ground{raytrace::point{0, 0, -5}, R3::identity};
+    std::vector<objects::sphere> row;
+    row.reserve(brute_force_to_bounding_box);
+    for (size_t i = 0; i < brute_force_to_bounding_box; i++) {
+        row.emplace_back(raytrace::point{4, precision(i) * 3.0_p, 0}, 1.0_p);
+    }
+    scene scene;
+    scene.add_object(&ground);
+    for (auto const& s : row) {
+        scene.add_object(&s);
+    }
+    ray const down{raytrace::point{-4, 0, 0}, vector{{0, 0, -1}}};
+    ASSERT_FALSE(scene.find_intersections(down).empty());
+    // after a clear only the objects added since are intersected (the ground was an infinite object)
+    scene.clear();
+    ASSERT_EQ(0U, scene.number_of_objects());
+    for (auto const& s : row) {
+        scene.add_object(&s);
+    }
+    EXPECT_TRUE(scene.find_intersections(down).empty());
+}
+
+TEST(SceneTest, ProgressiveFirstPassMatchesRender) {
+    using namespace raytrace;
+    raytrace::objects::sphere s0{raytrace::point{4, 0, 0}, 1.0_p};
+    raytrace::lights::beam sunlight{raytrace::vector{-1, 0, -1}, raytrace::colors::white, lights::intensities::full};
+    scene scene;
+    scene.add_object(&s0);
+    scene.add_light(&sunlight);
+    raytrace::camera view(12, 16, iso::degrees(55));
+    view.move_to(raytrace::point{-1, 0, 0}, raytrace::point{4, 0, 0});
+    // a single sample renders at the pixel centers, which is where the first pass is also sampled
+    scene.render(view, std::string{});
+    fourcc::image<fourcc::PixelFormat::RGBId> const rendered{view.capture};
+    scene.render_pass(view);
+    for (size_t y = 0; y < view.capture.height; y++) {
+        for (size_t x = 0; x < view.capture.width; x++) {
+            ASSERT_EQ(rendered.at(y, x).components.r, view.capture.at(y, x).components.r) << x << ", " << y;
+            ASSERT_EQ(rendered.at(y, x).components.g, view.capture.at(y, x).components.g) << x << ", " << y;
+            ASSERT_EQ(rendered.at(y, x).components.b, view.capture.at(y, x).components.b) << x << ", " << y;
+        }
+    }
+}
+
+TEST(SceneTest, AdaptiveSamplingHeatmap) {
+    using namespace raytrace;
+    raytrace::objects::sphere s0{raytrace::point{4, 0, 0}, 1.0_p};
+    raytrace::lights::beam sunlight{raytrace::vector{-1, 0, -1}, raytrace::colors::white, lights::intensities::full};
+    scene scene;
+    scene.add_object(&s0);
+    scene.add_light(&sunlight);
+    raytrace::camera view(24, 32, iso::degrees(55));
+    view.move_to(raytrace::point{-1, 0, 0}, raytrace::point{4, 0, 0});
+    constexpr size_t max_samples = 64U;
+    scene.render(view, std::string{}, max_samples, 1U, std::nullopt, image::AAA_MASK_ENABLED);
+    // the (black) background only needs one sample, while the edges of the sphere need more
+    uint8_t const single = static_cast<uint8_t>(255U / max_samples);
+    EXPECT_EQ(single, view.mask.at(0, 0));
+    EXPECT_EQ(single, view.mask.at(view.mask.height - 1U, view.mask.width - 1U));
+    size_t refined = 0U;
+    view.mask.for_each([&](uint8_t const& pixel) { refined += (pixel > single) ? 1U : 0U; });
+    EXPECT_LT(0U, refined);
+    EXPECT_GT(view.mask.area() / 2, static_cast<int>(refined));
+}
+
+TEST(SceneTest, ManyLightsHaveAFixedShadowBudget) {
+    using namespace raytrace;
+    raytrace::objects::plane floor;
+    std::vector<std::unique_ptr<lights::speck>> specks;
+    scene scene;
+    scene.add_object(&floor);
+    raytrace::camera view(2, 2, iso::degrees(55));
+    view.move_to(raytrace::point{1, 0, 10}, raytrace::point{0, 0, 0});
+    raytrace::ray const down{raytrace::point{0.5_p, 0.25_p, 10}, -R3::basis::Z};
+    for (size_t count : {light_selection_threshold, 4U * light_selection_threshold}) {
+        while (specks.size() < count) {
+            precision const angle = static_cast<precision>(specks.size());
+            specks.push_back(std::make_unique<lights::speck>(
+                raytrace::point{10.0_p * std::cos(angle), 10.0_p * std::sin(angle), 5.0_p}, colors::white, 100.0_p));
+            scene.add_light(specks.back().get());
+        }
+        scene.render(view, std::string{});  // builds the selection of the lights
+        size_t const before = raytrace::statistics::get().sampled_rays;
+        color const lit = scene.trace(down, mediums::vacuum, 1U);
+        raytrace::statistics::collect();
+        EXPECT_EQ(light_selection_budget, raytrace::statistics::get().sampled_rays - before)
+            << "with " << count << " lights";
+        EXPECT_LT(0.0_p, lit.red());
+    }
+}
+
+TEST(SceneTest, RussianRouletteIsUnbiased) {
+    using namespace raytrace;
+    // a hall of mirrors between a floor and a ceiling which is only lit by the ambient light, so every path is as long
+    // as the reflection depth and every path has the same color
+    mediums::plain polished{colors::white, 0.0_p, colors::white, mediums::smoothness::polished, 10.0_p};
+    raytrace::objects::plane floor{raytrace::point{0, 0, 0}, R3::identity};
+    raytrace::objects::plane ceiling{raytrace::point{0, 0, 1}, R3::roll(0.5_p)};
+    floor.material(&polished);
+    ceiling.material(&polished);
+    constexpr size_t depth = 12U;
+    raytrace::camera view(2, 2, iso::degrees(55));
+    view.move_to(raytrace::point{0, 0, 0.5_p}, raytrace::point{10, 0, 0.5_p});
+    auto path = [](size_t index) {
+        precision const offset = static_cast<precision>(index);
+        return raytrace::ray{raytrace::point{0.37_p * offset, 0.13_p * offset, 0.5_p},
+                             raytrace::vector{{1, 0, -1}}.normalized()};
+    };
+    auto hall = [&](scene& s) {
+        s.add_object(&floor);
+        s.add_object(&ceiling);
+        s.set_ambient_light(color{1.0_p, 1.0_p, 1.0_p, 0.5_p});
+        s.render(view, std::string{}, 1U, depth);
+    };
+    scene exact{0.0_p};  // the threshold never ends a path
+    hall(exact);
+    color const expected = exact.trace(path(0), mediums::vacuum, depth);
+
+    scene roulette;
+    EXPECT_EQ(Termination::Threshold, roulette.termination());
+    roulette.set_termination(Termination::RussianRoulette);
+    hall(roulette);
+    raytrace::statistics::collect();
+    raytrace::statistics const before = raytrace::statistics::get();
+    constexpr size_t paths = 4096U;
+    precision sum = 0.0_p;
+    for (size_t i = 0; i < paths; i++) {
+        sum += roulette.trace(path(i), mediums::vacuum, depth).red();
+    }
+    precision const mean = sum / static_cast<precision>(paths);
+    std::cout << "Exact " << expected.red() << " russian roulette " << mean << std::endl;
+    EXPECT_NEAR(expected.red(), mean, expected.red() / 200.0_p);
+    if constexpr (raytrace::statistics::enabled) {
+        raytrace::statistics::collect();
+        raytrace::statistics const& after = raytrace::statistics::get();
+        size_t played = 0U, survived = 0U;
+        for (size_t d = 0; d < raytrace::statistics::max_depth; d++) {
+            size_t const played_at = after.roulette_rays_at_depth[d] - before.roulette_rays_at_depth[d];
+            size_t const survived_at = after.survived_rays_at_depth[d] - before.survived_rays_at_depth[d];
+            if (d <= russian_roulette_depth) {
+                EXPECT_EQ(0U, played_at) << "The first bounces are always traced";
+            }
+            EXPECT_LE(survived_at, played_at);
+            played += played_at;
+            survived += survived_at;
+        }
+        // every path plays once it is deep enough and the deeper rays are mostly not traced
+        EXPECT_EQ(paths, after.roulette_rays_at_depth[russian_roulette_depth + 1U]
+                             - before.roulette_rays_at_depth[russian_roulette_depth + 1U]);
+        EXPECT_LT(survived, played / 2U);
+    }
+}
+
+TEST(SceneTest, ProfilesEachTile) {
+    using namespace raytrace;
+    raytrace::objects::sphere ball{raytrace::point{0, 0, 0}, 2};
+    lights::speck light{raytrace::point{0, 0, 10}, colors::white, 1E3};
+    scene scene;
+    scene.add_object(&ball);
+    scene.add_light(&light);
+    scene.set_tiling(tiling{8U, 8U, TileOrder::Scanline});
+    scene.set_profiling(true);
+    raytrace::camera view(32, 48, iso::degrees(55));
+    view.move_to(raytrace::point{0, -10, 0}, raytrace::point{0, 0, 0});
+    std::string const stem = (std::filesystem::temp_directory_path() / "gtest_scene_profile").string();
+    size_t notified = 0U;
+    image::rendered_tile const notifier = [&](tile const&, bool) {
+#pragma omp atomic
+        notified++;
+    };
+    raytrace::statistics::collect();
+    size_t const before = raytrace::statistics::get().total_rays();
+    scene.render(view, stem + ".ppm", 1U, 2U, notifier);
+    size_t const rays = raytrace::statistics::get().total_rays() - before;
+    // every tile is recorded once and still passed on to the callback
+    std::vector<profiler::tile_cost> const& costs = scene.profile().costs();
+    ASSERT_EQ(24U, costs.size());
+    EXPECT_EQ(24U, notified);
+    size_t pixels = 0U;
+    size_t charged = 0U;
+    for (profiler::tile_cost const& cost : costs) {
+        pixels += cost.region.width * cost.region.height;
+        charged += cost.rays;
+        EXPECT_LE(0.0, cost.start_us);
+        EXPECT_LT(0.0, cost.duration_us);
+        EXPECT_LE(cost.depth, 1U);
+    }
+    EXPECT_EQ(32U * 48U, pixels);
+    if constexpr (raytrace::statistics::enabled) {
+        // all the rays of the render are charged to some tile
+        EXPECT_EQ(rays, charged);
+        // the center of the image sees the ball which casts shadow rays and bounces, the corner only sees the void
+        auto const rays_per_pixel = scene.profile().heatmap(Cost::Rays);
+        EXPECT_LT(rays_per_pixel.at(0, 0).components.r, rays_per_pixel.at(16, 24).components.r);
+        EXPECT_FLOAT_EQ(1.0f, rays_per_pixel.at(0, 0).components.r);
+    }
+    // the heatmaps and the trace go next to the image
+    for (char const* suffix : {".ppm", "_time.pfm", "_rays.pfm", "_intersections.pfm", "_depth.pfm", "_trace.json"}) {
+        EXPECT_TRUE(std::filesystem::exists(stem + suffix)) << suffix;
+    }
+    std::ifstream file{stem + "_trace.json"};
+    std::string const trace{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    size_t events = 0U;
+    for (size_t at = trace.find("\"ph\":\"X\""); at != std::string::npos; at = trace.find("\"ph\":\"X\"", at + 1U)) {
+        events++;
+    }
+    EXPECT_EQ(24U, events);
+    for (char const* suffix : {".ppm", "_time.pfm", "_rays.pfm", "_intersections.pfm", "_depth.pfm", "_trace.json"}) {
+        std::filesystem::remove(stem + suffix);
+    }
+}
@@ -130,6 +130,9 @@ TEST(SquareTest, Intersection3) {
 }
 
 TEST(SquareTest, SandwichRays) {
+    if constexpr (not basal::use_high_precision) {
+        GTEST_SKIP() << "The rays land exactly on the edges, which single precision rounds to either side";
+    }
     using namespace raytrace;
     using namespace raytrace::objects;
 
@@ -0,0 +1,81 @@
+#include "basal/gtest_helper.hpp"
+
+#include <basal/basal.hpp>
+#include <raytrace/raytrace.hpp>
+#include <thread>
+#include <vector>
+
+#include "raytrace/gtest_helper.hpp"
+
+using namespace raytrace;
+
+TEST(StatisticsTest, MergesThreads) {
+    if constexpr (not raytrace::statistics::enabled) {
+        GTEST_SKIP() << "Statistics are compiled out";
+    }
+    raytrace::statistics::collect();
+    size_t const before = raytrace::statistics::get().shadow_rays;
+    constexpr size_t number_of_threads = 4U;
+    constexpr size_t number_of_counts = 1000U;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < number_of_threads; t++) {
+        threads.emplace_back([]() {
+            for (size_t i = 0; i < number_of_counts; i++) {
+                raytrace::statistics::count(&raytrace::statistics::shadow_rays);
+            }
+        });
+    }
+    // counts in this (still running) thread are merged by collect
+    raytrace::statistics::count(&raytrace::statistics::shadow_rays, 7U);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    raytrace::statistics::collect();
+    EXPECT_EQ(before + number_of_threads * number_of_counts + 7U, raytrace::statistics::get().shadow_rays);
+    // collecting again does not count anything twice
+    raytrace::statistics::collect();
+    EXPECT_EQ(before + number_of_threads * number_of_counts + 7U, raytrace::statistics::get().shadow_rays);
+}
+
+TEST(StatisticsTest, PaddedBlocks) {
+    EXPECT_EQ(0U, alignof(raytrace::statistics) % 64U);
+    EXPECT_EQ(0U, sizeof(raytrace::statistics) % 64U);
+}
+
+TEST(StatisticsTest, DepthsAndRate) {
+    raytrace::statistics s;
+    s.cast_rays_from_camera = 10U;
+    s.bounced_rays = 5U;
+    s.transmitted_rays = 3U;
+    s.sampled_rays = 2U;
+    EXPECT_EQ(20U, s.total_rays());
+    EXPECT_DOUBLE_EQ(0.0, s.rays_per_second());
+    s.render_seconds = 2.0;
+    EXPECT_DOUBLE_EQ(10.0, s.rays_per_second());
+    raytrace::statistics t;
+    t.traced_rays_at_depth[1] = 4U;
+    t.missed_rays_at_depth[1] = 1U;
+    s += t;
+    s += t;
+    EXPECT_EQ(8U, s.traced_rays_at_depth[1]);
+    EXPECT_EQ(2U, s.missed_rays_at_depth[1]);
+}
+
+TEST(StatisticsTest, RenderCountsByDepth) {
+    if constexpr (not raytrace::statistics::enabled) {
+        GTEST_SKIP() << "Statistics are compiled out";
+    }
+    raytrace::objects::sphere s0{raytrace::point{0, 0, 0}, 1};
+    raytrace::scene scene;
+    scene.add_object(&s0);
+    raytrace::camera view{4, 4, iso::degrees(30)};
+    view.move_to(raytrace::point{10, 0, 0}, raytrace::point{0, 0, 0});
+    raytrace::statistics::collect();
+    raytrace::statistics const before = raytrace::statistics::get();
+    scene.render(view, std::string{}, 1, 2);
+    raytrace::statistics const& after = raytrace::statistics::get();
+    // every camera ray is traced at depth zero
+    EXPECT_EQ(after.cast_rays_from_camera - before.cast_rays_from_camera,
+              after.traced_rays_at_depth[0] - before.traced_rays_at_depth[0]);
+    EXPECT_GT(after.render_seconds, before.render_seconds);
+}
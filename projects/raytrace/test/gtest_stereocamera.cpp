@@ -148,8 +148,8 @@ TEST(StereoCameraTest, Separation) {
     size_t const width = 240;
     size_t const height = 120;
     double const separation = 10.0_p;
-    double const sqrt2 = std::sqrt(2.0_p);
-    double const hsepsqrt2 = separation / (2 * sqrt2);
+    precision const sqrt2 = std::sqrt(2.0_p);
+    precision const hsepsqrt2 = separation / (2 * sqrt2);
     using set = raytrace::point[4];
     set sets[] = {
         {raytrace::point{0.0_p, 0.0_p, 0.0_p}, raytrace::point{0.0_p, 100, 0.0_p},
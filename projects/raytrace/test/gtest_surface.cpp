@@ -25,6 +25,37 @@ TEST(SurfaceTest, ShinySurface) {
     ASSERT_PRECISION_EQ(250.0_p, shiny.specular_tightness(R3::origin));
 }
 
+TEST(SurfaceTest, EvaluateMatchesVirtuals) {
+    using namespace raytrace;
+    raytrace::point const p{0.25_p, 0.5_p, 0.0_p};
+    mediums::plain shiny(colors::white, 0.1_p, colors::red, 0.7_p, 250.0_p);
+    mediums::metal steel(colors::grey, 0.9_p, 100.0_p);
+    mediums::transparent glass(1.5_p, 0.1_p, colors::blue);
+    mediums::checkerboard board(6.0_p, colors::red, colors::green);
+    std::vector<mediums::medium const*> media = {&shiny, &steel, &glass, &board};
+    for (mediums::medium const* m : media) {
+        mediums::surface const s = m->evaluate(p);
+        ASSERT_NE(mediums::Kind::Custom, m->kind());
+        ASSERT_EQ(m->kind(), s.kind);
+        ASSERT_COLOR_EQ(m->diffuse(p), s.diffuse);
+        ASSERT_COLOR_EQ(m->emissive(p), s.emissive);
+        ASSERT_COLOR_EQ(m->specular(p, 0.5_p, colors::white), s.specular(0.5_p, colors::white));
+        ASSERT_COLOR_EQ(m->bounced(p, colors::white), s.bounced(colors::white));
+        ASSERT_PRECISION_EQ(m->specular_tightness(p), s.tightness);
+        ASSERT_PRECISION_EQ(m->smoothness(p), s.smoothness);
+        ASSERT_PRECISION_EQ(m->refractive_index(p), s.refractive_index);
+        precision emitted[2] = {0.0_p, 0.0_p};
+        precision reflected[2] = {0.0_p, 0.0_p};
+        precision transmitted[2] = {0.0_p, 0.0_p};
+        iso::radians incident_angle(0.2_p);
+        iso::radians transmitted_angle(0.1_p);
+        m->radiosity(p, 1.0_p, incident_angle, transmitted_angle, emitted[0], reflected[0], transmitted[0]);
+        s.radiosity(1.0_p, incident_angle, transmitted_angle, emitted[1], reflected[1], transmitted[1]);
+        ASSERT_PRECISION_EQ(reflected[0], reflected[1]);
+        ASSERT_PRECISION_EQ(transmitted[0], transmitted[1]);
+    }
+}
+
 TEST(SurfaceTest, CheckerboardDiffuse) {
     using namespace raytrace;
     image img(480, 480);
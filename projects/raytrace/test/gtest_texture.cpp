@@ -0,0 +1,144 @@
+#include "basal/gtest_helper.hpp"
+
+#include <basal/basal.hpp>
+#include <filesystem>
+#include <raytrace/raytrace.hpp>
+
+#include "raytrace/gtest_helper.hpp"
+
+using namespace raytrace;
+
+namespace {
+/// A pattern which is red on the left half and blue on the right half
+color halves(image::point const& p) {
+    return (p.x() < 0.5_p) ? colors::red : colors::blue;
+}
+}  // namespace
+
+TEST(TextureTest, Levels) {
+    texture tex{16U, halves};
+    ASSERT_EQ(16U, tex.resolution());
+    ASSERT_EQ(5U, tex.levels());
+    EXPECT_FLOAT_EQ(1.0f, tex.at(0U, 3U, 2U).components.r);
+    EXPECT_FLOAT_EQ(1.0f, tex.at(0U, 3U, 12U).components.b);
+    // the last level is the average of everything
+    EXPECT_FLOAT_EQ(0.5f, tex.at(4U, 0U, 0U).components.r);
+    EXPECT_FLOAT_EQ(0.0f, tex.at(4U, 0U, 0U).components.g);
+    EXPECT_FLOAT_EQ(0.5f, tex.at(4U, 0U, 0U).components.b);
+    EXPECT_THROW(texture(12U, halves), basal::exception);
+}
+
+TEST(TextureTest, Filters) {
+    texture tex{16U, halves};
+    // at the center of a texel each filter gives the texel
+    image::point const center{2.5_p / 16.0_p, 7.5_p / 16.0_p};
+    ASSERT_COLOR_EQ(colors::red, tex.sample(center, Filter::Nearest, 0.0_p));
+    ASSERT_COLOR_EQ(colors::red, tex.sample(center, Filter::Bilinear, 0.0_p));
+    ASSERT_COLOR_EQ(colors::red, tex.sample(center, Filter::Trilinear, 0.0_p));
+    // half way between the halves is an even blend
+    image::point const edge{0.5_p, 0.25_p};
+    ASSERT_COLOR_EQ(colors::blue, tex.sample(edge, Filter::Nearest, 0.0_p));
+    color const blend = tex.sample(edge, Filter::Bilinear, 0.0_p);
+    EXPECT_NEAR(0.5_p, blend.red(), 1E-6);
+    EXPECT_NEAR(0.5_p, blend.blue(), 1E-6);
+    // the points wrap around the unit square
+    ASSERT_COLOR_EQ(colors::red, tex.sample(image::point{1.0_p + center.x(), center.y() - 3.0_p}, Filter::Bilinear,
+                                            0.0_p));
+    // a footprint as large as the texture is the average
+    color const average = tex.sample(center, Filter::Trilinear, 1.0_p);
+    EXPECT_NEAR(0.5_p, average.red(), 1E-6);
+    EXPECT_NEAR(0.5_p, average.blue(), 1E-6);
+}
+
+TEST(TextureTest, Addressing) {
+    texture wrapped{16U, halves};
+    texture clamped{16U, halves, Address::Clamp};
+    ASSERT_EQ(Address::Wrap, wrapped.address());
+    ASSERT_EQ(Address::Clamp, clamped.address());
+    // on the left edge a wrapped texture blends in the right edge, a clamped one does not
+    image::point const left{0.0_p, 0.5_p};
+    color const blend = wrapped.sample(left, Filter::Bilinear, 0.0_p);
+    EXPECT_NEAR(0.5_p, blend.red(), 1E-6);
+    EXPECT_NEAR(0.5_p, blend.blue(), 1E-6);
+    ASSERT_COLOR_EQ(colors::red, clamped.sample(left, Filter::Bilinear, 0.0_p));
+    // outside of the unit square the edges extend outward
+    image::point const beyond{1.25_p, 0.5_p};
+    ASSERT_COLOR_EQ(colors::red, wrapped.sample(beyond, Filter::Nearest, 0.0_p));
+    ASSERT_COLOR_EQ(colors::blue, clamped.sample(beyond, Filter::Nearest, 0.0_p));
+    ASSERT_COLOR_EQ(colors::blue, clamped.sample(beyond, Filter::Bilinear, 0.0_p));
+    ASSERT_COLOR_EQ(colors::red, clamped.sample(image::point{-0.25_p, 0.5_p}, Filter::Bilinear, 0.0_p));
+}
+
+TEST(TextureTest, SaveAndLoad) {
+    texture tex{8U, halves};
+    std::string const filename{"halves.tex"};
+    ASSERT_TRUE(tex.save(filename, "halves"));
+    ASSERT_EQ(nullptr, texture::load(filename, "thirds"));
+    ASSERT_EQ(nullptr, texture::load("missing.tex", "halves"));
+    auto loaded = texture::load(filename, "halves");
+    ASSERT_NE(nullptr, loaded);
+    ASSERT_EQ(tex.levels(), loaded->levels());
+    for (size_t y = 0; y < 8U; y++) {
+        for (size_t x = 0; x < 8U; x++) {
+            ASSERT_FLOAT_EQ(tex.at(0U, y, x).components.r, loaded->at(0U, y, x).components.r);
+            ASSERT_FLOAT_EQ(tex.at(0U, y, x).components.b, loaded->at(0U, y, x).components.b);
+        }
+    }
+    // the address is kept
+    texture clamped{8U, halves, Address::Clamp};
+    ASSERT_TRUE(clamped.save(filename, "halves"));
+    loaded = texture::load(filename, "halves");
+    ASSERT_NE(nullptr, loaded);
+    EXPECT_EQ(Address::Clamp, loaded->address());
+    // a resolution which does not match the size of the file is not used
+    FILE* file = fopen(filename.c_str(), "r+b");
+    ASSERT_NE(nullptr, file);
+    fseek(file, 24, SEEK_SET);
+    uint64_t const resolution{uint64_t{1U} << 40};
+    fwrite(&resolution, sizeof(resolution), 1U, file);
+    fclose(file);
+    EXPECT_EQ(nullptr, texture::load(filename, "halves"));
+    // nor is a truncated file
+    ASSERT_TRUE(tex.save(filename, "halves"));
+    std::filesystem::resize_file(filename, std::filesystem::file_size(filename) - 1U);
+    EXPECT_EQ(nullptr, texture::load(filename, "halves"));
+    std::filesystem::remove(filename);
+}
+
+TEST(TextureTest, BakedMedium) {
+    objects::sphere ball{R3::origin, 1.0_p};
+    mediums::perlin marble{iso::degrees{81}.value, 10.0_p, 245.4993546_p, colors::black, colors::white};
+    EXPECT_THROW(marble.bake(64U, Filter::Bilinear), basal::exception);
+    marble.mapper(std::bind(&objects::sphere::map, &ball, std::placeholders::_1));
+    mediums::plain flat{colors::white, 0.1_p, colors::white, 0.1_p, 10.0_p};
+    flat.mapper(std::bind(&objects::sphere::map, &ball, std::placeholders::_1));
+    EXPECT_THROW(flat.bake(64U, Filter::Bilinear), basal::exception);
+
+    raytrace::point const p{0.6_p, 0.0_p, 0.8_p};
+    color const procedural = marble.diffuse(p);
+    std::string const directory{"."};
+    std::filesystem::remove(marble.bake_name(256U));
+    marble.bake(256U, Filter::Bilinear, 0.0_p, directory);
+    ASSERT_TRUE(marble.is_baked());
+    ASSERT_TRUE(std::filesystem::exists(marble.bake_name(256U)));
+    color const baked = marble.diffuse(p);
+    EXPECT_NEAR(procedural.red(), baked.red(), 0.1_p);
+    EXPECT_NEAR(procedural.green(), baked.green(), 0.1_p);
+    EXPECT_NEAR(procedural.blue(), baked.blue(), 0.1_p);
+    // the evaluated surface comes from the bake too
+    ASSERT_COLOR_EQ(baked, marble.evaluate(p).diffuse);
+
+    // a second bake of the same parameters comes from the cache
+    mediums::perlin copy{iso::degrees{81}.value, 10.0_p, 245.4993546_p, colors::black, colors::white};
+    copy.mapper(std::bind(&objects::sphere::map, &ball, std::placeholders::_1));
+    ASSERT_EQ(marble.bake_name(256U), copy.bake_name(256U));
+    copy.bake(256U, Filter::Bilinear, 0.0_p, directory);
+    ASSERT_COLOR_EQ(baked, copy.diffuse(p));
+    mediums::perlin other{iso::degrees{82}.value, 10.0_p, 245.4993546_p, colors::black, colors::white};
+    ASSERT_NE(marble.bake_name(256U), other.bake_name(256U));
+
+    marble.unbake();
+    ASSERT_FALSE(marble.is_baked());
+    ASSERT_COLOR_EQ(procedural, marble.diffuse(p));
+    std::filesystem::remove(marble.bake_name(256U));
+}
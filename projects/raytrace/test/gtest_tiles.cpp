@@ -0,0 +1,152 @@
+#include "basal/gtest_helper.hpp"
+
+#include <basal/basal.hpp>
+#include <raytrace/raytrace.hpp>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "raytrace/gtest_helper.hpp"
+
+using namespace raytrace;
+
+namespace {
+/// Counts how many times each pixel is covered by the tiles
+std::vector<size_t> coverage(std::vector<tile> const& tiles, size_t height, size_t width) {
+    std::vector<size_t> counts(height * width, 0U);
+    for (auto const& t : tiles) {
+        for (size_t y = t.y; y < t.y + t.height; y++) {
+            for (size_t x = t.x; x < t.x + t.width; x++) {
+                counts[y * width + x]++;
+            }
+        }
+    }
+    return counts;
+}
+}  // namespace
+
+TEST(TilesTest, CoverImageOnce) {
+    for (auto order : {TileOrder::Scanline, TileOrder::Morton, TileOrder::Spiral}) {
+        auto tiles = make_tiles(70, 100, tiling{16, 8, order});
+        ASSERT_EQ(7U * 9U, tiles.size());
+        for (size_t c : coverage(tiles, 70, 100)) {
+            ASSERT_EQ(1U, c);
+        }
+    }
+    EXPECT_THROW(make_tiles(10, 10, tiling{0, 8, TileOrder::Scanline}), basal::exception);
+}
+
+TEST(TilesTest, Orders) {
+    auto scanline = make_tiles(64, 64, tiling{16, 16, TileOrder::Scanline});
+    EXPECT_EQ(16U, scanline[1].x);
+    EXPECT_EQ(0U, scanline[1].y);
+    EXPECT_EQ(0U, scanline[4].x);
+    EXPECT_EQ(16U, scanline[4].y);
+    // Z-order visits the 2x2 block in the corner first
+    auto morton = make_tiles(64, 64, tiling{16, 16, TileOrder::Morton});
+    EXPECT_EQ(16U, morton[1].x);
+    EXPECT_EQ(0U, morton[1].y);
+    EXPECT_EQ(0U, morton[2].x);
+    EXPECT_EQ(16U, morton[2].y);
+    EXPECT_EQ(16U, morton[3].x);
+    EXPECT_EQ(16U, morton[3].y);
+    // spirals start with the four center tiles and end on the corners
+    auto spiral = make_tiles(64, 64, tiling{16, 16, TileOrder::Spiral});
+    for (size_t i = 0; i < 4; i++) {
+        EXPECT_TRUE(spiral[i].x == 16U or spiral[i].x == 32U);
+        EXPECT_TRUE(spiral[i].y == 16U or spiral[i].y == 32U);
+    }
+}
+
+TEST(TilesTest, SchedulerStealsRemainingWork) {
+    auto tiles = make_tiles(64, 64, tiling{8, 8, TileOrder::Scanline});
+    tile_scheduler scheduler{tiles, 4};
+    // only one worker shows up, so it must steal everything the others were dealt
+    std::vector<tile> taken;
+    tile t;
+    while (scheduler.next(2, t)) {
+        taken.push_back(t);
+    }
+    EXPECT_EQ(tiles.size(), taken.size());
+    EXPECT_EQ(tiles.size() * 3U / 4U, scheduler.steals());
+    for (size_t c : coverage(taken, 64, 64)) {
+        ASSERT_EQ(1U, c);
+    }
+}
+
+TEST(TilesTest, SchedulerThreads) {
+    auto tiles = make_tiles(128, 96, tiling{8, 8, TileOrder::Morton});
+    constexpr size_t number_of_workers = 4U;
+    tile_scheduler scheduler{tiles, number_of_workers};
+    std::vector<std::vector<tile>> taken(number_of_workers);
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < number_of_workers; w++) {
+        threads.emplace_back([&, w]() {
+            tile t;
+            while (scheduler.next(w, t)) {
+                taken[w].push_back(t);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::vector<tile> all;
+    for (auto const& list : taken) {
+        all.insert(all.end(), list.begin(), list.end());
+    }
+    for (size_t c : coverage(all, 128, 96)) {
+        ASSERT_EQ(1U, c);
+    }
+}
+
+TEST(TilesTest, ImageNotifiesEachTile) {
+    raytrace::image img{48, 64};
+    size_t pixels = 0U;
+    std::mutex mutex;
+    img.generate_each([](image::point const&) -> color { return colors::red; }, 1,
+                      [&](tile const& region, bool completed) {
+                          std::lock_guard<std::mutex> lock(mutex);
+                          EXPECT_TRUE(completed);
+                          pixels += region.width * region.height;
+                      },
+                      nullptr, image::AAA_MASK_DISABLED, false, tiling{16, 16, TileOrder::Spiral});
+    EXPECT_EQ(48U * 64U, pixels);
+    EXPECT_EQ(1.0, img.at(47, 63).components.r);
+}
+
+TEST(TilesTest, LineProgress) {
+    line_progress progress{48, 64};
+    ASSERT_EQ(48U, progress.lines());
+    EXPECT_EQ(0U, progress.complete_lines());
+    // a line is complete once every tile across it is
+    progress.update(tile{0, 0, 32, 16}, true);
+    EXPECT_FALSE(progress.is_complete(0));
+    progress.update(tile{32, 0, 32, 16}, true);
+    EXPECT_TRUE(progress.is_complete(0));
+    EXPECT_TRUE(progress.is_complete(15));
+    EXPECT_FALSE(progress.is_complete(16));
+    EXPECT_EQ(16U, progress.complete_lines());
+    // a tile which is rendered again un-counts only its own pixels
+    progress.update(tile{0, 0, 32, 8}, false);
+    EXPECT_FALSE(progress.is_complete(7));
+    EXPECT_TRUE(progress.is_complete(8));
+    EXPECT_EQ(8U, progress.complete_lines());
+    // so the lines are complete again as soon as it finishes, the other tile on them is still counted
+    progress.update(tile{0, 0, 32, 8}, true);
+    EXPECT_TRUE(progress.is_complete(7));
+    EXPECT_EQ(16U, progress.complete_lines());
+    // and un-counting never goes below nothing
+    progress.update(tile{0, 32, 64, 16}, false);
+    progress.update(tile{0, 32, 32, 16}, true);
+    EXPECT_FALSE(progress.is_complete(32));
+    progress.update(tile{32, 32, 32, 16}, true);
+    EXPECT_TRUE(progress.is_complete(32));
+    // a whole render completes every line
+    line_progress rendered{48, 64};
+    raytrace::image img{48, 64};
+    img.generate_each([](image::point const&) -> color { return colors::red; }, 1,
+                      [&](tile const& region, bool completed) { rendered.update(region, completed); }, nullptr,
+                      image::AAA_MASK_DISABLED, false, tiling{16, 16, TileOrder::Spiral});
+    EXPECT_EQ(48U, rendered.complete_lines());
+}